@@ -32,10 +32,18 @@
   extern "C" {
 #endif
 /* ***************************************************************************************************************** */
+/*
+ *  Options guarded by "#if !defined( ... )" can be overridden from the compiler command line, this is how the
+ *  build profiles of the host CMake project select the FS types, VFAT, sector size, locking, mkfs and the return
+ *  code handler.
+ */
+
 /**
  *  This option switches support for return code handler. (0:Disable or 1:Enable)
  */
+#if !defined( EF_CONF_RETURN_CODE_HANDLER )
 #define EF_CONF_RETURN_CODE_HANDLER ( 1 )
+#endif
 
 /**
  *  This option switches support for assertions. (0:Disable or 1:Enable)
@@ -107,6 +115,21 @@
  */
 #define EF_DEF_VFAT_BUFFER_DYNAMIC  ( 2 )
 
+/**
+ *  This defines working on buffers taken from a static pool for LFN support.
+ */
+#define EF_DEF_VFAT_BUFFER_POOL ( 3 )
+
+/**
+ *  This defines a volume lock owned by one task at a time.
+ */
+#define EF_DEF_FS_LOCK_EXCLUSIVE  ( 1 )
+
+/**
+ *  This defines a volume lock shared by the read only functions.
+ */
+#define EF_DEF_FS_LOCK_SHARED     ( 2 )
+
 /* ************************************************************************* **
  *  Function Configurations
  * ************************************************************************* */
@@ -238,17 +261,34 @@
 /**
  *  The EF_CONF_VFAT switches the support for LFN (long file name) (0:Disable or 1:Enable).
  */
+#if !defined( EF_CONF_VFAT )
 #define EF_CONF_VFAT  ( 0 )
+#endif
 
 /**
  *  This option switches the working buffer for LFN support when LFN is enabled.
  *
  * EF_DEF_VFAT_BUFFER_STATIC  : static working buffer on the BSS.
  * EF_DEF_VFAT_BUFFER_STACK   : working buffer on the stack.
+ * EF_DEF_VFAT_BUFFER_POOL    : working buffer taken from a pool on the BSS for
+ *                              the time of the call.
  *
  *  When use stack for the working buffer, take care on stack overflow.
+ *  The static buffer cannot be used with EF_CONF_FS_LOCK, the pool can.
  */
+#if !defined( EF_CONF_VFAT_BUFFER )
 #define EF_CONF_VFAT_BUFFER  ( EF_DEF_VFAT_BUFFER_STATIC )
+#endif
+
+/**
+ *  Number of LFN working buffers of the pool (1 to 32), when EF_CONF_VFAT_BUFFER is EF_DEF_VFAT_BUFFER_POOL.
+ *  A buffer is taken without waiting by each call using a long file name and given back when it returns: it is the
+ *  number of such calls in progress at once on all the volumes, a call finding the pool empty fails with
+ *  EF_RET_NOT_ENOUGH_CORE.
+ */
+#if !defined( EF_CONF_VFAT_BUFFER_POOL_NB )
+#define EF_CONF_VFAT_BUFFER_POOL_NB  ( 4 )
+#endif
 
 /**
  *  This option switches the character encoding on the API when LFN is enabled.
@@ -298,7 +338,36 @@
 /**
  *  Number of drivers (disk drives) to be used. (1-26)
  */
+#if !defined( EF_CONF_DRIVERS_NB )
 #define EF_CONF_DRIVERS_NB  ( 2 )
+#endif
+
+/**
+ *  This option gives each drive a one sector bounce buffer, used when a transfer buffer does not meet the
+ *  alignment reported by the driver capabilities. (0:Disable or 1:Enable)
+ *  When disabled, the buffers are given to the drivers as they are.
+ */
+#if !defined( EF_CONF_DRIVE_BOUNCE )
+#define EF_CONF_DRIVE_BOUNCE  ( 0 )
+#endif
+
+/**
+ *  This option sets the size in sectors of the write staging buffer of each drive. (0:Disable)
+ *  Writes smaller than an erase block (GET_BLOCK_SIZE, limited to this size) are gathered in the buffer and
+ *  issued as aligned units when the unit is complete, when another unit is written or on CTRL_SYNC.
+ */
+#if !defined( EF_CONF_DRIVE_AGGREGATE )
+#define EF_CONF_DRIVE_AGGREGATE ( 0 )
+#endif
+
+/**
+ *  This option sets the size in sectors of the sync write queue of each drive. (0:Disable)
+ *  The sectors written while a volume is synchronized are queued, then issued in ascending sector order with the
+ *  adjacent ones merged in one command. The file data is issued before the directory entry pointing to it.
+ */
+#if !defined( EF_CONF_DRIVE_ELEVATOR )
+#define EF_CONF_DRIVE_ELEVATOR  ( 0 )
+#endif
 
 /**
  *  This option switches support for fixed sector size. (0:Disable or 1:Enable)
@@ -313,7 +382,9 @@
  *  for variable sector size mode and  eEFPrvDriveIOCtrl() function needs to implement
  *  GET_SECTOR_SIZE command.
  */
+#if !defined( EF_CONF_SECTOR_SIZE )
 #define EF_CONF_SECTOR_SIZE ( 512 )
+#endif
 
 /**
  *  This option switches support for 64-bit LBA. (0:Disable or 1:Enable)
@@ -344,6 +415,129 @@
  */
  #define EF_CONF_USE_TRIM ( 1 )
 
+/**
+ *  This option switches the volume format function eEF_mkfs(). (0:Disable or 1:Enable)
+ *  The drive needs to implement GET_SECTOR_COUNT and GET_BLOCK_SIZE commands.
+ */
+#if !defined( EF_CONF_MKFS )
+#define EF_CONF_MKFS  ( 0 )
+#endif
+
+/**
+ *  The option EF_CONF_DELAYED_ALLOC switches delayed cluster allocation on file append.
+ *
+ *  0:  Disable delayed allocation. eEF_fwrite() allocates the clusters one by one
+ *      as the file grows.
+ *  >0: Enable delayed allocation. Data appended past the end of the cluster chain
+ *      is staged in a write-behind buffer of EF_CONF_DELAYED_ALLOC sectors held in
+ *      each file object. Clusters are allocated as one contiguous run when the
+ *      buffer is full or flushed by eEF_fsync(), eEF_fclose(), eEF_fseek(),
+ *      eEF_fread() or eEF_truncate(), and the staged sectors are written with a
+ *      single multi-sector write.
+ */
+#if !defined( EF_CONF_DELAYED_ALLOC )
+#define EF_CONF_DELAYED_ALLOC ( 0 )
+#endif
+
+/**
+ *  Maximum directory depth walked by the incremental volume defragmenter eEF_defrag_volume().
+ *  Each level costs two ef_u32_t in ef_defrag_st. Deeper directories are not walked.
+ *  The defragmenter relies on EF_CONF_FILE_LOCK to leave open objects alone: without it, no
+ *  object shall be open on the volume while eEF_defrag_file() or eEF_defrag_volume() runs.
+ */
+#if !defined( EF_CONF_DEFRAG_DEPTH )
+#define EF_CONF_DEFRAG_DEPTH  ( 8 )
+#endif
+
+/**
+ *  Maximum directory depth walked by the volume consistency checker eEF_check().
+ *  Each level costs two ef_u32_t on the stack. When a deeper directory is found,
+ *  lost clusters are reported but not freed.
+ */
+#if !defined( EF_CONF_CHECK_DEPTH )
+#define EF_CONF_CHECK_DEPTH   ( 16 )
+#endif
+
+/**
+ *  This option checks on eEF_fopen() whether an existing file is a single contiguous run.
+ *
+ *   0: Disable. The run is learnt while the file is accessed, or set by eEF_expand() and eEF_fextents().
+ *   1: Enable. The file chain is walked once on opening.
+ *
+ *  Offsets inside the run of a file are mapped to sectors without FAT lookups and
+ *  transfers inside it are not split at cluster boundaries.
+ */
+#if !defined( EF_CONF_CONTIGUOUS_CHECK )
+#define EF_CONF_CONTIGUOUS_CHECK  ( 0 )
+#endif
+
+/**
+ *  Number of free cluster runs held in the free extent index of each volume (0:Disable).
+ *
+ *  The index is built by a single FAT scan on the first eEF_expand() after mounting
+ *  and kept up to date on every FAT update. It holds the largest free runs in two
+ *  balanced trees, by first cluster and by length, so a FAT update finds the runs
+ *  around its cluster and eEF_expand() picks the smallest run that fits in a
+ *  logarithmic time instead of scanning the FAT. Each entry costs two ef_u32_t and
+ *  four ef_u16_t in ef_fs_st.
+ */
+#if !defined( EF_CONF_FREE_INDEX )
+#define EF_CONF_FREE_INDEX  ( 0 )
+#endif
+
+/**
+ *  This option switches the per-volume I/O and cache statistics read by eEF_stats_get(). (0:Disable or 1:Enable)
+ *
+ *  The drive counters, and the volume counters under the shared volume lock, are atomic adds
+ *  (u32EFPortAtomicAdd(), the critical section where the cpu has none), the other volume
+ *  counters are plain increments under the volume lock. They sit on paths that already
+ *  touch the volume, so the statistics can be left enabled in production builds. They cost
+ *  one ef_stats_st in each ef_fs_st and one per registered drive.
+ */
+#if !defined( EF_CONF_STATS )
+#define EF_CONF_STATS ( 1 )
+#endif
+
+/**
+ *  This option switches the latency histograms of the public functions read by eEF_latency_get(). (0:Disable or 1:Enable)
+ *
+ *  Each instrumented function reads the port timestamp u32EFPortTimestampGet() on entry and
+ *  on exit, and counts the duration in a histogram with one bucket per power of two ticks.
+ *  A callback set by eEF_latency_callback_set() is called for every operation slower than
+ *  its threshold. When disabled, the instrumentation compiles to nothing.
+ */
+#if !defined( EF_CONF_LATENCY )
+#define EF_CONF_LATENCY ( 0 )
+#endif
+
+/**
+ *  Frequency of the port timestamp in Hz, used to convert the latency ticks into time.
+ *  The default port counts microseconds on the host and CPU cycles (DWT CYCCNT) on Cortex-M,
+ *  where this option must be set to the core clock.
+ */
+#if !defined( EF_CONF_LATENCY_TICK_HZ )
+#define EF_CONF_LATENCY_TICK_HZ ( 1000000 )
+#endif
+
+/**
+ *  This option switches the drive command trace read by eEF_trace_read(). (0:Disable or 1:Enable)
+ *
+ *  Once started by eEF_trace_enable(), every read, write, TRIM and SYNC command sent to the
+ *  drives is recorded with its timestamp, sector, count and the public function it was
+ *  issued for, in a ring buffer of EF_CONF_TRACE_DEPTH records. When the ring is full the
+ *  oldest records are overwritten and counted as lost.
+ */
+#if !defined( EF_CONF_TRACE )
+#define EF_CONF_TRACE ( 0 )
+#endif
+
+/**
+ *  Number of records of the drive command trace ring buffer, each one costs 24 bytes.
+ */
+#if !defined( EF_CONF_TRACE_DEPTH )
+#define EF_CONF_TRACE_DEPTH ( 256 )
+#endif
+
 /* ************************************************************************* **
  *  System Configurations
  * ************************************************************************* */
@@ -351,17 +545,23 @@
 /**
  *  This option switches support for FAT12 filesystem. (0:Disable or 1:Enable)
  */
+#if !defined( EF_CONF_FS_FAT12 )
 #define EF_CONF_FS_FAT12  ( 0 )
+#endif
 
 /**
  *  This option switches support for FAT12/16 filesystem. (0:Disable or 1:Enable)
  */
+#if !defined( EF_CONF_FS_FAT16 )
 #define EF_CONF_FS_FAT16  ( 0 )
+#endif
 
 /**
  *  This option switches support for FAT32 filesystem. (0:Disable or 1:Enable)
  */
+#if !defined( EF_CONF_FS_FAT32 )
 #define EF_CONF_FS_FAT32  ( 1 )
+#endif
 
 /**
  *  This option switches support for checking FAT16 filesystem. (0:Disable or 1:Enable)
@@ -429,8 +629,12 @@
  *  >0: Enable file lock function. The value defines how many files/sub-directories
  *      can be opened simultaneously under file lock control. Note that the file
  *      lock control is independent of re-entrancy.
+ *      The opened objects are found through a hash table, so the open time does
+ *      not grow with the value.
  */
+#if !defined( EF_CONF_FILE_LOCK )
 #define EF_CONF_FILE_LOCK   ( 0 )
+#endif
 
 /* #include <somertos.h>  // O/S definitions */
 /**
@@ -438,22 +642,47 @@
  *  module itself. Note that regardless of this option, file access to different
  *  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
  *  and f_fdisk() function, are always not re-entrant. Only file/directory access
- *  to the same volume is under control of this function. (0:Disable or 1:Enable)
+ *  to the same volume is under control of this function. (0:Disable, 1:Enable or 2:Enable shared)
  *
  *   0: Disable re-entrancy. EF_CONF_TIMEOUT and EF_SYNC_t have no effect.
  *   1: Enable re-entrancy. Also user provided synchronization handlers,
  *      iffSyncObjectTake(), iffSyncObjectGive(), iffSyncObjectDelete() and iffSyncObjectCreate()
  *      function, must be added to the project. Samples are available in
  *      option/syscall.c.
- */
+ *      The lock of a volume guards its metadata (FAT, directories and window).
+ *      The whole sectors of eEF_fread() and eEF_fwrite() are transferred without it,
+ *      under the lock of the drive (eEFPortLockTake()), a drive reporting
+ *      EF_DRIVE_CAP_CONCURRENT reading them with no lock at all.
+ *   2: Enable re-entrancy with a reader-writer volume lock. eEF_fread() of a file
+ *      with no delayed data, eEF_stat(), eEF_dirread() and eEF_findnext() own the
+ *      volume shared (eEFPortSyncObjectTakeShared()) and proceed together, the
+ *      other functions own it exclusively. The readers serialize their accesses
+ *      to the window of the volume on its window lock, eEF_fread() only holding it
+ *      while it follows the FAT chain outside the contiguous run of the file.
+ */
+#if !defined( EF_CONF_FS_LOCK )
 #define EF_CONF_FS_LOCK ( 0 )
+#endif
 
 /** The EF_CONF_TIMEOUT defines timeout period in unit of time tick.
  *  The EF_SYNC_t defines O/S dependent sync object type. e.g. HANDLE, ID, OS_EVENT*,
  *  SemaphoreHandle_t and etc. A header file for O/S definitions needs to be
  *  included somewhere in the scope of ff.h.
+ *  With the POSIX threads sync objects the tick is one millisecond.
  */
+#if !defined( EF_CONF_TIMEOUT )
 #define EF_CONF_TIMEOUT ( 1000 )
+#endif
+
+/**
+ *  The option EF_CONF_PORT_PTHREAD selects the POSIX threads sync objects of ef_port_system.c, for host builds and
+ *  Linux targets: a task waiting for a busy volume is blocked on a condition variable until the volume is given or
+ *  EF_CONF_TIMEOUT expires. The data shared by all the volumes (latency histograms, drive command trace) is then
+ *  updated under a mutex. (0:Disable or 1:Enable)
+ */
+#if !defined( EF_CONF_PORT_PTHREAD )
+#define EF_CONF_PORT_PTHREAD ( 0 )
+#endif
 
 /* ***************************************************************************************************************** */
 #ifdef __cplusplus
@@ -35,8 +35,58 @@
 /* Includes -------------------------------------------------------------------------------------------------------- */
 #include "efat.h"
 /* Local constant macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Largest number of member drives of the striped virtual drive
+ */
+#define EF_PORT_STRIPE_DRIVES_MAX ( 4 )
+
 /* Local function macros ------------------------------------------------------------------------------------------- */
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+
+/**
+ *  @brief  Model of the flash device simulator (ef_port_flash_config_st)
+ */
+typedef struct {
+  ef_u32_t  u32SectorNb;      /**< Number of sectors of the device */
+  ef_u16_t  u16SectorSize;    /**< Sector size in bytes, multiple of 512 */
+  ef_u32_t  u32PageSize;      /**< Program unit in sectors */
+  ef_u32_t  u32BlockSize;     /**< Erase block in sectors, multiple of the page, returned by GET_BLOCK_SIZE */
+  ef_u32_t  u32CacheBlocks;   /**< Erase blocks held by the write cache, 0: merged by every write command */
+  ef_u32_t  u32CommandUs;     /**< Overhead of every command [us] */
+  ef_u32_t  u32TransferUs;    /**< Bus transfer of one sector [us] */
+  ef_u32_t  u32ReadUs;        /**< Page read [us] */
+  ef_u32_t  u32ProgramUs;     /**< Page program [us] */
+  ef_u32_t  u32EraseUs;       /**< Block erase [us] */
+} ef_port_flash_config_st;
+
+/**
+ *  @brief  Activity of the flash device simulator (ef_port_flash_stats_st)
+ *          The write amplification is u64PagesProgrammed * u32PageSize / u64SectorsWritten.
+ */
+typedef struct {
+  ef_u64_t  u64ElapsedUs;       /**< Simulated busy time of the device [us] */
+  ef_u64_t  u64SectorsRead;     /**< Sectors read by the host */
+  ef_u64_t  u64SectorsWritten;  /**< Sectors written by the host */
+  ef_u64_t  u64SectorsTrimmed;  /**< Sectors trimmed by the host */
+  ef_u64_t  u64SectorsCopied;   /**< Valid sectors copied by the block merges */
+  ef_u64_t  u64PagesRead;       /**< Pages read from the array, host reads and merges */
+  ef_u64_t  u64PagesProgrammed; /**< Pages programmed */
+  ef_u64_t  u64BlocksErased;    /**< Blocks erased */
+  ef_u32_t  u32Commands;        /**< Read, write, trim and sync commands */
+  ef_u32_t  u32Merges;          /**< Blocks merged, on cache eviction, sync or uncached write */
+  ef_u32_t  u32CacheHits;       /**< Writes to a block already held by the write cache */
+} ef_port_flash_stats_st;
+
+/**
+ *  @brief  Members of the striped virtual drive (ef_port_stripe_config_st)
+ */
+typedef struct {
+  ef_u32_t  u32StripeSize;                          /**< Sectors of a stripe, stored on one member */
+  ef_u08_t  u8DrivesNb;                             /**< Number of members, 2 to EF_PORT_STRIPE_DRIVES_MAX */
+  ef_u08_t  u8Drives[ EF_PORT_STRIPE_DRIVES_MAX ];  /**< Physical drive numbers of the members, in stripe order */
+} ef_port_stripe_config_st;
+
 /* Public functions prototypes---------------------------------------------- */
 
 /**
@@ -44,6 +94,153 @@
  */
 extern ef_drive_functions_st xffDriveFunctionsSDIO;
 
+/**
+ *  @brief  RAM disk Drive Functions
+ */
+extern ef_drive_functions_st xffDriveFunctionsRAM;
+
+/**
+ *  @brief  Disk image file Drive Functions (POSIX host)
+ */
+extern ef_drive_functions_st xffDriveFunctionsImage;
+
+/**
+ *  @brief  Flash device simulator Drive Functions (host)
+ */
+extern ef_drive_functions_st xffDriveFunctionsFlash;
+
+/**
+ *  @brief  Striped (RAID-0) virtual Drive Functions
+ */
+extern ef_drive_functions_st xffDriveFunctionsStripe;
+
+/**
+ *  @brief  Configure the RAM disk, to be called before the drive is initialized
+ *          The previous disk is released if it was allocated by the driver.
+ *
+ *  @param  pu8Memory     Memory holding the sectors, 0:allocated on initialization
+ *  @param  u32SectorNb   Number of sectors of the disk
+ *  @param  u16SectorSize Sector size in bytes, multiple of 512
+ *  @param  u32BlockSize  Erase block size in sectors, returned by GET_BLOCK_SIZE
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+ef_return_et eEFPortDriveRAMConfigure (
+  ef_u08_t  * pu8Memory,
+  ef_u32_t    u32SectorNb,
+  ef_u16_t    u16SectorSize,
+  ef_u32_t    u32BlockSize
+);
+
+/**
+ *  @brief  Get the memory holding the sectors of the RAM disk
+ *
+ *  @return Pointer to the first sector, 0:not allocated yet
+ */
+ef_u08_t * pu8EFPortDriveRAMMemoryGet (
+  void
+);
+
+/**
+ *  @brief  Configure the disk image file, to be called before the drive is initialized
+ *          The previous image is closed.
+ *
+ *  @param  pcPath        Path of the image file, created if needed. The string must stay valid.
+ *  @param  u32SectorNb   Number of sectors of the disk, the image is extended to it. 0:size of the image
+ *  @param  u16SectorSize Sector size in bytes, multiple of 512
+ *  @param  u32BlockSize  Erase block size in sectors, returned by GET_BLOCK_SIZE
+ *  @param  bMap          EF_BOOL_TRUE to map the image in memory instead of using pread()/pwrite()
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   The previous image could not be closed
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+ef_return_et eEFPortDriveImageConfigure (
+  const char  * pcPath,
+  ef_u32_t      u32SectorNb,
+  ef_u16_t      u16SectorSize,
+  ef_u32_t      u32BlockSize,
+  ef_bool_t     bMap
+);
+
+/**
+ *  @brief  Write back and close the disk image file
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   R/W Error
+ */
+ef_return_et eEFPortDriveImageClose (
+  void
+);
+
+/**
+ *  @brief  Get the default model of the flash device simulator: 64 MiB, 4 KiB pages, 512 KiB erase blocks,
+ *          4 cached blocks, 100 us per command, 25 MB/s bus, 50 us page read, 400 us page program, 3 ms erase
+ *
+ *  @param  pxModel   Model to fill
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ */
+ef_return_et eEFPortDriveFlashDefaultGet (
+  ef_port_flash_config_st * pxModel
+);
+
+/**
+ *  @brief  Configure the flash device simulator, to be called before the drive is initialized
+ *          The previous device is released, the default model is used if never configured.
+ *
+ *  @param  pxModel   Model of the device, copied
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+ef_return_et eEFPortDriveFlashConfigure (
+  const ef_port_flash_config_st * pxModel
+);
+
+/**
+ *  @brief  Get the activity of the flash device simulator since it was initialized or reset
+ *
+ *  @param  pxStats   Activity to fill
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ */
+ef_return_et eEFPortDriveFlashStatsGet (
+  ef_port_flash_stats_st  * pxStats
+);
+
+/**
+ *  @brief  Clear the activity of the flash device simulator, the write cache is kept
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ */
+ef_return_et eEFPortDriveFlashStatsReset (
+  void
+);
+
+/**
+ *  @brief  Configure the striped virtual drive, to be called before the drive is initialized
+ *          The members are registered drives, initialized with the virtual drive. Their sector size must be
+ *          EF_CONF_SECTOR_SIZE, the virtual drive holds as many stripes on each one as the smallest member.
+ *
+ *  @param  pxConfig  Members and stripe size, copied
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+ef_return_et eEFPortDriveStripeConfigure (
+  const ef_port_stripe_config_st  * pxConfig
+);
+
 /* ***************************************************************************************************************** */
 #ifdef __cplusplus
 }
@@ -83,6 +83,24 @@ ef_return_et eEFPortMemCopy (
   ef_u32_t      u32BytesNb
 );
 
+/**
+ *  @brief  Copy memory byte by byte, the source and destination may overlap
+ *
+ *  @param  pvSrc       Pointer to the source data
+ *  @param  pvDst       Pointer to the destination data
+ *  @param  u32BytesNb  Number of bytes to transfer
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK  Success
+ *  @retval EF_RET_ERROR    An error occurred
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPortMemMove (
+  const void  * pvSrc,
+  void        * pvDst,
+  ef_u32_t      u32BytesNb
+);
+
 /**
  *  @brief  Set memory to zero
  *
@@ -35,7 +35,20 @@
 
 /* Includes -------------------------------------------------------------------------------------------------------- */
 #include "ef_def.h"
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+#include <pthread.h>
+#endif
 /* Local constant macros ------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+/**
+ *  Storage class of the module state owned by the calling task (POSIX threads: one copy per thread)
+ */
+#define EF_PORT_TASK_LOCAL  _Thread_local
+#else
+#define EF_PORT_TASK_LOCAL
+#endif
+
 /* Local function macros ------------------------------------------------------------------------------------------- */
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
 
@@ -43,11 +56,27 @@
 //  typedef  SemaphoreHandle_t  EF_SYNC_t;
 /* CMSIS-RTOS */
 //  typedef  osMutexDef_t EF_SYNC_t;
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+/* POSIX threads */
+/**
+ *  Object for synchronisation, defined in ef_port_system.c
+ */
+typedef  struct ef_port_sync_struct * EF_SYNC_t;
+/**
+ *  Lock of a module resource
+ */
+typedef  pthread_mutex_t EF_LOCK_t;
+#else
 /* DEFAULT NO RTOS */
 /**
  *  Object for synchronisation
  */
 typedef  ef_u08_t* EF_SYNC_t;
+/**
+ *  Lock of a module resource
+ */
+typedef  ef_u08_t EF_LOCK_t;
+#endif
 
   /* Public functions prototypes---------------------------------------------- */
 
@@ -61,6 +90,18 @@ ef_u32_t u32EFPortFatTimeGet (
   void
 );
 
+/**
+ *  @brief  Get a High Resolution Timestamp
+ *          Free running counter at EF_CONF_LATENCY_TICK_HZ, only called when EF_CONF_LATENCY or EF_CONF_TRACE
+ *          is enabled.
+ *          Durations are computed with an unsigned subtraction, so the counter may wrap.
+ *
+ *  @return The current timestamp in ticks
+ */
+ef_u32_t u32EFPortTimestampGet (
+  void
+);
+
 /**
  *  @brief  Create a Synchronization Object
  *          This function is called in f_mount() function to create a new
@@ -98,11 +139,13 @@ ef_return_et eEFPortSyncObjectDelete (
 /**
  *  @brief  Request Grant to Access the Volume
  *          This function is called on entering file functions to lock the volume.
+ *          It waits up to EF_CONF_TIMEOUT for the task owning the volume to give it.
  *
  *  @param  xSyncObject  Sync object to wait
  *
  *  @return Operation result
  *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_TIMEOUT    The volume was not given within EF_CONF_TIMEOUT
  *  @retval EF_RET_SYS_ERROR  An error occurred
  *  @retval EF_RET_ASSERT     Assertion failed
  */
@@ -111,9 +154,59 @@ ef_return_et eEFPortSyncObjectDelete (
 ef_return_et eEFPortSyncObjectTake (
   EF_SYNC_t xSyncObject
 );
+
+/**
+ *  @brief  Request Grant to Access the Volume without waiting
+ *          This function is called before eEFPortSyncObjectTake() to tell a free volume from a busy one.
+ *
+ *  @param  xSyncObject  Sync object to take
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success, the volume is locked
+ *  @retval EF_RET_TIMEOUT    The volume is locked by another task
+ */
+ef_return_et eEFPortSyncObjectTryTake (
+  EF_SYNC_t xSyncObject
+);
+
+/**
+ *  @brief  Request Shared Grant to Access the Volume
+ *          This function is called on entering the read only file functions when EF_CONF_FS_LOCK is 2. Several
+ *          tasks may own the volume shared at once, a task owning it exclusively excludes all others. A task
+ *          waiting for the exclusive grant holds back the new shared requests, and the tasks waiting for the
+ *          shared grant are let in when the exclusive owner gives it, so that no side starves.
+ *          It waits up to EF_CONF_TIMEOUT for the volume.
+ *
+ *  @param  xSyncObject  Sync object to wait
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_TIMEOUT    The volume was not given within EF_CONF_TIMEOUT
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+ef_return_et eEFPortSyncObjectTakeShared (
+  EF_SYNC_t xSyncObject
+);
+
+/**
+ *  @brief  Request Shared Grant to Access the Volume without waiting
+ *          This function is called before eEFPortSyncObjectTakeShared() to tell a free volume from a busy one.
+ *
+ *  @param  xSyncObject  Sync object to take
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success, the volume is locked shared
+ *  @retval EF_RET_TIMEOUT    The volume is locked exclusively or requested exclusively by another task
+ */
+ef_return_et eEFPortSyncObjectTryTakeShared (
+  EF_SYNC_t xSyncObject
+);
+
 /**
  *  @brief  Release Grant to Access the Volume
- *          This function is called on leaving file functions to unlock the volume.
+ *          This function is called on leaving file functions to unlock the volume, whether it was granted
+ *          exclusive or shared.
  *
  *  @param  xSyncObject  Sync object to be signaled
  *
@@ -126,6 +219,130 @@ ef_return_et eEFPortSyncObjectGive (
   EF_SYNC_t xSyncObject
 );
 
+/**
+ *  @brief  Create the lock of a module resource
+ *          A lock protects a resource for short sections: a drive while commands are sent to it, the window of
+ *          a volume shared by its readers. Unlike the volume sync objects it has no timeout.
+ *
+ *  @param  pxLock  Lock to create
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ */
+ef_return_et eEFPortLockCreate (
+  EF_LOCK_t * pxLock
+);
+
+/**
+ *  @brief  Delete the lock of a module resource
+ *
+ *  @param  pxLock  Lock to delete
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ */
+ef_return_et eEFPortLockDelete (
+  EF_LOCK_t * pxLock
+);
+
+/**
+ *  @brief  Take the lock of a module resource, waiting for it as long as needed
+ *
+ *  @param  pxLock  Lock to take
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ */
+ef_return_et eEFPortLockTake (
+  EF_LOCK_t * pxLock
+);
+
+/**
+ *  @brief  Give the lock of a module resource
+ *
+ *  @param  pxLock  Lock to give
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ */
+ef_return_et eEFPortLockGive (
+  EF_LOCK_t * pxLock
+);
+
+/**
+ *  @brief  Enter the critical section of the module wide data
+ *          Protects the short updates of the data shared by all the volumes (latency histograms, drive command
+ *          trace), the section is not nested and no drive access is made in it.
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ */
+ef_return_et eEFPortCriticalEnter (
+  void
+);
+
+/**
+ *  @brief  Leave the critical section of the module wide data
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_SYS_ERROR  An error occurred
+ */
+ef_return_et eEFPortCriticalExit (
+  void
+);
+
+/**
+ *  @brief  Replace a word shared by the tasks if it still holds the expected value, in one atomic step
+ *          Lets the tasks share a small state (the LFN buffer pool) without lock.
+ *
+ *  @param  pu32Value     Pointer to the shared word
+ *  @param  pu32Expected  Pointer to the expected value, receives the current value when it differs
+ *  @param  u32New        Value to store
+ *
+ *  @return Operation result
+ *  @retval EF_BOOL_TRUE   The word held the expected value and was replaced
+ *  @retval EF_BOOL_FALSE  The word held another value, now in *pu32Expected
+ */
+ef_bool_t bEFPortAtomicCompareSwap (
+  ef_u32_t  * pu32Value,
+  ef_u32_t  * pu32Expected,
+  ef_u32_t    u32New
+);
+
+/**
+ *  @brief  Add to a counter shared by the tasks, in one atomic step
+ *          Lets the tasks count without serializing on the critical section. Adding 0 reads the counter.
+ *
+ *  @param  pu32Value Pointer to the shared counter
+ *  @param  u32Add    Value to add, wraps around
+ *
+ *  @return Value of the counter after the addition
+ */
+ef_u32_t u32EFPortAtomicAdd (
+  ef_u32_t  * pu32Value,
+  ef_u32_t    u32Add
+);
+
+/**
+ *  @brief  Add to a 64 bits counter shared by the tasks, in one atomic step
+ *          Falls back to the critical section where the cpu has no 64 bits atomic access.
+ *
+ *  @param  pu64Value Pointer to the shared counter
+ *  @param  u64Add    Value to add, wraps around
+ *
+ *  @return Value of the counter after the addition
+ */
+ef_u64_t u64EFPortAtomicAdd (
+  ef_u64_t  * pu64Value,
+  ef_u64_t    u64Add
+);
+
 //#endif
 
 /**
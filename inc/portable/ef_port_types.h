@@ -45,6 +45,7 @@ extern "C" {
   typedef uint16_t      ef_u16_t;   /**< 16-bit unsigned integer */
   typedef uint32_t      ef_u32_t;   /**< 32-bit unsigned integer */
   typedef uint64_t      ef_u64_t;   /**< 64-bit unsigned integer */
+  typedef uintptr_t     ef_uintptr_t; /**< Unsigned integer holding an address */
   typedef bool          ef_bool_t;  /**< boolean type */
   #define EF_BOOL_TRUE  ( 1 )       /**< boolean TRUE value */
   #define EF_BOOL_FALSE ( 0 )       /**< boolean FALSE value */
@@ -111,10 +111,35 @@
 #define EF_DIR_REPLACEMENT_CHAR  ( 0x05 )  /**< Replacement of the character collides with EF_DIR_DELETED_MASK */
 
 /* Re-entrancy related */
-#if ( ( 0 != EF_CONF_FS_LOCK ) && ( 0 != EF_CONF_VFAT ) )
-  #error Static LFN work area cannot be used at thread-safe configuration
+#if (    ( 0 != EF_CONF_FS_LOCK ) && ( 0 != EF_CONF_VFAT ) \
+      && ( EF_DEF_VFAT_BUFFER_STATIC == EF_CONF_VFAT_BUFFER ) )
+  #error Static LFN work area cannot be used at thread-safe configuration, use EF_DEF_VFAT_BUFFER_POOL
 #endif
 
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER ) \
+    && ( ( 1 > EF_CONF_VFAT_BUFFER_POOL_NB ) || ( 32 < EF_CONF_VFAT_BUFFER_POOL_NB ) )
+  #error Wrong EF_CONF_VFAT_BUFFER_POOL_NB setting
+#endif
+
+
+/* Free extent index related */
+#if ( EF_CONF_FREE_INDEX > 0xFFFF )
+  #error Wrong EF_CONF_FREE_INDEX setting
+#endif
+
+#define EF_FAT_INDEX_NONE     ( 0 )   /**< Free extent index not built */
+#define EF_FAT_INDEX_COMPLETE ( 1 )   /**< Free extent index holds every free run */
+#define EF_FAT_INDEX_PARTIAL  ( 2 )   /**< Free extent index dropped some of the smallest runs */
+
+/* Statistics related */
+#if ( 0 != EF_CONF_STATS ) && ( EF_DEF_FS_LOCK_SHARED == EF_CONF_FS_LOCK )
+  /* The tasks owning a volume shared update its counters together */
+  #define EF_STATS_ADD( pxFS, field, n )  ( (void) u32EFPortAtomicAdd( &(pxFS)->xStats.field, (n) ) )
+#elif ( 0 != EF_CONF_STATS )
+  #define EF_STATS_ADD( pxFS, field, n )  ( (pxFS)->xStats.field += (n) )  /**< Add n to a volume counter */
+#else
+  #define EF_STATS_ADD( pxFS, field, n )
+#endif
 
 /* Definitions of sector size */
 #if ( EF_CONF_SECTOR_SIZE != 512 ) && ( EF_CONF_SECTOR_SIZE != 1024 ) && ( EF_CONF_SECTOR_SIZE != 2048 ) && ( EF_CONF_SECTOR_SIZE != 4096 )
@@ -149,11 +174,11 @@
  *  This define return code handler function switched by EF_CONF_CODE_COVERAGE
  *  eEFPrvPortReturnCodeHandler is declared in ef_port_system.c
  */
-//#if ( 0 != EF_CONF_RETURN_CODE_HANDLER )
+#if ( 0 != EF_CONF_RETURN_CODE_HANDLER )
   #define EF_RETURN_CODE_HANDLER( error_code) eEFPrvPortReturnCodeHandler(error_code, #error_code, __FILE_NAME__, __LINE__)
-//#else
-//  #define EF_RETURN_CODE_HANDLER(error_code) (error_code)
-//#endif
+#else
+  #define EF_RETURN_CODE_HANDLER(error_code) (error_code)
+#endif
 
   /**
  *  This define assertion function switched by EF_CONF_ASSERT_PUBLIC
@@ -191,6 +216,16 @@
 /* Public function macros -------------------------------------------------------------------------------------------------------------- */
 /* Public typedefs, structures, unions and enums --------------------------------------------------------------------------------------- */
 
+/**
+ *  @brief  Run of free clusters (ef_free_run_st)
+ */
+typedef struct ef_free_run_struct {
+  ef_u32_t    u32Cluster;             /**< First free cluster of the run */
+  ef_u32_t    u32ClusterNb;           /**< Number of free clusters in the run */
+  ef_u16_t    u16Child[ 2 ][ 2 ];     /**< Left and right children in the trees by cluster and by length, origin from 1
+                                           (0:none), u16Child[ 0 ][ 0 ] links the released runs */
+} ef_free_run_st;
+
 /**
  *  @brief  Filesystem object structure (ef_fs_st)
  */
@@ -215,6 +250,7 @@ typedef struct ef_fs_strut {
 #else
   EF_SYNC_t   xSyncObject;            /**< Identifier of sync object */
 #endif
+  EF_LOCK_t   xWindowLock;            /**< Window accesses of the tasks owning the volume shared */
   ef_u32_t    u32ClstLast;            /**< Last allocated cluster */
   ef_u32_t    u32ClstFreeNb;          /**< Number of free clusters */
 #if ( 0 != EF_CONF_RELATIVE_PATH )
@@ -236,6 +272,18 @@ typedef struct ef_fs_strut {
   ef_u08_t  * pu8FATWindow;           /**< Pointer to Disk access window for FAT */
   ef_u32_t    u32FATWinSize;          /**< Size of the Disk access window [bytes] */
   ef_u08_t    u8FATWinFlags;          /**< u8Window[] u8StatusFlags (b0:dirty) */
+#if ( 0 != EF_CONF_FREE_INDEX )
+  ef_free_run_st  xFreeIndex[ EF_CONF_FREE_INDEX ]; /**< Largest free runs, in a tree by cluster and one by length */
+  ef_u16_t    u16FreeIndexRoot[ 2 ];  /**< Roots of the trees by cluster and by length, origin from 1 (0:empty) */
+  ef_u16_t    u16FreeIndexFree;       /**< First released run of xFreeIndex[], origin from 1 (0:none) */
+  ef_u16_t    u16FreeIndexUsed;       /**< Runs of xFreeIndex[] used at least once, the ones above are free */
+  ef_u16_t    u16FreeIndexNb;         /**< Number of runs in xFreeIndex[] */
+  ef_u08_t    u8FreeIndexState;       /**< EF_FAT_INDEX_NONE, EF_FAT_INDEX_COMPLETE or EF_FAT_INDEX_PARTIAL */
+  ef_u32_t    u32FreeIndexMissNb;     /**< Smallest run found in no free run of the FAT since the last free, 0:none */
+#endif
+#if ( 0 != EF_CONF_STATS )
+  ef_stats_st xStats;                 /**< Volume counters, the drive ones are kept by the drive layer */
+#endif
 } ef_fs_st;
 
 /**
@@ -264,6 +312,11 @@ typedef struct ef_file_struct {
   ef_u08_t      u8Window[ EF_CONF_SECTOR_SIZE ];  /**< File private data read/write window */
   ef_lba_t      xDirSector;                       /**< Sector number containing the directory entry */
   ef_u08_t    * pu8DirPtr;                        /**< Pointer to the directory entry in the window[] */
+  ef_u32_t      u32ClstRunNb;                     /**< Clusters known to follow u32ClstStart contiguously, mapped without FAT lookups */
+#if ( 0 != EF_CONF_DELAYED_ALLOC )
+  ef_u32_t      u32DelayedSize;                   /**< Bytes staged in u8DelayedBuffer[ ] past the end of the cluster chain */
+  ef_u08_t      u8DelayedBuffer[ EF_CONF_DELAYED_ALLOC * EF_CONF_SECTOR_SIZE ]; /**< Delayed allocation write-behind buffer */
+#endif
 } ef_file_st;
 
 /**
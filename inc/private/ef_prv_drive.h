@@ -140,6 +140,108 @@ ef_return_et eEFPrvDriveRegister (
   ef_drive_functions_st * pxDriveFunctions
 );
 
+/**
+ *  @brief  Start queuing the writes of a Drive
+ *          Until eEFPrvDriveElevatorFlush(), the written sectors are kept sorted in the queue, the reads see them.
+ *          A full queue is issued and queuing goes on. Does nothing when EF_CONF_DRIVE_ELEVATOR is 0.
+ *
+ *  @param  u8PhyDrvNb  Physical drive number
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                 Succeeded
+ */
+ef_return_et eEFPrvDriveElevatorStart (
+  ef_u08_t  u8PhyDrvNb
+);
+
+/**
+ *  @brief  Issue the queued writes of a Drive in ascending sector order, adjacent sectors in one command,
+ *          and stop queuing. It also acts as an ordering barrier between two sets of writes.
+ *
+ *  @param  u8PhyDrvNb  Physical drive number
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                 Succeeded
+ *  @retval EF_RET_DISK_ERR           A queued write failed, the queue is emptied anyway
+ */
+ef_return_et eEFPrvDriveElevatorFlush (
+  ef_u08_t  u8PhyDrvNb
+);
+
+/**
+ *  @brief  Get the capabilities of a Drive, read from its driver when it was initialized
+ *
+ *  @param  u8PhyDrvNb  Physical drive number
+ *  @param  pxCaps      Pointer to the capabilities to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                 Succeeded
+ *  @retval EF_RET_INVALID_PARAMETER  Invalid drive number
+ */
+ef_return_et eEFPrvDriveCapsGet (
+  ef_u08_t            u8PhyDrvNb,
+  ef_drive_caps_st  * pxCaps
+);
+
+/**
+ *  @brief  Get the command and sector counters of a Drive
+ *          Only the drive fields of the statistics are written.
+ *
+ *  @param  u8PhyDrvNb  8 bits unsigned integer identifying the physical drive number
+ *  @param  pxStats     Pointer to the statistics to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+ef_return_et eEFPrvDriveStatsGet (
+  ef_u08_t      u8PhyDrvNb,
+  ef_stats_st * pxStats
+);
+
+/**
+ *  @brief  Reset the command and sector counters of a Drive
+ *
+ *  @param  u8PhyDrvNb  8 bits unsigned integer identifying the physical drive number
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ */
+ef_return_et eEFPrvDriveStatsReset (
+  ef_u08_t  u8PhyDrvNb
+);
+
+/**
+ *  @brief  Start or stop the command trace, starting it clears the records
+ *
+ *  @param  bEnable   EF_BOOL_TRUE to record the commands
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ */
+ef_return_et eEFPrvDriveTraceEnable (
+  ef_bool_t bEnable
+);
+
+/**
+ *  @brief  Move the oldest records of the command trace
+ *
+ *  @param  pxRecords     Pointer to the records to fill
+ *  @param  u32RecordsMax Number of records pxRecords can hold
+ *  @param  pu32RecordsNb Pointer to the number of records read
+ *  @param  pu32LostNb    Pointer to the number of records overwritten since the previous read
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+ef_return_et eEFPrvDriveTraceRead (
+  ef_trace_record_st  * pxRecords,
+  ef_u32_t              u32RecordsMax,
+  ef_u32_t            * pu32RecordsNb,
+  ef_u32_t            * pu32LostNb
+);
+
 /* ***************************************************************************************************************** */
 #ifdef __cplusplus
 }
@@ -277,6 +277,103 @@ ef_return_et eEFPrvFATChainStretch (
   ef_u32_t     * pu32Cluster
 );
 
+/**
+ *  @brief  FAT handling - Append a run of clusters to a chain or create a new chain with it
+ *          The run is taken contiguous when a large enough free extent exists, the first candidate
+ *          being the cluster following u32ClusterPrev. The extent is the best fit of the free extent
+ *          index when EF_CONF_FREE_INDEX is enabled, else the first fit within a bounded window of the
+ *          FAT, or of the whole FAT when bContiguous is set. Otherwise clusters are taken one by one,
+ *          unless bContiguous is set.
+ *          The new clusters are chained and terminated before being linked to u32ClusterPrev.
+ *
+ *  @param  pxObject        Pointer to Corresponding object
+ *  @param  u32ClusterPrev  Last cluster of the chain to append to, 0:Create a new chain
+ *  @param  u32ClusterNb    Number of clusters to allocate
+ *  @param  bContiguous     EF_BOOL_TRUE to fail with EF_RET_FAT_FULL when no contiguous run is large enough
+ *  @param  pu32Cluster     Pointer to the first allocated cluster number to update
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_FAT_FULL Not enough free clusters
+ *  @retval EF_RET_INT_ERR  Internal error
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFATChainRunAppend (
+  ef_object_st  * pxObject,
+  ef_u32_t        u32ClusterPrev,
+  ef_u32_t        u32ClusterNb,
+  ef_bool_t       bContiguous,
+  ef_u32_t      * pu32Cluster
+);
+
+/**
+ *  @brief  Free extent index - Forget the index, it is built again on next use
+ *
+ *  @param  pxFS    Pointer to the Filesystem object
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFATIndexReset (
+  ef_fs_st  * pxFS
+);
+
+/**
+ *  @brief  Free extent index - Build the index with a single scan of the FAT
+ *          The number of free clusters of the volume is updated on the way.
+ *
+ *  @param  pxFS    Pointer to the Filesystem object
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_INT_ERR  Internal error, the index is left unbuilt
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFATIndexBuild (
+  ef_fs_st  * pxFS
+);
+
+/**
+ *  @brief  Free extent index - Update the index after a FAT entry was written
+ *          Nothing is done while the index is not built.
+ *
+ *  @param  pxFS        Pointer to the Filesystem object
+ *  @param  u32Cluster  Cluster number whose FAT entry was written
+ *  @param  u32Value    Value written, 0:the cluster was freed
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFATIndexUpdate (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32Value
+);
+
+/**
+ *  @brief  Free extent index - Find the smallest free run holding a number of clusters
+ *          The index is built first if needed, and rebuilt once if it is partial and has
+ *          no run large enough. A size a rebuild found no run for fails without a rebuild
+ *          until a cluster is freed.
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32ClusterNb  Number of contiguous clusters needed
+ *  @param  pu32Cluster   Pointer to the first cluster of the run to update
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_DENIED   No free run is large enough
+ *  @retval EF_RET_INT_ERR  Internal error
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFATIndexFind (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32ClusterNb,
+  ef_u32_t  * pu32Cluster
+);
+
 /* ***************************************************************************************************************** */
 #ifdef __cplusplus
 }
@@ -98,6 +98,145 @@ ef_return_et eEFPrvFileWindowUpdate (
   ef_lba_t      xSector
 );
 
+/**
+ *  @brief  Check if the data at the file offset goes to the delayed allocation buffer
+ *          It does when data is already staged, or when the file offset is at the end
+ *          of the cluster chain on a cluster boundary.
+ *
+ *  @param  pxFile    Pointer to the File object
+ *  @param  pxFS      Pointer to the Filesystem object
+ *  @param  pbDelayed Pointer to the result to update, EF_BOOL_FALSE if EF_CONF_DELAYED_ALLOC is disabled
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_INT_ERR  Internal error
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileDelayedCheck (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS,
+  ef_bool_t   * pbDelayed
+);
+
+/**
+ *  @brief  Stage data in the delayed allocation buffer
+ *          When the buffer is full, it is flushed first and nothing is staged.
+ *
+ *  @param  pxFile            Pointer to the File object
+ *  @param  pxFS              Pointer to the Filesystem object
+ *  @param  pu8Buffer         Pointer to the data to stage
+ *  @param  u32BytesToWrite   Number of bytes to stage
+ *  @param  pu32BytesWritten  Pointer to the number of bytes staged to update
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_FAT_FULL Not enough free clusters to flush the buffer
+ *  @retval EF_RET_DISK_ERR A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_INT_ERR  Internal error
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileDelayedWrite (
+  ef_file_st      * pxFile,
+  ef_fs_st        * pxFS,
+  const ef_u08_t  * pu8Buffer,
+  ef_u32_t          u32BytesToWrite,
+  ef_u32_t        * pu32BytesWritten
+);
+
+/**
+ *  @brief  Flush the delayed allocation buffer
+ *          Allocates the clusters as one run appended to the file chain and writes the staged
+ *          sectors with one command per contiguous extent. The file window is left on the
+ *          sector holding the file offset. Once the run is linked to the chain, the staged data
+ *          is dropped whatever happens next: on a failure the file is aborted with the error, so
+ *          the run is never appended twice. Does nothing if EF_CONF_DELAYED_ALLOC is disabled.
+ *
+ *  @param  pxFile    Pointer to the File object
+ *  @param  pxFS      Pointer to the Filesystem object
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_FAT_FULL Not enough free clusters, the data stays staged
+ *  @retval EF_RET_DISK_ERR A hard error occurred in the low level disk I/O layer, the file is aborted
+ *  @retval EF_RET_INT_ERR  Internal error, the file is aborted once the run is linked
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileDelayedFlush (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS
+);
+
+/**
+ *  @brief  Record the cluster reached at a cluster index of the file
+ *          The contiguous run of the file grows when the cluster directly follows it.
+ *
+ *  @param  pxFile          Pointer to the File object
+ *  @param  u32ClusterIndex Index of the cluster in the file chain
+ *  @param  u32Cluster      Cluster number
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileRunGrow (
+  ef_file_st  * pxFile,
+  ef_u32_t      u32ClusterIndex,
+  ef_u32_t      u32Cluster
+);
+
+/**
+ *  @brief  Get the cluster at a cluster index of the file without FAT lookup
+ *
+ *  @param  pxFile          Pointer to the File object
+ *  @param  u32ClusterIndex Index of the cluster in the file chain
+ *  @param  pu32Cluster     Pointer to the cluster number to update
+ *  @param  pbFound         Pointer to the flag to update, EF_BOOL_TRUE if the index is in the contiguous run
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileRunClusterGet (
+  ef_file_st  * pxFile,
+  ef_u32_t      u32ClusterIndex,
+  ef_u32_t    * pu32Cluster,
+  ef_bool_t   * pbFound
+);
+
+/**
+ *  @brief  Get the number of sectors of the contiguous run from the file offset up to its end
+ *
+ *  @param  pxFile          Pointer to the File object
+ *  @param  pxFS            Pointer to the Filesystem object
+ *  @param  pu32SectorsNb   Pointer to the number of sectors to update, 0 if the offset is past the run
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileRunSectorsGet (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS,
+  ef_u32_t    * pu32SectorsNb
+);
+
+/**
+ *  @brief  Measure the contiguous run of the file by walking its chain
+ *          Does nothing if EF_CONF_CONTIGUOUS_CHECK is disabled.
+ *
+ *  @param  pxFile    Pointer to the File object
+ *  @param  pxFS      Pointer to the Filesystem object
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_INT_ERR  Internal error
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFileRunCheck (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS
+);
+
 /* ***************************************************************************************************************** */
 #ifdef __cplusplus
 }
@@ -0,0 +1,163 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_prv_latency.h
+ *  @ingroup  group_eFAT_Private
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Private latency histograms of the public functions.
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+#ifndef EFAT_PRIVATE_LATENCY_H
+#define EFAT_PRIVATE_LATENCY_H
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <efat.h>
+#include "ef_prv_def.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_TRACE )
+  /**
+   *  Tag the drive commands traced until the end of the public function with the function
+   */
+  #define EF_LATENCY_ORIGIN( eOperation ) (void) eEFPrvLatencyOriginSet( (eOperation) )
+#else
+  #define EF_LATENCY_ORIGIN( eOperation )
+#endif
+
+#if ( 0 != EF_CONF_LATENCY )
+  /**
+   *  Declare the context and the start timestamp of a timed public function, the context
+   *  is taken on entry as the function may move its path pointer
+   */
+  #define EF_LATENCY_START( eOperation, pvContext ) \
+    const void * pvLatencyContext = (pvContext); \
+    ef_u32_t     u32LatencyStart  = u32EFPortTimestampGet( ); \
+    EF_LATENCY_ORIGIN( eOperation )
+  /**
+   *  Count the duration of a timed public function, just before it returns
+   */
+  #define EF_LATENCY_END( eOperation, eResult ) \
+    (void) eEFPrvLatencyRecord( (eOperation), u32EFPortTimestampGet( ) - u32LatencyStart, (eResult), pvLatencyContext ); \
+    EF_LATENCY_ORIGIN( EF_LATENCY_OP_NB )
+#else
+  #define EF_LATENCY_START( eOperation, pvContext ) EF_LATENCY_ORIGIN( eOperation )
+  #define EF_LATENCY_END( eOperation, eResult )     EF_LATENCY_ORIGIN( EF_LATENCY_OP_NB )
+#endif
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+
+/* Public functions prototypes---------------------------------------------- */
+
+/**
+ *  @brief  Count the duration of a public function in its histogram
+ *          The slow operation callback is called when the duration reaches its threshold.
+ *
+ *  @param  eOperation  Timed function
+ *  @param  u32Ticks    Duration in port timestamp ticks
+ *  @param  eResult     Value returned by the function
+ *  @param  pvContext   File or directory object, or path, given to the function
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ *  @retval EF_RET_INT_ERR    Unknown operation
+ */
+ef_return_et eEFPrvLatencyRecord (
+  ef_latency_op_et    eOperation,
+  ef_u32_t            u32Ticks,
+  ef_return_et        eResult,
+  const void        * pvContext
+);
+
+/**
+ *  @brief  Set the public function the drive commands are issued for
+ *
+ *  @param  eOperation  Timed function, EF_LATENCY_OP_NB when leaving it
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ */
+ef_return_et eEFPrvLatencyOriginSet (
+  ef_latency_op_et    eOperation
+);
+
+/**
+ *  @brief  Get the public function the drive commands are issued for
+ *
+ *  @return Timed function in progress, EF_LATENCY_OP_NB when none
+ */
+ef_latency_op_et eEFPrvLatencyOriginGet (
+  void
+);
+
+/**
+ *  @brief  Copy the histogram of a public function
+ *
+ *  @param  eOperation  Timed function
+ *  @param  pxLatency   Pointer to the histogram to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+ef_return_et eEFPrvLatencyGet (
+  ef_latency_op_et    eOperation,
+  ef_latency_st     * pxLatency
+);
+
+/**
+ *  @brief  Clear the histograms of all the public functions
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ */
+ef_return_et eEFPrvLatencyReset (
+  void
+);
+
+/**
+ *  @brief  Set the slow operation callback and its threshold
+ *
+ *  @param  pxCallback          Pointer to the callback, 0 to remove it
+ *  @param  u32ThresholdTicks   Duration in ticks from which an operation is reported
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK         Succeeded
+ */
+ef_return_et eEFPrvLatencyCallbackSet (
+  xLatencyCallback  * pxCallback,
+  ef_u32_t            u32ThresholdTicks
+);
+
+/* ***************************************************************************************************************** */
+#ifdef __cplusplus
+}
+#endif
+#endif /* EFAT_PRIVATE_LATENCY_H */
+/* END OF FILE ***************************************************************************************************** */
@@ -100,6 +100,16 @@
     #define LEAVE_MKFS(res)  { if (!work) ef_memfree(buf); return res; }
     #define MAX_MALLOC  0x8000  /* Must be >=EF_CONF_SS_MAX */
 
+  /* LFN enabled with working buffer taken from the pool for the time of the call */
+  #elif ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
+
+    /* LFN working buffer */
+    #define EF_LFN_BUFFER_DEFINE                  ucs2_t * pxLFNPoolBuffer = 0;
+    #define EF_LFN_BUFFER_SET( pxFS )             eEFPrvLFNBufferAcquire( pxFS, &pxLFNPoolBuffer )
+    #define EF_LFN_BUFFER_GET( pxFS, ppxBuffer )  eEFPrvLFNBufferPtrGet( pxFS, ppxBuffer)
+    #define EF_LFN_BUFFER_FREE()                  (void) eEFPrvLFNBufferRelease( pxLFNPoolBuffer )
+    #define LEAVE_MKFS(res)  return res
+
   #else
 
     #error Wrong setting of EF_CONF_VFAT_BUFFER
@@ -126,6 +136,58 @@ ef_return_et eEFPrvLFNBufferPtrSet (
   const ucs2_t  * pxBuffer
 );
 
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
+/**
+ *  @brief  VFAT-LFN: Take a working buffer from the pool, without waiting
+ *          The pool is shared by all the volumes and is taken without lock.
+ *
+ *  @param  ppxBuffer Pointer to the buffer taken, 0 if none
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK             Success
+ *  @retval EF_RET_NOT_ENOUGH_CORE  Every buffer of the pool is in use
+ */
+ef_return_et eEFPrvLFNBufferTake (
+  ucs2_t  **  ppxBuffer
+);
+
+/**
+ *  @brief  VFAT-LFN: Take a working buffer from the pool and link it to the volume
+ *          The pool is shared by all the volumes and is taken without lock, the volume lock (or the window lock of a
+ *          volume owned shared) keeps the link to the volume until the buffer is given back.
+ *
+ *  @param  pxFS      Pointer to the file system object
+ *  @param  ppxBuffer Pointer to the buffer taken, 0 if none
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK             Success
+ *  @retval EF_RET_NOT_ENOUGH_CORE  Every buffer of the pool is in use
+ *  @retval EF_RET_ERROR          An error occurred
+ */
+ef_return_et eEFPrvLFNBufferAcquire (
+  ef_fs_st  *   pxFS,
+  ucs2_t    **  ppxBuffer
+);
+
+/**
+ *  @brief  VFAT-LFN: Give a working buffer back to the pool
+ *
+ *  @param  pxBuffer  Pointer to the buffer taken with eEFPrvLFNBufferAcquire(), 0 does nothing
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK     Success
+ *  @retval EF_RET_ERROR  The buffer is not one of the pool
+ */
+ef_return_et eEFPrvLFNBufferRelease (
+  ucs2_t  * pxBuffer
+);
+#else
+  /* No pool, the working buffer is static or on the stack */
+  #define eEFPrvLFNBufferTake( ppxBuffer )            ( EF_RET_OK )
+  #define eEFPrvLFNBufferAcquire( pxFS, ppxBuffer )   ( EF_RET_OK )
+  #define eEFPrvLFNBufferRelease( pxBuffer )          ( EF_RET_OK )
+#endif
+
 /**
  *  @brief  VFAT-LFN: Compare a part of file name with an LFN entry
  *
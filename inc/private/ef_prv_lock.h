@@ -66,6 +66,22 @@ ef_return_et eEFPrvFSLock (
   ef_fs_st  * pxFS
 );
 
+/**
+ *  @brief  Request shared grant to access the volume, for the read only functions
+ *          The grant is exclusive unless EF_CONF_FS_LOCK is EF_DEF_FS_LOCK_SHARED. The tasks owning the volume
+ *          shared access its window with eEFPrvFSWindowLock() held.
+ *
+ *  @param  pxFS  Pointer to the Filesystem object
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK  Success
+ *  @retval EF_RET_ERROR    An error occurred
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+ef_return_et eEFPrvFSLockShared (
+  ef_fs_st  * pxFS
+);
+
 /**
  *  @brief  Conditionnal Release grant to access the volume
  *
@@ -95,6 +111,54 @@ ef_return_et eEFPrvFSUnlock (
 ef_return_et eEFPrvFSUnlockForce (
   ef_fs_st  * pxFS
 );
+
+/**
+ *  @brief  Request again grant to access the volume of an object, after a data transfer done without it
+ *
+ *  @param  pxObject  Pointer to the object
+ *  @param  bShared   The grant released was shared
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK             Success
+ *  @retval EF_RET_TIMEOUT        The volume could not be obtained, the grant is not held
+ *  @retval EF_RET_INVALID_OBJECT The volume was mounted again meanwhile, the grant is held
+ *  @retval EF_RET_ASSERT         Assertion failed
+ */
+ef_return_et eEFPrvFSRelock (
+  ef_object_st  * pxObject,
+  ef_bool_t       bShared
+);
+
+/**
+ *  @brief  Request the window of a volume owned shared
+ *          The tasks owning a volume shared take turns on its window, the FAT and directory sectors. It is
+ *          taken after the volume lock and before the drive locks. Nothing is done unless EF_CONF_FS_LOCK is
+ *          EF_DEF_FS_LOCK_SHARED, an exclusive owner being alone using the window.
+ *
+ *  @param  pxFS  Pointer to the Filesystem object
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK     Success
+ *  @retval EF_RET_ERROR  An error occurred
+ *  @retval EF_RET_ASSERT Assertion failed
+ */
+ef_return_et eEFPrvFSWindowLock (
+  ef_fs_st  * pxFS
+);
+
+/**
+ *  @brief  Release the window of a volume owned shared
+ *
+ *  @param  pxFS  Pointer to the Filesystem object
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK     Success
+ *  @retval EF_RET_ERROR  An error occurred
+ *  @retval EF_RET_ASSERT Assertion failed
+ */
+ef_return_et eEFPrvFSWindowUnlock (
+  ef_fs_st  * pxFS
+);
 /*-----------------------------------------------------------------------*/
 /* File lock control functions                                           */
 /*-----------------------------------------------------------------------*/
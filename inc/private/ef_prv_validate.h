@@ -67,6 +67,20 @@ ef_return_et eEFPrvValidateObject (
     ef_fs_st     ** ppxFS
 );
 
+/**
+ *  @brief   Check if the file/directory object is valid or not, for a read only function
+ *           The volume is locked shared, see eEFPrvFSLockShared().
+ *
+ *  @param  pxObject  Pointer to the ef_object_st, the 1st member in the ef_file_st/ef_directory_st object, to check validity
+ *  @param  ppxFS     Pointer to pointer to the owner filesystem object to return
+ *
+ *  @return Function completion, see eEFPrvValidateObject()
+ */
+ef_return_et eEFPrvValidateObjectShared (
+    ef_object_st *  pxObject,
+    ef_fs_st     ** ppxFS
+);
+
 /* ***************************************************************************************************************** */
 #ifdef __cplusplus
 }
@@ -113,6 +113,19 @@ ef_return_et eEFPrvVolumeMountCheck (
   ef_fs_st    **  ppxFS
 );
 
+/**
+ *  @brief  Determine logical drive number for a read only function, the volume being locked shared
+ *
+ *  @param  ppxPath Pointer to pointer to the pxPath name (drive number)
+ *  @param  ppxFS   Pointer to pointer to the found filesystem object
+ *
+ *  @return Function completion, see eEFPrvVolumeMountCheck()
+ */
+ef_return_et eEFPrvVolumeMountCheckShared (
+  const TCHAR **  ppxPath,
+  ef_fs_st    **  ppxFS
+);
+
 /**
  *  @brief  Determine filesystem object from volume number
  *
@@ -83,10 +83,19 @@
 
 /* Generic command (Used by eFAT) */
 #define CTRL_SYNC         (  0 )  /**< Complete pending write process */
-#define GET_SECTOR_COUNT  (  1 )  /**< Get media size (needed at EF_USE_MKFS == 1) */
+#define GET_SECTOR_COUNT  (  1 )  /**< Get media size (needed at EF_CONF_MKFS == 1) */
 #define GET_SECTOR_SIZE   (  2 )  /**< Get sector size (needed at EF_CONF_SS_MAX != EF_CONF_SS_MIN) */
-#define GET_BLOCK_SIZE    (  3 )  /**< Get erase block size (needed at EF_USE_MKFS == 1) */
+#define GET_BLOCK_SIZE    (  3 )  /**< Get erase block size (needed at EF_CONF_MKFS == 1) */
 #define CTRL_TRIM         (  4 )  /**< Inform device that the data on the block of sectors is no longer used (needed at EF_CONF_USE_TRIM == 1) */
+#define GET_CAPABILITIES  (  9 )  /**< Get the driver capabilities, ef_drive_caps_st (optional, defaults used if refused) */
+#define CTRL_WRITE_ZEROES ( 15 )  /**< Fill a block of sectors with zeros (needed at EF_DRIVE_CAP_WRITE_ZEROES) */
+
+/* Driver features, u32Features of ef_drive_caps_st */
+#define EF_DRIVE_CAP_TRIM           ( 0x01UL )  /**< CTRL_TRIM is supported */
+#define EF_DRIVE_CAP_WRITE_ZEROES   ( 0x02UL )  /**< CTRL_WRITE_ZEROES is supported */
+#define EF_DRIVE_CAP_SCATTER_GATHER ( 0x04UL )  /**< The transfers can be split over several buffers */
+#define EF_DRIVE_CAP_ASYNC          ( 0x08UL )  /**< The transfers complete asynchronously */
+#define EF_DRIVE_CAP_CONCURRENT     ( 0x10UL )  /**< Reads may be sent by several tasks at once, and alongside writes of other sectors */
 
 /* Generic command (Not used by eFAT) */
 #define CTRL_POWER        (  5 )  /**< Get/Set power status */
@@ -102,6 +102,25 @@ typedef struct ef_file_info_struct {
 #endif
 } ef_file_info_st;
 
+/**
+ *  @brief  Physical extent of a file (ef_extent_st)
+ */
+typedef struct ef_extent_struct {
+  ef_lba_t  xSector;      /**< First sector of the run */
+  ef_u32_t  u32SectorNb;  /**< Number of sectors of the run */
+} ef_extent_st;
+
+/**
+ *  @brief  Capabilities of a driver, returned by GET_CAPABILITIES (ef_drive_caps_st)
+ *          A driver refusing the command gets: no limit, no alignment, any granularity, EF_DRIVE_CAP_TRIM.
+ */
+typedef struct ef_drive_caps_struct {
+  ef_u32_t  u32MaxSectors;    /**< Most sectors per read or write command, 0: no limit */
+  ef_u32_t  u32Alignment;     /**< Buffer address alignment needed by the transfers [bytes], power of 2, 1: none */
+  ef_u32_t  u32Granularity;   /**< Preferred size and alignment of the transfers [sectors], 1: any */
+  ef_u32_t  u32Features;      /**< Supported features, EF_DRIVE_CAP_xxx */
+} ef_drive_caps_st;
+
 /**
  *  @brief  Pointer to a Drive Initialization Function
  */
@@ -139,6 +158,141 @@ typedef struct
   xDriveCtrl        *pxCtrl;        /**< Pointer to a function to I/O control operation */
 } ef_drive_functions_st;
 
+/**
+ *  @brief  Incremental volume defragmentation state (ef_defrag_st)
+ *          Zero it to start a pass, it is zeroed again when the pass completes.
+ */
+typedef struct ef_defrag_struct {
+  ef_u32_t  u32DirClst[ EF_CONF_DEFRAG_DEPTH ];   /**< Start cluster of the directories being walked (0:root) */
+  ef_u32_t  u32DirOffset[ EF_CONF_DEFRAG_DEPTH ]; /**< Offset of the next entry to visit in each directory */
+  ef_u16_t  u16MountId;                           /**< Mount ID of the volume when the pass started */
+  ef_u08_t  u8Depth;                              /**< Number of directories being walked, 0:pass not started */
+  ef_u32_t  u32ObjectsMoved;                      /**< Files and directories relocated during the pass */
+  ef_u32_t  u32ClustersMoved;                     /**< Clusters relocated during the pass */
+} ef_defrag_st;
+
+/**
+ *  @brief  Volume consistency check report (ef_check_st)
+ */
+typedef struct ef_check_struct {
+  ef_u32_t  u32ObjectsNb;       /**< Files and directories checked */
+  ef_u32_t  u32ClustersUsedNb;  /**< Clusters owned by files and directories */
+  ef_u32_t  u32ClustersFreeNb;  /**< Free clusters counted in the FAT */
+  ef_u32_t  u32LostNb;          /**< Allocated clusters owned by no file or directory */
+  ef_u32_t  u32CrossLinkedNb;   /**< Chains running into a cluster already owned by another chain */
+  ef_u32_t  u32BrokenNb;        /**< Chains linking to a free, bad or out of range cluster */
+  ef_u32_t  u32SizeMismatchNb;  /**< Files whose size does not match the length of their chain */
+  ef_u32_t  u32RepairedNb;      /**< Repairs made */
+  ef_u32_t  u32PassesNb;        /**< Directory walks needed to cover the FAT with the bitmap given */
+  ef_bool_t bFreeNbMismatch;    /**< The free cluster count of the volume was wrong */
+  ef_bool_t bIncomplete;        /**< Directories deeper than EF_CONF_CHECK_DEPTH were not walked */
+} ef_check_st;
+
+/**
+ *  @brief  Volume I/O and cache statistics (ef_stats_st)
+ *          The drive counters are kept per physical drive, so volumes sharing a drive report the same ones.
+ */
+typedef struct ef_stats_struct {
+  ef_u32_t  u32ReadCmds;          /**< Drive read commands */
+  ef_u32_t  u32WriteCmds;         /**< Drive write commands */
+  ef_u64_t  u64SectorsRead;       /**< Sectors read from the drive */
+  ef_u64_t  u64SectorsWritten;    /**< Sectors written to the drive */
+  ef_u32_t  u32TrimCmds;          /**< Drive TRIM commands */
+  ef_u32_t  u32SyncCmds;          /**< Drive SYNC commands */
+  ef_u32_t  u32WindowHits;        /**< Volume window loads served without a drive access */
+  ef_u32_t  u32WindowMisses;      /**< Volume window loads reading the drive */
+  ef_u32_t  u32CacheHits;         /**< File sector cache updates served without a drive access */
+  ef_u32_t  u32CacheMisses;       /**< File sector cache updates reading the drive */
+  ef_u32_t  u32FatGets;           /**< FAT entries read */
+  ef_u32_t  u32FatSets;           /**< FAT entries written */
+  ef_u32_t  u32ClustersAllocated; /**< Clusters allocated */
+  ef_u32_t  u32ClustersFreed;     /**< Clusters freed */
+  ef_u32_t  u32LockWaits;         /**< Volume lock requests that found the volume busy */
+} ef_stats_st;
+
+/**
+ *  Number of buckets of a latency histogram, bucket n counts durations of 2^(n-1) to 2^n - 1 ticks
+ */
+#define EF_LATENCY_BUCKETS_NB ( 32 )
+
+/**
+ *  @brief  Public functions timed by the latency histograms (ef_latency_op_et)
+ *          eEF_findfirst() and eEF_findnext() are not timed: they are made of eEF_diropen() and eEF_dirread()
+ *          calls, which are timed and tag the drive commands they issue.
+ */
+typedef enum {
+  EF_LATENCY_MOUNT = 0,   /**< eEF_mount() */
+  EF_LATENCY_UMOUNT,      /**< eEF_umount() */
+  EF_LATENCY_FOPEN,       /**< eEF_fopen() */
+  EF_LATENCY_FCLOSE,      /**< eEF_fclose() */
+  EF_LATENCY_FREAD,       /**< eEF_fread() */
+  EF_LATENCY_FWRITE,      /**< eEF_fwrite() */
+  EF_LATENCY_FSYNC,       /**< eEF_fsync() */
+  EF_LATENCY_FSEEK,       /**< eEF_fseek() */
+  EF_LATENCY_TRUNCATE,    /**< eEF_truncate() */
+  EF_LATENCY_EXPAND,      /**< eEF_expand() */
+  EF_LATENCY_STAT,        /**< eEF_stat() */
+  EF_LATENCY_REMOVE,      /**< eEF_remove() */
+  EF_LATENCY_RENAME,      /**< eEF_rename() */
+  EF_LATENCY_DIRMAKE,     /**< eEF_dirmake() */
+  EF_LATENCY_DIROPEN,     /**< eEF_diropen() */
+  EF_LATENCY_DIRREAD,     /**< eEF_dirread() */
+  EF_LATENCY_GETFREE,     /**< eEF_getfree() */
+  EF_LATENCY_FEXTENTS,    /**< eEF_fextents() */
+  EF_LATENCY_DEFRAG_FILE, /**< eEF_defrag_file() */
+  EF_LATENCY_DEFRAG_VOL,  /**< eEF_defrag_volume() */
+  EF_LATENCY_CHECK,       /**< eEF_check() */
+  EF_LATENCY_OP_NB        /**< Number of timed functions */
+} ef_latency_op_et;
+
+/**
+ *  @brief  Latency histogram of a public function (ef_latency_st)
+ */
+typedef struct ef_latency_struct {
+  ef_u32_t  u32CallsNb;                             /**< Calls timed */
+  ef_u32_t  u32TicksMax;                            /**< Slowest call */
+  ef_u64_t  u64TicksTotal;                          /**< Sum of the durations, for the mean */
+  ef_u32_t  u32Buckets[ EF_LATENCY_BUCKETS_NB ];    /**< Calls per power of two ticks */
+} ef_latency_st;
+
+/**
+ *  @brief  Slow operation reported to the latency callback (ef_latency_event_st)
+ */
+typedef struct ef_latency_event_struct {
+  ef_latency_op_et  eOperation;   /**< Function called */
+  ef_return_et      eResult;      /**< Value returned by the function */
+  ef_u32_t          u32Ticks;     /**< Duration in port timestamp ticks */
+  const void      * pvContext;    /**< File or directory object, or path, given to the function */
+} ef_latency_event_st;
+
+/**
+ *  Slow operation callback, called from the public function before it returns
+ */
+typedef void (xLatencyCallback)( const ef_latency_event_st * pxEvent );
+
+/**
+ *  @brief  Drive commands recorded by the trace (ef_trace_op_et)
+ */
+typedef enum {
+  EF_TRACE_READ = 0,      /**< Sectors read */
+  EF_TRACE_WRITE,         /**< Sectors written */
+  EF_TRACE_TRIM,          /**< Sectors trimmed */
+  EF_TRACE_SYNC,          /**< Write cache flushed, no sector */
+} ef_trace_op_et;
+
+/**
+ *  @brief  Drive command trace record (ef_trace_record_st)
+ */
+typedef struct ef_trace_record_struct {
+  ef_u64_t  u64Sector;      /**< First sector */
+  ef_u32_t  u32Count;       /**< Number of sectors */
+  ef_u32_t  u32Timestamp;   /**< Port timestamp when the command was sent, in ticks */
+  ef_u08_t  u8Operation;    /**< Command, ef_trace_op_et */
+  ef_u08_t  u8Drive;        /**< Physical drive number */
+  ef_u08_t  u8Origin;       /**< Public function the command was issued for, ef_latency_op_et, EF_LATENCY_OP_NB:none */
+  ef_u08_t  u8Result;       /**< Value returned by the drive, ef_return_et */
+} ef_trace_record_st;
+
 /* Local variables ------------------------------------------------------------------------------------------------- */
 /* Public variables ------------------------------------------------------------------------------------------------ */
 /* Local function prototypes---------------------------------------------------------------------------------------- */
@@ -160,6 +314,21 @@ ef_return_et eEF_drive_register (
   ef_drive_functions_st * pxDriveFunctions
 );
 
+/**
+ *  @brief  Get the capabilities of a Drive, read from its driver when it was initialized
+ *
+ *  @param  u8PhyDrvNb  Physical drive number, in registration order
+ *  @param  pxCaps      Pointer to the capabilities to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                 Succeeded
+ *  @retval EF_RET_INVALID_PARAMETER  Given parameter is invalid
+ */
+ef_return_et eEF_drive_caps_get (
+  ef_u08_t            u8PhyDrvNb,
+  ef_drive_caps_st  * pxCaps
+);
+
 /**
  *  @brief  Mount a Logical Drive
  *
@@ -343,6 +512,7 @@ ef_return_et eEF_fread (
  *  @return Function completion
  *  @retval EF_RET_OK                   Succeeded
  *  @retval EF_RET_DISK_ERR             A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_FAT_FULL             The volume is full, the delayed data stays staged
  *  @retval EF_RET_INT_ERR              Assertion failed
  *  @retval EF_RET_NOT_READY            The physical drive cannot work
  *  @retval EF_RET_NO_FILE              Could not find the file
@@ -1088,6 +1258,248 @@ ef_return_et eEF_expand (
   ef_u08_t    u8Opt
 );
 
+/**
+ *  @brief  Get the Physical Layout of a File
+ *          The cluster chain is walked once and merged into runs of consecutive sectors. Runs
+ *          cover whole clusters, the last one may extend past the end of the file. Data staged
+ *          by the delayed allocation is allocated first. The run the file is known to start with
+ *          is not looked up in the FAT, only the clusters after it are.
+ *
+ *  @param  pxFile        Pointer to the file object
+ *  @param  pxExtents     Pointer to the array of runs to fill
+ *  @param  u32ExtentsMax Number of runs the array can hold
+ *  @param  pu32ExtentsNb Pointer to the number of runs of the file to update, may exceed u32ExtentsMax
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_DISK_ERR             A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_INT_ERR              Assertion failed
+ *  @retval EF_RET_INVALID_OBJECT       The file/directory object is invalid
+ *  @retval EF_RET_TIMEOUT              Could not get a grant to access the volume within defined period
+ */
+ef_return_et eEF_fextents (
+  EF_FILE       * pxFile,
+  ef_extent_st  * pxExtents,
+  ef_u32_t        u32ExtentsMax,
+  ef_u32_t      * pu32ExtentsNb
+);
+
+/**
+ *  @brief  Relocate a File or a Directory into one Contiguous Run
+ *          The data is copied to a free run found by the free space search, the new chain is
+ *          flushed before the directory entry is pointed to it, and the old chain is freed last.
+ *          A power loss leaves either the old or the new chain in use, the other one as lost clusters.
+ *          The object must not be open. Open objects are only detected, and rejected with EF_RET_LOCKED,
+ *          when EF_CONF_FILE_LOCK is enabled; otherwise the caller shall close them first, as an open
+ *          file keeps reading and writing its old chain once it is freed.
+ *
+ *  @param  pxPath  Pointer to the file or directory name
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded, or nothing to do (already contiguous, no free run large enough)
+ *  @retval EF_RET_DISK_ERR             A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_INT_ERR              Assertion failed
+ *  @retval EF_RET_NOT_READY            The physical drive cannot work
+ *  @retval EF_RET_NO_FILE              Could not find the file
+ *  @retval EF_RET_NO_PATH              Could not find the pxPath
+ *  @retval EF_RET_INVALID_NAME         The pxPath name format is invalid
+ *  @retval EF_RET_INVALID_DRIVE        The logical drive number is invalid
+ *  @retval EF_RET_NOT_ENABLED          The volume has no work area
+ *  @retval EF_RET_NO_FILESYSTEM        There is no valid FAT volume
+ *  @retval EF_RET_TIMEOUT              Could not get a grant to access the volume within defined period
+ *  @retval EF_RET_LOCKED               The operation is rejected according to the file sharing policy
+ *  @retval EF_RET_NOT_ENOUGH_CORE      LFN working buffer could not be allocated
+ */
+ef_return_et eEF_defrag_file (
+  const TCHAR * pxPath
+);
+
+/**
+ *  @brief  Defragment a Volume Incrementally
+ *          Walks the directory tree from where the previous call stopped and relocates each
+ *          fragmented file or directory like eEF_defrag_file(). Every visited entry costs one step
+ *          and every relocated cluster one more. The call returns once the budget is spent, after
+ *          the object in progress is completed. Open objects are skipped when EF_CONF_FILE_LOCK is
+ *          enabled; otherwise no object shall be open on the volume during the pass.
+ *
+ *  @param  pxPath        Pointer to the logical drive path
+ *  @param  pxState       Pointer to the defragmentation state, zeroed to start a pass
+ *  @param  u32StepBudget Number of steps allowed for this call
+ *  @param  pbDone        Pointer to the pass completion flag to update
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_DISK_ERR             A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_INT_ERR              Assertion failed
+ *  @retval EF_RET_NOT_READY            The physical drive cannot work
+ *  @retval EF_RET_INVALID_DRIVE        The logical drive number is invalid
+ *  @retval EF_RET_NOT_ENABLED          The volume has no work area
+ *  @retval EF_RET_NO_FILESYSTEM        There is no valid FAT volume
+ *  @retval EF_RET_TIMEOUT              Could not get a grant to access the volume within defined period
+ */
+ef_return_et eEF_defrag_volume (
+  const TCHAR   * pxPath,
+  ef_defrag_st  * pxState,
+  ef_u32_t        u32StepBudget,
+  ef_bool_t     * pbDone
+);
+
+/**
+ *  @brief  Check the Consistency of a Volume
+ *          The FAT is read once, sector by sector, and compared with the chains of all the files and
+ *          directories, which are tracked in a bitmap of one bit per cluster. When the bitmap given
+ *          cannot hold all the clusters, the FAT is checked in slices and the directory tree walked
+ *          once per slice. Cross-linked chains, broken chains, lost clusters, wrong file sizes and a
+ *          wrong free cluster count are reported.
+ *          On repair, the volume is checked a second time: lost clusters are freed, broken chains are
+ *          terminated, file sizes are fitted to their chain and the free cluster count is fixed.
+ *          Cross-links are only reported, and when one is found on the volume, broken chains and file
+ *          sizes are only reported too, as cutting a shared chain would damage the other owner.
+ *          No file shall be open on the volume during a repair.
+ *
+ *  @param  pxPath        Pointer to the logical drive path
+ *  @param  pu8Bitmap     Pointer to the working bitmap
+ *  @param  u32BitmapSize Size of the working bitmap in bytes, ( number of clusters + 7 ) / 8 for a single pass
+ *  @param  bRepair       EF_BOOL_TRUE to repair what can be repaired
+ *  @param  pxReport      Pointer to the report to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded, see the report for the inconsistencies found
+ *  @retval EF_RET_DISK_ERR             A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_INT_ERR              Assertion failed
+ *  @retval EF_RET_NOT_READY            The physical drive cannot work
+ *  @retval EF_RET_INVALID_DRIVE        The logical drive number is invalid
+ *  @retval EF_RET_NOT_ENABLED          The volume has no work area
+ *  @retval EF_RET_NO_FILESYSTEM        There is no valid FAT volume
+ *  @retval EF_RET_TIMEOUT              Could not get a grant to access the volume within defined period
+ *  @retval EF_RET_INVALID_PARAMETER    The bitmap is empty
+ */
+ef_return_et eEF_check (
+  const TCHAR * pxPath,
+  ef_u08_t    * pu8Bitmap,
+  ef_u32_t      u32BitmapSize,
+  ef_bool_t     bRepair,
+  ef_check_st * pxReport
+);
+
+/**
+ *  @brief  Get the I/O and Cache Statistics of a Volume
+ *          The volume counters run from the mount, the drive ones from the drive registration, both
+ *          from the last eEF_stats_reset(). They are all zero when EF_CONF_STATS is disabled.
+ *
+ *  @param  pxPath        Pointer to the logical drive path
+ *  @param  pxStats       Pointer to the statistics to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_INT_ERR              Assertion failed
+ *  @retval EF_RET_NOT_READY            The physical drive cannot work
+ *  @retval EF_RET_INVALID_DRIVE        The logical drive number is invalid
+ *  @retval EF_RET_NOT_ENABLED          The volume has no work area
+ *  @retval EF_RET_NO_FILESYSTEM        There is no valid FAT volume
+ *  @retval EF_RET_TIMEOUT              Could not get a grant to access the volume within defined period
+ */
+ef_return_et eEF_stats_get (
+  const TCHAR * pxPath,
+  ef_stats_st * pxStats
+);
+
+/**
+ *  @brief  Reset the I/O and Cache Statistics of a Volume
+ *          The drive counters of the physical drive hosting the volume are reset as well.
+ *
+ *  @param  pxPath        Pointer to the logical drive path
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_INT_ERR              Assertion failed
+ *  @retval EF_RET_NOT_READY            The physical drive cannot work
+ *  @retval EF_RET_INVALID_DRIVE        The logical drive number is invalid
+ *  @retval EF_RET_NOT_ENABLED          The volume has no work area
+ *  @retval EF_RET_NO_FILESYSTEM        There is no valid FAT volume
+ *  @retval EF_RET_TIMEOUT              Could not get a grant to access the volume within defined period
+ */
+ef_return_et eEF_stats_reset (
+  const TCHAR * pxPath
+);
+
+/**
+ *  @brief  Get the Latency Histogram of a Public Function
+ *          The histogram is all zero when EF_CONF_LATENCY is disabled.
+ *
+ *  @param  eOperation    Timed function
+ *  @param  pxLatency     Pointer to the histogram to fill
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_INVALID_PARAMETER    Given parameter is invalid
+ */
+ef_return_et eEF_latency_get (
+  ef_latency_op_et  eOperation,
+  ef_latency_st   * pxLatency
+);
+
+/**
+ *  @brief  Reset the Latency Histograms of all the Public Functions
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ */
+ef_return_et eEF_latency_reset (
+  void
+);
+
+/**
+ *  @brief  Set the Slow Operation Callback
+ *          The callback is called by every timed function lasting u32ThresholdTicks or more.
+ *
+ *  @param  pxCallback          Pointer to the callback, 0 to remove it
+ *  @param  u32ThresholdTicks   Duration in port timestamp ticks from which an operation is reported
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_NOT_ENABLED          EF_CONF_LATENCY is disabled
+ */
+ef_return_et eEF_latency_callback_set (
+  xLatencyCallback  * pxCallback,
+  ef_u32_t            u32ThresholdTicks
+);
+
+/**
+ *  @brief  Start or Stop the Drive Command Trace
+ *          Starting the trace clears the records and the lost count.
+ *
+ *  @param  bEnable       EF_BOOL_TRUE to start recording, EF_BOOL_FALSE to stop
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_NOT_ENABLED          EF_CONF_TRACE is disabled
+ */
+ef_return_et eEF_trace_enable (
+  ef_bool_t bEnable
+);
+
+/**
+ *  @brief  Read the Oldest Records of the Drive Command Trace
+ *          The records read are removed from the trace. The lost count is the number of records
+ *          overwritten since the previous read, it is cleared by the read.
+ *
+ *  @param  pxRecords     Pointer to the records to fill
+ *  @param  u32RecordsMax Number of records pxRecords can hold
+ *  @param  pu32RecordsNb Pointer to the number of records read
+ *  @param  pu32LostNb    Pointer to the number of records lost
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                   Succeeded
+ *  @retval EF_RET_NOT_ENABLED          EF_CONF_TRACE is disabled
+ */
+ef_return_et eEF_trace_read (
+  ef_trace_record_st  * pxRecords,
+  ef_u32_t              u32RecordsMax,
+  ef_u32_t            * pu32RecordsNb,
+  ef_u32_t            * pu32LostNb
+);
+
 /**
  *  @brief  Set Active Codepage for the Path Name
  *
@@ -0,0 +1,325 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_bench.h
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host benchmarks common helpers: backends, drive command counters, timer and PRNG
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+#ifndef EFAT_TEST_BENCH_H
+#define EFAT_TEST_BENCH_H
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <efat.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Path of the benchmark volume
+ */
+#define EF_BENCH_VOLUME           "A:"
+
+/**
+ *  Default seed of the pseudo random generator
+ */
+#define EF_BENCH_SEED_DEFAULT     ( 0x2545F491UL )
+
+/**
+ *  Number of buckets of the free extent histogram, bucket k counts runs of 2^k to 2^(k+1)-1 clusters
+ */
+#define EF_BENCH_HISTOGRAM_NB     ( 21 )
+
+/**
+ *  Erase block size reported by the backends [sectors]
+ */
+#define EF_BENCH_BLOCK_SIZE       ( 8UL )
+
+/**
+ *  First bytes of a drive command trace file
+ */
+#define EF_BENCH_TRACE_MAGIC      ( 0x52544645UL )  /* "EFTR" */
+
+/**
+ *  Version of the drive command trace file format
+ */
+#define EF_BENCH_TRACE_VERSION    ( 1 )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Stop the benchmark with an error message on the first failed call
+ */
+#define EF_BENCH_CHECK( call )                                                        \
+  if ( EF_RET_OK != ( eRetVal = ( call ) ) )                                          \
+  {                                                                                   \
+    printf( "FAILED: %s returned %d (%s:%d)\n", #call, (int) eRetVal, __FILE__, __LINE__ ); \
+    return eRetVal;                                                                   \
+  }
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+
+/**
+ *  @brief  Drive backend used by the benchmarks
+ */
+typedef enum {
+  EF_BENCH_BACKEND_RAM = 0,   /**< RAM disk */
+  EF_BENCH_BACKEND_IMAGE,     /**< Disk image file */
+  EF_BENCH_BACKEND_FLASH,     /**< Flash device simulator, default model */
+  EF_BENCH_BACKEND_STRIPE,    /**< Striped drive over a RAM disk and the flash device simulator */
+} ef_bench_backend_et;
+
+/**
+ *  @brief  Benchmark configuration, from the command line
+ */
+typedef struct {
+  ef_bench_backend_et   eBackend;     /**< Drive backend */
+  const char          * pcImagePath;  /**< Path of the disk image file */
+  ef_bool_t             bImageMap;    /**< Map the disk image in memory */
+  ef_u32_t              u32Seed;      /**< Seed of the pseudo random generator */
+  ef_u32_t              u32DiskMaxMB; /**< Largest disk created [MB], bigger configurations are skipped */
+  ef_u32_t              u32SizeMB;    /**< Data size of the workload [MB] */
+  ef_u32_t              u32Ops;       /**< Number of operations of the random workloads */
+  ef_u32_t              u32SlowMs;    /**< Public function calls slower than this are reported [ms], 0:none */
+  const char          * pcTracePath;  /**< Drive command trace file, 0:no trace */
+  ef_u32_t              u32ReadUs;    /**< Latency added to every read command of the drive [us], 0:none */
+} ef_bench_config_st;
+
+/**
+ *  @brief  Commands received by the drive
+ */
+typedef struct {
+  ef_u32_t  u32ReadCmds;      /**< Number of read commands */
+  ef_u32_t  u32WriteCmds;     /**< Number of write commands */
+  ef_u32_t  u32CtrlCmds;      /**< Number of control commands (sync, trim...) */
+  ef_u64_t  u64SectorsRead;   /**< Number of sectors read */
+  ef_u64_t  u64SectorsWritten;/**< Number of sectors written */
+  ef_u64_t  u64DeviceUs;      /**< Simulated device time [us], flash backend only */
+  ef_u64_t  u64SectorsProgrammed; /**< Sectors programmed in the flash array, flash backend only */
+} ef_bench_counters_st;
+
+/**
+ *  @brief  Free space layout of the benchmark volume
+ */
+typedef struct {
+  ef_u32_t  u32ClusterSize;   /**< Cluster size [bytes] */
+  ef_u32_t  u32ClustersNb;    /**< Number of data clusters */
+  ef_u32_t  u32FreeNb;        /**< Number of free clusters */
+  ef_u32_t  u32RunsNb;        /**< Number of free runs */
+  ef_u32_t  u32RunMax;        /**< Longest free run [clusters] */
+  ef_u32_t  u32Histogram[ EF_BENCH_HISTOGRAM_NB ]; /**< Free runs per power of two length, last one open-ended */
+} ef_bench_free_st;
+
+/**
+ *  @brief  Header of a drive command trace file, followed by the ef_trace_record_st records
+ */
+typedef struct {
+  ef_u32_t  u32Magic;         /**< EF_BENCH_TRACE_MAGIC */
+  ef_u32_t  u32Version;       /**< EF_BENCH_TRACE_VERSION */
+  ef_u32_t  u32RecordSize;    /**< sizeof(ef_trace_record_st) */
+  ef_u32_t  u32SectorSize;    /**< Sector size [bytes] */
+  ef_u32_t  u32TickHz;        /**< Frequency of the record timestamps */
+  ef_u32_t  u32LostNb;        /**< Records lost while tracing, updated when the trace is closed */
+} ef_bench_trace_header_st;
+
+/* Public functions prototypes---------------------------------------------- */
+
+/**
+ *  @brief  Parse the common command line options of the benchmarks
+ *          -b ram|image|flash|stripe  backend, -f path  image file, -m  map the image, -s seed, -d disk max [MB],
+ *          -z data size [MB], -n random operations, -l slow call threshold [ms], -t trace file
+ *
+ *  @param  iArgc     Number of arguments
+ *  @param  ppcArgv   Arguments
+ *  @param  pxConfig  Configuration, preset with the defaults of the benchmark
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK                 Succeeded
+ *  @retval EF_RET_INVALID_PARAMETER  Unknown option, the usage was printed
+ */
+ef_return_et eEFBenchArgsParse (
+  int                   iArgc,
+  char               ** ppcArgv,
+  ef_bench_config_st  * pxConfig
+);
+
+/**
+ *  @brief  Print the configuration of the build and of the benchmark
+ *
+ *  @param  pcName    Name of the benchmark
+ *  @param  pxConfig  Configuration
+ */
+void vEFBenchConfigPrint (
+  const char                * pcName,
+  const ef_bench_config_st  * pxConfig
+);
+
+/**
+ *  @brief  Create, format and mount a fresh benchmark volume
+ *          The disk is sized to hold u32DataMB and the FAT32 minimum cluster count when FAT32 is the only FS type.
+ *
+ *  @param  pxConfig        Configuration
+ *  @param  u32ClusterSize  Cluster size [bytes], 0:default of eEF_mkfs
+ *  @param  u32DataMB       Data to be stored on the volume [MB]
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK             Succeeded
+ *  @retval EF_RET_NOT_ENOUGH_CORE  The disk would be larger than u32DiskMaxMB, configuration skipped
+ *  @retval Others                Error of the drive or of the file system
+ */
+ef_return_et eEFBenchVolumeCreate (
+  const ef_bench_config_st  * pxConfig,
+  ef_u32_t                    u32ClusterSize,
+  ef_u32_t                    u32DataMB
+);
+
+/**
+ *  @brief  Unmount the benchmark volume and release the backend
+ *
+ *  @param  pxConfig  Configuration
+ *
+ *  @return Function completion
+ */
+ef_return_et eEFBenchVolumeRelease (
+  const ef_bench_config_st  * pxConfig
+);
+
+/**
+ *  @brief  Scan the FAT of the benchmark volume for its free runs
+ *
+ *  @param  pxFree  Free space layout to fill
+ *
+ *  @return Function completion
+ */
+ef_return_et eEFBenchFreeScan (
+  ef_bench_free_st  * pxFree
+);
+
+/**
+ *  @brief  Reset the drive command counters
+ */
+void vEFBenchCountersReset (
+  void
+);
+
+/**
+ *  @brief  Get the drive command counters
+ *
+ *  @param  pxCounters  Counters since the last reset
+ */
+void vEFBenchCountersGet (
+  ef_bench_counters_st  * pxCounters
+);
+
+/**
+ *  @brief  Clear the latency histograms and report the calls slower than a threshold
+ *
+ *  @param  u32ThresholdMs  Slow call threshold [ms], 0 reports none
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK   Succeeded
+ */
+ef_return_et eEFBenchLatencyWatch (
+  ef_u32_t  u32ThresholdMs
+);
+
+/**
+ *  @brief  Print the latency of every public function called since eEFBenchLatencyWatch()
+ */
+void vEFBenchLatencyPrint (
+  void
+);
+
+/**
+ *  @brief  Get the name of a timed public function
+ *
+ *  @param  eOperation  Timed function
+ *
+ *  @return Name of the function, "none" for EF_LATENCY_OP_NB and unknown values
+ */
+const char * pcEFBenchLatencyName (
+  ef_latency_op_et  eOperation
+);
+
+/**
+ *  @brief  Start recording the drive commands in the trace file of the configuration, if any
+ *
+ *  @param  pxConfig  Configuration
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK           Succeeded
+ *  @retval EF_RET_NOT_ENABLED  EF_CONF_TRACE is disabled
+ *  @retval EF_RET_DENIED       The trace file could not be created
+ */
+ef_return_et eEFBenchTraceStart (
+  const ef_bench_config_st  * pxConfig
+);
+
+/**
+ *  @brief  Write the remaining records and close the trace file
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK           Succeeded
+ *  @retval EF_RET_DISK_ERR     The trace file could not be written
+ */
+ef_return_et eEFBenchTraceStop (
+  void
+);
+
+/**
+ *  @brief  Get a monotonic time stamp
+ *
+ *  @return Time in seconds
+ */
+double dEFBenchTimeGet (
+  void
+);
+
+/**
+ *  @brief  Seed the pseudo random generator
+ *
+ *  @param  u32Seed   Seed, 0 is replaced by EF_BENCH_SEED_DEFAULT
+ */
+void vEFBenchRandomSeed (
+  ef_u32_t  u32Seed
+);
+
+/**
+ *  @brief  Get the next pseudo random number (xorshift32), the sequence only depends on the seed
+ *
+ *  @return Pseudo random number
+ */
+ef_u32_t u32EFBenchRandom (
+  void
+);
+
+/* ***************************************************************************************************************** */
+#ifdef __cplusplus
+}
+#endif
+#endif /* EFAT_TEST_BENCH_H */
+/* END OF FILE ***************************************************************************************************** */
@@ -339,6 +339,17 @@ ef_return_et eEFPortDriveSDIOCtrl (
     BSP_SD_GetCardInfo( &CardInfo );
     *(ef_u32_t*)pvBuffer = CardInfo.LogBlockSize;
   }
+  else if ( GET_CAPABILITIES == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_drive_caps_st  * pxCaps = (ef_drive_caps_st *) pvBuffer;
+
+    /* The BSP transfers words straight from the buffer, no TRIM command */
+    pxCaps->u32MaxSectors   = 0;
+    pxCaps->u32Alignment    = 4;
+    pxCaps->u32Granularity  = 1;
+    pxCaps->u32Features     = 0;
+  }
   else
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
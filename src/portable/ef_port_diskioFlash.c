@@ -0,0 +1,783 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_port_diskioFlash.c
+ *  @ingroup  group_eFAT_Portable
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Code file for the flash device simulator drive.
+ *
+ *  @note     The drive keeps the sectors in memory like the RAM disk and models the cost of an SD/eMMC device:
+ *            a command overhead, a bus transfer per sector, page reads and programs, block erases. The device
+ *            maps whole erase blocks, so a block written partially is merged with its valid sectors and
+ *            programmed again in a freshly erased block. The write cache holds the blocks being written and
+ *            merges them when it is full or synchronized. The simulated time and the flash operations are read
+ *            with eEFPortDriveFlashStatsGet().
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include "efat.h"
+#include <ef_port_memory.h>
+#include "ef_port_diskio.h"
+#include <stdlib.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Largest number of erase blocks held by the write cache
+ */
+#define EF_PORT_FLASH_CACHE_MAX         ( 64 )
+
+/**
+ *  Default model: 64 MiB device, 4 KiB pages, 512 KiB erase blocks, 4 open blocks, 25 MB/s bus
+ */
+#define EF_PORT_FLASH_DEFAULT_BYTES     ( 64UL * 1024UL * 1024UL )
+#define EF_PORT_FLASH_DEFAULT_PAGE      ( 4096UL )
+#define EF_PORT_FLASH_DEFAULT_BLOCK     ( 512UL * 1024UL )
+#define EF_PORT_FLASH_DEFAULT_CACHE     ( 4 )
+#define EF_PORT_FLASH_DEFAULT_CMD_US    ( 100 )
+#define EF_PORT_FLASH_DEFAULT_XFER_US   ( 20 )
+#define EF_PORT_FLASH_DEFAULT_READ_US   ( 50 )
+#define EF_PORT_FLASH_DEFAULT_PROG_US   ( 400 )
+#define EF_PORT_FLASH_DEFAULT_ERASE_US  ( 3000 )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Test, set and clear a bit of a bitmap
+ */
+#define EF_FLASH_BIT_GET( pu8Map, u32Bit )  ( 0 != ( (pu8Map)[ (u32Bit) >> 3 ] & ( 1U << ( (u32Bit) & 7U ) ) ) )
+#define EF_FLASH_BIT_SET( pu8Map, u32Bit )  ( (pu8Map)[ (u32Bit) >> 3 ] |= (ef_u08_t) ( 1U << ( (u32Bit) & 7U ) ) )
+#define EF_FLASH_BIT_CLR( pu8Map, u32Bit )  ( (pu8Map)[ (u32Bit) >> 3 ] &= (ef_u08_t) ~( 1U << ( (u32Bit) & 7U ) ) )
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+
+/**
+ *  @brief  Erase block held by the write cache
+ */
+typedef struct {
+  ef_bool_t   bUsed;        /**< The entry holds a block */
+  ef_u32_t    u32Block;     /**< Erase block number */
+  ef_u32_t    u32LastUse;   /**< Write command number of the last write, for the LRU replacement */
+  ef_u08_t  * pu8Dirty;     /**< Sectors of the block written since it was cached, one bit per sector */
+} ef_flash_cache_st;
+
+/* Local variables ------------------------------------------------------------------------------------------------- */
+
+/**
+ *  Drive status
+ */
+static ef_return_et             eFlashStatus = EF_RET_DISK_NOINIT;
+
+/**
+ *  Model of the device
+ */
+static ef_port_flash_config_st  xFlashModel;
+
+/**
+ *  The model was configured, else the default one is used
+ */
+static ef_bool_t                bFlashConfigured = EF_BOOL_FALSE;
+
+/**
+ *  Sectors of the device
+ */
+static ef_u08_t               * pu8FlashData = 0;
+
+/**
+ *  Sectors holding data, cleared by TRIM, one bit per sector
+ */
+static ef_u08_t               * pu8FlashValid = 0;
+
+/**
+ *  Write cache, a single entry flushed after every write when the model has no cache
+ */
+static ef_flash_cache_st        xFlashCache[ EF_PORT_FLASH_CACHE_MAX ];
+
+/**
+ *  Write commands received, clock of the LRU replacement
+ */
+static ef_u32_t                 u32FlashWriteNb = 0;
+
+/**
+ *  Simulated activity
+ */
+static ef_port_flash_stats_st   xFlashStats;
+
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Initialize the device, allocating its sectors and the write cache
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveFlashInitialize (
+  void
+);
+
+/**
+ *  @brief  Get Drive Status
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveFlashStatus (
+  void
+);
+
+/**
+ *  @brief  Read Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data buffer to store read data
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to read
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveFlashRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Write Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data to be written
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to write
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveFlashWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+/**
+ *  @brief  Miscellaneous Functions
+ *
+ *  @param  u8Cmd       Control code
+ *  @param  pvBuffer    Buffer to send/receive control data
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveFlashCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+);
+
+/**
+ *  @brief  Check a sector range against the size of the device
+ *
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveFlashRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Merge a cached block: program its pages holding data in an erased block, copying the valid sectors
+ *          that were not rewritten, and erase the block it replaces
+ *
+ *  @param  pxEntry   Cache entry, released
+ */
+static void vEFPortDriveFlashMerge (
+  ef_flash_cache_st * pxEntry
+);
+
+/**
+ *  @brief  Get the cache entry of an erase block, merging the least recently written block if the cache is full
+ *
+ *  @param  u32Block  Erase block number
+ *
+ *  @return Cache entry holding the block
+ */
+static ef_flash_cache_st * pxEFPortDriveFlashCacheGet (
+  ef_u32_t  u32Block
+);
+
+/**
+ *  @brief  Merge every cached block
+ */
+static void vEFPortDriveFlashCacheFlush (
+  void
+);
+
+/**
+ *  @brief  Release the memory of the device
+ */
+static void vEFPortDriveFlashRelease (
+  void
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFPortDriveFlashRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the drive is not initialized */
+  if ( EF_RET_OK != eFlashStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  /* Else, if the range goes past the end of the device */
+  else if (    ( xSector >= xFlashModel.u32SectorNb )
+            || ( u32Count > ( xFlashModel.u32SectorNb - xSector ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static void vEFPortDriveFlashMerge (
+  ef_flash_cache_st * pxEntry
+)
+{
+  ef_u32_t  u32First = pxEntry->u32Block * xFlashModel.u32BlockSize;
+  ef_u32_t  u32PagesRead = 0;
+  ef_u32_t  u32PagesProgrammed = 0;
+
+  for ( ef_u32_t u32Page = 0 ; u32Page < xFlashModel.u32BlockSize ; u32Page += xFlashModel.u32PageSize )
+  {
+    ef_bool_t bDirty = EF_BOOL_FALSE;
+    ef_bool_t bOld = EF_BOOL_FALSE;
+
+    for ( ef_u32_t u32Sector = u32Page ; u32Sector < ( u32Page + xFlashModel.u32PageSize ) ; u32Sector++ )
+    {
+      if ( EF_FLASH_BIT_GET( pxEntry->pu8Dirty, u32Sector ) )
+      {
+        bDirty = EF_BOOL_TRUE;
+      }
+      /* Else, if the sector holds data that was not rewritten, it is copied */
+      else if (    ( ( u32First + u32Sector ) < xFlashModel.u32SectorNb )
+                && ( EF_FLASH_BIT_GET( pu8FlashValid, u32First + u32Sector ) ) )
+      {
+        bOld = EF_BOOL_TRUE;
+        xFlashStats.u64SectorsCopied++;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    /* A page with old data is read before it is programmed again */
+    if ( EF_BOOL_FALSE != bOld )
+    {
+      u32PagesRead++;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    if ( ( EF_BOOL_FALSE != bDirty ) || ( EF_BOOL_FALSE != bOld ) )
+    {
+      u32PagesProgrammed++;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  xFlashStats.u64PagesRead += u32PagesRead;
+  xFlashStats.u64PagesProgrammed += u32PagesProgrammed;
+  xFlashStats.u64BlocksErased++;
+  xFlashStats.u32Merges++;
+  xFlashStats.u64ElapsedUs +=   (ef_u64_t) u32PagesRead * xFlashModel.u32ReadUs
+                              + (ef_u64_t) u32PagesProgrammed * xFlashModel.u32ProgramUs
+                              + xFlashModel.u32EraseUs;
+
+  (void) eEFPortMemZero( pxEntry->pu8Dirty, ( xFlashModel.u32BlockSize + 7 ) / 8 );
+  pxEntry->bUsed = EF_BOOL_FALSE;
+}
+
+static ef_flash_cache_st * pxEFPortDriveFlashCacheGet (
+  ef_u32_t  u32Block
+)
+{
+  ef_u32_t            u32Entries = ( 0 != xFlashModel.u32CacheBlocks ) ? xFlashModel.u32CacheBlocks : 1;
+  ef_flash_cache_st * pxEntry = 0;
+  ef_flash_cache_st * pxOldest = &xFlashCache[ 0 ];
+
+  for ( ef_u32_t u32Index = 0 ; ( 0 == pxEntry ) && ( u32Index < u32Entries ) ; u32Index++ )
+  {
+    if (    ( EF_BOOL_FALSE != xFlashCache[ u32Index ].bUsed )
+         && ( u32Block == xFlashCache[ u32Index ].u32Block ) )
+    {
+      pxEntry = &xFlashCache[ u32Index ];
+    }
+    /* Else, a free entry is taken first, then the least recently written one */
+    else if (    ( EF_BOOL_FALSE != pxOldest->bUsed )
+              && (    ( EF_BOOL_FALSE == xFlashCache[ u32Index ].bUsed )
+                   || ( xFlashCache[ u32Index ].u32LastUse < pxOldest->u32LastUse ) ) )
+    {
+      pxOldest = &xFlashCache[ u32Index ];
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  /* If the block is not cached */
+  if ( 0 == pxEntry )
+  {
+    if ( EF_BOOL_FALSE != pxOldest->bUsed )
+    {
+      vEFPortDriveFlashMerge( pxOldest );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pxEntry = pxOldest;
+    pxEntry->bUsed = EF_BOOL_TRUE;
+    pxEntry->u32Block = u32Block;
+  }
+  else
+  {
+    xFlashStats.u32CacheHits++;
+  }
+  pxEntry->u32LastUse = u32FlashWriteNb;
+
+  return pxEntry;
+}
+
+static void vEFPortDriveFlashCacheFlush (
+  void
+)
+{
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_PORT_FLASH_CACHE_MAX ; u32Index++ )
+  {
+    if ( EF_BOOL_FALSE != xFlashCache[ u32Index ].bUsed )
+    {
+      vEFPortDriveFlashMerge( &xFlashCache[ u32Index ] );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+}
+
+static void vEFPortDriveFlashRelease (
+  void
+)
+{
+  free( pu8FlashData );
+  free( pu8FlashValid );
+  pu8FlashData = 0;
+  pu8FlashValid = 0;
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_PORT_FLASH_CACHE_MAX ; u32Index++ )
+  {
+    free( xFlashCache[ u32Index ].pu8Dirty );
+    xFlashCache[ u32Index ].pu8Dirty = 0;
+    xFlashCache[ u32Index ].bUsed = EF_BOOL_FALSE;
+  }
+}
+
+static ef_return_et eEFPortDriveFlashInitialize (
+  void
+)
+{
+  /* If the drive is not initialized yet */
+  if ( EF_RET_DISK_NOINIT == eFlashStatus )
+  {
+    ef_u32_t  u32Entries;
+    ef_bool_t bAllocated;
+
+    if ( EF_BOOL_FALSE == bFlashConfigured )
+    {
+      (void) eEFPortDriveFlashDefaultGet( &xFlashModel );
+      bFlashConfigured = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    u32Entries = ( 0 != xFlashModel.u32CacheBlocks ) ? xFlashModel.u32CacheBlocks : 1;
+    pu8FlashData = (ef_u08_t *) calloc( xFlashModel.u32SectorNb, xFlashModel.u16SectorSize );
+    pu8FlashValid = (ef_u08_t *) calloc( ( xFlashModel.u32SectorNb + 7 ) / 8, 1 );
+    bAllocated = ( ( 0 != pu8FlashData ) && ( 0 != pu8FlashValid ) ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+    for ( ef_u32_t u32Index = 0 ; u32Index < u32Entries ; u32Index++ )
+    {
+      xFlashCache[ u32Index ].pu8Dirty = (ef_u08_t *) calloc( ( xFlashModel.u32BlockSize + 7 ) / 8, 1 );
+      if ( 0 == xFlashCache[ u32Index ].pu8Dirty )
+      {
+        bAllocated = EF_BOOL_FALSE;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    /* If the memory could not be allocated */
+    if ( EF_BOOL_FALSE == bAllocated )
+    {
+      vEFPortDriveFlashRelease( );
+      eFlashStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+    }
+    else
+    {
+      u32FlashWriteNb = 0;
+      (void) eEFPortMemZero( &xFlashStats, sizeof(xFlashStats) );
+      eFlashStatus = EF_RET_OK;
+    }
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eFlashStatus;
+}
+
+static ef_return_et eEFPortDriveFlashStatus (
+  void
+)
+{
+  return eFlashStatus;
+}
+
+static ef_return_et eEFPortDriveFlashRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et eRetVal = eEFPortDriveFlashRangeCheck( xSector, u32Count );
+
+  /* If the range is valid */
+  if ( EF_RET_OK == eRetVal )
+  {
+    ef_u32_t  u32PagesRead = 0;
+    ef_u32_t  u32Page = (ef_u32_t) xSector / xFlashModel.u32PageSize;
+    ef_u32_t  u32PageLast = (ef_u32_t) ( xSector + u32Count - 1 ) / xFlashModel.u32PageSize;
+
+    (void) eEFPortMemCopy( pu8FlashData + ( (size_t) xSector * xFlashModel.u16SectorSize ),
+                           pu8Buffer,
+                           u32Count * xFlashModel.u16SectorSize );
+    /* Pages without data are answered without reading the array */
+    for ( ; u32Page <= u32PageLast ; u32Page++ )
+    {
+      for ( ef_u32_t u32Sector = u32Page * xFlashModel.u32PageSize ;
+            ( u32Sector < ( ( u32Page + 1 ) * xFlashModel.u32PageSize ) ) && ( u32Sector < xFlashModel.u32SectorNb ) ;
+            u32Sector++ )
+      {
+        if ( EF_FLASH_BIT_GET( pu8FlashValid, u32Sector ) )
+        {
+          u32PagesRead++;
+          break;
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+    }
+    xFlashStats.u32Commands++;
+    xFlashStats.u64SectorsRead += u32Count;
+    xFlashStats.u64PagesRead += u32PagesRead;
+    xFlashStats.u64ElapsedUs +=   xFlashModel.u32CommandUs
+                                + (ef_u64_t) u32Count * xFlashModel.u32TransferUs
+                                + (ef_u64_t) u32PagesRead * xFlashModel.u32ReadUs;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveFlashWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  ef_return_et eRetVal = eEFPortDriveFlashRangeCheck( xSector, u32Count );
+
+  /* If the range is valid */
+  if ( EF_RET_OK == eRetVal )
+  {
+    ef_flash_cache_st * pxEntry = 0;
+
+    (void) eEFPortMemCopy( pu8Buffer,
+                           pu8FlashData + ( (size_t) xSector * xFlashModel.u16SectorSize ),
+                           u32Count * xFlashModel.u16SectorSize );
+    u32FlashWriteNb++;
+    for ( ef_u32_t u32Sector = (ef_u32_t) xSector ; u32Sector < ( (ef_u32_t) xSector + u32Count ) ; u32Sector++ )
+    {
+      ef_u32_t  u32Block = u32Sector / xFlashModel.u32BlockSize;
+
+      if ( ( 0 == pxEntry ) || ( u32Block != pxEntry->u32Block ) )
+      {
+        pxEntry = pxEFPortDriveFlashCacheGet( u32Block );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      EF_FLASH_BIT_SET( pxEntry->pu8Dirty, u32Sector - ( u32Block * xFlashModel.u32BlockSize ) );
+      EF_FLASH_BIT_SET( pu8FlashValid, u32Sector );
+    }
+    xFlashStats.u32Commands++;
+    xFlashStats.u64SectorsWritten += u32Count;
+    xFlashStats.u64ElapsedUs +=   xFlashModel.u32CommandUs
+                                + (ef_u64_t) u32Count * xFlashModel.u32TransferUs;
+    /* Without cache, the blocks are merged before the command completes */
+    if ( 0 == xFlashModel.u32CacheBlocks )
+    {
+      vEFPortDriveFlashCacheFlush( );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveFlashCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_RET_OK != eFlashStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  else if ( CTRL_SYNC == u8Cmd )
+  {
+    xFlashStats.u32Commands++;
+    xFlashStats.u64ElapsedUs += xFlashModel.u32CommandUs;
+    vEFPortDriveFlashCacheFlush( );
+  }
+  else if ( GET_SECTOR_COUNT == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get number of sectors on the disk (DWORD) */
+    *(ef_u32_t*)pvBuffer = xFlashModel.u32SectorNb;
+  }
+  else if ( GET_SECTOR_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get R/W xSector size (WORD) */
+    *(ef_u16_t*)pvBuffer = xFlashModel.u16SectorSize;
+  }
+  else if ( GET_BLOCK_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get erase block size in unit of xSector (DWORD) */
+    *(ef_u32_t*)pvBuffer = xFlashModel.u32BlockSize;
+  }
+  else if ( GET_CAPABILITIES == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_drive_caps_st  * pxCaps = (ef_drive_caps_st *) pvBuffer;
+
+    /* Transfers smaller than a page cost a whole page */
+    pxCaps->u32MaxSectors   = 0;
+    pxCaps->u32Alignment    = 1;
+    pxCaps->u32Granularity  = xFlashModel.u32PageSize;
+    pxCaps->u32Features     = EF_DRIVE_CAP_TRIM;
+  }
+  else if ( CTRL_TRIM == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_lba_t  * pxRange = (ef_lba_t *) pvBuffer;
+
+    /* If the range is not valid */
+    if (    ( pxRange[ 0 ] > pxRange[ 1 ] )
+         || ( EF_RET_OK != eEFPortDriveFlashRangeCheck( pxRange[ 0 ], (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+    }
+    else
+    {
+      /* Trimmed sectors read back as erased and are not copied by the next merges */
+      (void) eEFPortMemZero( pu8FlashData + ( (size_t) pxRange[ 0 ] * xFlashModel.u16SectorSize ),
+                             (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) * xFlashModel.u16SectorSize );
+      for ( ef_u32_t u32Sector = (ef_u32_t) pxRange[ 0 ] ; u32Sector <= (ef_u32_t) pxRange[ 1 ] ; u32Sector++ )
+      {
+        EF_FLASH_BIT_CLR( pu8FlashValid, u32Sector );
+      }
+      for ( ef_u32_t u32Index = 0 ; u32Index < EF_PORT_FLASH_CACHE_MAX ; u32Index++ )
+      {
+        ef_flash_cache_st * pxEntry = &xFlashCache[ u32Index ];
+        ef_u32_t            u32First = pxEntry->u32Block * xFlashModel.u32BlockSize;
+
+        if ( EF_BOOL_FALSE != pxEntry->bUsed )
+        {
+          for ( ef_u32_t u32Sector = 0 ; u32Sector < xFlashModel.u32BlockSize ; u32Sector++ )
+          {
+            if ( ( ( u32First + u32Sector ) >= pxRange[ 0 ] ) && ( ( u32First + u32Sector ) <= pxRange[ 1 ] ) )
+            {
+              EF_FLASH_BIT_CLR( pxEntry->pu8Dirty, u32Sector );
+            }
+            else
+            {
+              EF_CODE_COVERAGE( );
+            }
+          }
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+      xFlashStats.u32Commands++;
+      xFlashStats.u64SectorsTrimmed += pxRange[ 1 ] - pxRange[ 0 ] + 1;
+      xFlashStats.u64ElapsedUs += xFlashModel.u32CommandUs;
+    }
+  }
+  else
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFPortDriveFlashDefaultGet (
+  ef_port_flash_config_st * pxModel
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxModel );
+
+  pxModel->u32SectorNb    = EF_PORT_FLASH_DEFAULT_BYTES / EF_CONF_SECTOR_SIZE;
+  pxModel->u16SectorSize  = EF_CONF_SECTOR_SIZE;
+  pxModel->u32PageSize    = EF_PORT_FLASH_DEFAULT_PAGE / EF_CONF_SECTOR_SIZE;
+  pxModel->u32BlockSize   = EF_PORT_FLASH_DEFAULT_BLOCK / EF_CONF_SECTOR_SIZE;
+  pxModel->u32CacheBlocks = EF_PORT_FLASH_DEFAULT_CACHE;
+  pxModel->u32CommandUs   = EF_PORT_FLASH_DEFAULT_CMD_US;
+  pxModel->u32TransferUs  = ( EF_PORT_FLASH_DEFAULT_XFER_US * EF_CONF_SECTOR_SIZE ) / 512;
+  pxModel->u32ReadUs      = EF_PORT_FLASH_DEFAULT_READ_US;
+  pxModel->u32ProgramUs   = EF_PORT_FLASH_DEFAULT_PROG_US;
+  pxModel->u32EraseUs     = EF_PORT_FLASH_DEFAULT_ERASE_US;
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPortDriveFlashConfigure (
+  const ef_port_flash_config_st * pxModel
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxModel );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If a parameter is invalid */
+  if (    ( 0 == pxModel->u32SectorNb )
+       || ( 0 == pxModel->u16SectorSize )
+       || ( 0 != ( pxModel->u16SectorSize % 512 ) )
+       || ( 0 == pxModel->u32PageSize )
+       || ( 0 == pxModel->u32BlockSize )
+       || ( 0 != ( pxModel->u32BlockSize % pxModel->u32PageSize ) )
+       || ( pxModel->u32CacheBlocks > EF_PORT_FLASH_CACHE_MAX ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    vEFPortDriveFlashRelease( );
+    xFlashModel = *pxModel;
+    bFlashConfigured = EF_BOOL_TRUE;
+    /* Memory is allocated on next initialization */
+    eFlashStatus = EF_RET_DISK_NOINIT;
+  }
+
+  return eRetVal;
+}
+
+ef_return_et eEFPortDriveFlashStatsGet (
+  ef_port_flash_stats_st  * pxStats
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxStats );
+
+  *pxStats = xFlashStats;
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPortDriveFlashStatsReset (
+  void
+)
+{
+  return eEFPortMemZero( &xFlashStats, sizeof(xFlashStats) );
+}
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+
+/**
+ *  @brief  Flash device simulator Drive Functions
+ */
+ef_drive_functions_st xffDriveFunctionsFlash = {
+    /* Pointer to function to Initialize Drive */
+    .pxInitialize  = eEFPortDriveFlashInitialize,
+    /* Pointer to function to Get Disk Status */
+    .pxStatus      = eEFPortDriveFlashStatus,
+    /* Pointer to function to Read Sector(s) */
+    .pxRead        = eEFPortDriveFlashRead,
+    /* Pointer to function to Write Sector(s) */
+    .pxWrite       = eEFPortDriveFlashWrite,
+    /* Pointer to function to I/O control operation */
+    .pxCtrl        = eEFPortDriveFlashCtrl,
+};
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
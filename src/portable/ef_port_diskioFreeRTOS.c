@@ -126,6 +126,36 @@ ef_return_et eEFPortDriveSDIOCtrl (
 static ef_return_et eEFPortDriveSDIOCheckStatus (
   ef_u32_t timeout
 );
+
+/**
+ *  @brief  Read sectors with one DMA command, the buffer must be EF_PORT_SD_DMA_ALIGN aligned
+ *
+ *  @param  pu8Buffer   Pointer to the data buffer to store read data
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to read
+ *
+ *  @return Results of Disk Functions
+ */
+static ef_return_et eEFPortDriveSDIOReadDMA (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Write sectors with one DMA command, the buffer must be EF_PORT_SD_DMA_ALIGN aligned
+ *
+ *  @param  pu8Buffer   Pointer to the data to be written
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to write
+ *
+ *  @return Results of Disk Functions
+ */
+static ef_return_et eEFPortDriveSDIOWriteDMA (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
 /* Private functions ---------------------------------------------------------*/
 
 
@@ -169,6 +199,17 @@ StaticSemaphore_t xSemaphoreBufferSDWrite;
 #define ENABLE_SCRATCH_BUFFER
 /* USER CODE END enableScratchBuffer */
 
+/*
+ * Buffers meeting this alignment are transferred by one multi-block DMA command,
+ * the others go sector by sector through the scratch buffer. The cache maintenance
+ * works on whole 32-byte lines, so it needs line aligned buffers.
+ */
+#if ( 0 != ENABLE_SD_DMA_CACHE_MAINTENANCE )
+#define EF_PORT_SD_DMA_ALIGN  ( 32 )
+#else
+#define EF_PORT_SD_DMA_ALIGN  ( 4 )
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 ALIGN_32BYTES(static ef_u08_t u8ScratchBuffer[ BLOCKSIZE ]); // 32-Byte aligned for cache maintenance
 /* Disk status */
@@ -200,6 +241,85 @@ static ef_return_et eEFPortDriveSDIOCheckStatus (
   return eRetVal;
 }
 
+/* Read sectors with one DMA command and wait for its completion */
+static ef_return_et eEFPortDriveSDIOReadDMA (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* Drop a completion left by an aborted transfer */
+  xSemaphoreTake( xSemaphoreSDRead, ( TickType_t ) 0 );
+
+  if ( MSD_OK != BSP_SD_ReadBlocks_DMA( (ef_u32_t*)pu8Buffer, (ef_u32_t)xSector, u32Count ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+  }
+  else if ( pdTRUE != xSemaphoreTake( xSemaphoreSDRead, ( TickType_t ) EF_PORT_SD_TIMEOUT ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_TIMEOUT_RD );
+  }
+  else if ( EF_RET_OK != eEFPortDriveSDIOCheckStatus(EF_PORT_SD_TIMEOUT) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+  }
+  else if ( 0 != ENABLE_SD_DMA_CACHE_MAINTENANCE )
+  {
+    /*
+     * invalidate the buffer once the DMA is done to get
+     * the actual data instead of the cached one
+     */
+    SCB_InvalidateDCache_by_Addr( (ef_u32_t*)pu8Buffer, u32Count * BLOCKSIZE );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+/* Write sectors with one DMA command and wait for its completion */
+static ef_return_et eEFPortDriveSDIOWriteDMA (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* Drop a completion left by an aborted transfer */
+  xSemaphoreTake( xSemaphoreSDWrite, ( TickType_t ) 0 );
+
+  if ( 0 != ENABLE_SD_DMA_CACHE_MAINTENANCE )
+  {
+    /*
+     * write the cached data back to memory before the DMA reads it
+     */
+    SCB_CleanDCache_by_Addr( (ef_u32_t*)pu8Buffer, u32Count * BLOCKSIZE );
+  }
+  if ( MSD_OK != BSP_SD_WriteBlocks_DMA( (ef_u32_t*)pu8Buffer, (ef_u32_t)xSector, u32Count ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+  }
+  else if ( pdTRUE != xSemaphoreTake( xSemaphoreSDWrite, ( TickType_t ) EF_PORT_SD_TIMEOUT ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_TIMEOUT_WR );
+  }
+  else if ( EF_RET_OK != eEFPortDriveSDIOCheckStatus(EF_PORT_SD_TIMEOUT) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
 /* Initialize a Drive */
 ef_return_et eEFPortDriveSDIOInitialize (
   void
@@ -277,63 +397,23 @@ ef_return_et eEFPortDriveSDIORead (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
   }
+  /* Fast path, the DMA transfers all the sectors straight into the aligned buffer */
+  else if ( 0 == ( (ef_uintptr_t) pu8Buffer & ( EF_PORT_SD_DMA_ALIGN - 1 ) ) )
+  {
+    eRetVal = eEFPortDriveSDIOReadDMA( pu8Buffer, xSector, u32Count );
+  }
   else
   {
     /* Slow path, fetch each xSector a part and memcpy to destination buffer */
-    ef_u32_t  i;
-    ef_u08_t ret = MSD_ERROR;
-
-    for ( i = u32Count ; i != 0 ; i-- )
+    for ( ; ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) ; u32Count-- )
     {
-      xSemaphoreTake( xSemaphoreSDRead, ( TickType_t ) 0 );
-
-//      if  (    ( MSD_OK == BSP_SD_ReadBlocks_DMA( (ef_u32_t*)scratch, (ef_u32_t)xSector++, 1 ) )
-//          && ( pdTRUE == xSemaphoreTake( xSemaphoreSDRead, ( TickType_t ) EF_PORT_SD_TIMEOUT ) )
-//          && ( MSD_OK == BSP_SD_GetCardState( ) )
-//        )
-      ret = MSD_ERROR;
-      if  ( MSD_OK != BSP_SD_ReadBlocks_DMA( (ef_u32_t*)u8ScratchBuffer, (ef_u32_t)xSector++, 1 ) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
-        break;
-      }
-      else if  ( pdTRUE != xSemaphoreTake( xSemaphoreSDRead, ( TickType_t ) EF_PORT_SD_TIMEOUT ) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_TIMEOUT_RD );
-        break;
-      }
-      else if  ( 0 != eEFPortDriveSDIOCheckStatus(EF_PORT_SD_TIMEOUT) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
-        break;
-      }
-      else
+      eRetVal = eEFPortDriveSDIOReadDMA( u8ScratchBuffer, xSector++, 1 );
+      if ( EF_RET_OK == eRetVal )
       {
-        if ( 0 != ENABLE_SD_DMA_CACHE_MAINTENANCE )
-        {
-          /*
-           *
-           * invalidate the scratch buffer before the next read to get
-           * the actual data instead of the cached one
-           */
-          SCB_InvalidateDCache_by_Addr((ef_u32_t*)u8ScratchBuffer, BLOCKSIZE);
-        }
         eEFPortMemCopy( u8ScratchBuffer, pu8Buffer, BLOCKSIZE );
         pu8Buffer += BLOCKSIZE;
-
-        ret = MSD_OK;
       }
     }
-
-    if (    ( 0 == i )
-         && ( MSD_OK == ret ) )
-    {
-      eRetVal = EF_RET_OK;
-    }
-    else
-    {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
-    }
   }
 
   return eRetVal;
@@ -355,48 +435,19 @@ ef_return_et eEFPortDriveSDIOWrite (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
   }
+  /* Fast path, the DMA transfers all the sectors straight from the aligned buffer */
+  else if ( 0 == ( (ef_uintptr_t) pu8Buffer & ( EF_PORT_SD_DMA_ALIGN - 1 ) ) )
+  {
+    eRetVal = eEFPortDriveSDIOWriteDMA( pu8Buffer, xSector, u32Count );
+  }
   else
   {
-    xSemaphoreTake( xSemaphoreSDWrite, ( TickType_t ) 0 );
-
-    /* Slow path, fetch each xSector a part and memcpy to destination buffer */
-    for ( ef_u32_t  i = u32Count ; i != 0 ; i-- )
+    /* Slow path, copy each xSector to the scratch buffer before sending it */
+    for ( ; ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) ; u32Count-- )
     {
-      if ( 0 != ENABLE_SD_DMA_CACHE_MAINTENANCE )
-      {
-        /*
-         * invalidate the scratch buffer before the next write
-         * to get the actual data instead of the cached one
-         */
-        SCB_InvalidateDCache_by_Addr( (ef_u32_t*)u8ScratchBuffer, BLOCKSIZE );
-      }
-      eEFPortMemCopy( pu8Buffer, u8ScratchBuffer, BLOCKSIZE);
+      eEFPortMemCopy( pu8Buffer, u8ScratchBuffer, BLOCKSIZE );
       pu8Buffer += BLOCKSIZE;
-      if ( MSD_OK != BSP_SD_WriteBlocks_DMA( (ef_u32_t*)u8ScratchBuffer, (ef_u32_t)xSector++, 1 ) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
-        break;
-      }
-      else if ( pdTRUE != xSemaphoreTake( xSemaphoreSDWrite, ( TickType_t ) EF_PORT_SD_TIMEOUT ) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_TIMEOUT_WR );
-        break;
-      }
-      else if ( 0 != eEFPortDriveSDIOCheckStatus(EF_PORT_SD_TIMEOUT) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
-        break;
-      }
-      else if ( 1 == i )
-      {
-        eRetVal = EF_RET_OK;
-        break;
-      }
-      else
-      {
-        /* Keep transfering */;
-        EF_CODE_COVERAGE( );
-      }
+      eRetVal = eEFPortDriveSDIOWriteDMA( u8ScratchBuffer, xSector++, 1 );
     }
   }
 
@@ -447,6 +498,15 @@ ef_return_et eEFPortDriveSDIOCtrl (
         eRetVal = EF_RET_OK;
         break;
 
+      /* Get the driver capabilities: aligned buffers get the multi-block DMA, no TRIM command */
+      case GET_CAPABILITIES :
+        ((ef_drive_caps_st*)pvBuffer)->u32MaxSectors  = 0;
+        ((ef_drive_caps_st*)pvBuffer)->u32Alignment   = EF_PORT_SD_DMA_ALIGN;
+        ((ef_drive_caps_st*)pvBuffer)->u32Granularity = 1;
+        ((ef_drive_caps_st*)pvBuffer)->u32Features    = 0;
+        eRetVal = EF_RET_OK;
+        break;
+
       default:
         eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
     }
@@ -0,0 +1,605 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_port_diskioImage.c
+ *  @ingroup  group_eFAT_Portable
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Code file for the disk image file drive.
+ *
+ *  @note     The drive is a disk image file on a POSIX host, accessed with pread()/pwrite() or
+ *            mapped in memory with mmap(). Trimmed sectors are deallocated from the file.
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+/* fallocate() and fdatasync() are GNU extensions */
+#ifndef _GNU_SOURCE
+  #define _GNU_SOURCE
+#endif
+#include "efat.h"
+#include <ef_port_memory.h>
+#include "ef_port_diskio.h"
+
+#if defined( __unix__ )
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Default erase block size of the image, in sectors
+ */
+#define EF_PORT_IMAGE_DEFAULT_BLOCK_SIZE  ( 1 )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+
+/**
+ *  Drive status
+ */
+static ef_return_et eImageStatus = EF_RET_DISK_NOINIT;
+
+/**
+ *  Path of the image file
+ */
+static const char * pcImagePath = 0;
+
+/**
+ *  File descriptor of the image file, -1:not opened
+ */
+static int          iImageFd = -1;
+
+/**
+ *  Image mapped in memory, 0:pread()/pwrite() are used
+ */
+static ef_u08_t   * pu8ImageMap = 0;
+
+/**
+ *  Map the image in memory on initialization
+ */
+static ef_bool_t    bImageMap = EF_BOOL_FALSE;
+
+/**
+ *  Number of sectors of the image
+ */
+static ef_u32_t     u32ImageSectorNb = 0;
+
+/**
+ *  Sector size of the image in bytes
+ */
+static ef_u16_t     u16ImageSectorSize = EF_CONF_SECTOR_SIZE;
+
+/**
+ *  Erase block size of the image in sectors
+ */
+static ef_u32_t     u32ImageBlockSize = EF_PORT_IMAGE_DEFAULT_BLOCK_SIZE;
+
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Open the image file, create or extend it to the configured size, and map it if requested
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveImageInitialize (
+  void
+);
+
+/**
+ *  @brief  Get Drive Status
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveImageStatus (
+  void
+);
+
+/**
+ *  @brief  Read Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data buffer to store read data
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to read
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   R/W Error
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveImageRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Write Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data to be written
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to write
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   R/W Error
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveImageWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+/**
+ *  @brief  Miscellaneous Functions
+ *
+ *  @param  u8Cmd       Control code
+ *  @param  pvBuffer    Buffer to send/receive control data
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   R/W Error
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveImageCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+);
+
+/**
+ *  @brief  Check a sector range against the size of the image
+ *
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveImageRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFPortDriveImageRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the drive is not initialized */
+  if ( EF_RET_OK != eImageStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  /* Else, if the range goes past the end of the image */
+  else if (    ( xSector >= u32ImageSectorNb )
+            || ( u32Count > ( u32ImageSectorNb - xSector ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveImageInitialize (
+  void
+)
+{
+  struct stat xStat;
+
+  /* If the drive is already initialized */
+  if ( EF_RET_DISK_NOINIT != eImageStatus )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if no image was configured */
+  else if ( 0 == pcImagePath )
+  {
+    eImageStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+  }
+  /* Else, if opening the image failed */
+  else if (    ( 0 > ( iImageFd = open( pcImagePath, O_RDWR | O_CREAT, 0644 ) ) )
+            || ( 0 != fstat( iImageFd, &xStat ) ) )
+  {
+    eImageStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+  }
+  else
+  {
+    eImageStatus = EF_RET_OK;
+    /* If the size is taken from the image */
+    if ( 0 == u32ImageSectorNb )
+    {
+      u32ImageSectorNb = (ef_u32_t) ( xStat.st_size / u16ImageSectorSize );
+    }
+    /* Else, if extending the image to the configured size failed */
+    else if (    ( xStat.st_size < ( (off_t) u32ImageSectorNb * u16ImageSectorSize ) )
+              && ( 0 != ftruncate( iImageFd, (off_t) u32ImageSectorNb * u16ImageSectorSize ) ) )
+    {
+      eImageStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* If the image is empty */
+    if ( 0 == u32ImageSectorNb )
+    {
+      eImageStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+    }
+    /* Else, if the image is not mapped */
+    else if ( EF_BOOL_FALSE == bImageMap )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* Else, if mapping the image failed */
+    else if ( MAP_FAILED == ( pu8ImageMap = (ef_u08_t *) mmap( 0,
+                                                               (size_t) u32ImageSectorNb * u16ImageSectorSize,
+                                                               PROT_READ | PROT_WRITE,
+                                                               MAP_SHARED,
+                                                               iImageFd,
+                                                               0 ) ) )
+    {
+      pu8ImageMap = 0;
+      eImageStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* If something failed */
+    if ( EF_RET_OK != eImageStatus )
+    {
+      (void) close( iImageFd );
+      iImageFd = -1;
+      eImageStatus = EF_RET_DISK_NOINIT;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eImageStatus;
+}
+
+static ef_return_et eEFPortDriveImageStatus (
+  void
+)
+{
+  return eImageStatus;
+}
+
+static ef_return_et eEFPortDriveImageRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = eEFPortDriveImageRangeCheck( xSector, u32Count );
+  size_t        xBytesNb = (size_t) u32Count * u16ImageSectorSize;
+  off_t         xOffset = (off_t) xSector * u16ImageSectorSize;
+
+  /* If the range is not valid */
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if the image is mapped */
+  else if ( 0 != pu8ImageMap )
+  {
+    (void) eEFPortMemCopy( pu8ImageMap + xOffset, pu8Buffer, (ef_u32_t) xBytesNb );
+  }
+  else
+  {
+    /* Loop until everything is read, pread() may return less than asked */
+    while ( 0 != xBytesNb )
+    {
+      ssize_t xDone = pread( iImageFd, pu8Buffer, xBytesNb, xOffset );
+
+      /* If the read failed */
+      if ( 0 >= xDone )
+      {
+        /* If interrupted by a signal */
+        if ( ( 0 > xDone ) && ( EINTR == errno ) )
+        {
+          continue;
+        }
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+        break;
+      }
+      pu8Buffer += xDone;
+      xOffset += xDone;
+      xBytesNb -= (size_t) xDone;
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveImageWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  ef_return_et  eRetVal = eEFPortDriveImageRangeCheck( xSector, u32Count );
+  size_t        xBytesNb = (size_t) u32Count * u16ImageSectorSize;
+  off_t         xOffset = (off_t) xSector * u16ImageSectorSize;
+
+  /* If the range is not valid */
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if the image is mapped */
+  else if ( 0 != pu8ImageMap )
+  {
+    (void) eEFPortMemCopy( pu8Buffer, pu8ImageMap + xOffset, (ef_u32_t) xBytesNb );
+  }
+  else
+  {
+    /* Loop until everything is written, pwrite() may write less than asked */
+    while ( 0 != xBytesNb )
+    {
+      ssize_t xDone = pwrite( iImageFd, pu8Buffer, xBytesNb, xOffset );
+
+      /* If the write failed */
+      if ( 0 >= xDone )
+      {
+        /* If interrupted by a signal */
+        if ( ( 0 > xDone ) && ( EINTR == errno ) )
+        {
+          continue;
+        }
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+        break;
+      }
+      pu8Buffer += xDone;
+      xOffset += xDone;
+      xBytesNb -= (size_t) xDone;
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveImageCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_RET_OK != eImageStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  else if ( CTRL_SYNC == u8Cmd )
+  {
+    /* If     the image is mapped
+     *    AND writing back the mapping failed
+     */
+    if (    ( 0 != pu8ImageMap )
+         && ( 0 != msync( pu8ImageMap, (size_t) u32ImageSectorNb * u16ImageSectorSize, MS_SYNC ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+    }
+    /* Else, if flushing the file failed */
+    else if ( 0 != fdatasync( iImageFd ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  else if ( GET_SECTOR_COUNT == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get number of sectors on the disk (DWORD) */
+    *(ef_u32_t*)pvBuffer = u32ImageSectorNb;
+  }
+  else if ( GET_SECTOR_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get R/W xSector size (WORD) */
+    *(ef_u16_t*)pvBuffer = u16ImageSectorSize;
+  }
+  else if ( GET_BLOCK_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get erase block size in unit of xSector (DWORD) */
+    *(ef_u32_t*)pvBuffer = u32ImageBlockSize;
+  }
+  else if ( GET_CAPABILITIES == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_drive_caps_st  * pxCaps = (ef_drive_caps_st *) pvBuffer;
+
+    /* pread()/pwrite() and the mapping take any buffer, from any thread */
+    pxCaps->u32MaxSectors   = 0;
+    pxCaps->u32Alignment    = 1;
+    pxCaps->u32Granularity  = 1;
+    pxCaps->u32Features     = EF_DRIVE_CAP_TRIM | EF_DRIVE_CAP_CONCURRENT;
+  }
+  else if ( CTRL_TRIM == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_lba_t  * pxRange = (ef_lba_t *) pvBuffer;
+
+    /* If the range is not valid */
+    if (    ( pxRange[ 0 ] > pxRange[ 1 ] )
+         || ( EF_RET_OK != eEFPortDriveImageRangeCheck( pxRange[ 0 ], (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+    }
+#if defined( FALLOC_FL_PUNCH_HOLE )
+    /* Else, if deallocating the sectors from the file failed */
+    else if ( 0 != fallocate( iImageFd,
+                              FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                              (off_t) pxRange[ 0 ] * u16ImageSectorSize,
+                              (off_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) * u16ImageSectorSize ) )
+    {
+      /* The file system does not support it, trimming is only a hint */
+      EF_CODE_COVERAGE( );
+    }
+#endif
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  else
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFPortDriveImageConfigure (
+  const char  * pcPath,
+  ef_u32_t      u32SectorNb,
+  ef_u16_t      u16SectorSize,
+  ef_u32_t      u32BlockSize,
+  ef_bool_t     bMap
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If a parameter is invalid */
+  if (    ( 0 == pcPath )
+       || ( 0 == u16SectorSize )
+       || ( 0 != ( u16SectorSize % 512 ) )
+       || ( 0 == u32BlockSize ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  /* Else, if closing the previous image failed */
+  else if ( EF_RET_OK != eEFPortDriveImageClose( ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+  }
+  else
+  {
+    pcImagePath = pcPath;
+    u32ImageSectorNb = u32SectorNb;
+    u16ImageSectorSize = u16SectorSize;
+    u32ImageBlockSize = u32BlockSize;
+    bImageMap = bMap;
+  }
+
+  return eRetVal;
+}
+
+ef_return_et eEFPortDriveImageClose (
+  void
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the image is mapped */
+  if ( 0 != pu8ImageMap )
+  {
+    /* If writing back or unmapping the image failed */
+    if (    ( 0 != msync( pu8ImageMap, (size_t) u32ImageSectorNb * u16ImageSectorSize, MS_SYNC ) )
+         || ( 0 != munmap( pu8ImageMap, (size_t) u32ImageSectorNb * u16ImageSectorSize ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pu8ImageMap = 0;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* If the image is opened */
+  if ( 0 <= iImageFd )
+  {
+    /* If closing the image failed */
+    if ( 0 != close( iImageFd ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    iImageFd = -1;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  eImageStatus = EF_RET_DISK_NOINIT;
+
+  return eRetVal;
+}
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+
+/**
+ *  @brief  Disk image file Drive Functions
+ */
+ef_drive_functions_st xffDriveFunctionsImage = {
+    /* Pointer to function to Initialize Drive */
+    .pxInitialize  = eEFPortDriveImageInitialize,
+    /* Pointer to function to Get Disk Status */
+    .pxStatus      = eEFPortDriveImageStatus,
+    /* Pointer to function to Read Sector(s) */
+    .pxRead        = eEFPortDriveImageRead,
+    /* Pointer to function to Write Sector(s) */
+    .pxWrite       = eEFPortDriveImageWrite,
+    /* Pointer to function to I/O control operation */
+    .pxCtrl        = eEFPortDriveImageCtrl,
+};
+
+#endif /* defined( __unix__ ) */
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,446 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_port_diskioRAM.c
+ *  @ingroup  group_eFAT_Portable
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Code file for the RAM disk drive.
+ *
+ *  @note     The drive is a plain array of sectors in memory. It is meant to run eFAT on a build host,
+ *            for tests and benchmarks, without any storage device.
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include "efat.h"
+#include <ef_port_memory.h>
+#include "ef_port_diskio.h"
+#include <stdlib.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Default number of sectors of the RAM disk
+ */
+#define EF_PORT_RAM_DEFAULT_SECTOR_NB   ( 65536 )
+
+/**
+ *  Default erase block size of the RAM disk, in sectors
+ */
+#define EF_PORT_RAM_DEFAULT_BLOCK_SIZE  ( 1 )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+
+/**
+ *  Drive status
+ */
+static ef_return_et eRAMStatus = EF_RET_DISK_NOINIT;
+
+/**
+ *  Sectors of the RAM disk
+ */
+static ef_u08_t * pu8RAMDisk = 0;
+
+/**
+ *  The RAM disk was allocated by the driver
+ */
+static ef_bool_t  bRAMAllocated = EF_BOOL_FALSE;
+
+/**
+ *  Number of sectors of the RAM disk
+ */
+static ef_u32_t   u32RAMSectorNb = EF_PORT_RAM_DEFAULT_SECTOR_NB;
+
+/**
+ *  Sector size of the RAM disk in bytes
+ */
+static ef_u16_t   u16RAMSectorSize = EF_CONF_SECTOR_SIZE;
+
+/**
+ *  Erase block size of the RAM disk in sectors
+ */
+static ef_u32_t   u32RAMBlockSize = EF_PORT_RAM_DEFAULT_BLOCK_SIZE;
+
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Initialize the RAM disk, allocating it if no memory was given
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveRAMInitialize (
+  void
+);
+
+/**
+ *  @brief  Get Drive Status
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveRAMStatus (
+  void
+);
+
+/**
+ *  @brief  Read Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data buffer to store read data
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to read
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveRAMRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Write Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data to be written
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to write
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveRAMWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+/**
+ *  @brief  Miscellaneous Functions
+ *
+ *  @param  u8Cmd       Control code
+ *  @param  pvBuffer    Buffer to send/receive control data
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveRAMCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+);
+
+/**
+ *  @brief  Check a sector range against the size of the RAM disk
+ *
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveRAMRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFPortDriveRAMRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the drive is not initialized */
+  if ( EF_RET_OK != eRAMStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  /* Else, if the range goes past the end of the disk */
+  else if (    ( xSector >= u32RAMSectorNb )
+            || ( u32Count > ( u32RAMSectorNb - xSector ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveRAMInitialize (
+  void
+)
+{
+  /* If the drive is not initialized yet */
+  if ( EF_RET_DISK_NOINIT == eRAMStatus )
+  {
+    /* If no memory was given */
+    if ( 0 == pu8RAMDisk )
+    {
+      pu8RAMDisk = (ef_u08_t *) calloc( u32RAMSectorNb, u16RAMSectorSize );
+      bRAMAllocated = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* If the memory could not be allocated */
+    if ( 0 == pu8RAMDisk )
+    {
+      bRAMAllocated = EF_BOOL_FALSE;
+      eRAMStatus = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+    }
+    else
+    {
+      eRAMStatus = EF_RET_OK;
+    }
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRAMStatus;
+}
+
+static ef_return_et eEFPortDriveRAMStatus (
+  void
+)
+{
+  return eRAMStatus;
+}
+
+static ef_return_et eEFPortDriveRAMRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et eRetVal = eEFPortDriveRAMRangeCheck( xSector, u32Count );
+
+  /* If the range is valid */
+  if ( EF_RET_OK == eRetVal )
+  {
+    (void) eEFPortMemCopy( pu8RAMDisk + ( (size_t) xSector * u16RAMSectorSize ),
+                           pu8Buffer,
+                           u32Count * u16RAMSectorSize );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveRAMWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  ef_return_et eRetVal = eEFPortDriveRAMRangeCheck( xSector, u32Count );
+
+  /* If the range is valid */
+  if ( EF_RET_OK == eRetVal )
+  {
+    (void) eEFPortMemCopy( pu8Buffer,
+                           pu8RAMDisk + ( (size_t) xSector * u16RAMSectorSize ),
+                           u32Count * u16RAMSectorSize );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveRAMCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_RET_OK != eRAMStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  else if ( CTRL_SYNC == u8Cmd )
+  {
+    /* Nothing is pending, writes are done in place */
+    EF_CODE_COVERAGE( );
+  }
+  else if ( GET_SECTOR_COUNT == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get number of sectors on the disk (DWORD) */
+    *(ef_u32_t*)pvBuffer = u32RAMSectorNb;
+  }
+  else if ( GET_SECTOR_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get R/W xSector size (WORD) */
+    *(ef_u16_t*)pvBuffer = u16RAMSectorSize;
+  }
+  else if ( GET_BLOCK_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get erase block size in unit of xSector (DWORD) */
+    *(ef_u32_t*)pvBuffer = u32RAMBlockSize;
+  }
+  else if ( GET_CAPABILITIES == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_drive_caps_st  * pxCaps = (ef_drive_caps_st *) pvBuffer;
+
+    /* Any transfer is a memory copy */
+    pxCaps->u32MaxSectors   = 0;
+    pxCaps->u32Alignment    = 1;
+    pxCaps->u32Granularity  = 1;
+    pxCaps->u32Features     = EF_DRIVE_CAP_TRIM | EF_DRIVE_CAP_WRITE_ZEROES | EF_DRIVE_CAP_CONCURRENT;
+  }
+  else if ( CTRL_WRITE_ZEROES == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_lba_t  * pxRange = (ef_lba_t *) pvBuffer;
+
+    /* If the range is not valid */
+    if (    ( pxRange[ 0 ] > pxRange[ 1 ] )
+         || ( EF_RET_OK != eEFPortDriveRAMRangeCheck( pxRange[ 0 ], (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+    }
+    else
+    {
+      (void) eEFPortMemZero( pu8RAMDisk + ( (size_t) pxRange[ 0 ] * u16RAMSectorSize ),
+                             (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) * u16RAMSectorSize );
+    }
+  }
+  else if ( CTRL_TRIM == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_lba_t  * pxRange = (ef_lba_t *) pvBuffer;
+
+    /* If the range is not valid */
+    if (    ( pxRange[ 0 ] > pxRange[ 1 ] )
+         || ( EF_RET_OK != eEFPortDriveRAMRangeCheck( pxRange[ 0 ], (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+    }
+    else
+    {
+      /* Trimmed sectors read back as erased */
+      (void) eEFPortMemZero( pu8RAMDisk + ( (size_t) pxRange[ 0 ] * u16RAMSectorSize ),
+                             (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) * u16RAMSectorSize );
+    }
+  }
+  else
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFPortDriveRAMConfigure (
+  ef_u08_t  * pu8Memory,
+  ef_u32_t    u32SectorNb,
+  ef_u16_t    u16SectorSize,
+  ef_u32_t    u32BlockSize
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If a parameter is invalid */
+  if (    ( 0 == u32SectorNb )
+       || ( 0 == u16SectorSize )
+       || ( 0 != ( u16SectorSize % 512 ) )
+       || ( 0 == u32BlockSize ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    /* If the previous disk was allocated by the driver */
+    if ( EF_BOOL_FALSE != bRAMAllocated )
+    {
+      free( pu8RAMDisk );
+      bRAMAllocated = EF_BOOL_FALSE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pu8RAMDisk = pu8Memory;
+    u32RAMSectorNb = u32SectorNb;
+    u16RAMSectorSize = u16SectorSize;
+    u32RAMBlockSize = u32BlockSize;
+    /* Memory is allocated or attached on next initialization */
+    eRAMStatus = EF_RET_DISK_NOINIT;
+  }
+
+  return eRetVal;
+}
+
+ef_u08_t * pu8EFPortDriveRAMMemoryGet (
+  void
+)
+{
+  return pu8RAMDisk;
+}
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+
+/**
+ *  @brief  RAM disk Drive Functions
+ */
+ef_drive_functions_st xffDriveFunctionsRAM = {
+    /* Pointer to function to Initialize Drive */
+    .pxInitialize  = eEFPortDriveRAMInitialize,
+    /* Pointer to function to Get Disk Status */
+    .pxStatus      = eEFPortDriveRAMStatus,
+    /* Pointer to function to Read Sector(s) */
+    .pxRead        = eEFPortDriveRAMRead,
+    /* Pointer to function to Write Sector(s) */
+    .pxWrite       = eEFPortDriveRAMWrite,
+    /* Pointer to function to I/O control operation */
+    .pxCtrl        = eEFPortDriveRAMCtrl,
+};
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
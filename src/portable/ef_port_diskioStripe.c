@@ -0,0 +1,635 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_port_diskioStripe.c
+ *  @ingroup  group_eFAT_Portable
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Code file for the striped (RAID-0) virtual drive.
+ *
+ *  @note     The drive spreads its sectors over two or more registered drives, stripe by stripe: stripe n of
+ *            the virtual drive is stripe n / N of member n % N. Every member access goes through the drive layer,
+ *            so the members keep their own capabilities, bounce buffers, counters and trace records.
+ *            A transfer is split at the stripe boundaries and sent as one command per stripe, one after the
+ *            other: a single request is not faster than on one member. The members only work in parallel for
+ *            concurrent tasks, the reads of the virtual drive overlap when every member reports
+ *            EF_DRIVE_CAP_CONCURRENT.
+ *            The members are initialized by the virtual drive, the virtual drive must not be one of them.
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include "efat.h"
+#include "ef_prv_def.h"
+#include "ef_prv_drive.h"
+#include "ef_port_diskio.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Features of the virtual drive available when every member has them
+ */
+#define EF_PORT_STRIPE_FEATURES ( EF_DRIVE_CAP_TRIM | EF_DRIVE_CAP_WRITE_ZEROES | EF_DRIVE_CAP_CONCURRENT )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+
+/**
+ *  Drive status
+ */
+static ef_return_et             eStripeStatus = EF_RET_DISK_NOINIT;
+
+/**
+ *  Member drives and stripe size
+ */
+static ef_port_stripe_config_st xStripeConfig;
+
+/**
+ *  The members were configured
+ */
+static ef_bool_t                bStripeConfigured = EF_BOOL_FALSE;
+
+/**
+ *  Sectors of the virtual drive: as many stripes on every member as the smallest one holds
+ */
+static ef_u32_t                 u32StripeSectorNb = 0;
+
+/**
+ *  Largest erase block of the members [sectors]
+ */
+static ef_u32_t                 u32StripeBlockSize = 1;
+
+/**
+ *  Largest transfer granularity of the members [sectors]
+ */
+static ef_u32_t                 u32StripeGranularity = 1;
+
+/**
+ *  Features shared by all the members
+ */
+static ef_u32_t                 u32StripeFeatures = 0;
+
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Initialize the members and get the geometry of the virtual drive
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveStripeInitialize (
+  void
+);
+
+/**
+ *  @brief  Get Drive Status, the first member not ready gives its status
+ *
+ *  @return Status of Disk Functions
+ */
+static ef_return_et eEFPortDriveStripeStatus (
+  void
+);
+
+/**
+ *  @brief  Read Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data buffer to store read data
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to read
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   R/W Error of a member
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveStripeRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Write Sector(s)
+ *
+ *  @param  pu8Buffer   Pointer to the data to be written
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors to write
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   R/W Error of a member
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveStripeWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+/**
+ *  @brief  Miscellaneous Functions
+ *
+ *  @param  u8Cmd       Control code
+ *  @param  pvBuffer    Buffer to send/receive control data
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_ERROR   Error of a member
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveStripeCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+);
+
+/**
+ *  @brief  Check a sector range against the size of the virtual drive
+ *
+ *  @param  xSector     Start xSector in LBA
+ *  @param  u32Count    Number of sectors
+ *
+ *  @return Results of Disk Functions
+ *  @retval EF_RET_OK           Successful
+ *  @retval EF_RET_DISK_NOTRDY  Not Ready
+ *  @retval EF_RET_DISK_PARERR  Invalid Parameter
+ */
+static ef_return_et eEFPortDriveStripeRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+/**
+ *  @brief  Get the member holding a sector of the virtual drive and its place on that member
+ *
+ *  @param  xSector     Sector of the virtual drive
+ *  @param  pu8Member   Index of the member in the configuration
+ *
+ *  @return Sector of the member
+ */
+static ef_lba_t xEFPortDriveStripeMap (
+  ef_lba_t    xSector,
+  ef_u08_t  * pu8Member
+);
+
+/**
+ *  @brief  Get the sectors of a member inside a range of the virtual drive, they are contiguous on the member
+ *
+ *  @param  u8Member    Index of the member in the configuration
+ *  @param  pxRange     First and last sectors of the virtual drive
+ *  @param  pxMember    First and last sectors of the member to fill
+ *
+ *  @return EF_BOOL_TRUE if the member holds sectors of the range
+ */
+static ef_bool_t bEFPortDriveStripeMemberRange (
+  ef_u08_t          u8Member,
+  const ef_lba_t  * pxRange,
+  ef_lba_t        * pxMember
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFPortDriveStripeRangeCheck (
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the drive is not initialized */
+  if ( EF_RET_OK != eStripeStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  /* Else, if the range goes past the end of the drive */
+  else if (    ( xSector >= u32StripeSectorNb )
+            || ( u32Count > ( u32StripeSectorNb - xSector ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static ef_lba_t xEFPortDriveStripeMap (
+  ef_lba_t    xSector,
+  ef_u08_t  * pu8Member
+)
+{
+  ef_lba_t  xStripe = xSector / xStripeConfig.u32StripeSize;
+
+  *pu8Member = (ef_u08_t) ( xStripe % xStripeConfig.u8DrivesNb );
+
+  return   ( ( xStripe / xStripeConfig.u8DrivesNb ) * xStripeConfig.u32StripeSize )
+         + ( xSector % xStripeConfig.u32StripeSize );
+}
+
+static ef_bool_t bEFPortDriveStripeMemberRange (
+  ef_u08_t          u8Member,
+  const ef_lba_t  * pxRange,
+  ef_lba_t        * pxMember
+)
+{
+  ef_u32_t  u32Size = xStripeConfig.u32StripeSize;
+  ef_u08_t  u8DrivesNb = xStripeConfig.u8DrivesNb;
+  ef_lba_t  xStripeFirst = pxRange[ 0 ] / u32Size;
+  ef_lba_t  xStripeLast = pxRange[ 1 ] / u32Size;
+  ef_lba_t  xFirst = pxRange[ 0 ];
+  ef_lba_t  xLast = pxRange[ 1 ];
+  ef_u08_t  u8Dummy;
+  ef_bool_t bFound = EF_BOOL_FALSE;
+
+  /* First sector of the member at or after the start of the range */
+  if ( u8Member != ( xStripeFirst % u8DrivesNb ) )
+  {
+    xStripeFirst += ( u8Member + u8DrivesNb - ( xStripeFirst % u8DrivesNb ) ) % u8DrivesNb;
+    xFirst = xStripeFirst * u32Size;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Last sector of the member at or before the end of the range */
+  if ( u8Member != ( xStripeLast % u8DrivesNb ) )
+  {
+    if ( xStripeLast >= ( ( ( xStripeLast % u8DrivesNb ) + u8DrivesNb - u8Member ) % u8DrivesNb ) )
+    {
+      xStripeLast -= ( ( xStripeLast % u8DrivesNb ) + u8DrivesNb - u8Member ) % u8DrivesNb;
+      xLast = ( xStripeLast * u32Size ) + u32Size - 1;
+    }
+    else
+    {
+      /* No stripe of the member before the end */
+      xFirst = xLast + 1;
+    }
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  if ( xFirst <= xLast )
+  {
+    pxMember[ 0 ] = xEFPortDriveStripeMap( xFirst, &u8Dummy );
+    pxMember[ 1 ] = xEFPortDriveStripeMap( xLast, &u8Dummy );
+    bFound = EF_BOOL_TRUE;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return bFound;
+}
+
+static ef_return_et eEFPortDriveStripeInitialize (
+  void
+)
+{
+  ef_return_et      eRetVal = EF_RET_OK;
+  ef_u32_t          u32MemberSectorNb = 0xFFFFFFFFUL;
+  ef_u32_t          u32Value;
+  ef_u16_t          u16SectorSize;
+  ef_drive_caps_st  xCaps;
+
+  /* If the members are not known */
+  if ( EF_BOOL_FALSE == bStripeConfigured )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+  }
+  else
+  {
+    u32StripeBlockSize = 1;
+    u32StripeGranularity = 1;
+    u32StripeFeatures = EF_PORT_STRIPE_FEATURES;
+    for ( ef_u08_t u8Member = 0 ; ( EF_RET_OK == eRetVal ) && ( u8Member < xStripeConfig.u8DrivesNb ) ; u8Member++ )
+    {
+      ef_u08_t  u8Drive = xStripeConfig.u8Drives[ u8Member ];
+
+      /* If the member cannot be used: not ready, other sector size or unknown size */
+      if (    ( EF_RET_OK != eEFPrvDriveInitialize( u8Drive ) )
+           || ( EF_RET_OK != eEFPrvDriveIOCtrl( u8Drive, GET_SECTOR_SIZE, &u16SectorSize ) )
+           || ( EF_CONF_SECTOR_SIZE != u16SectorSize )
+           || ( EF_RET_OK != eEFPrvDriveIOCtrl( u8Drive, GET_SECTOR_COUNT, &u32Value ) )
+           || ( EF_RET_OK != eEFPrvDriveCapsGet( u8Drive, &xCaps ) ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+      }
+      else
+      {
+        u32MemberSectorNb = ( u32Value < u32MemberSectorNb ) ? u32Value : u32MemberSectorNb;
+        u32StripeGranularity = ( xCaps.u32Granularity > u32StripeGranularity ) ? xCaps.u32Granularity
+                                                                                : u32StripeGranularity;
+        u32StripeFeatures &= xCaps.u32Features;
+        if (    ( EF_RET_OK == eEFPrvDriveIOCtrl( u8Drive, GET_BLOCK_SIZE, &u32Value ) )
+             && ( u32Value > u32StripeBlockSize ) )
+        {
+          u32StripeBlockSize = u32Value;
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+    }
+    /* Whole stripes only */
+    u32MemberSectorNb -= u32MemberSectorNb % xStripeConfig.u32StripeSize;
+    if ( EF_RET_OK != eRetVal )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* Else, if the size of the virtual drive does not fit in a DWORD */
+    else if ( u32MemberSectorNb > ( 0xFFFFFFFFUL / xStripeConfig.u8DrivesNb ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOINIT );
+    }
+    else
+    {
+      u32StripeSectorNb = u32MemberSectorNb * xStripeConfig.u8DrivesNb;
+    }
+  }
+  eStripeStatus = eRetVal;
+
+  return eStripeStatus;
+}
+
+static ef_return_et eEFPortDriveStripeStatus (
+  void
+)
+{
+  ef_return_et  eRetVal = eStripeStatus;
+
+  for ( ef_u08_t u8Member = 0 ; ( EF_RET_OK == eRetVal ) && ( u8Member < xStripeConfig.u8DrivesNb ) ; u8Member++ )
+  {
+    eRetVal = eEFPrvDriveStatus( xStripeConfig.u8Drives[ u8Member ] );
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveStripeRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = eEFPortDriveStripeRangeCheck( xSector, u32Count );
+  ef_lba_t      xMemberSector;
+  ef_u08_t      u8Member;
+  ef_u32_t      u32Chunk;
+
+  /* One command per stripe, the members in turn */
+  while ( ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) )
+  {
+    u32Chunk = xStripeConfig.u32StripeSize - (ef_u32_t) ( xSector % xStripeConfig.u32StripeSize );
+    u32Chunk = ( u32Chunk < u32Count ) ? u32Chunk : u32Count;
+    xMemberSector = xEFPortDriveStripeMap( xSector, &u8Member );
+    if ( EF_RET_OK != eEFPrvDriveRead( xStripeConfig.u8Drives[ u8Member ], pu8Buffer, xMemberSector, u32Chunk ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pu8Buffer += u32Chunk * EF_CONF_SECTOR_SIZE;
+    xSector += u32Chunk;
+    u32Count -= u32Chunk;
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveStripeWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  ef_return_et  eRetVal = eEFPortDriveStripeRangeCheck( xSector, u32Count );
+  ef_lba_t      xMemberSector;
+  ef_u08_t      u8Member;
+  ef_u32_t      u32Chunk;
+
+  /* One command per stripe, the members in turn */
+  while ( ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) )
+  {
+    u32Chunk = xStripeConfig.u32StripeSize - (ef_u32_t) ( xSector % xStripeConfig.u32StripeSize );
+    u32Chunk = ( u32Chunk < u32Count ) ? u32Chunk : u32Count;
+    xMemberSector = xEFPortDriveStripeMap( xSector, &u8Member );
+    if ( EF_RET_OK != eEFPrvDriveWrite( xStripeConfig.u8Drives[ u8Member ], pu8Buffer, xMemberSector, u32Chunk ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pu8Buffer += u32Chunk * EF_CONF_SECTOR_SIZE;
+    xSector += u32Chunk;
+    u32Count -= u32Chunk;
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPortDriveStripeCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_RET_OK != eStripeStatus )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_NOTRDY );
+  }
+  else if ( CTRL_SYNC == u8Cmd )
+  {
+    /* Every member is synchronized, the first failure is reported */
+    for ( ef_u08_t u8Member = 0 ; u8Member < xStripeConfig.u8DrivesNb ; u8Member++ )
+    {
+      if (    ( EF_RET_OK != eEFPrvDriveIOCtrl( xStripeConfig.u8Drives[ u8Member ], CTRL_SYNC, 0 ) )
+           && ( EF_RET_OK == eRetVal ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+  else if ( GET_SECTOR_COUNT == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get number of sectors on the disk (DWORD) */
+    *(ef_u32_t*)pvBuffer = u32StripeSectorNb;
+  }
+  else if ( GET_SECTOR_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get R/W xSector size (WORD) */
+    *(ef_u16_t*)pvBuffer = EF_CONF_SECTOR_SIZE;
+  }
+  else if ( GET_BLOCK_SIZE == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    /* Get erase block size in unit of xSector (DWORD): a row of stripes, or of erase blocks when larger */
+    *(ef_u32_t*)pvBuffer =   xStripeConfig.u8DrivesNb
+                           * ( ( u32StripeBlockSize > xStripeConfig.u32StripeSize ) ? u32StripeBlockSize
+                                                                                    : xStripeConfig.u32StripeSize );
+  }
+  else if ( GET_CAPABILITIES == u8Cmd )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_drive_caps_st  * pxCaps = (ef_drive_caps_st *) pvBuffer;
+
+    /* Transfers are split by stripe, the members bounce their own buffers */
+    pxCaps->u32MaxSectors   = 0;
+    pxCaps->u32Alignment    = 1;
+    pxCaps->u32Granularity  = u32StripeGranularity;
+    pxCaps->u32Features     = u32StripeFeatures;
+  }
+  else if ( ( CTRL_TRIM == u8Cmd ) || ( CTRL_WRITE_ZEROES == u8Cmd ) )
+  {
+    EF_ASSERT_PRIVATE( 0 != pvBuffer );
+    ef_lba_t  * pxRange = (ef_lba_t *) pvBuffer;
+    ef_lba_t    xMemberRange[ 2 ];
+
+    /* If the range is not valid */
+    if (    ( pxRange[ 0 ] > pxRange[ 1 ] )
+         || ( EF_RET_OK != eEFPortDriveStripeRangeCheck( pxRange[ 0 ], (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ) ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+    }
+    else
+    {
+      /* One command per member, its sectors of the range are contiguous */
+      for ( ef_u08_t u8Member = 0 ;
+            ( EF_RET_OK == eRetVal ) && ( u8Member < xStripeConfig.u8DrivesNb ) ;
+            u8Member++ )
+      {
+        if ( EF_BOOL_FALSE == bEFPortDriveStripeMemberRange( u8Member, pxRange, xMemberRange ) )
+        {
+          EF_CODE_COVERAGE( );
+        }
+        else if ( EF_RET_OK != eEFPrvDriveIOCtrl( xStripeConfig.u8Drives[ u8Member ], u8Cmd, xMemberRange ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERROR );
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+    }
+  }
+  else
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFPortDriveStripeConfigure (
+  const ef_port_stripe_config_st  * pxConfig
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxConfig );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the number of members or the stripe size is invalid */
+  if (    ( 2 > pxConfig->u8DrivesNb )
+       || ( EF_PORT_STRIPE_DRIVES_MAX < pxConfig->u8DrivesNb )
+       || ( 0 == pxConfig->u32StripeSize ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+  }
+  else
+  {
+    /* A member must be a valid drive, used once */
+    for ( ef_u08_t u8Member = 0 ; ( EF_RET_OK == eRetVal ) && ( u8Member < pxConfig->u8DrivesNb ) ; u8Member++ )
+    {
+      if ( EF_CONF_DRIVERS_NB <= pxConfig->u8Drives[ u8Member ] )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+      }
+      else
+      {
+        for ( ef_u08_t u8Other = 0 ; u8Other < u8Member ; u8Other++ )
+        {
+          if ( pxConfig->u8Drives[ u8Other ] == pxConfig->u8Drives[ u8Member ] )
+          {
+            eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_PARERR );
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+        }
+      }
+    }
+  }
+  if ( EF_RET_OK == eRetVal )
+  {
+    xStripeConfig = *pxConfig;
+    bStripeConfigured = EF_BOOL_TRUE;
+    /* The geometry is read on next initialization */
+    eStripeStatus = EF_RET_DISK_NOINIT;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+
+/**
+ *  @brief  Striped virtual Drive Functions
+ */
+ef_drive_functions_st xffDriveFunctionsStripe = {
+    /* Pointer to function to Initialize Drive */
+    .pxInitialize  = eEFPortDriveStripeInitialize,
+    /* Pointer to function to Get Disk Status */
+    .pxStatus      = eEFPortDriveStripeStatus,
+    /* Pointer to function to Read Sector(s) */
+    .pxRead        = eEFPortDriveStripeRead,
+    /* Pointer to function to Write Sector(s) */
+    .pxWrite       = eEFPortDriveStripeWrite,
+    /* Pointer to function to I/O control operation */
+    .pxCtrl        = eEFPortDriveStripeCtrl,
+};
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -63,6 +63,40 @@ ef_return_et eEFPortMemCopy (
   return EF_RET_OK;
 }
 
+/* Copy memory to overlapping memory */
+ef_return_et eEFPortMemMove (
+  const void  * pvSrc,
+  void        * pvDst,
+  ef_u32_t      u32BytesNb
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pvSrc );
+  EF_ASSERT_PRIVATE( 0 != pvDst );
+
+  ef_u08_t       * pu8Dst = (ef_u08_t*) pvDst;
+  const ef_u08_t * pu8Src = (const ef_u08_t*) pvSrc;
+
+  /* Copy from the end when the destination is after the source */
+  if ( pu8Dst > pu8Src )
+  {
+    pu8Dst += u32BytesNb;
+    pu8Src += u32BytesNb;
+    for ( ef_u32_t i = u32BytesNb ; 0 != i ; i-- )
+    {
+      *--pu8Dst = *--pu8Src;
+    }
+  }
+  else
+  {
+    for ( ef_u32_t i = u32BytesNb ; 0 != i ; i-- )
+    {
+      *pu8Dst++ = *pu8Src++;
+    }
+  }
+
+  return EF_RET_OK;
+}
+
 /* Set memory to zero */
 ef_return_et eEFPortMemZero (
   void    * pvDst,
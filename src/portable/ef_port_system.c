@@ -28,14 +28,117 @@
 #include <efat.h>
 #include "ef_prv_def.h"
 #include "stdio.h"
+#if ( ( 0 != EF_CONF_LATENCY ) || ( 0 != EF_CONF_TRACE ) || ( 0 != EF_CONF_PORT_PTHREAD ) ) && !defined( __ARM_ARCH_7M__ ) && !defined( __ARM_ARCH_7EM__ )
+#include <time.h>
+#endif
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+/**
+ *  POSIX threads sync object: the volume is owned exclusively by one task or shared by several, the others
+ *  wait on the conditions. A volume given while tasks wait is handed over to them, so the task giving it cannot
+ *  take it back at once and starve the waiting ones.
+ */
+struct ef_port_sync_struct
+{
+  pthread_mutex_t xMutex;             /**< Protects the fields below */
+  pthread_cond_t  xCondition;         /**< Signaled when the volume is handed over to an exclusive waiter */
+  pthread_cond_t  xShared;            /**< Broadcast when the volume is handed over to the shared waiters */
+  ef_bool_t       bTaken;             /**< A task owns the volume exclusively */
+  ef_u32_t        u32Waiters;         /**< Number of tasks waiting for the exclusive volume */
+  ef_u32_t        u32Handovers;       /**< Volume given to the exclusive waiters, not yet picked up */
+  ef_u32_t        u32Sharers;         /**< Number of tasks owning the volume shared */
+  ef_u32_t        u32SharedWaiters;   /**< Number of tasks waiting for the shared volume */
+  ef_u32_t        u32SharedHandovers; /**< Volume given to the shared waiters, not yet picked up */
+};
+#endif
 
 /* FreeRTOS */
 //static const EF_SYNC_t xffSyncObjects[ EF_CONF_VOLUMES_NB ];  /** Table of FreeRTOS mutex */
 /* CMSIS-RTOS */
 //static const EF_SYNC_t xffSyncObjects[ EF_CONF_VOLUMES_NB ];  /** Table of CMSIS-RTOS mutex */
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+/* POSIX threads */
+static struct ef_port_sync_struct xffSyncObjects[ EF_CONF_VOLUMES_NB ];
+static pthread_mutex_t xffCriticalMutex = PTHREAD_MUTEX_INITIALIZER;
+#else
 /* DEFAULT NO RTOS */
 //const EF_SYNC_t xffSyncObjects[ EF_CONF_VOLUMES_NB ] = { 0 };
 ef_u08_t u8ffSyncObjects[ EF_CONF_VOLUMES_NB ] = { 0 };
+#endif
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+/* Get the end of the wait for a volume, on the monotonic clock */
+static void vEFPortSyncDeadlineGet (
+  struct timespec * pxDeadline
+)
+{
+  (void) clock_gettime( CLOCK_MONOTONIC, pxDeadline );
+  pxDeadline->tv_sec  += EF_CONF_TIMEOUT / 1000;
+  pxDeadline->tv_nsec += ( EF_CONF_TIMEOUT % 1000 ) * 1000000L;
+  if ( 1000000000L <= pxDeadline->tv_nsec )
+  {
+    pxDeadline->tv_sec++;
+    pxDeadline->tv_nsec -= 1000000000L;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+}
+
+/* Let every task waiting for the shared volume in, the mutex of the sync object being held */
+static void vEFPortSyncSharedHandover (
+  struct ef_port_sync_struct  * pxSync
+)
+{
+  ef_u32_t  u32Waiting = pxSync->u32SharedWaiters - pxSync->u32SharedHandovers;
+
+  if ( 0 != u32Waiting )
+  {
+    pxSync->u32Sharers          += u32Waiting;
+    pxSync->u32SharedHandovers  += u32Waiting;
+    (void) pthread_cond_broadcast( &pxSync->xShared );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+}
+#endif
+
+#if ( 0 != EF_CONF_LATENCY ) || ( 0 != EF_CONF_TRACE )
+/* Get a High Resolution Timestamp */
+ef_u32_t u32EFPortTimestampGet (
+  void
+)
+{
+  ef_u32_t u32Timestamp;
+
+#if defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ )
+  /* Cortex-M3/M4/M7: DWT cycle counter, enabled on first use */
+  volatile ef_u32_t * pu32DEMCR   = (volatile ef_u32_t *) 0xE000EDFC;
+  volatile ef_u32_t * pu32DWTCtrl = (volatile ef_u32_t *) 0xE0001000;
+  volatile ef_u32_t * pu32CYCCNT  = (volatile ef_u32_t *) 0xE0001004;
+
+  if ( 0 == ( 0x00000001 & *pu32DWTCtrl ) )
+  {
+    *pu32DEMCR   |= 0x01000000;   /* TRCENA */
+    *pu32CYCCNT   = 0;
+    *pu32DWTCtrl |= 0x00000001;   /* CYCCNTENA */
+  }
+  u32Timestamp = *pu32CYCCNT;
+#else
+  /* Host: monotonic clock in microseconds */
+  struct timespec xTime;
+
+  (void) clock_gettime( CLOCK_MONOTONIC, &xTime );
+  u32Timestamp = (ef_u32_t) ( (ef_u64_t) xTime.tv_sec * 1000000 + (ef_u64_t) xTime.tv_nsec / 1000 );
+#endif
+
+  return u32Timestamp;
+}
+#endif
+
 
 /* Create a Synchronization Object */
 ef_return_et eEFPortSyncObjectCreate (
@@ -44,8 +147,9 @@ ef_return_et eEFPortSyncObjectCreate (
 )
 {
   EF_ASSERT_PRIVATE( 0 != pxSyncObject );
+  EF_ASSERT_PRIVATE( EF_CONF_VOLUMES_NB > u8Volume );
 
-//  ef_return_et  eRetVal = EF_RET_ERROR;
+  ef_return_et  eRetVal = EF_RET_OK;
   /* FreeRTOS */
 //  *pxSyncObject = xSemaphoreCreateMutex();
 //  return (int)(*xSyncObject != NULL);
@@ -54,13 +158,54 @@ ef_return_et eEFPortSyncObjectCreate (
 //  *pxSyncObject = osMutexCreate( &Mutex[ u8Volume ] );
 //  return (int)(*xSyncObject != NULL);
 
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  struct ef_port_sync_struct  * pxSync = &xffSyncObjects[ u8Volume ];
+  pthread_condattr_t            xConditionAttr;
+
+  pxSync->bTaken              = EF_BOOL_FALSE;
+  pxSync->u32Waiters          = 0;
+  pxSync->u32Handovers        = 0;
+  pxSync->u32Sharers          = 0;
+  pxSync->u32SharedWaiters    = 0;
+  pxSync->u32SharedHandovers  = 0;
+  if ( 0 != pthread_mutex_init( &pxSync->xMutex, 0 ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else if ( 0 != pthread_condattr_init( &xConditionAttr ) )
+  {
+    (void) pthread_mutex_destroy( &pxSync->xMutex );
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    /* The timeout is measured on the monotonic clock, not on the settable real time clock */
+    if (    ( 0 != pthread_condattr_setclock( &xConditionAttr, CLOCK_MONOTONIC ) )
+         || ( 0 != pthread_cond_init( &pxSync->xCondition, &xConditionAttr ) ) )
+    {
+      (void) pthread_mutex_destroy( &pxSync->xMutex );
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+    }
+    else if ( 0 != pthread_cond_init( &pxSync->xShared, &xConditionAttr ) )
+    {
+      (void) pthread_cond_destroy( &pxSync->xCondition );
+      (void) pthread_mutex_destroy( &pxSync->xMutex );
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+    }
+    else
+    {
+      *pxSyncObject = pxSync;
+    }
+    (void) pthread_condattr_destroy( &xConditionAttr );
+  }
+#else
   /* DEFAULT NO RTOS */
   //xffSyncObjects[ u8Volume ]
   *pxSyncObject = &u8ffSyncObjects[ u8Volume ];
+#endif
 
-//  eRetVal = EF_RET_OK;
-
-  return EF_RET_OK;
+  return eRetVal;
 }
 
 
@@ -79,9 +224,23 @@ ef_return_et eEFPortSyncObjectDelete (
   /* CMSIS-RTOS */
 //  return (int)(osMutexDelete(xSyncObject) == osOK);
 
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if (    ( 0 != pthread_cond_destroy( &xSyncObject->xShared ) )
+       || ( 0 != pthread_cond_destroy( &xSyncObject->xCondition ) )
+       || ( 0 != pthread_mutex_destroy( &xSyncObject->xMutex ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
   /* DEFAULT NO RTOS */
   *xSyncObject = 0;
   //&xSyncObject = 0;
+#endif
 //  return eRetVal;
   return eRetVal;
 }
@@ -100,6 +259,47 @@ ef_return_et eEFPortSyncObjectTake (
   /* CMSIS-RTOS */
 //  return (int)(osMutexWait(xSyncObject, EF_CONF_TIMEOUT) == osOK);
 
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  struct timespec xDeadline;
+  int             iResult = 0;
+
+  vEFPortSyncDeadlineGet( &xDeadline );
+  (void) pthread_mutex_lock( &xSyncObject->xMutex );
+  if ( ( EF_BOOL_FALSE == xSyncObject->bTaken ) && ( 0 == xSyncObject->u32Sharers ) )
+  {
+    xSyncObject->bTaken = EF_BOOL_TRUE;
+  }
+  else
+  {
+    /* Wait for the owner to hand the volume over, the wait may wake up spuriously */
+    xSyncObject->u32Waiters++;
+    while ( ( 0 == xSyncObject->u32Handovers ) && ( 0 == iResult ) )
+    {
+      iResult = pthread_cond_timedwait( &xSyncObject->xCondition, &xSyncObject->xMutex, &xDeadline );
+    }
+    /* A volume handed over at the deadline is still picked up */
+    if ( 0 != xSyncObject->u32Handovers )
+    {
+      xSyncObject->u32Handovers--;
+    }
+    else
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
+    }
+    xSyncObject->u32Waiters--;
+    /* The shared waiters held back by this task are let in if the volume is shared */
+    if ( ( EF_RET_OK != eRetVal ) && ( 0 == xSyncObject->u32Waiters ) && ( EF_BOOL_FALSE == xSyncObject->bTaken ) )
+    {
+      vEFPortSyncSharedHandover( xSyncObject );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  (void) pthread_mutex_unlock( &xSyncObject->xMutex );
+#else
   /* DEFAULT NO RTOS */
   if ( 0 == *xSyncObject )
   {
@@ -109,6 +309,126 @@ ef_return_et eEFPortSyncObjectTake (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
   }
+#endif
+  return eRetVal;
+}
+
+
+/* Request Grant to Access the Volume without waiting */
+ef_return_et eEFPortSyncObjectTryTake (
+  EF_SYNC_t xSyncObject
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  return (int)(xSemaphoreTake(xSyncObject, 0) == pdTRUE);
+
+  /* CMSIS-RTOS */
+//  return (int)(osMutexWait(xSyncObject, 0) == osOK);
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  (void) pthread_mutex_lock( &xSyncObject->xMutex );
+  if ( ( EF_BOOL_FALSE == xSyncObject->bTaken ) && ( 0 == xSyncObject->u32Sharers ) )
+  {
+    xSyncObject->bTaken = EF_BOOL_TRUE;
+  }
+  else
+  {
+    eRetVal = EF_RET_TIMEOUT;
+  }
+  (void) pthread_mutex_unlock( &xSyncObject->xMutex );
+#else
+  /* DEFAULT NO RTOS */
+  if ( 0 == *xSyncObject )
+  {
+    *xSyncObject = 1;
+  }
+  else
+  {
+    eRetVal = EF_RET_TIMEOUT;
+  }
+#endif
+  return eRetVal;
+}
+
+
+/* Request Shared Grant to Access the Volume */
+ef_return_et eEFPortSyncObjectTakeShared (
+  EF_SYNC_t xSyncObject
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS, no reader-writer lock: the grant is exclusive */
+//  return (int)(xSemaphoreTake(xSyncObject, EF_CONF_TIMEOUT) == pdTRUE);
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  struct timespec xDeadline;
+  int             iResult = 0;
+
+  vEFPortSyncDeadlineGet( &xDeadline );
+  (void) pthread_mutex_lock( &xSyncObject->xMutex );
+  if ( ( EF_BOOL_FALSE == xSyncObject->bTaken ) && ( 0 == xSyncObject->u32Waiters ) )
+  {
+    xSyncObject->u32Sharers++;
+  }
+  else
+  {
+    /* Wait for the exclusive owner to let the shared waiters in, the wait may wake up spuriously */
+    xSyncObject->u32SharedWaiters++;
+    while ( ( 0 == xSyncObject->u32SharedHandovers ) && ( 0 == iResult ) )
+    {
+      iResult = pthread_cond_timedwait( &xSyncObject->xShared, &xSyncObject->xMutex, &xDeadline );
+    }
+    /* The volume was counted as shared by this task when handed over */
+    if ( 0 != xSyncObject->u32SharedHandovers )
+    {
+      xSyncObject->u32SharedHandovers--;
+    }
+    else
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
+    }
+    xSyncObject->u32SharedWaiters--;
+  }
+  (void) pthread_mutex_unlock( &xSyncObject->xMutex );
+#else
+  /* DEFAULT NO RTOS: a single task, the grant is exclusive */
+  eRetVal = eEFPortSyncObjectTake( xSyncObject );
+#endif
+  return eRetVal;
+}
+
+
+/* Request Shared Grant to Access the Volume without waiting */
+ef_return_et eEFPortSyncObjectTryTakeShared (
+  EF_SYNC_t xSyncObject
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS, no reader-writer lock: the grant is exclusive */
+//  return (int)(xSemaphoreTake(xSyncObject, 0) == pdTRUE);
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  (void) pthread_mutex_lock( &xSyncObject->xMutex );
+  if ( ( EF_BOOL_FALSE == xSyncObject->bTaken ) && ( 0 == xSyncObject->u32Waiters ) )
+  {
+    xSyncObject->u32Sharers++;
+  }
+  else
+  {
+    eRetVal = EF_RET_TIMEOUT;
+  }
+  (void) pthread_mutex_unlock( &xSyncObject->xMutex );
+#else
+  /* DEFAULT NO RTOS */
+  eRetVal = eEFPortSyncObjectTryTake( xSyncObject );
+#endif
   return eRetVal;
 }
 
@@ -126,6 +446,46 @@ ef_return_et eEFPortSyncObjectGive (
   /* CMSIS-RTOS */
 //  osMutexRelease(xSyncObject);
 
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  (void) pthread_mutex_lock( &xSyncObject->xMutex );
+  /* If a task owns the volume shared, the last one hands it over to an exclusive waiter */
+  if ( 0 != xSyncObject->u32Sharers )
+  {
+    xSyncObject->u32Sharers--;
+    if ( ( 0 == xSyncObject->u32Sharers ) && ( xSyncObject->u32Waiters > xSyncObject->u32Handovers ) )
+    {
+      xSyncObject->bTaken = EF_BOOL_TRUE;
+      xSyncObject->u32Handovers++;
+      (void) pthread_cond_signal( &xSyncObject->xCondition );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  else if ( EF_BOOL_FALSE == xSyncObject->bTaken )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  /* Else, if tasks wait for the shared volume, they are all let in first */
+  else if ( xSyncObject->u32SharedWaiters > xSyncObject->u32SharedHandovers )
+  {
+    xSyncObject->bTaken = EF_BOOL_FALSE;
+    vEFPortSyncSharedHandover( xSyncObject );
+  }
+  /* Else, if a task waits, the volume stays taken and is handed over to it */
+  else if ( xSyncObject->u32Waiters > xSyncObject->u32Handovers )
+  {
+    xSyncObject->u32Handovers++;
+    (void) pthread_cond_signal( &xSyncObject->xCondition );
+  }
+  else
+  {
+    xSyncObject->bTaken = EF_BOOL_FALSE;
+  }
+  (void) pthread_mutex_unlock( &xSyncObject->xMutex );
+#else
   /* DEFAULT NO RTOS */
   if ( 0 < *xSyncObject )
   {
@@ -135,9 +495,261 @@ ef_return_et eEFPortSyncObjectGive (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
   }
+#endif
+  return eRetVal;
+}
+
+
+/* Create the lock of a module resource */
+ef_return_et eEFPortLockCreate (
+  EF_LOCK_t * pxLock
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxLock );
+
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  *pxLock = xSemaphoreCreateMutex();
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if ( 0 != pthread_mutex_init( pxLock, 0 ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* DEFAULT NO RTOS */
+  *pxLock = 0;
+#endif
+  return eRetVal;
+}
+
+
+/* Delete the lock of a module resource */
+ef_return_et eEFPortLockDelete (
+  EF_LOCK_t * pxLock
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxLock );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  vSemaphoreDelete(*pxLock);
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if ( 0 != pthread_mutex_destroy( pxLock ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* DEFAULT NO RTOS */
+  *pxLock = 0;
+#endif
+  return eRetVal;
+}
+
+
+/* Take the lock of a module resource */
+ef_return_et eEFPortLockTake (
+  EF_LOCK_t * pxLock
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  xSemaphoreTake(*pxLock, portMAX_DELAY);
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if ( 0 != pthread_mutex_lock( pxLock ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* DEFAULT NO RTOS: single task, the lock is always free */
+  *pxLock = 1;
+#endif
+  return eRetVal;
+}
+
+
+/* Give the lock of a module resource */
+ef_return_et eEFPortLockGive (
+  EF_LOCK_t * pxLock
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  xSemaphoreGive(*pxLock);
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if ( 0 != pthread_mutex_unlock( pxLock ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* DEFAULT NO RTOS */
+  *pxLock = 0;
+#endif
+  return eRetVal;
+}
+
+
+/* Enter the critical section of the module wide data */
+ef_return_et eEFPortCriticalEnter (
+  void
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  taskENTER_CRITICAL();
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if ( 0 != pthread_mutex_lock( &xffCriticalMutex ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* DEFAULT NO RTOS: single task, nothing to do */
+#endif
+  return eRetVal;
+}
+
+
+/* Leave the critical section of the module wide data */
+ef_return_et eEFPortCriticalExit (
+  void
+)
+{
+  ef_return_et eRetVal = EF_RET_OK;
+
+  /* FreeRTOS */
+//  taskEXIT_CRITICAL();
+
+#if ( 0 != EF_CONF_PORT_PTHREAD )
+  /* POSIX threads */
+  if ( 0 != pthread_mutex_unlock( &xffCriticalMutex ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_SYS_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* DEFAULT NO RTOS: single task, nothing to do */
+#endif
   return eRetVal;
 }
 
+/* Replace a word shared by the tasks if it still holds the expected value */
+ef_bool_t bEFPortAtomicCompareSwap (
+  ef_u32_t  * pu32Value,
+  ef_u32_t  * pu32Expected,
+  ef_u32_t    u32New
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu32Value );
+  EF_ASSERT_PRIVATE( 0 != pu32Expected );
+
+  ef_bool_t bRetVal = EF_BOOL_FALSE;
+
+#if defined( __GNUC__ )
+  /* GCC and clang builtin, lock-free on the 32 bits cpus (LDREX/STREX on Cortex-M3 and above) */
+  if ( 0 != __atomic_compare_exchange_n( pu32Value, pu32Expected, u32New, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+  {
+    bRetVal = EF_BOOL_TRUE;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  /* Other compilers: the critical section makes the compare and the store one step */
+  (void) eEFPortCriticalEnter( );
+  if ( *pu32Expected == *pu32Value )
+  {
+    *pu32Value = u32New;
+    bRetVal = EF_BOOL_TRUE;
+  }
+  else
+  {
+    *pu32Expected = *pu32Value;
+  }
+  (void) eEFPortCriticalExit( );
+#endif
+  return bRetVal;
+}
+
+ef_u32_t u32EFPortAtomicAdd (
+  ef_u32_t  * pu32Value,
+  ef_u32_t    u32Add
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu32Value );
+
+  ef_u32_t  u32RetVal;
+
+#if defined( __GNUC__ )
+  /* GCC and clang builtin, a counter needs no ordering with the other data */
+  u32RetVal = __atomic_add_fetch( pu32Value, u32Add, __ATOMIC_RELAXED );
+#else
+  (void) eEFPortCriticalEnter( );
+  *pu32Value += u32Add;
+  u32RetVal = *pu32Value;
+  (void) eEFPortCriticalExit( );
+#endif
+  return u32RetVal;
+}
+
+ef_u64_t u64EFPortAtomicAdd (
+  ef_u64_t  * pu64Value,
+  ef_u64_t    u64Add
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu64Value );
+
+  ef_u64_t  u64RetVal;
+
+#if defined( __GNUC__ ) && ( 2 == __GCC_ATOMIC_LLONG_LOCK_FREE )
+  /* Lock-free on the 64 bits cpus, the 32 bits ones would call the atomic library */
+  u64RetVal = __atomic_add_fetch( pu64Value, u64Add, __ATOMIC_RELAXED );
+#else
+  (void) eEFPortCriticalEnter( );
+  *pu64Value += u64Add;
+  u64RetVal = *pu64Value;
+  (void) eEFPortCriticalExit( );
+#endif
+  return u64RetVal;
+}
+
 ef_return_et eEFPrvPortAssertFailed (
   char  * pcFile,
   int     iLine
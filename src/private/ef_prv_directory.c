@@ -114,6 +114,7 @@ ef_return_et eEFPrvDirectoryClusterClear (
   ef_return_et  eRetVal = EF_RET_OK;
   /* Top of the cluster */
   ef_lba_t xSector;
+  ef_drive_caps_st xCaps;
 
   /* If Flushing disk access window failed */
   if ( EF_RET_OK != eEFPrvFSWindowStore( pxFS ) )
@@ -130,6 +131,27 @@ ef_return_et eEFPrvDirectoryClusterClear (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
   }
+  /* Else, if getting the driver capabilities failed */
+  else if ( EF_RET_OK != eEFPrvDriveCapsGet( pxFS->u8PhysDrv, &xCaps ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if the driver fills the sectors with zeros itself */
+  else if ( EF_DRIVE_CAP_WRITE_ZEROES & xCaps.u32Features )
+  {
+    ef_lba_t  xRange[ 2 ] = { xSector, xSector + pxFS->u8ClstSize - 1 };
+
+    /* Window already holds the zeros of the top sector */
+    pxFS->xWindowSector = xSector;
+    if ( EF_RET_OK != eEFPrvDriveIOCtrl( pxFS->u8PhysDrv, CTRL_WRITE_ZEROES, xRange ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
   else
   {
     /* Set window to top of the cluster */
@@ -356,7 +378,7 @@ ef_return_et eEFPrvDirectoryIndexNext (
         EF_CODE_COVERAGE( );
       }
       /* Else, if stretching is not requested */
-      if ( EF_BOOL_TRUE != bStretch )
+      else if ( EF_BOOL_TRUE != bStretch )
       {
         /* Report EOT */
         pxDir->xSector = 0;
@@ -385,6 +407,11 @@ ef_return_et eEFPrvDirectoryIndexNext (
       {
         EF_CODE_COVERAGE( );
       }
+      /* Else, if end of table was reported */
+      else if ( 0 == pxDir->xSector )
+      {
+        EF_CODE_COVERAGE( );
+      }
       else
       {
         /* Initialize data for new cluster */
@@ -147,6 +147,11 @@ ef_return_et eEFPrvDirRead (
     /* Terminate the read operation on error or EOT */
     pxDir->xSector = 0;
   }
+  /* Else, if the end of the table was reached */
+  else if ( 0 == pxDir->xSector )
+  {
+    bEmpty = EF_BOOL_TRUE;
+  }
   else
   {
     EF_CODE_COVERAGE( );
@@ -36,7 +36,10 @@
 
 #include <efat.h>
 #include "ef_prv_def.h"
+#include "ef_prv_drive.h"
 #include "ef_port_diskio.h"
+#include "ef_port_memory.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 
@@ -44,23 +47,1039 @@
 #error Wrong EF_CONF_DRIVERS_NB setting
 #endif
 
+/**
+ *  Largest buffer alignment met by the bounce sector [bytes]
+ */
+#define EF_DRIVE_BOUNCE_ALIGN_MAX ( 64 )
+
+#if ( 0 > EF_CONF_DRIVE_AGGREGATE )
+#error Wrong EF_CONF_DRIVE_AGGREGATE setting
+#endif
+
 /* Local function macros ------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+/**
+ *  Test, set and clear the dirty flag of a sector of the staged unit
+ */
+#define EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index )  \
+  ( 0 != ( (pxStage)->u32Dirty[ (u32Index) >> 5 ] & ( 1UL << ( (u32Index) & 31 ) ) ) )
+#define EF_DRIVE_STAGE_DIRTY_SET( pxStage, u32Index ) \
+  ( (pxStage)->u32Dirty[ (u32Index) >> 5 ] |= ( 1UL << ( (u32Index) & 31 ) ) )
+#define EF_DRIVE_STAGE_DIRTY_CLR( pxStage, u32Index ) \
+  ( (pxStage)->u32Dirty[ (u32Index) >> 5 ] &= ~( 1UL << ( (u32Index) & 31 ) ) )
+#endif
+
+#if ( 0 != EF_CONF_FS_LOCK )
+/* The commands of a drive are serialized by its lock, taken after the lock of the volume */
+#define EF_DRIVE_LOCK( u8PhyDrvNb )   (void) eEFPortLockTake( &xFarFsDrivesLock[ u8PhyDrvNb ] )
+#define EF_DRIVE_UNLOCK( u8PhyDrvNb ) (void) eEFPortLockGive( &xFarFsDrivesLock[ u8PhyDrvNb ] )
+#else
+#define EF_DRIVE_LOCK( u8PhyDrvNb )
+#define EF_DRIVE_UNLOCK( u8PhyDrvNb )
+#endif
+
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+/**
+ *  Write staging unit of a drive: sectors of one erase block gathered before being written
+ */
+typedef struct
+{
+  ef_lba_t  xUnit;          /**< First sector of the staged unit */
+  ef_u32_t  u32UnitSize;    /**< Sectors of a unit, 0 when the writes are not aggregated */
+  ef_u32_t  u32SectorNb;    /**< Sectors of the drive, the last unit can be shorter */
+  ef_u32_t  u32DirtyNb;     /**< Number of staged sectors */
+  ef_u32_t  u32Dirty[ ( EF_CONF_DRIVE_AGGREGATE + 31 ) / 32 ]; /**< Staged sectors flags */
+  ef_u08_t  u8Data[ ( EF_CONF_DRIVE_AGGREGATE * EF_CONF_SECTOR_SIZE ) + EF_DRIVE_BOUNCE_ALIGN_MAX ];
+} ef_drive_stage_st;
+#endif
+
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+/**
+ *  Sync write queue of a drive: sectors sorted by number, issued with the adjacent ones merged
+ */
+typedef struct
+{
+  ef_bool_t bStarted;       /**< Writes are queued */
+  ef_u32_t  u32Nb;          /**< Number of queued sectors */
+  ef_lba_t  xSectors[ EF_CONF_DRIVE_ELEVATOR ]; /**< Queued sectors numbers, ascending */
+  ef_u08_t  u8Data[ ( EF_CONF_DRIVE_ELEVATOR * EF_CONF_SECTOR_SIZE ) + EF_DRIVE_BOUNCE_ALIGN_MAX ];
+} ef_drive_elevator_st;
+#endif
+
 /* Local variables ------------------------------------------------------------------------------------------------- */
 
-/**
- *  Filesystem objects (logical drives)
- */
-static ef_u08_t u8FarFsDrivesNb = 0;
+/**
+ *  Filesystem objects (logical drives)
+ */
+static ef_u08_t u8FarFsDrivesNb = 0;
+
+/**
+ *  Filesystem objects (logical drives)
+ */
+static ef_drive_functions_st xFarFsDrives[ EF_CONF_DRIVERS_NB ] = { { 0, 0, 0, 0, 0 } };
+
+/**
+ *  Capabilities of the drives, read on initialization
+ */
+static ef_drive_caps_st xFarFsDrivesCaps[ EF_CONF_DRIVERS_NB ];
+
+#if ( 0 != EF_CONF_FS_LOCK )
+/**
+ *  Locks of the drives, shared by the volumes of a drive
+ */
+static EF_LOCK_t xFarFsDrivesLock[ EF_CONF_DRIVERS_NB ];
+#endif
+
+#if ( 0 != EF_CONF_DRIVE_BOUNCE )
+/**
+ *  Bounce sector of the drives, with room to meet an alignment up to EF_DRIVE_BOUNCE_ALIGN_MAX
+ */
+static ef_u08_t u8FarFsDrivesBounce[ EF_CONF_DRIVERS_NB ][ EF_CONF_SECTOR_SIZE + EF_DRIVE_BOUNCE_ALIGN_MAX ];
+#endif
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+/**
+ *  Write staging units of the drives
+ */
+static ef_drive_stage_st xFarFsDrivesStage[ EF_CONF_DRIVERS_NB ];
+#endif
+
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+/**
+ *  Sync write queues of the drives
+ */
+static ef_drive_elevator_st xFarFsDrivesElevator[ EF_CONF_DRIVERS_NB ];
+#endif
+
+#if ( 0 != EF_CONF_STATS )
+/**
+ *  Commands and sectors counters of the drives
+ */
+static ef_stats_st xFarFsDrivesStats[ EF_CONF_DRIVERS_NB ];
+#endif
+
+#if ( 0 != EF_CONF_TRACE )
+/**
+ *  Drive command trace ring buffer
+ */
+static ef_trace_record_st xFarFsTrace[ EF_CONF_TRACE_DEPTH ];
+
+/**
+ *  Index of the oldest record of the trace
+ */
+static ef_u32_t u32FarFsTraceFirst = 0;
+
+/**
+ *  Number of records in the trace
+ */
+static ef_u32_t u32FarFsTraceNb = 0;
+
+/**
+ *  Number of records overwritten since the last read
+ */
+static ef_u32_t u32FarFsTraceLost = 0;
+
+/**
+ *  Commands are recorded
+ */
+static ef_bool_t bFarFsTraceEnabled = EF_BOOL_FALSE;
+#endif
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_TRACE )
+static ef_return_et eEFPrvDriveTraceRecord (
+  ef_trace_op_et  eOperation,
+  ef_u08_t        u8PhyDrvNb,
+  ef_lba_t        xSector,
+  ef_u32_t        u32Count,
+  ef_u32_t        u32Timestamp,
+  ef_return_et    eResult
+);
+#endif
+
+static ef_return_et eEFPrvDriveReadCommand (
+  ef_u08_t    u8PhyDrvNb,
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+static ef_return_et eEFPrvDriveWriteCommand (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+static ef_u32_t u32EFPrvDriveChunkGet (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_u32_t          u32Count
+);
+
+#if ( 0 != EF_CONF_DRIVE_BOUNCE )
+static ef_u08_t * pu8EFPrvDriveBounceGet (
+  ef_u08_t  u8PhyDrvNb
+);
+#endif
+
+static ef_return_et eEFPrvDriveReadSplit (
+  ef_u08_t    u8PhyDrvNb,
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+static ef_return_et eEFPrvDriveWriteSplit (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+static ef_u08_t * pu8EFPrvDriveStageDataGet (
+  ef_u08_t  u8PhyDrvNb
+);
+
+static ef_u32_t u32EFPrvDriveStageLengthGet (
+  ef_u08_t  u8PhyDrvNb
+);
+
+static ef_return_et eEFPrvDriveStageFlush (
+  ef_u08_t  u8PhyDrvNb
+);
+
+static ef_return_et eEFPrvDriveStageDrop (
+  ef_u08_t  u8PhyDrvNb,
+  ef_lba_t  xFirst,
+  ef_lba_t  xLast
+);
+
+static ef_return_et eEFPrvDriveStageSetup (
+  ef_u08_t  u8PhyDrvNb
+);
+#endif
+
+static ef_return_et eEFPrvDriveWriteStaged (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+static ef_return_et eEFPrvDriveReadNewest (
+  ef_u08_t    u8PhyDrvNb,
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+static ef_return_et eEFPrvDriveElevatorStop (
+  ef_u08_t  u8PhyDrvNb
+);
+
+#if ( 0 != EF_CONF_FS_LOCK )
+static ef_bool_t bEFPrvDriveRangeHeld (
+  ef_u08_t  u8PhyDrvNb,
+  ef_lba_t  xSector,
+  ef_u32_t  u32Count
+);
+#endif
+
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+static ef_u08_t * pu8EFPrvDriveElevatorDataGet (
+  ef_u08_t  u8PhyDrvNb
+);
+
+static ef_return_et eEFPrvDriveElevatorDrain (
+  ef_u08_t  u8PhyDrvNb
+);
+
+static ef_return_et eEFPrvDriveElevatorQueue (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+#endif
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_TRACE )
+/* Record a command in the trace, overwriting the oldest record when full */
+static ef_return_et eEFPrvDriveTraceRecord (
+  ef_trace_op_et  eOperation,
+  ef_u08_t        u8PhyDrvNb,
+  ef_lba_t        xSector,
+  ef_u32_t        u32Count,
+  ef_u32_t        u32Timestamp,
+  ef_return_et    eResult
+)
+{
+  ef_trace_record_st  * pxRecord;
+
+  if ( EF_BOOL_FALSE == bFarFsTraceEnabled )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    (void) eEFPortCriticalEnter( );
+    /* If the ring is full, the oldest record is lost */
+    if ( EF_CONF_TRACE_DEPTH == u32FarFsTraceNb )
+    {
+      u32FarFsTraceFirst = ( u32FarFsTraceFirst + 1 ) % EF_CONF_TRACE_DEPTH;
+      u32FarFsTraceNb--;
+      u32FarFsTraceLost++;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pxRecord = &xFarFsTrace[ ( u32FarFsTraceFirst + u32FarFsTraceNb ) % EF_CONF_TRACE_DEPTH ];
+    pxRecord->u64Sector     = (ef_u64_t) xSector;
+    pxRecord->u32Count      = u32Count;
+    pxRecord->u32Timestamp  = u32Timestamp;
+    pxRecord->u8Operation   = (ef_u08_t) eOperation;
+    pxRecord->u8Drive       = u8PhyDrvNb;
+    pxRecord->u8Origin      = (ef_u08_t) eEFPrvLatencyOriginGet( );
+    pxRecord->u8Result      = (ef_u08_t) eResult;
+    u32FarFsTraceNb++;
+    (void) eEFPortCriticalExit( );
+  }
+
+  return EF_RET_OK;
+}
+#endif
+
+/* Send one read command to the driver */
+static ef_return_et eEFPrvDriveReadCommand (
+  ef_u08_t    u8PhyDrvNb,
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+
+#if ( 0 != EF_CONF_STATS )
+  /* Reads of a concurrent drive are sent outside of its lock */
+  (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32ReadCmds, 1 );
+  (void) u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsRead, u32Count );
+#endif
+
+#if ( 0 != EF_CONF_TRACE )
+  ef_u32_t      u32Timestamp = u32EFPortTimestampGet( );
+  ef_return_et  eRetVal = xFarFsDrives[ u8PhyDrvNb ].pxRead( pu8Buffer, xSector, u32Count );
+
+  (void) eEFPrvDriveTraceRecord( EF_TRACE_READ, u8PhyDrvNb, xSector, u32Count, u32Timestamp, eRetVal );
+
+  return eRetVal;
+#else
+  return xFarFsDrives[ u8PhyDrvNb ].pxRead( pu8Buffer, xSector, u32Count );
+#endif
+}
+
+/* Send one write command to the driver */
+static ef_return_et eEFPrvDriveWriteCommand (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+
+#if ( 0 != EF_CONF_STATS )
+  (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32WriteCmds, 1 );
+  (void) u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsWritten, u32Count );
+#endif
+
+#if ( 0 != EF_CONF_TRACE )
+  ef_u32_t      u32Timestamp = u32EFPortTimestampGet( );
+  ef_return_et  eRetVal = xFarFsDrives[ u8PhyDrvNb ].pxWrite( pu8Buffer, xSector, u32Count );
+
+  (void) eEFPrvDriveTraceRecord( EF_TRACE_WRITE, u8PhyDrvNb, xSector, u32Count, u32Timestamp, eRetVal );
+
+  return eRetVal;
+#else
+  return xFarFsDrives[ u8PhyDrvNb ].pxWrite( pu8Buffer, xSector, u32Count );
+#endif
+}
+
+/* Get the number of sectors of the next command: 0 if the buffer needs the bounce sector, else at most the
+ * largest command of the driver */
+static ef_u32_t u32EFPrvDriveChunkGet (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_u32_t          u32Count
+)
+{
+  ef_drive_caps_st  * pxCaps = &xFarFsDrivesCaps[ u8PhyDrvNb ];
+  ef_u32_t            u32Chunk = u32Count;
+
+  if (    ( 0 != EF_CONF_DRIVE_BOUNCE )
+       && ( 1 < pxCaps->u32Alignment )
+       && ( 0 != ( (ef_uintptr_t) pu8Buffer & ( pxCaps->u32Alignment - 1 ) ) ) )
+  {
+    u32Chunk = 0;
+  }
+  else if ( ( 0 != pxCaps->u32MaxSectors ) && ( u32Chunk > pxCaps->u32MaxSectors ) )
+  {
+    u32Chunk = pxCaps->u32MaxSectors;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return u32Chunk;
+}
+
+/* Get the aligned bounce sector of a drive */
+#if ( 0 != EF_CONF_DRIVE_BOUNCE )
+static ef_u08_t * pu8EFPrvDriveBounceGet (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_u08_t  * pu8Bounce = u8FarFsDrivesBounce[ u8PhyDrvNb ];
+  ef_u32_t    u32Alignment = xFarFsDrivesCaps[ u8PhyDrvNb ].u32Alignment;
+
+  return pu8Bounce + ( ( u32Alignment - ( (ef_uintptr_t) pu8Bounce & ( u32Alignment - 1 ) ) ) & ( u32Alignment - 1 ) );
+}
+#endif
+
+/* Read Sector(s), split in commands the driver accepts */
+static ef_return_et eEFPrvDriveReadSplit (
+  ef_u08_t    u8PhyDrvNb,
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32Chunk;
+
+  while ( ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) )
+  {
+    u32Chunk = u32EFPrvDriveChunkGet( u8PhyDrvNb, pu8Buffer, u32Count );
+#if ( 0 != EF_CONF_DRIVE_BOUNCE )
+    /* If the buffer is not aligned, one sector goes through the bounce sector */
+    if ( 0 == u32Chunk )
+    {
+      ef_u08_t  * pu8Bounce = pu8EFPrvDriveBounceGet( u8PhyDrvNb );
+
+      u32Chunk = 1;
+      eRetVal = eEFPrvDriveReadCommand( u8PhyDrvNb, pu8Bounce, xSector, 1 );
+      if ( EF_RET_OK == eRetVal )
+      {
+        (void) eEFPortMemCopy( pu8Bounce, pu8Buffer, EF_CONF_SECTOR_SIZE );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    else
+#endif
+    {
+      eRetVal = eEFPrvDriveReadCommand( u8PhyDrvNb, pu8Buffer, xSector, u32Chunk );
+    }
+    pu8Buffer += u32Chunk * EF_CONF_SECTOR_SIZE;
+    xSector += u32Chunk;
+    u32Count -= u32Chunk;
+  }
+
+  return eRetVal;
+}
+
+/* Write Sector(s), split in commands the driver accepts */
+static ef_return_et eEFPrvDriveWriteSplit (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32Chunk;
+
+  while ( ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) )
+  {
+    u32Chunk = u32EFPrvDriveChunkGet( u8PhyDrvNb, pu8Buffer, u32Count );
+#if ( 0 != EF_CONF_DRIVE_BOUNCE )
+    /* If the buffer is not aligned, one sector goes through the bounce sector */
+    if ( 0 == u32Chunk )
+    {
+      ef_u08_t  * pu8Bounce = pu8EFPrvDriveBounceGet( u8PhyDrvNb );
+
+      u32Chunk = 1;
+      (void) eEFPortMemCopy( pu8Buffer, pu8Bounce, EF_CONF_SECTOR_SIZE );
+      eRetVal = eEFPrvDriveWriteCommand( u8PhyDrvNb, pu8Bounce, xSector, 1 );
+    }
+    else
+#endif
+    {
+      eRetVal = eEFPrvDriveWriteCommand( u8PhyDrvNb, pu8Buffer, xSector, u32Chunk );
+    }
+    pu8Buffer += u32Chunk * EF_CONF_SECTOR_SIZE;
+    xSector += u32Chunk;
+    u32Count -= u32Chunk;
+  }
+
+  return eRetVal;
+}
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+/* Get the staging unit data of a drive, aligned for any driver */
+static ef_u08_t * pu8EFPrvDriveStageDataGet (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_u08_t  * pu8Data = xFarFsDrivesStage[ u8PhyDrvNb ].u8Data;
+
+  return pu8Data + ( ( EF_DRIVE_BOUNCE_ALIGN_MAX - ( (ef_uintptr_t) pu8Data & ( EF_DRIVE_BOUNCE_ALIGN_MAX - 1 ) ) )
+                     & ( EF_DRIVE_BOUNCE_ALIGN_MAX - 1 ) );
+}
+
+/* Get the number of sectors of the staged unit, shorter than a unit at the end of the drive */
+static ef_u32_t u32EFPrvDriveStageLengthGet (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+  ef_u32_t            u32Length = pxStage->u32UnitSize;
+
+  if (    ( 0 != pxStage->u32SectorNb )
+       && ( ( pxStage->xUnit + u32Length ) > pxStage->u32SectorNb ) )
+  {
+    u32Length = (ef_u32_t) ( pxStage->u32SectorNb - pxStage->xUnit );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return u32Length;
+}
+
+/* Write the staged sectors of a drive: the whole unit when most of it is staged, the holes being read back from
+ * the drive, else each run of staged sectors */
+static ef_return_et eEFPrvDriveStageFlush (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+  ef_u08_t          * pu8Data = pu8EFPrvDriveStageDataGet( u8PhyDrvNb );
+  ef_u32_t            u32Length = u32EFPrvDriveStageLengthGet( u8PhyDrvNb );
+  ef_bool_t           bDirty;
+  ef_u32_t            u32Index;
+  ef_u32_t            u32Run;
+  ef_return_et        eRetVal = EF_RET_OK;
+
+  if ( 0 == pxStage->u32DirtyNb )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    bDirty = ( ( 2 * pxStage->u32DirtyNb ) >= u32Length ) ? EF_BOOL_FALSE : EF_BOOL_TRUE;
+    /* Walk the runs of sectors with the same state: the clean ones are read back for a whole unit write,
+     * the dirty ones are written on their own else */
+    for ( u32Index = 0 ; ( EF_RET_OK == eRetVal ) && ( u32Index < u32Length ) ; u32Index += u32Run )
+    {
+      for ( u32Run = 1 ;
+               ( ( u32Index + u32Run ) < u32Length )
+            && ( EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index + u32Run ) == EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) ) ;
+            u32Run++ )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      if ( ( EF_BOOL_FALSE == bDirty ) && ( ! EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) ) )
+      {
+        eRetVal = eEFPrvDriveReadSplit( u8PhyDrvNb,
+                                        pu8Data + ( u32Index * EF_CONF_SECTOR_SIZE ),
+                                        pxStage->xUnit + u32Index,
+                                        u32Run );
+      }
+      else if ( ( EF_BOOL_FALSE != bDirty ) && ( EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) ) )
+      {
+        eRetVal = eEFPrvDriveWriteSplit( u8PhyDrvNb,
+                                         pu8Data + ( u32Index * EF_CONF_SECTOR_SIZE ),
+                                         pxStage->xUnit + u32Index,
+                                         u32Run );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    if ( ( EF_RET_OK == eRetVal ) && ( EF_BOOL_FALSE == bDirty ) )
+    {
+      eRetVal = eEFPrvDriveWriteSplit( u8PhyDrvNb, pu8Data, pxStage->xUnit, u32Length );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* On error the sectors stay staged, the next flush tries again */
+    if ( EF_RET_OK == eRetVal )
+    {
+      (void) eEFPortMemZero( pxStage->u32Dirty, sizeof( pxStage->u32Dirty ) );
+      pxStage->u32DirtyNb = 0;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+
+/* Forget the staged sectors of a range, overwritten or discarded by the drive */
+static ef_return_et eEFPrvDriveStageDrop (
+  ef_u08_t  u8PhyDrvNb,
+  ef_lba_t  xFirst,
+  ef_lba_t  xLast
+)
+{
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+  ef_u32_t            u32Index;
+
+  for ( u32Index = 0 ; ( 0 != pxStage->u32DirtyNb ) && ( u32Index < pxStage->u32UnitSize ) ; u32Index++ )
+  {
+    if (    ( ( pxStage->xUnit + u32Index ) >= xFirst )
+         && ( ( pxStage->xUnit + u32Index ) <= xLast )
+         && ( EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) ) )
+    {
+      EF_DRIVE_STAGE_DIRTY_CLR( pxStage, u32Index );
+      pxStage->u32DirtyNb--;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return EF_RET_OK;
+}
+
+/* Get the unit size of a drive from its erase block size, the staged sectors are written first */
+static ef_return_et eEFPrvDriveStageSetup (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+  ef_u32_t            u32BlockSize = 0;
+  ef_u32_t            u32SectorNb = 0;
+  ef_u32_t            u32UnitMax = 1;
+  ef_return_et        eRetVal = eEFPrvDriveStageFlush( u8PhyDrvNb );
+
+  /* Largest power of 2 fitting in the staging buffer */
+  while ( ( 2 * u32UnitMax ) <= EF_CONF_DRIVE_AGGREGATE )
+  {
+    u32UnitMax *= 2;
+  }
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Erase block size unknown or not a power of 2: the writes are not aggregated */
+  else if (    ( EF_RET_OK != xFarFsDrives[ u8PhyDrvNb ].pxCtrl( GET_BLOCK_SIZE, &u32BlockSize ) )
+            || ( 2 > u32BlockSize )
+            || ( 0 != ( u32BlockSize & ( u32BlockSize - 1 ) ) ) )
+  {
+    pxStage->u32UnitSize = 0;
+  }
+  else
+  {
+    if ( EF_RET_OK != xFarFsDrives[ u8PhyDrvNb ].pxCtrl( GET_SECTOR_COUNT, &u32SectorNb ) )
+    {
+      u32SectorNb = 0;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    pxStage->u32UnitSize  = ( u32BlockSize < u32UnitMax ) ? u32BlockSize : u32UnitMax;
+    pxStage->u32SectorNb  = u32SectorNb;
+    /* A unit of one sector gathers nothing */
+    if ( 2 > pxStage->u32UnitSize )
+    {
+      pxStage->u32UnitSize = 0;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+#endif
 
-/**
- *  Filesystem objects (logical drives)
- */
-static ef_drive_functions_st xFarFsDrives[ EF_CONF_DRIVERS_NB ] = { { 0, 0, 0, 0, 0 } };
+/* Write Sector(s), the writes smaller than a unit being staged */
+static ef_return_et eEFPrvDriveWriteStaged (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+  ef_u08_t          * pu8Data = pu8EFPrvDriveStageDataGet( u8PhyDrvNb );
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_lba_t            xUnit;
+  ef_u32_t            u32Offset;
+  ef_u32_t            u32Chunk;
+
+  if ( 0 == pxStage->u32UnitSize )
+  {
+    eRetVal = eEFPrvDriveWriteSplit( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+    u32Count = 0;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  while ( ( EF_RET_OK == eRetVal ) && ( 0 != u32Count ) )
+  {
+    u32Offset = (ef_u32_t) ( xSector % pxStage->u32UnitSize );
+    xUnit     = xSector - u32Offset;
+    u32Chunk  = pxStage->u32UnitSize - u32Offset;
+    if ( u32Chunk > u32Count )
+    {
+      u32Chunk = u32Count;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* A whole unit is written as it is, replacing what was staged for it */
+    if ( u32Chunk == pxStage->u32UnitSize )
+    {
+      if ( xUnit == pxStage->xUnit )
+      {
+        (void) eEFPrvDriveStageDrop( u8PhyDrvNb, xUnit, xUnit + u32Chunk - 1 );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      eRetVal = eEFPrvDriveWriteSplit( u8PhyDrvNb, pu8Buffer, xSector, u32Chunk );
+    }
+    else
+    {
+      /* The staging buffer holds one unit, the previous one is written before */
+      if ( ( 0 != pxStage->u32DirtyNb ) && ( xUnit != pxStage->xUnit ) )
+      {
+        eRetVal = eEFPrvDriveStageFlush( u8PhyDrvNb );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      if ( EF_RET_OK == eRetVal )
+      {
+        pxStage->xUnit = xUnit;
+        (void) eEFPortMemCopy( pu8Buffer, pu8Data + ( u32Offset * EF_CONF_SECTOR_SIZE ), u32Chunk * EF_CONF_SECTOR_SIZE );
+        for ( ef_u32_t u32Index = u32Offset ; u32Index < ( u32Offset + u32Chunk ) ; u32Index++ )
+        {
+          if ( ! EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) )
+          {
+            EF_DRIVE_STAGE_DIRTY_SET( pxStage, u32Index );
+            pxStage->u32DirtyNb++;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+        }
+        /* A completed unit has nothing more to wait for */
+        if ( u32EFPrvDriveStageLengthGet( u8PhyDrvNb ) == pxStage->u32DirtyNb )
+        {
+          eRetVal = eEFPrvDriveStageFlush( u8PhyDrvNb );
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    pu8Buffer += u32Chunk * EF_CONF_SECTOR_SIZE;
+    xSector += u32Chunk;
+    u32Count -= u32Chunk;
+  }
+
+  return eRetVal;
+#else
+  return eEFPrvDriveWriteSplit( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+#endif
+}
+
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+/* Get the queued sectors data of a drive, aligned for any driver */
+static ef_u08_t * pu8EFPrvDriveElevatorDataGet (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_u08_t  * pu8Data = xFarFsDrivesElevator[ u8PhyDrvNb ].u8Data;
+
+  return pu8Data + ( ( EF_DRIVE_BOUNCE_ALIGN_MAX - ( (ef_uintptr_t) pu8Data & ( EF_DRIVE_BOUNCE_ALIGN_MAX - 1 ) ) )
+                     & ( EF_DRIVE_BOUNCE_ALIGN_MAX - 1 ) );
+}
+
+/* Issue the queued sectors in ascending order, one command per run of adjacent sectors, the queue stays active */
+static ef_return_et eEFPrvDriveElevatorDrain (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_drive_elevator_st  * pxElevator = &xFarFsDrivesElevator[ u8PhyDrvNb ];
+  ef_u08_t              * pu8Data = pu8EFPrvDriveElevatorDataGet( u8PhyDrvNb );
+  ef_u32_t                u32Index;
+  ef_u32_t                u32Run;
+  ef_return_et            eRetVal = EF_RET_OK;
+
+  for ( u32Index = 0 ; ( EF_RET_OK == eRetVal ) && ( u32Index < pxElevator->u32Nb ) ; u32Index += u32Run )
+  {
+    for ( u32Run = 1 ;
+             ( ( u32Index + u32Run ) < pxElevator->u32Nb )
+          && ( pxElevator->xSectors[ u32Index + u32Run ] == ( pxElevator->xSectors[ u32Index ] + u32Run ) ) ;
+          u32Run++ )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    eRetVal = eEFPrvDriveWriteStaged( u8PhyDrvNb,
+                                      pu8Data + ( u32Index * EF_CONF_SECTOR_SIZE ),
+                                      pxElevator->xSectors[ u32Index ],
+                                      u32Run );
+  }
+  /* A failed write is reported once, the queue is emptied in any case */
+  pxElevator->u32Nb = 0;
+
+  return eRetVal;
+}
+
+/* Queue sectors, kept sorted by sector number, a sector queued again replaces the previous data */
+static ef_return_et eEFPrvDriveElevatorQueue (
+  ef_u08_t          u8PhyDrvNb,
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  ef_drive_elevator_st  * pxElevator = &xFarFsDrivesElevator[ u8PhyDrvNb ];
+  ef_u08_t              * pu8Data = pu8EFPrvDriveElevatorDataGet( u8PhyDrvNb );
+  ef_u32_t                u32Index;
+  ef_return_et            eRetVal = EF_RET_OK;
+
+  /* If the sectors may not fit, the queue is issued first */
+  if ( ( pxElevator->u32Nb + u32Count ) > EF_CONF_DRIVE_ELEVATOR )
+  {
+    eRetVal = eEFPrvDriveElevatorDrain( u8PhyDrvNb );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Larger than the queue: nothing to sort it with */
+  else if ( u32Count > EF_CONF_DRIVE_ELEVATOR )
+  {
+    eRetVal = eEFPrvDriveWriteStaged( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+  }
+  else
+  {
+    for ( ; 0 != u32Count ; u32Count-- )
+    {
+      for ( u32Index = 0 ;
+            ( u32Index < pxElevator->u32Nb ) && ( pxElevator->xSectors[ u32Index ] < xSector ) ;
+            u32Index++ )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Make room for a new sector */
+      if ( ( u32Index == pxElevator->u32Nb ) || ( pxElevator->xSectors[ u32Index ] != xSector ) )
+      {
+        (void) eEFPortMemMove( pu8Data + ( u32Index * EF_CONF_SECTOR_SIZE ),
+                               pu8Data + ( ( u32Index + 1 ) * EF_CONF_SECTOR_SIZE ),
+                               ( pxElevator->u32Nb - u32Index ) * EF_CONF_SECTOR_SIZE );
+        (void) eEFPortMemMove( &pxElevator->xSectors[ u32Index ],
+                               &pxElevator->xSectors[ u32Index + 1 ],
+                               ( pxElevator->u32Nb - u32Index ) * sizeof( ef_lba_t ) );
+        pxElevator->xSectors[ u32Index ] = xSector;
+        pxElevator->u32Nb++;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      (void) eEFPortMemCopy( pu8Buffer, pu8Data + ( u32Index * EF_CONF_SECTOR_SIZE ), EF_CONF_SECTOR_SIZE );
+      pu8Buffer += EF_CONF_SECTOR_SIZE;
+      xSector++;
+    }
+  }
+
+  return eRetVal;
+}
+#endif
+
+/* Read Sector(s), the staged and queued sectors being newer than the drive content */
+static ef_return_et eEFPrvDriveReadNewest (
+  ef_u08_t    u8PhyDrvNb,
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  ef_return_et  eRetVal = eEFPrvDriveReadSplit( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+  ef_u08_t          * pu8Data = pu8EFPrvDriveStageDataGet( u8PhyDrvNb );
+
+  for ( ef_u32_t u32Index = 0 ;
+        ( EF_RET_OK == eRetVal ) && ( 0 != pxStage->u32DirtyNb ) && ( u32Index < pxStage->u32UnitSize ) ;
+        u32Index++ )
+  {
+    if (    ( ( pxStage->xUnit + u32Index ) >= xSector )
+         && ( ( pxStage->xUnit + u32Index ) < ( xSector + u32Count ) )
+         && ( EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) ) )
+    {
+      (void) eEFPortMemCopy( pu8Data + ( u32Index * EF_CONF_SECTOR_SIZE ),
+                             pu8Buffer + ( ( pxStage->xUnit + u32Index - xSector ) * EF_CONF_SECTOR_SIZE ),
+                             EF_CONF_SECTOR_SIZE );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+#endif
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+  ef_drive_elevator_st  * pxElevator = &xFarFsDrivesElevator[ u8PhyDrvNb ];
+  ef_u08_t              * pu8Queued = pu8EFPrvDriveElevatorDataGet( u8PhyDrvNb );
+
+  /* The queued sectors are newer than the drive and staged content */
+  for ( ef_u32_t u32Index = 0 ; ( EF_RET_OK == eRetVal ) && ( u32Index < pxElevator->u32Nb ) ; u32Index++ )
+  {
+    if (    ( pxElevator->xSectors[ u32Index ] >= xSector )
+         && ( pxElevator->xSectors[ u32Index ] < ( xSector + u32Count ) ) )
+    {
+      (void) eEFPortMemCopy( pu8Queued + ( u32Index * EF_CONF_SECTOR_SIZE ),
+                             pu8Buffer + ( ( pxElevator->xSectors[ u32Index ] - xSector ) * EF_CONF_SECTOR_SIZE ),
+                             EF_CONF_SECTOR_SIZE );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+#endif
+
+  return eRetVal;
+}
+
+/* Issue the queued writes of a Drive and stop queuing */
+static ef_return_et eEFPrvDriveElevatorStop (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+  xFarFsDrivesElevator[ u8PhyDrvNb ].bStarted = EF_BOOL_FALSE;
+  if ( EF_RET_OK != eEFPrvDriveElevatorDrain( u8PhyDrvNb ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#else
+  (void) u8PhyDrvNb;
+#endif
+
+  return eRetVal;
+}
+
+#if ( 0 != EF_CONF_FS_LOCK )
+/* Check if the newest content of some sectors of a range is staged or queued, not yet on the drive */
+static ef_bool_t bEFPrvDriveRangeHeld (
+  ef_u08_t  u8PhyDrvNb,
+  ef_lba_t  xSector,
+  ef_u32_t  u32Count
+)
+{
+  ef_bool_t bHeld = EF_BOOL_FALSE;
+
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+  ef_drive_stage_st * pxStage = &xFarFsDrivesStage[ u8PhyDrvNb ];
+
+  for ( ef_u32_t u32Index = 0 ;
+        ( EF_BOOL_FALSE == bHeld ) && ( 0 != pxStage->u32DirtyNb ) && ( u32Index < pxStage->u32UnitSize ) ;
+        u32Index++ )
+  {
+    if (    ( ( pxStage->xUnit + u32Index ) >= xSector )
+         && ( ( pxStage->xUnit + u32Index ) < ( xSector + u32Count ) )
+         && ( EF_DRIVE_STAGE_IS_DIRTY( pxStage, u32Index ) ) )
+    {
+      bHeld = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+#endif
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+  ef_drive_elevator_st  * pxElevator = &xFarFsDrivesElevator[ u8PhyDrvNb ];
+
+  for ( ef_u32_t u32Index = 0 ; ( EF_BOOL_FALSE == bHeld ) && ( u32Index < pxElevator->u32Nb ) ; u32Index++ )
+  {
+    if (    ( pxElevator->xSectors[ u32Index ] >= xSector )
+         && ( pxElevator->xSectors[ u32Index ] < ( xSector + u32Count ) ) )
+    {
+      bHeld = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+#endif
+#if ( ( 0 == EF_CONF_DRIVE_AGGREGATE ) && ( 0 == EF_CONF_DRIVE_ELEVATOR ) )
+  (void) u8PhyDrvNb;
+  (void) xSector;
+  (void) u32Count;
+#endif
+
+  return bHeld;
+}
+#endif
 
-/* Public variables ------------------------------------------------------------------------------------------------ */
-/* Local function prototypes---------------------------------------------------------------------------------------- */
-/* Local functions ------------------------------------------------------------------------------------------------- */
 /* Public functions ------------------------------------------------------------------------------------------------ */
 
 /* Initialize a Drive */
@@ -68,7 +1087,54 @@ ef_return_et  eEFPrvDriveInitialize (
   ef_u08_t u8PhyDrvNb
 )
 {
-  return xFarFsDrives[ u8PhyDrvNb ].pxInitialize( );
+  ef_return_et      eRetVal;
+  ef_drive_caps_st  xCaps;
+
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+  eRetVal = xFarFsDrives[ u8PhyDrvNb ].pxInitialize( );
+
+  /* If the drive is ready and its driver reports valid capabilities */
+  if (    ( EF_RET_OK == eRetVal )
+       && ( EF_RET_OK == xFarFsDrives[ u8PhyDrvNb ].pxCtrl( GET_CAPABILITIES, &xCaps ) ) )
+  {
+    /* An alignment that is not a power of 2 or cannot be met is ignored */
+    if (    ( 0 == xCaps.u32Alignment )
+         || ( 0 != ( xCaps.u32Alignment & ( xCaps.u32Alignment - 1 ) ) )
+         || ( EF_DRIVE_BOUNCE_ALIGN_MAX < xCaps.u32Alignment ) )
+    {
+      xCaps.u32Alignment = 1;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    if ( 0 == xCaps.u32Granularity )
+    {
+      xCaps.u32Granularity = 1;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    xFarFsDrivesCaps[ u8PhyDrvNb ] = xCaps;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+  if ( EF_RET_OK == eRetVal )
+  {
+    eRetVal = eEFPrvDriveStageSetup( u8PhyDrvNb );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#endif
+  EF_DRIVE_UNLOCK( u8PhyDrvNb );
+
+  return eRetVal;
 }
 
 /* Get Drive Status */
@@ -76,10 +1142,16 @@ ef_return_et  eEFPrvDriveStatus (
   ef_u08_t u8PhyDrvNb
 )
 {
-  return xFarFsDrives[ u8PhyDrvNb ].pxStatus( );
+  ef_return_et  eRetVal;
+
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+  eRetVal = xFarFsDrives[ u8PhyDrvNb ].pxStatus( );
+  EF_DRIVE_UNLOCK( u8PhyDrvNb );
+
+  return eRetVal;
 }
 
-/* Read Sector(s)*/
+/* Read Sector(s), the staged sectors being newer than the drive content */
 ef_return_et  eEFPrvDriveRead (
   ef_u08_t    u8PhyDrvNb,
   ef_u08_t  * pu8Buffer,
@@ -87,13 +1159,30 @@ ef_return_et  eEFPrvDriveRead (
   ef_u32_t    u32Count
 )
 {
-//  EF_ASSERT_PRIVATE( EF_CONF_DRIVERS_NB <= u8PhyDrvNb );
-  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+  ef_return_et  eRetVal;
 
-  return xFarFsDrives[ u8PhyDrvNb ].pxRead( pu8Buffer, xSector, u32Count );
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+#if ( 0 != EF_CONF_FS_LOCK )
+  /* A concurrent drive reads the sectors it holds the newest content of without its lock, so that the reads of
+   * several tasks overlap */
+  if (    ( 0 != ( EF_DRIVE_CAP_CONCURRENT & xFarFsDrivesCaps[ u8PhyDrvNb ].u32Features ) )
+       && ( 0 != u32EFPrvDriveChunkGet( u8PhyDrvNb, pu8Buffer, u32Count ) )
+       && ( EF_BOOL_FALSE == bEFPrvDriveRangeHeld( u8PhyDrvNb, xSector, u32Count ) ) )
+  {
+    EF_DRIVE_UNLOCK( u8PhyDrvNb );
+    eRetVal = eEFPrvDriveReadSplit( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+  }
+  else
+#endif
+  {
+    eRetVal = eEFPrvDriveReadNewest( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+    EF_DRIVE_UNLOCK( u8PhyDrvNb );
+  }
+
+  return eRetVal;
 }
 
-/* Write Sector(s) */
+/* Write Sector(s), queued while the elevator of the drive is started */
 ef_return_et  eEFPrvDriveWrite (
   ef_u08_t          u8PhyDrvNb,
   const ef_u08_t  * pu8Buffer,
@@ -101,10 +1190,22 @@ ef_return_et  eEFPrvDriveWrite (
   ef_u32_t          u32Count
 )
 {
-//  EF_ASSERT_PRIVATE( EF_CONF_DRIVERS_NB <= u8PhyDrvNb );
-  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+  ef_return_et  eRetVal;
 
-  return xFarFsDrives[ u8PhyDrvNb ].pxWrite( pu8Buffer, xSector, u32Count );
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+  if ( EF_BOOL_FALSE != xFarFsDrivesElevator[ u8PhyDrvNb ].bStarted )
+  {
+    eRetVal = eEFPrvDriveElevatorQueue( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+  }
+  else
+#endif
+  {
+    eRetVal = eEFPrvDriveWriteStaged( u8PhyDrvNb, pu8Buffer, xSector, u32Count );
+  }
+  EF_DRIVE_UNLOCK( u8PhyDrvNb );
+
+  return eRetVal;
 }
 
 /* Miscellaneous Functions */
@@ -114,14 +1215,110 @@ ef_return_et  eEFPrvDriveIOCtrl (
   void      * pvBuffer
 )
 {
-//  EF_ASSERT_PRIVATE( EF_CONF_DRIVERS_NB <= u8PhyDrvNb );
 
   /* Assertion of non null buffer delegated to driver function
    * as it might be null if not needed
    */
   //  EF_ASSERT_PRIVATE( 0 != pvBuffer );
 
-  return xFarFsDrives[ u8PhyDrvNb ].pxCtrl( u8Cmd, pvBuffer );
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_lba_t    * pxRange = (ef_lba_t *) pvBuffer;
+
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+  /* The queued sectors are written before a sync */
+  if ( CTRL_SYNC == u8Cmd )
+  {
+    eRetVal = eEFPrvDriveElevatorStop( u8PhyDrvNb );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#endif
+#if ( 0 != EF_CONF_DRIVE_AGGREGATE )
+  /* The staged sectors are written before a sync, and forgotten when discarded or zeroed */
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if ( CTRL_SYNC == u8Cmd )
+  {
+    eRetVal = eEFPrvDriveStageFlush( u8PhyDrvNb );
+  }
+  else if ( ( ( CTRL_TRIM == u8Cmd ) || ( CTRL_WRITE_ZEROES == u8Cmd ) ) && ( 0 != pvBuffer ) )
+  {
+    (void) eEFPrvDriveStageDrop( u8PhyDrvNb, pxRange[ 0 ], pxRange[ 1 ] );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#endif
+
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* If the driver does not support TRIM, the hint is dropped */
+  else if (    ( CTRL_TRIM == u8Cmd )
+       && ( 0 == ( EF_DRIVE_CAP_TRIM & xFarFsDrivesCaps[ u8PhyDrvNb ].u32Features ) ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+#if ( 0 != EF_CONF_STATS )
+    if ( CTRL_TRIM == u8Cmd )
+    {
+      (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32TrimCmds, 1 );
+    }
+    else if ( CTRL_SYNC == u8Cmd )
+    {
+      (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32SyncCmds, 1 );
+    }
+    else if ( CTRL_WRITE_ZEROES == u8Cmd )
+    {
+      (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32WriteCmds, 1 );
+      (void) u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsWritten,
+                                 pxRange[ 1 ] - pxRange[ 0 ] + 1 );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+#endif
+
+#if ( 0 != EF_CONF_TRACE )
+    ef_u32_t  u32Timestamp = u32EFPortTimestampGet( );
+#endif
+
+    eRetVal = xFarFsDrives[ u8PhyDrvNb ].pxCtrl( u8Cmd, pvBuffer );
+
+#if ( 0 != EF_CONF_TRACE )
+    /* Geometry queries are not recorded, zero fills are recorded as writes */
+    if ( ( ( CTRL_TRIM == u8Cmd ) || ( CTRL_WRITE_ZEROES == u8Cmd ) ) && ( 0 != pvBuffer ) )
+    {
+      (void) eEFPrvDriveTraceRecord( ( CTRL_TRIM == u8Cmd ) ? EF_TRACE_TRIM : EF_TRACE_WRITE,
+                                     u8PhyDrvNb,
+                                     pxRange[ 0 ],
+                                     (ef_u32_t) ( pxRange[ 1 ] - pxRange[ 0 ] + 1 ),
+                                     u32Timestamp,
+                                     eRetVal );
+    }
+    else if ( CTRL_SYNC == u8Cmd )
+    {
+      (void) eEFPrvDriveTraceRecord( EF_TRACE_SYNC, u8PhyDrvNb, 0, 0, u32Timestamp, eRetVal );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+#endif
+  }
+  EF_DRIVE_UNLOCK( u8PhyDrvNb );
+
+  return eRetVal;
 }
 
 /* Register a Drive */
@@ -145,6 +1342,16 @@ ef_return_et eEFPrvDriveRegister (
     xFarFsDrives[ u8FarFsDrivesNb ].pxWrite       = pxDriveFunctions->pxWrite;
     /* Register function to I/O control operation */
     xFarFsDrives[ u8FarFsDrivesNb ].pxCtrl        = pxDriveFunctions->pxCtrl;
+    /* Capabilities of a driver that does not report them, until it is initialized */
+    xFarFsDrivesCaps[ u8FarFsDrivesNb ].u32MaxSectors   = 0;
+    xFarFsDrivesCaps[ u8FarFsDrivesNb ].u32Alignment    = 1;
+    xFarFsDrivesCaps[ u8FarFsDrivesNb ].u32Granularity  = 1;
+    xFarFsDrivesCaps[ u8FarFsDrivesNb ].u32Features     = EF_DRIVE_CAP_TRIM;
+#if ( 0 != EF_CONF_FS_LOCK )
+    eRetVal = eEFPortLockCreate( &xFarFsDrivesLock[ u8FarFsDrivesNb ] );
+#endif
+    /* The next driver gets the next drive number */
+    u8FarFsDrivesNb++;
   }
   else
   {
@@ -154,5 +1361,162 @@ ef_return_et eEFPrvDriveRegister (
   return eRetVal;
 }
 
+/* Start queuing the writes of a Drive */
+ef_return_et eEFPrvDriveElevatorStart (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+#if ( 0 != EF_CONF_DRIVE_ELEVATOR )
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+  xFarFsDrivesElevator[ u8PhyDrvNb ].bStarted = EF_BOOL_TRUE;
+  EF_DRIVE_UNLOCK( u8PhyDrvNb );
+#else
+  (void) u8PhyDrvNb;
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Issue the queued writes of a Drive and stop queuing */
+ef_return_et eEFPrvDriveElevatorFlush (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+  ef_return_et  eRetVal;
+
+  EF_DRIVE_LOCK( u8PhyDrvNb );
+  eRetVal = eEFPrvDriveElevatorStop( u8PhyDrvNb );
+  EF_DRIVE_UNLOCK( u8PhyDrvNb );
+
+  return eRetVal;
+}
+
+/* Get the capabilities of a Drive */
+ef_return_et eEFPrvDriveCapsGet (
+  ef_u08_t            u8PhyDrvNb,
+  ef_drive_caps_st  * pxCaps
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCaps );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_CONF_DRIVERS_NB <= u8PhyDrvNb )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_PARAMETER );
+  }
+  else
+  {
+    *pxCaps = xFarFsDrivesCaps[ u8PhyDrvNb ];
+  }
+
+  return eRetVal;
+}
+
+/* Get the counters of a Drive */
+ef_return_et eEFPrvDriveStatsGet (
+  ef_u08_t      u8PhyDrvNb,
+  ef_stats_st * pxStats
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxStats );
+
+#if ( 0 != EF_CONF_STATS )
+  /* The counters are read one by one, the commands in progress keep counting */
+  pxStats->u32ReadCmds        = u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32ReadCmds, 0 );
+  pxStats->u32WriteCmds       = u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32WriteCmds, 0 );
+  pxStats->u64SectorsRead     = u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsRead, 0 );
+  pxStats->u64SectorsWritten  = u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsWritten, 0 );
+  pxStats->u32TrimCmds        = u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32TrimCmds, 0 );
+  pxStats->u32SyncCmds        = u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32SyncCmds, 0 );
+#else
+  (void) u8PhyDrvNb;
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Start or stop the command trace */
+ef_return_et eEFPrvDriveTraceEnable (
+  ef_bool_t bEnable
+)
+{
+#if ( 0 != EF_CONF_TRACE )
+  (void) eEFPortCriticalEnter( );
+  if ( EF_BOOL_FALSE != bEnable )
+  {
+    u32FarFsTraceFirst  = 0;
+    u32FarFsTraceNb     = 0;
+    u32FarFsTraceLost   = 0;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  bFarFsTraceEnabled = bEnable;
+  (void) eEFPortCriticalExit( );
+#else
+  (void) bEnable;
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Read the oldest records of the command trace */
+ef_return_et eEFPrvDriveTraceRead (
+  ef_trace_record_st  * pxRecords,
+  ef_u32_t              u32RecordsMax,
+  ef_u32_t            * pu32RecordsNb,
+  ef_u32_t            * pu32LostNb
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxRecords );
+  EF_ASSERT_PRIVATE( 0 != pu32RecordsNb );
+  EF_ASSERT_PRIVATE( 0 != pu32LostNb );
+
+  *pu32RecordsNb  = 0;
+  *pu32LostNb     = 0;
+#if ( 0 != EF_CONF_TRACE )
+  (void) eEFPortCriticalEnter( );
+  while ( ( *pu32RecordsNb < u32RecordsMax ) && ( 0 != u32FarFsTraceNb ) )
+  {
+    pxRecords[ *pu32RecordsNb ] = xFarFsTrace[ u32FarFsTraceFirst ];
+    u32FarFsTraceFirst = ( u32FarFsTraceFirst + 1 ) % EF_CONF_TRACE_DEPTH;
+    u32FarFsTraceNb--;
+    ( *pu32RecordsNb )++;
+  }
+  *pu32LostNb       = u32FarFsTraceLost;
+  u32FarFsTraceLost = 0;
+  (void) eEFPortCriticalExit( );
+#else
+  (void) u32RecordsMax;
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Reset the counters of a Drive */
+ef_return_et eEFPrvDriveStatsReset (
+  ef_u08_t  u8PhyDrvNb
+)
+{
+#if ( 0 != EF_CONF_STATS )
+  ef_stats_st xStats;
+
+  /* Take off what was read, the commands counted meanwhile are kept */
+  (void) eEFPrvDriveStatsGet( u8PhyDrvNb, &xStats );
+  (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32ReadCmds, 0 - xStats.u32ReadCmds );
+  (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32WriteCmds, 0 - xStats.u32WriteCmds );
+  (void) u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsRead, 0 - xStats.u64SectorsRead );
+  (void) u64EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u64SectorsWritten, 0 - xStats.u64SectorsWritten );
+  (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32TrimCmds, 0 - xStats.u32TrimCmds );
+  (void) u32EFPortAtomicAdd( &xFarFsDrivesStats[ u8PhyDrvNb ].u32SyncCmds, 0 - xStats.u32SyncCmds );
+#else
+  (void) u8PhyDrvNb;
+#endif
+
+  return EF_RET_OK;
+}
+
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
@@ -51,6 +51,11 @@
  */
 #define EF_FAT_END_OF_CHAIN  0xFFFFFFFF
 
+/**
+ * Clusters scanned at most for a contiguous free run before taking the clusters one by one
+ */
+#define EF_FAT_RUN_SCAN_NB  ( 4096 )
+
 /* Local function macros ------------------------------------------------------------------------------------------- */
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
 /* Local variables ------------------------------------------------------------------------------------------------- */
@@ -76,6 +81,29 @@ static ef_return_et eEFPrvFATClusterFindFree (
   ef_u32_t      * pu32Cluster
 );
 
+/**
+ *  @brief  FAT access - Find a run of contiguous free clusters
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32Cluster    Cluster number from where to start looking
+ *  @param  u32ClusterNb  Number of contiguous free clusters needed
+ *  @param  u32ScanNb     Number of clusters scanned at most, the whole FAT being scanned once at most
+ *  @param  pu32Cluster   Pointer to the first cluster number of the run to update
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_FAT_FULL No run of u32ClusterNb free clusters among the clusters scanned
+ *  @retval EF_RET_INT_ERR  Internal error
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+static ef_return_et eEFPrvFATRunFindFree (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNb,
+  ef_u32_t    u32ScanNb,
+  ef_u32_t  * pu32Cluster
+);
+
 /* Local functions ------------------------------------------------------------------------------------------------- */
 static ef_return_et eEFPrvFATClusterFindFree (
   ef_object_st  * pxObject,
@@ -97,27 +125,13 @@ static ef_return_et eEFPrvFATClusterFindFree (
   else
   {
     ef_u32_t  u32ClusterValue;
-    ef_u32_t  u32ClusterStop = 0;
-    /* If we start from the beginning of the FAT */
-    if ( 2 == u32Cluster )
-    {
-      /* Stop at the end of the FAT */
-      u32ClusterStop = 0;
-    }
-    /* Else, if we start from the end of the FAT */
-    else if ( pxFS->u32FatEntriesNb == u32Cluster )
-    {
-      /* Stop just before the end of the FAT */
-      u32ClusterStop = pxFS->u32FatEntriesNb - 1;
-    }
-    else
-    {
-      /* Stop at the end of the FAT */
-      u32ClusterStop = u32Cluster - 1;
-    }
+    /* Number of clusters left to scan, every cluster is scanned once */
+    ef_u32_t  u32ClusterLeft = pxFS->u32FatEntriesNb - 2;
 
+    /* By default, FAT is full */
+    eRetVal = EF_RET_FAT_FULL;
     /* Loop through the FAT */
-    while ( u32ClusterStop != u32Cluster )
+    while ( 0 != u32ClusterLeft )
     {
       /* Get the cluster status */
       /* If an error occured */
@@ -130,17 +144,20 @@ static ef_return_et eEFPrvFATClusterFindFree (
       /* Else, if a free cluster */
       else if ( 0 == u32ClusterValue )
       {
-        /* Return new cluster number or error status */
+        /* Return new cluster number */
         *pu32Cluster = u32Cluster;
+        eRetVal = EF_RET_OK;
         break;
       }
       else
       {
         /* Keep Looping */
+        u32ClusterLeft--;
         u32Cluster++;
-        if ( pxFS->u32FatEntriesNb < u32Cluster )
+        /* If the end of the FAT is reached */
+        if ( pxFS->u32FatEntriesNb <= u32Cluster )
         {
-          /* Stop just before the end of the FAT */
+          /* Wrap around to the first cluster */
           u32Cluster = 2;
         }
         else
@@ -150,21 +167,107 @@ static ef_return_et eEFPrvFATClusterFindFree (
       }
     } /* Loop through the FAT */
 
-    if ( u32ClusterStop == u32Cluster )
+  }
+  /* If no free cluster was found or an error occured */
+  if ( EF_RET_OK != eRetVal )
+  {
+    /* Set cluster number to 0 */
+    *pu32Cluster = 0;
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvFATRunFindFree (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNb,
+  ef_u32_t    u32ScanNb,
+  ef_u32_t  * pu32Cluster
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pu32Cluster );
+
+  /* By default, no run is large enough */
+  ef_return_et  eRetVal = EF_RET_FAT_FULL;
+
+  ef_u32_t  u32ClusterValue;
+  ef_u32_t  u32RunStart = 0;
+  ef_u32_t  u32RunLength = 0;
+  /* Scan the whole FAT once at most, plus enough to catch a run crossing the start cluster */
+  ef_u32_t  u32Remaining = ( pxFS->u32FatEntriesNb - 2 ) + u32ClusterNb - 1;
+
+  if ( u32Remaining > u32ScanNb )
+  {
+    u32Remaining = u32ScanNb;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  /* Loop through the FAT */
+  while ( 0 != u32Remaining )
+  {
+    u32Remaining--;
+    /* If getting the cluster status failed */
+    if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterValue ) )
     {
-      /* By default, FAT is full */
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_FULL );
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+      /* Return immediately */
+      break;
+    }
+    /* Else, if a free cluster */
+    else if ( 0 == u32ClusterValue )
+    {
+      /* If a new run begins here */
+      if ( 0 == u32RunLength )
+      {
+        u32RunStart = u32Cluster;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      u32RunLength++;
+      /* If the run is large enough */
+      if ( u32ClusterNb == u32RunLength )
+      {
+        eRetVal = EF_RET_OK;
+        break;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    else
+    {
+      /* The run is broken */
+      u32RunLength = 0;
+    }
+    /* Keep Looping */
+    u32Cluster++;
+    if ( pxFS->u32FatEntriesNb <= u32Cluster )
+    {
+      /* Wrap to the beginning of the FAT, a run cannot cross the end of the FAT */
+      u32Cluster = 2;
+      u32RunLength = 0;
     }
     else
     {
       EF_CODE_COVERAGE( );
     }
+  } /* Loop through the FAT */
 
+  /* If a run was found */
+  if ( EF_RET_OK == eRetVal )
+  {
+    *pu32Cluster = u32RunStart;
   }
-  /* If no free cluster was found or an error occured */
-  if ( EF_RET_OK != eRetVal )
+  else
   {
-    /* Set cluster number to 0 */
     *pu32Cluster = 0;
   }
 
@@ -293,6 +396,8 @@ ef_return_et eEFPrvFATGet (
 
   ef_return_et  eRetVal = EF_RET_OK;
 
+  EF_STATS_ADD( pxFS, u32FatGets, 1 );
+
   /* If Cluster not in valid range */
   if ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
   {
@@ -389,6 +494,8 @@ ef_return_et eEFPrvFATSet (
 
   /* Check if in valid range */
   ef_return_et eRetVal = EF_RET_INT_ERR;
+  /* Value as requested, the FAT32 reserved bits are merged in u32NewValue */
+  ef_u32_t     u32Value = u32NewValue;
 
   /* If Cluster not in valid range */
   if ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
@@ -397,7 +504,6 @@ ef_return_et eEFPrvFATSet (
   }
   else if ( 0 != ( EF_FS_FAT32 & pxFS->u8FsType ) )
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
 
       /* Load the FS window with the sector containing the FAT Cluster Number */
       if ( EF_RET_OK != eEFPrvFSWindowLoad(   pxFS,
@@ -413,6 +519,7 @@ ef_return_et eEFPrvFATSet (
                           & 0xF0000000 );
         vEFPortStoreu32( pxFS->pu8Window + u32Cluster * 4 % EF_SECTOR_SIZE( pxFS ), u32NewValue );
         pxFS->u8WinFlags = EF_FS_WIN_DIRTY;
+        eRetVal = EF_RET_OK;
       }
 
   }
@@ -432,6 +539,7 @@ ef_return_et eEFPrvFATSet (
         vEFPortStoreu16(  pxFS->pu8Window + u32Cluster * 2 % EF_SECTOR_SIZE( pxFS ),
                     (ef_u16_t)u32NewValue );
         pxFS->u8WinFlags = EF_FS_WIN_DIRTY;
+        eRetVal = EF_RET_OK;
       }
 
   }
@@ -477,6 +585,7 @@ ef_return_et eEFPrvFATSet (
           *p = (ef_u08_t) ((*p & 0xF0) | ((ef_u08_t)(u32NewValue >> 8) & 0x0F));
         }
         pxFS->u8WinFlags = EF_FS_WIN_DIRTY;
+        eRetVal = EF_RET_OK;
       }
     }
 
@@ -486,6 +595,18 @@ ef_return_et eEFPrvFATSet (
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
   }
 
+  /* If the entry was written */
+  if ( EF_RET_OK == eRetVal )
+  {
+    EF_STATS_ADD( pxFS, u32FatSets, 1 );
+    /* Keep the free extent index in line with the FAT */
+    (void) eEFPrvFATIndexUpdate( pxFS, u32Cluster, u32Value );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
   return eRetVal;
 }
 
@@ -716,6 +837,7 @@ ef_return_et eEFPrvFATChainRemove (
         }
     //    else
     //    {
+        EF_STATS_ADD( pxFS, u32ClustersFreed, 1 );
         if ( pxFS->u32ClstFreeNb < ( pxFS->u32FatEntriesNb - 2 ) )
         {  /* Update FSINFO */
           pxFS->u32ClstFreeNb++;
@@ -808,6 +930,7 @@ ef_return_et eEFPrvFATChainCreate (
     else
     {
       /* Update FSINFO. */
+      EF_STATS_ADD( pxFS, u32ClustersAllocated, 1 );
       pxFS->u32ClstLast = u32ClusterNew;
       if ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) )
       {
@@ -835,14 +958,12 @@ ef_return_et eEFPrvFATChainStretch (
   EF_ASSERT_PRIVATE( 0 != pxObject );
   EF_ASSERT_PRIVATE( 0 != pu32Cluster );
 
-  ef_return_et    eRetVal = EF_RET_FAT_FULL; /* By default, FAT is full */
+  ef_return_et    eRetVal = EF_RET_OK;
   ef_fs_st      * pxFS = pxObject->pxFS;
 
   ef_u32_t  u32ClusterStart = 0;
   ef_u32_t  u32ClusterValue = 0;
 
-  /* GET THE CLUSTER FROM WHERE TO START SEARCHING BEGIN */
-  /* Stretch a chain */
   /* If getting the cluster status failed */
   if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterValue ) )
   {
@@ -856,83 +977,59 @@ ef_return_et eEFPrvFATChainStretch (
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
   }
   /* Else, if we have a valid linked cluster */
-  else if ( pxFS->u32FatEntriesNb >= u32ClusterValue )
+  else if ( pxFS->u32FatEntriesNb > u32ClusterValue )
   {
-    ef_u32_t  u32ClusterNew = u32ClusterValue;
-    /* If getting the next cluster status failed */
-    if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32ClusterNew, &u32ClusterValue ) )
-    {
-      /* There is an eror */
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
-    }
-    /* Else, if we have an invalid linked cluster */
-    else if ( 2 > u32ClusterValue )
-    {
-      /* There is an eror */
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
-    }
-    else
-    {
-      /* Function completed succesfully */
-      eRetVal = EF_RET_OK;
-      /* Return next cluster numbers */
-      *pu32Cluster = u32ClusterNew;
-    }
+    /* Crawl to the next cluster of the chain */
+    *pu32Cluster = u32ClusterValue;
   }
-  else
+  /* Else we have an End Of Chain cluster, if there are no free clusters */
+  else if ( 0 == pxFS->u32ClstFreeNb )
   {
-    EF_CODE_COVERAGE( );
-  }
-  /* Else we have an End Of Chain cluster */
-  /* If there are free clusters */
-  if ( 0 == pxFS->u32ClstFreeNb )
-  //if ( pxFS->u32FatEntriesNb < u32ClusterValue )
-  {
-    /* There is an eror */
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_FULL );
   }
-  else //if ( pxFS->u32FatEntriesNb < u32ClusterValue )
+  else
   {
-    /* Stretching an existing chain? */
-    /* Suggested cluster to start to find */
-    u32ClusterStart = pxFS->u32ClstLast;
-    /* If    last cluster is null
-     *    OR last cluster is not known
-     */
-    if ( EF_RET_OK == eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
+    /* Search right after the chain end first, to keep the file contiguous */
+    u32ClusterStart = u32Cluster + 1;
+    /* If the chain end is the last cluster of the FAT */
+    if ( pxFS->u32FatEntriesNb <= u32ClusterStart )
     {
       /* Start searching from beggining of the FAT */
       u32ClusterStart = 2;
     }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
     /* SEARCH FOR A FREE CLUSTER BEGIN */
     ef_u32_t  u32ClusterNew = 0;
-    /* If we found a free cluster starting from cluster start */
+    /* If no free cluster was found starting from cluster start */
     if ( EF_RET_OK != eEFPrvFATClusterFindFree( pxObject, u32ClusterStart, &u32ClusterNew ) )
     {
-      ; /* No Free Cluster found */
+      /* No Free Cluster found */
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_FULL );
     }
-    /* Else, if marking the new cluster as end of chain 'EOC' */
+    /* Else, if marking the new cluster as end of chain 'EOC' failed */
     else if ( EF_RET_OK != eEFPrvFATSet( pxFS, u32ClusterNew, EF_FAT_END_OF_CHAIN) )
     {
-      ; /* No Free Cluster found */
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
     }
-    /* Else, if linking it from the previous one if needed */
+    /* Else, if linking it from the previous one failed */
     else if ( EF_RET_OK != eEFPrvFATSet( pxFS, u32Cluster, u32ClusterNew ) )
     {
-      ; /* No Free Cluster found */
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
     }
     /* Else, all function succeeded. */
     else
     {
       /* Update FSINFO. */
+      EF_STATS_ADD( pxFS, u32ClustersAllocated, 1 );
       pxFS->u32ClstLast = u32ClusterNew;
       if ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) )
       {
         pxFS->u32ClstFreeNb--;
       }
       pxFS->u8FsInfoFlags |= 1;
-      /* Function completed succesfully */
-      eRetVal = EF_RET_OK;
       /* Return new cluster numbers */
       *pu32Cluster = u32ClusterNew;
     }
@@ -942,5 +1039,223 @@ ef_return_et eEFPrvFATChainStretch (
   return eRetVal;
 }
 
+ef_return_et eEFPrvFATChainRunAppend (
+  ef_object_st  * pxObject,
+  ef_u32_t        u32ClusterPrev,
+  ef_u32_t        u32ClusterNb,
+  ef_bool_t       bContiguous,
+  ef_u32_t      * pu32Cluster
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxObject );
+  EF_ASSERT_PRIVATE( 0 != pu32Cluster );
+
+  ef_return_et    eRetVal = EF_RET_OK;
+  ef_fs_st      * pxFS = pxObject->pxFS;
+
+  ef_u32_t  u32ClusterFirst = 0;
+  ef_u32_t  u32ClusterTail = 0;
+
+  /* If there is nothing to allocate */
+  if ( 0 == u32ClusterNb )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if the free clusters count is known and too small */
+  else if (    ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) )
+            && ( pxFS->u32ClstFreeNb < u32ClusterNb ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_FULL );
+  }
+  else
+  {
+    /* GET THE CLUSTER FROM WHERE TO START SEARCHING BEGIN */
+    /* Try to continue the chain first, else start from the last allocated cluster */
+    ef_u32_t  u32Cluster = ( 0 != u32ClusterPrev ) ? ( u32ClusterPrev + 1 ) : pxFS->u32ClstLast;
+    if ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
+    {
+      /* Start searching from beginning of the FAT */
+      u32Cluster = 2;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* GET THE CLUSTER FROM WHERE TO START SEARCHING END */
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+    /* If     the chain is continued
+     *    AND the clusters following it are free
+     */
+    if (    ( 0 != u32ClusterPrev )
+         && ( EF_RET_OK == eEFPrvFATRunFindFree( pxFS, u32Cluster, u32ClusterNb, u32ClusterNb, &u32ClusterFirst ) ) )
+    {
+      eRetVal = EF_RET_OK;
+    }
+    /* Else, if the free extent index has no run large enough */
+    else if ( EF_RET_DENIED == ( eRetVal = eEFPrvFATIndexFind( pxFS, u32ClusterNb, &u32ClusterFirst ) ) )
+    {
+      eRetVal = EF_RET_FAT_FULL;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+#else
+    /* A run is looked for over the whole FAT only when it is required, else within a window */
+    eRetVal = eEFPrvFATRunFindFree( pxFS,
+                                    u32Cluster,
+                                    u32ClusterNb,
+                                    ( EF_BOOL_FALSE != bContiguous ) ? pxFS->u32FatEntriesNb : EF_FAT_RUN_SCAN_NB,
+                                    &u32ClusterFirst );
+#endif
+    /* If a contiguous run was found */
+    if ( EF_RET_OK == eRetVal )
+    { /* CONTIGUOUS RUN BEGIN */
+      /* Chain the run, the last cluster being the end of chain */
+      for ( ef_u32_t u32Index = 1 ; u32Index <= u32ClusterNb ; u32Index++ )
+      {
+        u32ClusterTail = u32ClusterFirst + u32Index - 1;
+        if ( EF_RET_OK != eEFPrvFATSet( pxFS,
+                                        u32ClusterTail,
+                                        ( u32ClusterNb == u32Index ) ? EF_FAT_END_OF_CHAIN : ( u32ClusterTail + 1 ) ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+          /* The last cluster chained links to the failed one: free the part of the run taken by its index */
+          for ( ef_u32_t u32Free = u32ClusterFirst ; u32Free < u32ClusterTail ; u32Free++ )
+          {
+            (void) eEFPrvFATSet( pxFS, u32Free, 0 );
+            EF_STATS_ADD( pxFS, u32ClustersFreed, 1 );
+            if ( pxFS->u32ClstFreeNb < ( pxFS->u32FatEntriesNb - 2 ) )
+            {
+              pxFS->u32ClstFreeNb++;
+            }
+            else
+            {
+              EF_CODE_COVERAGE( );
+            }
+          }
+          pxFS->u8FsInfoFlags |= 1;
+          u32ClusterFirst = 0;
+          break;
+        }
+        /* Else, update FSINFO */
+        else
+        {
+          EF_STATS_ADD( pxFS, u32ClustersAllocated, 1 );
+          if ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) )
+          {
+            pxFS->u32ClstFreeNb--;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+        }
+      }
+    } /* CONTIGUOUS RUN END */
+    /* Else, if there is no contiguous run large enough and a fragmented chain is allowed */
+    else if (    ( EF_RET_FAT_FULL == eRetVal )
+              && ( EF_BOOL_FALSE == bContiguous ) )
+    { /* CLUSTER BY CLUSTER BEGIN */
+      eRetVal = EF_RET_OK;
+      for ( ef_u32_t u32Index = 0 ; u32Index < u32ClusterNb ; u32Index++ )
+      {
+        ef_u32_t  u32ClusterNew = 0;
+        /* If finding a free cluster failed */
+        if ( EF_RET_OK != eEFPrvFATClusterFindFree( pxObject, u32Cluster, &u32ClusterNew ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_FULL );
+          break;
+        }
+        /* Else, if marking the new cluster as end of chain 'EOC' failed */
+        else if ( EF_RET_OK != eEFPrvFATSet( pxFS, u32ClusterNew, EF_FAT_END_OF_CHAIN ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+          break;
+        }
+        /* Else, if linking it from the previous new one failed */
+        else if (    ( 0 != u32ClusterTail )
+                  && ( EF_RET_OK != eEFPrvFATSet( pxFS, u32ClusterTail, u32ClusterNew ) ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+          /* It is not in the chain freed below */
+          (void) eEFPrvFATSet( pxFS, u32ClusterNew, 0 );
+          break;
+        }
+        else
+        {
+          if ( 0 == u32ClusterFirst )
+          {
+            u32ClusterFirst = u32ClusterNew;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+          u32ClusterTail = u32ClusterNew;
+          /* Update FSINFO */
+          EF_STATS_ADD( pxFS, u32ClustersAllocated, 1 );
+          if ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) )
+          {
+            pxFS->u32ClstFreeNb--;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+          /* Next search starts after this cluster */
+          u32Cluster = u32ClusterNew + 1;
+          if ( pxFS->u32FatEntriesNb <= u32Cluster )
+          {
+            u32Cluster = 2;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+        }
+      }
+    } /* CLUSTER BY CLUSTER END */
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* If the new clusters are chained, link them to the existing chain if any */
+    if ( EF_RET_OK != eRetVal )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    else if (    ( 0 != u32ClusterPrev )
+              && ( EF_RET_OK != eEFPrvFATSet( pxFS, u32ClusterPrev, u32ClusterFirst ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+    }
+    else
+    {
+      /* Update FSINFO */
+      pxFS->u32ClstLast = u32ClusterTail;
+      pxFS->u8FsInfoFlags |= 1;
+      /* Return first new cluster number */
+      *pu32Cluster = u32ClusterFirst;
+    }
+
+    /* If something failed after some clusters were taken */
+    if (    ( EF_RET_OK != eRetVal )
+         && ( 0 != u32ClusterFirst ) )
+    {
+      /* Give them back, the existing chain being left as it was */
+      (void) eEFPrvFATChainRemove( pxObject, u32ClusterFirst, 0 );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,723 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_prv_fat_index.c
+ *  @ingroup  group_eFAT_Private
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Private file - Free extent index of the FAT
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include "ef_prv_def.h"
+#include "ef_prv_fat.h"
+#include <ef_port_memory.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+/**
+ *  Tree of the runs ordered by first cluster, to find the runs around a cluster
+ */
+#define EF_FAT_INDEX_BY_CLUSTER ( 0 )
+
+/**
+ *  Tree of the runs ordered by length then first cluster, to find the smallest run that fits
+ */
+#define EF_FAT_INDEX_BY_LENGTH  ( 1 )
+
+/**
+ *  Children of a run in a tree
+ */
+#define EF_FAT_INDEX_LEFT       ( 0 )
+#define EF_FAT_INDEX_RIGHT      ( 1 )
+#endif
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+/**
+ *  Run of the index from its number, origin from 1
+ */
+#define EF_FAT_INDEX_RUN( pxFS, u16Run )  ( &( pxFS )->xFreeIndex[ ( u16Run ) - 1 ] )
+#endif
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+/**
+ *  @brief  Compare a run of the index with a key of a tree
+ *
+ *  @param  pxRun         Pointer to the run
+ *  @param  u8Tree        EF_FAT_INDEX_BY_CLUSTER or EF_FAT_INDEX_BY_LENGTH
+ *  @param  u32Cluster    First cluster of the key
+ *  @param  u32ClusterNb  Number of clusters of the key, only used by EF_FAT_INDEX_BY_LENGTH
+ *
+ *  @return -1, 0 or 1 when the run is before, at or after the key
+ */
+static int iEFPrvFATIndexCompare (
+  const ef_free_run_st  * pxRun,
+  ef_u08_t                u8Tree,
+  ef_u32_t                u32Cluster,
+  ef_u32_t                u32ClusterNb
+);
+
+/**
+ *  @brief  Priority of a run in the trees, a hash of its number
+ *
+ *  @param  u16Run  Run of the index, origin from 1
+ *
+ *  @return Priority, the run with the highest one is the root
+ */
+static ef_u32_t u32EFPrvFATIndexPriority (
+  ef_u16_t  u16Run
+);
+
+/**
+ *  @brief  Split a tree in the runs before a key and the others
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u8Tree        EF_FAT_INDEX_BY_CLUSTER or EF_FAT_INDEX_BY_LENGTH
+ *  @param  u16Root       Root of the tree to split
+ *  @param  u32Cluster    First cluster of the key
+ *  @param  u32ClusterNb  Number of clusters of the key
+ *  @param  bInclusive    EF_BOOL_TRUE: the run at the key goes to the first tree
+ *  @param  pu16Before    Pointer to the root of the runs before the key
+ *  @param  pu16After     Pointer to the root of the other runs
+ */
+static void vEFPrvFATIndexSplit (
+  ef_fs_st  * pxFS,
+  ef_u08_t    u8Tree,
+  ef_u16_t    u16Root,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNb,
+  ef_bool_t   bInclusive,
+  ef_u16_t  * pu16Before,
+  ef_u16_t  * pu16After
+);
+
+/**
+ *  @brief  Join two trees, every run of the first one being before the runs of the second one
+ *
+ *  @param  pxFS      Pointer to the Filesystem object
+ *  @param  u8Tree    EF_FAT_INDEX_BY_CLUSTER or EF_FAT_INDEX_BY_LENGTH
+ *  @param  u16First  Root of the first tree
+ *  @param  u16Second Root of the second tree
+ *
+ *  @return Root of the joined tree
+ */
+static ef_u16_t u16EFPrvFATIndexJoin (
+  ef_fs_st  * pxFS,
+  ef_u08_t    u8Tree,
+  ef_u16_t    u16First,
+  ef_u16_t    u16Second
+);
+
+/**
+ *  @brief  Remove a run from the index
+ *
+ *  @param  pxFS    Pointer to the Filesystem object
+ *  @param  u16Run  Run to remove, origin from 1
+ */
+static void vEFPrvFATIndexRemove (
+  ef_fs_st  * pxFS,
+  ef_u16_t    u16Run
+);
+
+/**
+ *  @brief  Insert a run in the index
+ *          When the index is full, the smallest run is dropped and the index becomes partial.
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32Cluster    First cluster of the run
+ *  @param  u32ClusterNb  Number of clusters of the run
+ */
+static void vEFPrvFATIndexInsert (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNb
+);
+
+/**
+ *  @brief  Search of the smallest run of the index holding a number of clusters
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32ClusterNb  Number of contiguous clusters needed
+ *  @param  pu32Cluster   Pointer to the first cluster of the run to update
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK       Succeeded
+ *  @retval EF_RET_DENIED   No run of the index is large enough
+ */
+static ef_return_et eEFPrvFATIndexSearch (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32ClusterNb,
+  ef_u32_t  * pu32Cluster
+);
+#endif
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+static int iEFPrvFATIndexCompare (
+  const ef_free_run_st  * pxRun,
+  ef_u08_t                u8Tree,
+  ef_u32_t                u32Cluster,
+  ef_u32_t                u32ClusterNb
+)
+{
+  int iRetVal = 0;
+
+  if (    ( EF_FAT_INDEX_BY_LENGTH == u8Tree )
+       && ( pxRun->u32ClusterNb != u32ClusterNb ) )
+  {
+    iRetVal = ( pxRun->u32ClusterNb < u32ClusterNb ) ? -1 : 1;
+  }
+  else if ( pxRun->u32Cluster != u32Cluster )
+  {
+    iRetVal = ( pxRun->u32Cluster < u32Cluster ) ? -1 : 1;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return iRetVal;
+}
+
+static ef_u32_t u32EFPrvFATIndexPriority (
+  ef_u16_t  u16Run
+)
+{
+  ef_u32_t  u32Hash = u16Run;
+
+  /* Finalizer of MurmurHash3, the priorities of consecutive runs look random */
+  u32Hash ^= u32Hash >> 16;
+  u32Hash *= 0x85EBCA6BUL;
+  u32Hash ^= u32Hash >> 13;
+  u32Hash *= 0xC2B2AE35UL;
+  u32Hash ^= u32Hash >> 16;
+
+  return u32Hash;
+}
+
+/* The trees are treaps: ordered by key, and each run is above its children in the order of their priorities, which
+ * keeps their depth logarithmic whatever the order of the updates. */
+static void vEFPrvFATIndexSplit (
+  ef_fs_st  * pxFS,
+  ef_u08_t    u8Tree,
+  ef_u16_t    u16Root,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNb,
+  ef_bool_t   bInclusive,
+  ef_u16_t  * pu16Before,
+  ef_u16_t  * pu16After
+)
+{
+  ef_free_run_st  * pxRun;
+  int               iOrder;
+
+  if ( 0 == u16Root )
+  {
+    *pu16Before = 0;
+    *pu16After = 0;
+  }
+  else
+  {
+    pxRun = EF_FAT_INDEX_RUN( pxFS, u16Root );
+    iOrder = iEFPrvFATIndexCompare( pxRun, u8Tree, u32Cluster, u32ClusterNb );
+    /* If the root goes to the first tree, with its left children */
+    if (    ( 0 > iOrder )
+         || (    ( 0 == iOrder )
+              && ( EF_BOOL_TRUE == bInclusive ) ) )
+    {
+      vEFPrvFATIndexSplit( pxFS, u8Tree, pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_RIGHT ],
+                           u32Cluster, u32ClusterNb, bInclusive,
+                           &pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_RIGHT ], pu16After );
+      *pu16Before = u16Root;
+    }
+    else
+    {
+      vEFPrvFATIndexSplit( pxFS, u8Tree, pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_LEFT ],
+                           u32Cluster, u32ClusterNb, bInclusive,
+                           pu16Before, &pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_LEFT ] );
+      *pu16After = u16Root;
+    }
+  }
+}
+
+static ef_u16_t u16EFPrvFATIndexJoin (
+  ef_fs_st  * pxFS,
+  ef_u08_t    u8Tree,
+  ef_u16_t    u16First,
+  ef_u16_t    u16Second
+)
+{
+  ef_u16_t          u16Root;
+  ef_free_run_st  * pxRun;
+
+  if ( 0 == u16First )
+  {
+    u16Root = u16Second;
+  }
+  else if ( 0 == u16Second )
+  {
+    u16Root = u16First;
+  }
+  /* Else, if the root of the first tree is above, the second tree joins its right children */
+  else if ( u32EFPrvFATIndexPriority( u16First ) > u32EFPrvFATIndexPriority( u16Second ) )
+  {
+    pxRun = EF_FAT_INDEX_RUN( pxFS, u16First );
+    pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_RIGHT ] =
+      u16EFPrvFATIndexJoin( pxFS, u8Tree, pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_RIGHT ], u16Second );
+    u16Root = u16First;
+  }
+  else
+  {
+    pxRun = EF_FAT_INDEX_RUN( pxFS, u16Second );
+    pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_LEFT ] =
+      u16EFPrvFATIndexJoin( pxFS, u8Tree, u16First, pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_LEFT ] );
+    u16Root = u16Second;
+  }
+
+  return u16Root;
+}
+
+static void vEFPrvFATIndexRemove (
+  ef_fs_st  * pxFS,
+  ef_u16_t    u16Run
+)
+{
+  ef_free_run_st  * pxRun = EF_FAT_INDEX_RUN( pxFS, u16Run );
+  ef_u16_t          u16Before;
+  ef_u16_t          u16At;
+  ef_u16_t          u16After;
+
+  /* Cut the run out of each tree and join the rest */
+  for ( ef_u08_t u8Tree = EF_FAT_INDEX_BY_CLUSTER ; u8Tree <= EF_FAT_INDEX_BY_LENGTH ; u8Tree++ )
+  {
+    vEFPrvFATIndexSplit( pxFS, u8Tree, pxFS->u16FreeIndexRoot[ u8Tree ],
+                         pxRun->u32Cluster, pxRun->u32ClusterNb, EF_BOOL_FALSE, &u16Before, &u16At );
+    vEFPrvFATIndexSplit( pxFS, u8Tree, u16At,
+                         pxRun->u32Cluster, pxRun->u32ClusterNb, EF_BOOL_TRUE, &u16At, &u16After );
+    pxFS->u16FreeIndexRoot[ u8Tree ] = u16EFPrvFATIndexJoin( pxFS, u8Tree, u16Before, u16After );
+  }
+
+  /* Give the run back to the free list */
+  pxRun->u16Child[ EF_FAT_INDEX_BY_CLUSTER ][ EF_FAT_INDEX_LEFT ] = pxFS->u16FreeIndexFree;
+  pxFS->u16FreeIndexFree = u16Run;
+  pxFS->u16FreeIndexNb--;
+}
+
+static void vEFPrvFATIndexInsert (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNb
+)
+{
+  ef_u16_t          u16Run;
+  ef_u16_t          u16Smallest;
+  ef_u16_t          u16Before;
+  ef_u16_t          u16After;
+  ef_free_run_st  * pxRun;
+
+  /* Smallest run of the index, the leftmost one of the tree by length */
+  u16Smallest = pxFS->u16FreeIndexRoot[ EF_FAT_INDEX_BY_LENGTH ];
+  while (    ( 0 != u16Smallest )
+          && ( 0 != EF_FAT_INDEX_RUN( pxFS, u16Smallest )->u16Child[ EF_FAT_INDEX_BY_LENGTH ][ EF_FAT_INDEX_LEFT ] ) )
+  {
+    u16Smallest = EF_FAT_INDEX_RUN( pxFS, u16Smallest )->u16Child[ EF_FAT_INDEX_BY_LENGTH ][ EF_FAT_INDEX_LEFT ];
+  }
+
+  /* If     the index is full
+   *    AND the run is not larger than the smallest one
+   */
+  if (    ( EF_CONF_FREE_INDEX == pxFS->u16FreeIndexNb )
+       && ( u32ClusterNb <= EF_FAT_INDEX_RUN( pxFS, u16Smallest )->u32ClusterNb ) )
+  {
+    /* Drop the run */
+    pxFS->u8FreeIndexState = EF_FAT_INDEX_PARTIAL;
+  }
+  else
+  {
+    /* If the index is full */
+    if ( EF_CONF_FREE_INDEX == pxFS->u16FreeIndexNb )
+    {
+      /* Drop the smallest run */
+      vEFPrvFATIndexRemove( pxFS, u16Smallest );
+      pxFS->u8FreeIndexState = EF_FAT_INDEX_PARTIAL;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* Take a released run, or one never used yet */
+    if ( 0 != pxFS->u16FreeIndexFree )
+    {
+      u16Run = pxFS->u16FreeIndexFree;
+      pxFS->u16FreeIndexFree = EF_FAT_INDEX_RUN( pxFS, u16Run )->u16Child[ EF_FAT_INDEX_BY_CLUSTER ][ EF_FAT_INDEX_LEFT ];
+    }
+    else
+    {
+      pxFS->u16FreeIndexUsed++;
+      u16Run = pxFS->u16FreeIndexUsed;
+    }
+    pxRun = EF_FAT_INDEX_RUN( pxFS, u16Run );
+    pxRun->u32Cluster = u32Cluster;
+    pxRun->u32ClusterNb = u32ClusterNb;
+
+    /* Put the run between the runs before and after it in each tree */
+    for ( ef_u08_t u8Tree = EF_FAT_INDEX_BY_CLUSTER ; u8Tree <= EF_FAT_INDEX_BY_LENGTH ; u8Tree++ )
+    {
+      pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_LEFT ] = 0;
+      pxRun->u16Child[ u8Tree ][ EF_FAT_INDEX_RIGHT ] = 0;
+      vEFPrvFATIndexSplit( pxFS, u8Tree, pxFS->u16FreeIndexRoot[ u8Tree ],
+                           u32Cluster, u32ClusterNb, EF_BOOL_FALSE, &u16Before, &u16After );
+      pxFS->u16FreeIndexRoot[ u8Tree ] =
+        u16EFPrvFATIndexJoin( pxFS, u8Tree, u16EFPrvFATIndexJoin( pxFS, u8Tree, u16Before, u16Run ), u16After );
+    }
+    pxFS->u16FreeIndexNb++;
+  }
+}
+
+static ef_return_et eEFPrvFATIndexSearch (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32ClusterNb,
+  ef_u32_t  * pu32Cluster
+)
+{
+  ef_return_et      eRetVal = EF_RET_DENIED;
+  ef_u16_t          u16Run = pxFS->u16FreeIndexRoot[ EF_FAT_INDEX_BY_LENGTH ];
+  ef_free_run_st  * pxRun;
+
+  /* Leftmost run of the tree by length holding enough clusters */
+  while ( 0 != u16Run )
+  {
+    pxRun = EF_FAT_INDEX_RUN( pxFS, u16Run );
+    if ( pxRun->u32ClusterNb < u32ClusterNb )
+    {
+      u16Run = pxRun->u16Child[ EF_FAT_INDEX_BY_LENGTH ][ EF_FAT_INDEX_RIGHT ];
+    }
+    else
+    {
+      *pu32Cluster = pxRun->u32Cluster;
+      eRetVal = EF_RET_OK;
+      u16Run = pxRun->u16Child[ EF_FAT_INDEX_BY_LENGTH ][ EF_FAT_INDEX_LEFT ];
+    }
+  }
+
+  return eRetVal;
+}
+#endif
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFPrvFATIndexReset (
+  ef_fs_st  * pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+  pxFS->u16FreeIndexRoot[ EF_FAT_INDEX_BY_CLUSTER ] = 0;
+  pxFS->u16FreeIndexRoot[ EF_FAT_INDEX_BY_LENGTH ] = 0;
+  pxFS->u16FreeIndexFree = 0;
+  pxFS->u16FreeIndexUsed = 0;
+  pxFS->u16FreeIndexNb = 0;
+  pxFS->u8FreeIndexState = EF_FAT_INDEX_NONE;
+  pxFS->u32FreeIndexMissNb = 0;
+#endif
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPrvFATIndexBuild (
+  ef_fs_st  * pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+#if ( 0 == EF_CONF_FREE_INDEX )
+  EF_CODE_COVERAGE( );
+#else
+  ef_u32_t  u32Cluster;
+  ef_u32_t  u32ClusterValue;
+  ef_u32_t  u32RunStart = 0;
+  ef_u32_t  u32RunLength = 0;
+  ef_u32_t  u32FreeNb = 0;
+
+  (void) eEFPrvFATIndexReset( pxFS );
+  pxFS->u8FreeIndexState = EF_FAT_INDEX_COMPLETE;
+
+  /* Stream through the FAT, consecutive entries sharing the FAT sector already loaded */
+  for ( u32Cluster = 2 ; u32Cluster < pxFS->u32FatEntriesNb ; u32Cluster++ )
+  {
+    /* If getting the cluster status failed */
+    if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterValue ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+      break;
+    }
+    /* Else, if a free cluster */
+    else if ( 0 == u32ClusterValue )
+    {
+      /* If a new run begins here */
+      if ( 0 == u32RunLength )
+      {
+        u32RunStart = u32Cluster;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      u32RunLength++;
+      u32FreeNb++;
+    }
+    /* Else, if a run ends here */
+    else if ( 0 != u32RunLength )
+    {
+      vEFPrvFATIndexInsert( pxFS, u32RunStart, u32RunLength );
+      u32RunLength = 0;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  /* If the scan failed */
+  if ( EF_RET_OK != eRetVal )
+  {
+    (void) eEFPrvFATIndexReset( pxFS );
+  }
+  else
+  {
+    /* If the last run reaches the end of the FAT */
+    if ( 0 != u32RunLength )
+    {
+      vEFPrvFATIndexInsert( pxFS, u32RunStart, u32RunLength );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* The free cluster count is exact now */
+    pxFS->u32ClstFreeNb = u32FreeNb;
+    pxFS->u8FsInfoFlags |= 1;
+  }
+#endif
+
+  return eRetVal;
+}
+
+ef_return_et eEFPrvFATIndexUpdate (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32Value
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+#if ( 0 == EF_CONF_FREE_INDEX )
+  (void) u32Cluster;
+  (void) u32Value;
+#else
+  ef_u16_t          u16Run;
+  ef_u16_t          u16Before = 0;
+  ef_u16_t          u16After = 0;
+  ef_free_run_st  * pxRun;
+  ef_free_run_st    xRun;
+
+  /* If the index is not built */
+  if ( EF_FAT_INDEX_NONE == pxFS->u8FreeIndexState )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    /* Look for the last run starting at or before the cluster and the first run starting after it */
+    u16Run = pxFS->u16FreeIndexRoot[ EF_FAT_INDEX_BY_CLUSTER ];
+    while ( 0 != u16Run )
+    {
+      pxRun = EF_FAT_INDEX_RUN( pxFS, u16Run );
+      if ( pxRun->u32Cluster <= u32Cluster )
+      {
+        u16Before = u16Run;
+        u16Run = pxRun->u16Child[ EF_FAT_INDEX_BY_CLUSTER ][ EF_FAT_INDEX_RIGHT ];
+      }
+      else
+      {
+        u16After = u16Run;
+        u16Run = pxRun->u16Child[ EF_FAT_INDEX_BY_CLUSTER ][ EF_FAT_INDEX_LEFT ];
+      }
+    }
+
+    /* If the cluster is in the run before it */
+    if (    ( 0 != u16Before )
+         && ( u32Cluster < ( EF_FAT_INDEX_RUN( pxFS, u16Before )->u32Cluster
+                             + EF_FAT_INDEX_RUN( pxFS, u16Before )->u32ClusterNb ) ) )
+    {
+      /* If the cluster is allocated out of the indexed run */
+      if ( 0 != u32Value )
+      {
+        xRun = *EF_FAT_INDEX_RUN( pxFS, u16Before );
+
+        /* Split the run around the cluster */
+        vEFPrvFATIndexRemove( pxFS, u16Before );
+        if ( u32Cluster > xRun.u32Cluster )
+        {
+          vEFPrvFATIndexInsert( pxFS, xRun.u32Cluster, u32Cluster - xRun.u32Cluster );
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+        if ( ( u32Cluster + 1 ) < ( xRun.u32Cluster + xRun.u32ClusterNb ) )
+        {
+          vEFPrvFATIndexInsert( pxFS,
+                                u32Cluster + 1,
+                                ( xRun.u32Cluster + xRun.u32ClusterNb ) - ( u32Cluster + 1 ) );
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+      else
+      {
+        /* Cluster already free */
+        EF_CODE_COVERAGE( );
+      }
+    }
+    /* Else, if the cluster is freed */
+    else if ( 0 == u32Value )
+    {
+      /* It may join runs dropped from a partial index into a larger one */
+      pxFS->u32FreeIndexMissNb = 0;
+      xRun.u32Cluster = u32Cluster;
+      xRun.u32ClusterNb = 1;
+
+      /* Merge the run starting right after the cluster */
+      if (    ( 0 != u16After )
+           && ( ( u32Cluster + 1 ) == EF_FAT_INDEX_RUN( pxFS, u16After )->u32Cluster ) )
+      {
+        xRun.u32ClusterNb += EF_FAT_INDEX_RUN( pxFS, u16After )->u32ClusterNb;
+        vEFPrvFATIndexRemove( pxFS, u16After );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Merge the run ending right before the cluster */
+      if (    ( 0 != u16Before )
+           && ( u32Cluster == ( EF_FAT_INDEX_RUN( pxFS, u16Before )->u32Cluster
+                                + EF_FAT_INDEX_RUN( pxFS, u16Before )->u32ClusterNb ) ) )
+      {
+        xRun.u32Cluster = EF_FAT_INDEX_RUN( pxFS, u16Before )->u32Cluster;
+        xRun.u32ClusterNb += EF_FAT_INDEX_RUN( pxFS, u16Before )->u32ClusterNb;
+        vEFPrvFATIndexRemove( pxFS, u16Before );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      vEFPrvFATIndexInsert( pxFS, xRun.u32Cluster, xRun.u32ClusterNb );
+    }
+    else
+    {
+      /* Link update inside a chain */
+      EF_CODE_COVERAGE( );
+    }
+  }
+#endif
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPrvFATIndexFind (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32ClusterNb,
+  ef_u32_t  * pu32Cluster
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pu32Cluster );
+
+  ef_return_et  eRetVal = EF_RET_DENIED;
+
+#if ( 0 == EF_CONF_FREE_INDEX )
+  (void) u32ClusterNb;
+#else
+  /* If     the index is not built
+   *    AND building it failed
+   */
+  if (    ( EF_FAT_INDEX_NONE == pxFS->u8FreeIndexState )
+       && ( EF_RET_OK != eEFPrvFATIndexBuild( pxFS ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if a run is large enough */
+  else if ( EF_RET_OK == eEFPrvFATIndexSearch( pxFS, u32ClusterNb, pu32Cluster ) )
+  {
+    eRetVal = EF_RET_OK;
+  }
+  /* Else, if    the index holds every free run
+   *          OR a rebuild found no run this large, and no cluster was freed since
+   */
+  else if (    ( EF_FAT_INDEX_PARTIAL != pxFS->u8FreeIndexState )
+            || (    ( 0 != pxFS->u32FreeIndexMissNb )
+                 && ( u32ClusterNb >= pxFS->u32FreeIndexMissNb ) ) )
+  {
+    /* There is no run large enough */
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if rebuilding the partial index failed */
+  else if ( EF_RET_OK != eEFPrvFATIndexBuild( pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if the rebuilt index, holding the largest runs, has no run large enough */
+  else if ( EF_RET_OK != ( eRetVal = eEFPrvFATIndexSearch( pxFS, u32ClusterNb, pu32Cluster ) ) )
+  {
+    /* Allocations only shrink the runs: the next requests this large fail without a rebuild */
+    pxFS->u32FreeIndexMissNb = u32ClusterNb;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#endif
+
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -69,7 +69,7 @@ ef_return_et eEFPrvDirFileInfosGet (
   /* Invalidate file info */
   pxFileInfo->xName[ 0 ] = 0;
   /* If read pointer has reached end of directory */
-  if ( 0 != pxDir->xSector )
+  if ( 0 == pxDir->xSector )
   {
     eRetVal = EF_RET_ERROR;
   }
@@ -79,7 +79,8 @@ ef_return_et eEFPrvDirFileInfosGet (
     /* Copy name body and extension */
     for ( ef_u32_t u32IdxSrc = 0 ; 11 > u32IdxSrc ; u32IdxSrc++ )
     {
-      if ( 8 == u32IdxSrc )
+      if (    ( 8 == u32IdxSrc )
+           && ( ' ' != pxDir->pu8Dir[ u32IdxSrc ] ) )
       {
         /* Insert a . if extension is exist */
         pxFileInfo->xName[ u32IdxDst++ ] = '.';
@@ -34,9 +34,18 @@
 #include "ef_prv_def.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FILE_LOCK )
+/**
+ *  Number of hash chains of the opened objects table, one per entry
+ */
+#define EF_FILES_HASH_NB  ( EF_CONF_FILE_LOCK )
+#endif
+
 /* Local function macros ------------------------------------------------------------------------------------------- */
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
 
+#if ( 0 != EF_CONF_FILE_LOCK )
 /**
  *  File lock control structure
  */
@@ -45,22 +54,169 @@ typedef struct ef_flock_struct {
   ef_u32_t    u32Clst;    /**< Object ID 2, containing directory (0:root) */
   ef_u32_t    u32Offset;  /**< Object ID 3, offset in the directory */
   ef_u16_t    u16Cnt;     /**< Object open counter, 0:none, 0x01..0xFF:read mode open count, 0x100:write mode */
+  ef_u32_t    u32Next;    /**< Next entry of the hash chain or of the free list, origin from 1 (0:none) */
 } ef_flock_st;
+#endif
 
 /* Local variables ------------------------------------------------------------------------------------------------- */
 /* Public variables ------------------------------------------------------------------------------------------------ */
 
-#if 0 != EF_CONF_FILE_LOCK
+#if ( 0 != EF_CONF_FILE_LOCK )
 /**
  *  Opened files object locking table
  */
 static  ef_flock_st Files[ EF_CONF_FILE_LOCK ];
-#else
-extern  ef_flock_st Files[ 1 ];
+
+/**
+ *  First entry of each hash chain of the opened objects, origin from 1 (0:empty chain)
+ */
+static  ef_u32_t    u32FilesHash[ EF_FILES_HASH_NB ];
+
+/**
+ *  First entry of the list of the released entries, origin from 1 (0:empty list)
+ */
+static  ef_u32_t    u32FilesFree;
+
+/**
+ *  Number of entries used at least once, the entries above have never been used and are free
+ */
+static  ef_u32_t    u32FilesUsed;
 #endif
 
 /* Local function prototypes---------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FILE_LOCK )
+static ef_u32_t u32EFPrvLockHash (
+  const ef_fs_st  * pxFS,
+  ef_u32_t          u32Clst,
+  ef_u32_t          u32Offset
+);
+
+static ef_u32_t u32EFPrvLockFind (
+  const ef_directory_st * pxDir
+);
+
+static ef_u32_t u32EFPrvLockAlloc (
+  const ef_directory_st * pxDir
+);
+
+static void vEFPrvLockRelease (
+  ef_u32_t  u32Id
+);
+#endif
+
 /* Local functions ------------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_FILE_LOCK )
+/* Hash chain of an object */
+static ef_u32_t u32EFPrvLockHash (
+  const ef_fs_st  * pxFS,
+  ef_u32_t          u32Clst,
+  ef_u32_t          u32Offset
+)
+{
+  ef_u32_t  u32Hash;
+
+  /* The directory entries are 32 bytes apart, the volume objects are at least 16 bytes apart */
+  u32Hash = (ef_u32_t) ( (ef_uintptr_t) pxFS >> 4 );
+  u32Hash ^= u32Clst * 0x9E3779B1UL;
+  u32Hash ^= ( u32Offset >> 5 ) * 0x85EBCA6BUL;
+  u32Hash ^= u32Hash >> 16;
+
+  return u32Hash % EF_FILES_HASH_NB;
+}
+
+/* Find the entry of an opened object, returns its index origin from 1 (0:not opened) */
+static ef_u32_t u32EFPrvLockFind (
+  const ef_directory_st * pxDir
+)
+{
+  ef_u32_t  u32Id;
+
+  u32Id = u32FilesHash[ u32EFPrvLockHash( pxDir->xObject.pxFS, pxDir->xObject.u32ClstStart, pxDir->u32Offset ) ];
+  while (    ( 0 != u32Id )
+          && (    ( Files[ u32Id - 1 ].pxFS       != pxDir->xObject.pxFS )
+               || ( Files[ u32Id - 1 ].u32Clst    != pxDir->xObject.u32ClstStart )
+               || ( Files[ u32Id - 1 ].u32Offset  != pxDir->u32Offset ) ) )
+  {
+    u32Id = Files[ u32Id - 1 ].u32Next;
+  }
+
+  return u32Id;
+}
+
+/* Register an object in a free entry, returns its index origin from 1 (0:no free entry) */
+static ef_u32_t u32EFPrvLockAlloc (
+  const ef_directory_st * pxDir
+)
+{
+  ef_u32_t  u32Id = 0;
+  ef_u32_t  u32Hash;
+
+  if ( 0 != u32FilesFree )
+  {
+    u32Id = u32FilesFree;
+    u32FilesFree = Files[ u32Id - 1 ].u32Next;
+  }
+  else if ( EF_CONF_FILE_LOCK > u32FilesUsed )
+  {
+    u32FilesUsed++;
+    u32Id = u32FilesUsed;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  if ( 0 == u32Id )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    u32Hash = u32EFPrvLockHash( pxDir->xObject.pxFS, pxDir->xObject.u32ClstStart, pxDir->u32Offset );
+    Files[ u32Id - 1 ].pxFS       = pxDir->xObject.pxFS;
+    Files[ u32Id - 1 ].u32Clst    = pxDir->xObject.u32ClstStart;
+    Files[ u32Id - 1 ].u32Offset  = pxDir->u32Offset;
+    Files[ u32Id - 1 ].u16Cnt     = 0;
+    Files[ u32Id - 1 ].u32Next    = u32FilesHash[ u32Hash ];
+    u32FilesHash[ u32Hash ] = u32Id;
+  }
+
+  return u32Id;
+}
+
+/* Unlink an entry from its hash chain and give it back to the free list */
+static void vEFPrvLockRelease (
+  ef_u32_t  u32Id
+)
+{
+  ef_u32_t  * pu32Link;
+
+  pu32Link = &u32FilesHash[ u32EFPrvLockHash( Files[ u32Id - 1 ].pxFS,
+                                              Files[ u32Id - 1 ].u32Clst,
+                                              Files[ u32Id - 1 ].u32Offset ) ];
+  while (    ( 0 != *pu32Link )
+          && ( u32Id != *pu32Link ) )
+  {
+    pu32Link = &Files[ *pu32Link - 1 ].u32Next;
+  }
+  if ( 0 == *pu32Link )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    *pu32Link = Files[ u32Id - 1 ].u32Next;
+  }
+
+  Files[ u32Id - 1 ].pxFS     = 0;
+  Files[ u32Id - 1 ].u16Cnt   = 0;
+  Files[ u32Id - 1 ].u32Next  = u32FilesFree;
+  u32FilesFree = u32Id;
+}
+#endif
+
 /* Public functions ------------------------------------------------------------------------------------------------ */
 
 /*-----------------------------------------------------------------------*/
@@ -76,70 +232,45 @@ ef_return_et eEFPrvLockCheck (
 
   ef_return_et  eRetVal = EF_RET_OK;
 
-  if ( 0 == EF_CONF_FILE_LOCK )
+#if ( 0 != EF_CONF_FILE_LOCK )
+  ef_u32_t  u32Id;
+
+  (void) eEFPortCriticalEnter( );
+  /* Search open object table for the object */
+  u32Id = u32EFPrvLockFind( pxDir );
+  if ( 0 == u32Id )
   {
-    EF_CODE_COVERAGE( );
+    /* The object has not been opened */
+    /* Is there a blank entry for new object? */
+    if (    ( 0 == u32FilesFree )
+         && ( EF_CONF_FILE_LOCK == u32FilesUsed )
+         && ( 2 != acc ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TOO_MANY_OPEN_FILES );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
   }
   else
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
-
-    ef_u32_t  i;
-    ef_u32_t  be = 0;
-
-    /* Search open object table for the object */
-    be = 0;
-    for ( i = 0 ; i < EF_CONF_FILE_LOCK ; i++ )
-    {
-      /* Existing entry */
-      if ( 0 != Files[ i ].pxFS )
-      {
-        /* Check if the object matches with an open object */
-        if (    ( Files[ i ].pxFS       == pxDir->xObject.pxFS )
-             && ( Files[ i ].u32Clst    == pxDir->xObject.u32ClstStart )
-             && ( Files[ i ].u32Offset  == pxDir->u32Offset ) )
-        {
-          break;
-        }
-        else
-        {
-          EF_CODE_COVERAGE( );
-        }
-      }
-      else
-      {      /* Blank entry */
-        be = 1;
-      }
-    }
-    if ( EF_CONF_FILE_LOCK == i )
+    /* The object was opened. Reject any open against writing file and all write mode open */
+    if (    ( 0 != acc )
+         || ( 0x100 == Files[ u32Id - 1 ].u16Cnt ) )
     {
-      /* The object has not been opened */
-      /* Is there a blank entry for new object? */
-      if (    ( 0 == be )
-           && ( 2 != acc ) )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TOO_MANY_OPEN_FILES );
-      }
-      else
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_OK );
-      }
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_LOCKED );
     }
     else
     {
-      /* The object was opened. Reject any open against writing file and all write mode open */
-      if (    ( 0 != acc )
-           || ( 0x100 != Files[ i ].u16Cnt ) )
-      {
-        /* Reject any open against writing file and all write mode open */
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_LOCKED );
-      }
-      else
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_OK );
-      }
+      EF_CODE_COVERAGE( );
     }
   }
+  (void) eEFPortCriticalExit( );
+#else
+  /* No file locking mechanism */
+  (void) acc;
+#endif
 
   return eRetVal;
 }
@@ -149,27 +280,23 @@ ef_return_et eEFPrvLockEnq (void)
 {
   ef_return_et eRetVal = EF_RET_OK;
 
-  /* If there is no file locking mechanism */
-  if ( 0 == EF_CONF_FILE_LOCK )
+#if ( 0 != EF_CONF_FILE_LOCK )
+  (void) eEFPortCriticalEnter( );
+  if (    ( 0 == u32FilesFree )
+       && ( EF_CONF_FILE_LOCK == u32FilesUsed ) )
   {
-    EF_CODE_COVERAGE( );
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_LOCKED );
   }
   else
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_LOCKED );
-    for ( ef_u32_t i = 0 ; i < EF_CONF_FILE_LOCK ; i++ )
-    {
-      if ( 0 == Files[ i ].pxFS )
-      {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_OK );
-        break;
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
-    }
+    EF_CODE_COVERAGE( );
   }
+  (void) eEFPortCriticalExit( );
+#else
+  /* No file locking mechanism */
+  EF_CODE_COVERAGE( );
+#endif
+
   return eRetVal;
 }
 
@@ -184,85 +311,55 @@ ef_return_et eEFPrvLockInc (
 
   ef_return_et  eRetVal = EF_RET_OK;
 
-  /* If there is no file locking mechanism */
-  if ( 0 == EF_CONF_FILE_LOCK )
+  /* No lock to release on close, unless registered below */
+  *pu32LockId = 0;
+
+#if ( 0 != EF_CONF_FILE_LOCK )
+  ef_u32_t  u32Id;
+
+  (void) eEFPortCriticalEnter( );
+  /* Find the object, if not opened register it as new */
+  u32Id = u32EFPrvLockFind( pxDir );
+  if ( 0 == u32Id )
   {
-    EF_CODE_COVERAGE( );
+    u32Id = u32EFPrvLockAlloc( pxDir );
   }
   else
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
-    ef_u32_t i;
-
-    /* Find the object */
-    for ( i = 0; i < EF_CONF_FILE_LOCK; i++ )
-    {
-      if (    ( Files[ i ].pxFS       == pxDir->xObject.pxFS )
-           && ( Files[ i ].u32Clst    == pxDir->xObject.u32ClstStart )
-           && ( Files[ i ].u32Offset  == pxDir->u32Offset ) )
-      {
-        break;
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
-    }
-
-    /* Not opened. Register it as new. */
-    if ( EF_CONF_FILE_LOCK == i )
-    {
-      for ( i = 0 ; i < EF_CONF_FILE_LOCK ; i++ )
-      {
-        if ( 0 == Files[ i ].pxFS )
-        {
-          break;
-        }
-        else
-        {
-          EF_CODE_COVERAGE( );
-        }
-      }
-      /* No free entry to register (int u8ErrorCode) */
-      if ( EF_CONF_FILE_LOCK == i )
-      {
-        *pu32LockId = 0;
-        return EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
-      Files[ i ].pxFS       = pxDir->xObject.pxFS;
-      Files[ i ].u32Clst    = pxDir->xObject.u32ClstStart;
-      Files[ i ].u32Offset  = pxDir->u32Offset;
-      Files[ i ].u16Cnt     = 0;
-    }
-
-    if (    ( 1 <= iAccess )
-         && ( 0 != Files[ i ].u16Cnt ) )
-    {
-      *pu32LockId = 0;  /* Access violation (int u8ErrorCode) */
-      return EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
-    }
-    else
-    {
-      EF_CODE_COVERAGE( );
-    }
+    EF_CODE_COVERAGE( );
+  }
 
+  /* No free entry to register */
+  if ( 0 == u32Id )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  /* Access violation */
+  else if (    ( 1 <= iAccess )
+            && ( 0 != Files[ u32Id - 1 ].u16Cnt ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  else
+  {
     if ( 0 != iAccess )
     {
       /* Set semaphore value */
-      Files[ i ].u16Cnt = 0x100;
+      Files[ u32Id - 1 ].u16Cnt = 0x100;
     }
     else
     {
       /* Set semaphore value */
-      Files[ i ].u16Cnt = Files[ i ].u16Cnt + 1;
+      Files[ u32Id - 1 ].u16Cnt = Files[ u32Id - 1 ].u16Cnt + 1;
     }
-
-    *pu32LockId = i + 1;
+    *pu32LockId = u32Id;
   }
+  (void) eEFPortCriticalExit( );
+#else
+  /* No file locking mechanism */
+  (void) iAccess;
+#endif
+
   return eRetVal;
 }
 
@@ -271,54 +368,58 @@ ef_return_et eEFPrvLockDec (
   ef_u32_t  i
 )
 {
-  /* Invalid index nunber */
   ef_return_et eRetVal = EF_RET_OK;
 
-  /* If there is no file locking mechanism */
-  if ( 0 == EF_CONF_FILE_LOCK )
+#if ( 0 != EF_CONF_FILE_LOCK )
+  ef_u16_t n;
+
+  (void) eEFPortCriticalEnter( );
+  /* Invalid index number, origin from 1 */
+  if (    ( 0 == i )
+       || ( EF_CONF_FILE_LOCK < i ) )
   {
-    EF_CODE_COVERAGE( );
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
   }
   else
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
-    ef_u16_t n;
-
     /* Index number origin from 0 */
-    if ( --i < EF_CONF_FILE_LOCK )
+    i--;
+    n = Files[ i ].u16Cnt;
+    /* If write u8Mode open, delete the entry */
+    if ( 0x100 == n )
     {
-      n = Files[ i ].u16Cnt;
-      /* If write u8Mode open, delete the entry */
-      if ( 0x100 == n )
-      {
-        n = 0;
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
-      /* Decrement read u8Mode open count */
-      if ( 0 < n )
-      {
-        n--;
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
-      Files[ i ].u16Cnt = n;
-      /* Delete the entry if open count gets zero */
-      if ( 0 == n )
-      {
-        Files[ i ].pxFS = 0;
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_OK );
+      n = 0;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* Decrement read u8Mode open count */
+    if ( 0 < n )
+    {
+      n--;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    Files[ i ].u16Cnt = n;
+    /* Delete the entry if open count gets zero, unless already cleared with its volume */
+    if (    ( 0 == n )
+         && ( 0 != Files[ i ].pxFS ) )
+    {
+      vEFPrvLockRelease( i + 1 );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
     }
   }
+  (void) eEFPortCriticalExit( );
+#else
+  /* No file locking mechanism */
+  (void) i;
+#endif
 
   return eRetVal;
 }
@@ -332,28 +433,24 @@ ef_return_et eEFPrvLockClear (
 
   ef_return_et  eRetVal = EF_RET_OK;
 
-  /* If there is no file locking mechanism */
-  if ( 0 == EF_CONF_FILE_LOCK )
-  {
-    EF_CODE_COVERAGE( );
-  }
-  else
+#if ( 0 != EF_CONF_FILE_LOCK )
+  (void) eEFPortCriticalEnter( );
+  for ( ef_u32_t i = 0 ; i < u32FilesUsed ; i++ )
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
-
-    for ( ef_u32_t i = 0 ; i < EF_CONF_FILE_LOCK ; i++ )
+    if ( Files[ i ].pxFS == pxFS )
+    {
+      vEFPrvLockRelease( i + 1 );
+    }
+    else
     {
-      if ( Files[ i ].pxFS == pxFS )
-      {
-        Files[ i ].pxFS = 0;
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_OK );
-      }
-      else
-      {
-        EF_CODE_COVERAGE( );
-      }
+      EF_CODE_COVERAGE( );
     }
   }
+  (void) eEFPortCriticalExit( );
+#else
+  /* No file locking mechanism */
+  (void) pxFS;
+#endif
 
   return eRetVal;
 }
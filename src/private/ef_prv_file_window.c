@@ -31,7 +31,10 @@
 /* Includes -------------------------------------------------------------------------------------------------------- */
 #include <efat.h>
 #include <ef_prv_def.h>
+#include <ef_port_memory.h>
 #include "ef_prv_drive.h"
+#include "ef_prv_fat.h"
+#include "ef_prv_file.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -89,7 +92,7 @@ ef_return_et eEFPrvFileWindowUpdate (
   if ( pxFile->xSector == xSector )
   {
     /* Do nothing */
-    EF_CODE_COVERAGE( );
+    EF_STATS_ADD( pxFS, u32CacheHits, 1 );
   }
   /* Else, if Write-back dirty sector cache if needed failed */
   else if ( EF_RET_OK != eEFPrvFileWindowDirtyWriteBack ( pxFile, pxFS ) )
@@ -103,6 +106,7 @@ ef_return_et eEFPrvFileWindowUpdate (
   }
   else
   {
+    EF_STATS_ADD( pxFS, u32CacheMisses, 1 );
     /* Now the sector in the window is where the FileOffset belong */
     pxFile->xSector = xSector;
   }
@@ -110,6 +114,424 @@ ef_return_et eEFPrvFileWindowUpdate (
   return eRetVal;
 }
 
+ef_return_et eEFPrvFileDelayedCheck (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS,
+  ef_bool_t   * pbDelayed
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pbDelayed );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  *pbDelayed = EF_BOOL_FALSE;
+
+#if ( 0 == EF_CONF_DELAYED_ALLOC )
+  EF_CODE_COVERAGE( );
+#else
+  ef_u32_t  u32ClusterValue;
+
+  /* If data is already staged */
+  if ( 0 != pxFile->u32DelayedSize )
+  {
+    *pbDelayed = EF_BOOL_TRUE;
+  }
+  /* Else, if not on a cluster boundary */
+  else if ( 0 != ( pxFile->u32FileOffset % ( (ef_u32_t) pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS ) ) ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if the file has no cluster chain yet */
+  else if ( 0 == pxFile->xObject.u32ClstStart )
+  {
+    *pbDelayed = EF_BOOL_TRUE;
+  }
+  /* Else, if on the top of the file */
+  else if ( 0 == pxFile->u32FileOffset )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if getting the current cluster status failed */
+  else if ( EF_RET_OK != eEFPrvFATGet( pxFS, pxFile->u32Clst, &u32ClusterValue ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if the current cluster is the end of the chain */
+  else if ( pxFS->u32FatEntriesNb <= u32ClusterValue )
+  {
+    *pbDelayed = EF_BOOL_TRUE;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+#endif
+
+  return eRetVal;
+}
+
+ef_return_et eEFPrvFileDelayedWrite (
+  ef_file_st      * pxFile,
+  ef_fs_st        * pxFS,
+  const ef_u08_t  * pu8Buffer,
+  ef_u32_t          u32BytesToWrite,
+  ef_u32_t        * pu32BytesWritten
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pu8Buffer );
+  EF_ASSERT_PRIVATE( 0 != pu32BytesWritten );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  *pu32BytesWritten = 0;
+
+#if ( 0 == EF_CONF_DELAYED_ALLOC )
+  (void) pu8Buffer;
+  (void) u32BytesToWrite;
+  /* There is no delayed allocation buffer */
+  eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+#else
+  /* Room left in the buffer */
+  ef_u32_t  u32BytesFree = (ef_u32_t) sizeof( pxFile->u8DelayedBuffer ) - pxFile->u32DelayedSize;
+
+  /* If the buffer is full */
+  if ( 0 == u32BytesFree )
+  {
+    /* Allocate and write what is staged, the caller comes back with the same data */
+    eRetVal = eEFPrvFileDelayedFlush( pxFile, pxFS );
+  }
+  else
+  {
+    /* Clip it by the room left in the buffer if needed */
+    if ( u32BytesToWrite > u32BytesFree )
+    {
+      u32BytesToWrite = u32BytesFree;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* If filling the buffer failed */
+    if ( EF_RET_OK != eEFPortMemCopy( pu8Buffer,
+                                      pxFile->u8DelayedBuffer + pxFile->u32DelayedSize,
+                                      u32BytesToWrite ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+    }
+    else
+    {
+      pxFile->u32DelayedSize += u32BytesToWrite;
+      *pu32BytesWritten = u32BytesToWrite;
+    }
+  }
+#endif
+
+  return eRetVal;
+}
+
+ef_return_et eEFPrvFileDelayedFlush (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+#if ( 0 == EF_CONF_DELAYED_ALLOC )
+  EF_CODE_COVERAGE( );
+#else
+  /* Number of staged sectors, the last one may be partial */
+  ef_u32_t  u32SectorsNb = ( pxFile->u32DelayedSize + EF_SECTOR_SIZE( pxFS ) - 1 ) / EF_SECTOR_SIZE( pxFS );
+  /* Staging always starts at the end of the chain, current cluster is its last one */
+  ef_u32_t  u32ClusterPrev = ( 0 != pxFile->xObject.u32ClstStart ) ? pxFile->u32Clst : 0;
+  ef_u32_t  u32Cluster = 0;
+
+  /* If nothing is staged */
+  if ( 0 == pxFile->u32DelayedSize )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if Write-back dirty sector cache failed */
+  else if ( EF_RET_OK != eEFPrvFileWindowDirtyWriteBack( pxFile, pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  /* Else, if allocating the clusters as a single run failed */
+  else if ( EF_RET_OK != ( eRetVal = eEFPrvFATChainRunAppend( &pxFile->xObject,
+                                                              u32ClusterPrev,
+                                                              ( u32SectorsNb + pxFS->u8ClstSize - 1 ) / pxFS->u8ClstSize,
+                                                              EF_BOOL_FALSE,
+                                                              &u32Cluster ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+  }
+  else
+  {
+    ef_u32_t  u32SectorsDone = 0;
+    ef_u32_t  u32ExtentSectors = 0;
+    ef_u32_t  u32ExtentCluster = u32Cluster;
+    ef_u32_t  u32ClusterNext = 0;
+    ef_lba_t  xSector = 0;
+    ef_lba_t  xSectorLast = 0;
+    /* Staging starts on a cluster boundary */
+    ef_u32_t  u32ClusterIndex = ( pxFile->u32FileOffset - pxFile->u32DelayedSize )
+                              / ( (ef_u32_t) pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS ) );
+
+    /* If the first write */
+    if ( 0 == pxFile->xObject.u32ClstStart )
+    {
+      /* Set start cluster */
+      pxFile->xObject.u32ClstStart = u32Cluster;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    (void) eEFPrvFileRunGrow( pxFile, u32ClusterIndex, u32Cluster );
+
+    /* Write the staged sectors, one command per contiguous extent */
+    while ( u32SectorsDone < u32SectorsNb )
+    {
+      /* Add the current cluster to the extent, clipped to the staged sectors */
+      ef_u32_t  u32Sectors = u32SectorsNb - u32SectorsDone - u32ExtentSectors;
+      if ( u32Sectors > pxFS->u8ClstSize )
+      {
+        u32Sectors = pxFS->u8ClstSize;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      u32ExtentSectors += u32Sectors;
+
+      /* If this is the last cluster to write */
+      if ( u32SectorsNb == ( u32SectorsDone + u32ExtentSectors ) )
+      {
+        u32ClusterNext = 0;
+      }
+      /* Else, if getting the next cluster failed */
+      else if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterNext ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        break;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+
+      /* If the next cluster is contiguous */
+      if ( ( u32Cluster + 1 ) == u32ClusterNext )
+      {
+        /* Keep growing the extent */
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if getting the base sector of the extent failed */
+      else if ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, u32ExtentCluster, &xSector ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        break;
+      }
+      /* Else, if writing the extent failed */
+      else if ( EF_RET_OK != eEFPrvDriveWrite(  pxFS->u8PhysDrv,
+                                                pxFile->u8DelayedBuffer + ( u32SectorsDone * EF_SECTOR_SIZE( pxFS ) ),
+                                                xSector,
+                                                u32ExtentSectors ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+        break;
+      }
+      else
+      {
+        xSectorLast = xSector + u32ExtentSectors - 1;
+        u32SectorsDone += u32ExtentSectors;
+        u32ExtentSectors = 0;
+        u32ExtentCluster = u32ClusterNext;
+      }
+
+      /* If there is a next cluster */
+      if ( 0 != u32ClusterNext )
+      {
+        u32Cluster = u32ClusterNext;
+        (void) eEFPrvFileRunGrow( pxFile, ++u32ClusterIndex, u32Cluster );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+
+    /* If something failed */
+    if ( EF_RET_OK != eRetVal )
+    {
+      /* The run is linked already: drop the staged data so that a later flush does not link a second run, and
+       * abort the file, whose chain now holds clusters without their data */
+      pxFile->u32DelayedSize = 0;
+      pxFile->u8ErrorCode = (ef_u08_t) eRetVal;
+    }
+    else
+    {
+      /* Update current cluster to the last one of the chain */
+      pxFile->u32Clst = u32Cluster;
+      /* Nothing staged anymore */
+      pxFile->u32DelayedSize = 0;
+
+      /* If the file offset is inside the last written sector */
+      if ( 0 != ( pxFile->u32FileOffset % EF_SECTOR_SIZE( pxFS ) ) )
+      {
+        /* The window takes the copy of the partial sector, it is clean */
+        pxFile->xSector = xSectorLast;
+        eRetVal = eEFPortMemCopy( pxFile->u8DelayedBuffer + ( ( u32SectorsNb - 1 ) * EF_SECTOR_SIZE( pxFS ) ),
+                                  pxFile->u8Window,
+                                  EF_SECTOR_SIZE( pxFS ) );
+      }
+      /* Else, if the file offset is on a cluster boundary */
+      else if ( 0 == ( ( pxFile->u32FileOffset / EF_SECTOR_SIZE( pxFS ) ) % pxFS->u8ClstSize ) )
+      {
+        /* Sector is computed again on next access */
+        pxFile->xSector = 0;
+      }
+      /* Else, load the sector following the written ones */
+      else if ( EF_RET_OK != eEFPrvFileWindowUpdate( pxFile, pxFS, xSectorLast + 1 ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+#endif
+
+  return eRetVal;
+}
+
+ef_return_et eEFPrvFileRunGrow (
+  ef_file_st  * pxFile,
+  ef_u32_t      u32ClusterIndex,
+  ef_u32_t      u32Cluster
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+
+  /* If     the cluster directly follows the run
+   *    AND it is where the run would continue
+   */
+  if (    ( 0 != pxFile->xObject.u32ClstStart )
+       && ( u32ClusterIndex == pxFile->u32ClstRunNb )
+       && ( u32Cluster == ( pxFile->xObject.u32ClstStart + u32ClusterIndex ) ) )
+  {
+    pxFile->u32ClstRunNb++;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPrvFileRunClusterGet (
+  ef_file_st  * pxFile,
+  ef_u32_t      u32ClusterIndex,
+  ef_u32_t    * pu32Cluster,
+  ef_bool_t   * pbFound
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+  EF_ASSERT_PRIVATE( 0 != pu32Cluster );
+  EF_ASSERT_PRIVATE( 0 != pbFound );
+
+  /* If the index is inside the run */
+  if ( u32ClusterIndex < pxFile->u32ClstRunNb )
+  {
+    *pu32Cluster = pxFile->xObject.u32ClstStart + u32ClusterIndex;
+    *pbFound = EF_BOOL_TRUE;
+  }
+  else
+  {
+    *pbFound = EF_BOOL_FALSE;
+  }
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPrvFileRunSectorsGet (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS,
+  ef_u32_t    * pu32SectorsNb
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pu32SectorsNb );
+
+  ef_u32_t  u32SectorIndex = pxFile->u32FileOffset / EF_SECTOR_SIZE( pxFS );
+  ef_u32_t  u32SectorRunNb = pxFile->u32ClstRunNb * pxFS->u8ClstSize;
+
+  /* If the offset is inside the run */
+  if ( u32SectorIndex < u32SectorRunNb )
+  {
+    *pu32SectorsNb = u32SectorRunNb - u32SectorIndex;
+  }
+  else
+  {
+    *pu32SectorsNb = 0;
+  }
+
+  return EF_RET_OK;
+}
+
+ef_return_et eEFPrvFileRunCheck (
+  ef_file_st  * pxFile,
+  ef_fs_st    * pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFile );
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+#if ( 0 == EF_CONF_CONTIGUOUS_CHECK )
+  EF_CODE_COVERAGE( );
+#else
+  ef_u32_t  u32Cluster = pxFile->xObject.u32ClstStart;
+  ef_u32_t  u32ClusterNext;
+
+  pxFile->u32ClstRunNb = 0;
+
+  /* Follow the chain while it stays contiguous */
+  while ( EF_RET_OK == eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
+  {
+    (void) eEFPrvFileRunGrow( pxFile, pxFile->u32ClstRunNb, u32Cluster );
+    /* If getting the next cluster failed */
+    if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterNext ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+      break;
+    }
+    /* Else, if the chain leaves the run or ends */
+    else if ( ( u32Cluster + 1 ) != u32ClusterNext )
+    {
+      break;
+    }
+    else
+    {
+      u32Cluster = u32ClusterNext;
+    }
+  }
+#endif
+
+  return eRetVal;
+}
+
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
 
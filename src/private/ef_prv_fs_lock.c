@@ -45,18 +45,61 @@ ef_return_et eEFPrvFSLock (
   ef_return_et  eRetVal = EF_RET_OK;
 
   /* If    There is no file system locking mechanism
-   *    OR Sync object take is ok */
+   *    OR Sync object is free */
   if ( 0 == EF_CONF_FS_LOCK )
   {
     EF_CODE_COVERAGE( );
   }
-  else if ( EF_RET_OK == eEFPortSyncObjectTake( pxFS->xSyncObject ) )
+  else if ( EF_RET_OK == eEFPortSyncObjectTryTake( pxFS->xSyncObject ) )
   {
     EF_CODE_COVERAGE( );
   }
+  /* Else, the volume is busy, wait for it */
   else
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+    if ( EF_RET_OK != eEFPortSyncObjectTake( pxFS->xSyncObject ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+    }
+    /* The wait is counted once the volume is owned, the counters are protected by the lock */
+    else
+    {
+      EF_STATS_ADD( pxFS, u32LockWaits, 1 );
+    }
+  }
+
+  return eRetVal;
+}
+
+/* Request shared grant to access the volume */
+ef_return_et eEFPrvFSLockShared (
+  ef_fs_st *  pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the volume lock is not shared, the grant is exclusive */
+  if ( EF_DEF_FS_LOCK_SHARED != EF_CONF_FS_LOCK )
+  {
+    eRetVal = eEFPrvFSLock( pxFS );
+  }
+  else if ( EF_RET_OK == eEFPortSyncObjectTryTakeShared( pxFS->xSyncObject ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, the volume is owned exclusively or requested so, wait for it */
+  else
+  {
+    if ( EF_RET_OK != eEFPortSyncObjectTakeShared( pxFS->xSyncObject ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+    }
+    else
+    {
+      EF_STATS_ADD( pxFS, u32LockWaits, 1 );
+    }
   }
 
   return eRetVal;
@@ -126,5 +169,85 @@ ef_return_et eEFPrvFSUnlockForce (
   return eRetVal;
 }
 
+/* Request again grant to access the volume of an object */
+ef_return_et eEFPrvFSRelock (
+  ef_object_st  * pxObject,
+  ef_bool_t       bShared
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxObject );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the volume cannot be obtained, with the grant released */
+  if (    ( ( EF_BOOL_FALSE != bShared ) && ( EF_RET_OK != eEFPrvFSLockShared( pxObject->pxFS ) ) )
+       || ( ( EF_BOOL_FALSE == bShared ) && ( EF_RET_OK != eEFPrvFSLock( pxObject->pxFS ) ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
+  }
+  /* Else, if the volume was mounted again while it was released */
+  else if ( pxObject->u16MountId != pxObject->pxFS->u16MountId )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_OBJECT );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+/* Request/Release the window of a volume owned shared */
+ef_return_et eEFPrvFSWindowLock (
+  ef_fs_st  * pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the volume is never owned shared, its owner is alone using the window */
+  if ( EF_DEF_FS_LOCK_SHARED != EF_CONF_FS_LOCK )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if ( EF_RET_OK != eEFPortLockTake( &pxFS->xWindowLock ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+/* Request/Release the window of a volume owned shared */
+ef_return_et eEFPrvFSWindowUnlock (
+  ef_fs_st  * pxFS
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_DEF_FS_LOCK_SHARED != EF_CONF_FS_LOCK )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if ( EF_RET_OK != eEFPortLockGive( &pxFS->xWindowLock ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
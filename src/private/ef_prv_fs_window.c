@@ -124,7 +124,7 @@ ef_return_et eEFPrvFSWindowLoad (
   /* If window offset is the same */
   if ( xSector == pxFS->xWindowSector )
   {
-    EF_CODE_COVERAGE( );
+    EF_STATS_ADD( pxFS, u32WindowHits, 1 );
   }
   /* Else, if Flushing the window failed */
   else if ( EF_RET_OK !=  eEFPrvFSWindowStore( pxFS ) )
@@ -143,6 +143,7 @@ ef_return_et eEFPrvFSWindowLoad (
   }
   else
   {
+    EF_STATS_ADD( pxFS, u32WindowMisses, 1 );
     pxFS->xWindowSector = xSector;
   }
 
@@ -158,7 +159,12 @@ ef_return_et eEFPrvFSSync (
 
   ef_return_et eRetVal = EF_RET_OK;
 
-  if ( EF_RET_OK != eEFPrvFSWindowStore( pxFS ) )
+  /* The window, 2nd FAT and FSInfo writes are queued, the CTRL_SYNC below issues them sorted */
+  if ( EF_RET_OK != eEFPrvDriveElevatorStart( pxFS->u8PhysDrv ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  else if ( EF_RET_OK != eEFPrvFSWindowStore( pxFS ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
   }
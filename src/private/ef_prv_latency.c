@@ -0,0 +1,216 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_prv_latency.c
+ *  @ingroup  group_eFAT_Private
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Latency histograms of the public functions.
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include <ef_port_memory.h>
+#include "ef_prv_def.h"
+#include "ef_prv_latency.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+
+#if ( 0 != EF_CONF_LATENCY )
+/**
+ *  Latency histograms of the timed public functions
+ */
+static ef_latency_st xEFLatency[ EF_LATENCY_OP_NB ];
+
+/**
+ *  Slow operation callback (0:none)
+ */
+static xLatencyCallback * pxEFLatencyCallback = 0;
+
+/**
+ *  Duration in ticks from which the callback is called
+ */
+static ef_u32_t u32EFLatencyThreshold = 0xFFFFFFFF;
+#endif
+
+#if ( 0 != EF_CONF_TRACE )
+/**
+ *  Public function in progress in the calling task, EF_LATENCY_OP_NB when none
+ */
+static EF_PORT_TASK_LOCAL ef_latency_op_et eEFLatencyOrigin = EF_LATENCY_OP_NB;
+#endif
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+/* Count the duration of a public function in its histogram */
+ef_return_et eEFPrvLatencyRecord (
+  ef_latency_op_et    eOperation,
+  ef_u32_t            u32Ticks,
+  ef_return_et        eResult,
+  const void        * pvContext
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+#if ( 0 != EF_CONF_LATENCY )
+  if ( EF_LATENCY_OP_NB <= eOperation )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  else
+  {
+    ef_latency_st * pxLatency = &xEFLatency[ eOperation ];
+    ef_u32_t        u32Bucket = 0;
+
+    /* Bucket: number of significant bits of the duration, the last one holds all the longer ones */
+    for ( ef_u32_t u32Value = u32Ticks ; ( 0 != u32Value ) && ( ( EF_LATENCY_BUCKETS_NB - 1 ) > u32Bucket ) ; u32Value >>= 1 )
+    {
+      u32Bucket++;
+    }
+    (void) eEFPortCriticalEnter( );
+    pxLatency->u32Buckets[ u32Bucket ]++;
+    pxLatency->u32CallsNb++;
+    pxLatency->u64TicksTotal += u32Ticks;
+    if ( pxLatency->u32TicksMax < u32Ticks )
+    {
+      pxLatency->u32TicksMax = u32Ticks;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    (void) eEFPortCriticalExit( );
+
+    /* If the operation is slow enough to be reported */
+    if (    ( 0 != pxEFLatencyCallback )
+         && ( u32EFLatencyThreshold <= u32Ticks ) )
+    {
+      ef_latency_event_st xEvent;
+
+      xEvent.eOperation = eOperation;
+      xEvent.eResult    = eResult;
+      xEvent.u32Ticks   = u32Ticks;
+      xEvent.pvContext  = pvContext;
+      pxEFLatencyCallback( &xEvent );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+#else
+  (void) eOperation;
+  (void) u32Ticks;
+  (void) eResult;
+  (void) pvContext;
+#endif
+
+  return eRetVal;
+}
+
+/* Set the public function the drive commands are issued for */
+ef_return_et eEFPrvLatencyOriginSet (
+  ef_latency_op_et    eOperation
+)
+{
+#if ( 0 != EF_CONF_TRACE )
+  eEFLatencyOrigin = eOperation;
+#else
+  (void) eOperation;
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Get the public function the drive commands are issued for */
+ef_latency_op_et eEFPrvLatencyOriginGet (
+  void
+)
+{
+#if ( 0 != EF_CONF_TRACE )
+  return eEFLatencyOrigin;
+#else
+  return EF_LATENCY_OP_NB;
+#endif
+}
+
+/* Copy the histogram of a public function */
+ef_return_et eEFPrvLatencyGet (
+  ef_latency_op_et    eOperation,
+  ef_latency_st     * pxLatency
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxLatency );
+
+#if ( 0 != EF_CONF_LATENCY )
+  (void) eEFPortCriticalEnter( );
+  *pxLatency = xEFLatency[ eOperation ];
+  (void) eEFPortCriticalExit( );
+#else
+  (void) eOperation;
+  (void) eEFPortMemZero( pxLatency, sizeof( ef_latency_st ) );
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Clear the histograms of all the public functions */
+ef_return_et eEFPrvLatencyReset (
+  void
+)
+{
+#if ( 0 != EF_CONF_LATENCY )
+  (void) eEFPortCriticalEnter( );
+  (void) eEFPortMemZero( xEFLatency, sizeof( xEFLatency ) );
+  (void) eEFPortCriticalExit( );
+#endif
+
+  return EF_RET_OK;
+}
+
+/* Set the slow operation callback and its threshold */
+ef_return_et eEFPrvLatencyCallbackSet (
+  xLatencyCallback  * pxCallback,
+  ef_u32_t            u32ThresholdTicks
+)
+{
+#if ( 0 != EF_CONF_LATENCY )
+  pxEFLatencyCallback   = pxCallback;
+  u32EFLatencyThreshold = u32ThresholdTicks;
+#else
+  (void) pxCallback;
+  (void) u32ThresholdTicks;
+#endif
+
+  return EF_RET_OK;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -47,25 +47,34 @@ static const ef_u08_t LfnOfs[ 13 ] = { 1,  3,  5,  7,  9,      /* The first 5 */
 /* Local function macros ------------------------------------------------------------------------------------------- */
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
 
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
 /**
  *  @brief  Buffer type structure (LFN_Buffer_st)
  */
 typedef struct LFN_Buffer_struct {
   ucs2_t xBuffer[ EF_LFN_UNITS_MAX + 1 ]; /**< Buffer to hold LFN string */
 } LFN_Buffer_st;
+#endif
 
 /* Local variables ------------------------------------------------------------------------------------------------- */
 /* Public variables ------------------------------------------------------------------------------------------------ */
 
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
 /**
- *  LFN working buffers 32-Byte aligned for cache maintenance
+ *  LFN working buffers pool 32-Byte aligned for cache maintenance
  */
-static LFN_Buffer_st xLFNBuffers[ EF_CONF_VOLUMES_NB ] __attribute__ ((aligned (32)));
+static LFN_Buffer_st xLFNBuffers[ EF_CONF_VFAT_BUFFER_POOL_NB ] __attribute__ ((aligned (32)));
+
+/**
+ *  Buffers of the pool in use, bit n for xLFNBuffers[ n ], only changed with bEFPortAtomicCompareSwap()
+ */
+static ef_u32_t u32LFNBuffersTaken = 0;
+#endif
 
 /**
  *  LFN working buffers pointers
  */
-static LFN_Buffer_st * pxLFNBuffers[ EF_CONF_VOLUMES_NB ];
+static const ucs2_t * pxLFNBuffers[ EF_CONF_VOLUMES_NB ];
 
 /* Local function prototypes---------------------------------------------------------------------------------------- */
 /* Local functions ------------------------------------------------------------------------------------------------- */
@@ -80,8 +89,7 @@ ef_return_et eEFPrvLFNBufferPtrGet (
 
   ef_return_et  eRetVal = EF_RET_OK;
 
-  if (    ( 0 <= pxFS->u8LogicNumber )
-       && ( EF_CONF_VOLUMES_NB > pxFS->u8LogicNumber ) )
+  if ( EF_CONF_VOLUMES_NB > pxFS->u8LogicNumber )
   {
     /* Volume number */
     *ppxBuffer = pxLFNBuffers[ pxFS->u8LogicNumber ];
@@ -103,8 +111,7 @@ ef_return_et eEFPrvLFNBufferPtrSet (
 
   ef_return_et  eRetVal = EF_RET_OK;
 
-  if (    ( 0 <= pxFS->u8LogicNumber )
-       && ( EF_CONF_VOLUMES_NB > pxFS->u8LogicNumber ) )
+  if ( EF_CONF_VOLUMES_NB > pxFS->u8LogicNumber )
   {
     /* Volume number */
     pxLFNBuffers[ pxFS->u8LogicNumber ] = pxBuffer;
@@ -116,6 +123,109 @@ ef_return_et eEFPrvLFNBufferPtrSet (
   return eRetVal;
 }
 
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
+/* Take a working buffer from the pool */
+ef_return_et eEFPrvLFNBufferTake (
+  ucs2_t  **  ppxBuffer
+)
+{
+  EF_ASSERT_PRIVATE( 0 != ppxBuffer );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32Taken = 0;
+  ef_u32_t      u32Index;
+
+  *ppxBuffer = 0;
+
+  /* Mark the first free buffer of the last seen state, retry if another task changed the state meanwhile */
+  do
+  {
+    for ( u32Index = 0 ;    ( EF_CONF_VFAT_BUFFER_POOL_NB > u32Index )
+                         && ( 0 != ( u32Taken & ( 1UL << u32Index ) ) ) ; u32Index++ )
+    {
+      EF_CODE_COVERAGE( );
+    }
+  } while (    ( EF_CONF_VFAT_BUFFER_POOL_NB > u32Index )
+            && ( EF_BOOL_FALSE == bEFPortAtomicCompareSwap( &u32LFNBuffersTaken, &u32Taken,
+                                                            u32Taken | ( 1UL << u32Index ) ) ) );
+
+  if ( EF_CONF_VFAT_BUFFER_POOL_NB == u32Index )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_NOT_ENOUGH_CORE );
+  }
+  else
+  {
+    *ppxBuffer = xLFNBuffers[ u32Index ].xBuffer;
+  }
+  return eRetVal;
+}
+
+/* Take a working buffer from the pool and link it to the volume */
+ef_return_et eEFPrvLFNBufferAcquire (
+  ef_fs_st  *   pxFS,
+  ucs2_t    **  ppxBuffer
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != ppxBuffer );
+
+  ef_return_et  eRetVal;
+
+  eRetVal = eEFPrvLFNBufferTake( ppxBuffer );
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if ( EF_RET_OK != eEFPrvLFNBufferPtrSet( pxFS, *ppxBuffer ) )
+  {
+    /* Not linked, the caller will not give it back */
+    (void) eEFPrvLFNBufferRelease( *ppxBuffer );
+    *ppxBuffer = 0;
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  return eRetVal;
+}
+
+/* Give a working buffer back to the pool */
+ef_return_et eEFPrvLFNBufferRelease (
+  ucs2_t  * pxBuffer
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32Index;
+  ef_u32_t      u32Taken;
+
+  if ( 0 == pxBuffer )
+  {
+    /* Nothing taken */
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    u32Index = (ef_u32_t) ( (LFN_Buffer_st *) pxBuffer - xLFNBuffers );
+    if ( EF_CONF_VFAT_BUFFER_POOL_NB <= u32Index )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+    }
+    else
+    {
+      /* Clear the bit of the buffer, retry if another task changed the state meanwhile */
+      u32Taken = 1UL << u32Index;
+      while ( EF_BOOL_FALSE == bEFPortAtomicCompareSwap( &u32LFNBuffersTaken, &u32Taken,
+                                                         u32Taken & ~( 1UL << u32Index ) ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+  return eRetVal;
+}
+#endif
+
 /* VFAT-LFN: Compare a part of file name with an LFN entry */
 ef_return_et eEFPrvLFNCompare (
   const ucs2_t  * pxLFNBuffer,
@@ -149,9 +259,20 @@ ef_return_et eEFPrvLFNCompare (
       ucs2_t uc = u16EFPortLoad( pu8Dir + LfnOfs[ s ] );
       if ( 0 != u16Char )
       {
+        ef_u32_t  u32CharDir  = 0;
+        ef_u32_t  u32CharName = 1;
+        /* Up-case both characters, a buffer overflow never matches */
+        if ( i < ( EF_LFN_UNITS_MAX + 1 ) )
+        {
+          (void) eEFPrvUnicodeToUpper( uc, &u32CharDir );
+          (void) eEFPrvUnicodeToUpper( pxLFNBuffer[ i++ ], &u32CharName );
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
         /* Compare it */
-        if (    ( i >= ( EF_LFN_UNITS_MAX + 1 ) )
-             || ( ef_wtoupper( uc ) != ef_wtoupper( pxLFNBuffer[ i++ ] ) ) )
+        if ( u32CharDir != u32CharName )
         {
           /* Not matched */
           eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
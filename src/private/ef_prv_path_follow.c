@@ -108,7 +108,7 @@ ef_return_et eEFPrvPathFollow (
     /* Follow path */
     for ( ; ; )
     {
-      ef_bool_t bFound = EF_BOOL_FALSE;
+      ef_bool_t bSegmentFound = EF_BOOL_FALSE;
 
       /* Get a segment name of the pxPath failed */
       if ( EF_RET_OK != eEFPrvNameCreate( pxDir, &pxPath ) )
@@ -117,13 +117,13 @@ ef_return_et eEFPrvPathFollow (
         break;
       }
       /* Else, if finding an object with the segment name failed */
-      else if ( EF_RET_OK != eEFPrvDirFind( pxDir, &bFound ) )
+      else if ( EF_RET_OK != eEFPrvDirFind( pxDir, &bSegmentFound ) )
       {
         eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_NAME );
         break;
       }
       /* Else, if Failed to find the object */
-      else if ( EF_BOOL_FALSE == bFound )
+      else if ( EF_BOOL_FALSE == bSegmentFound )
       {
         ef_u08_t  ns = pxDir->u8Name[ EF_NSFLAG ];
         /* If dot entry is not exist, stay there */
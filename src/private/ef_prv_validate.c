@@ -45,11 +45,30 @@
 #include "ef_prv_unicode.h"
 #include "ef_prv_drive.h"
 
-/* Public functions ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
 
-ef_return_et eEFPrvValidateObject (
+/**
+ *  @brief  Check if the file/directory object is valid and lock its volume, exclusive or shared
+ *
+ *  @param  pxObject  Pointer to the object to check validity
+ *  @param  ppxFS     Pointer to pointer to the owner filesystem object to return
+ *  @param  bShared   Lock the volume shared
+ *
+ *  @return Function completion, see eEFPrvValidateObject()
+ */
+static ef_return_et eEFPrvValidateObjectMode (
   ef_object_st   * pxObject,
-  ef_fs_st      ** ppxFS
+  ef_fs_st      ** ppxFS,
+  ef_bool_t        bShared
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+/* Check if the file/directory object is valid and lock its volume, exclusive or shared */
+static ef_return_et eEFPrvValidateObjectMode (
+  ef_object_st   * pxObject,
+  ef_fs_st      ** ppxFS,
+  ef_bool_t        bShared
 )
 {
   EF_ASSERT_PRIVATE( 0 != pxObject );
@@ -74,7 +93,12 @@ ef_return_et eEFPrvValidateObject (
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_OBJECT );
   }
   /* Else, if we cannot obtain the file system object */
-  else if ( EF_RET_OK != eEFPrvFSLock( pxObject->pxFS ) )
+  else if ( ( EF_BOOL_FALSE == bShared ) && ( EF_RET_OK != eEFPrvFSLock( pxObject->pxFS ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
+  }
+  /* Else, if we cannot obtain the file system object shared */
+  else if ( ( EF_BOOL_FALSE != bShared ) && ( EF_RET_OK != eEFPrvFSLockShared( pxObject->pxFS ) ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
   }
@@ -95,5 +119,23 @@ ef_return_et eEFPrvValidateObject (
   return eRetVal;
 }
 
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFPrvValidateObject (
+  ef_object_st   * pxObject,
+  ef_fs_st      ** ppxFS
+)
+{
+  return eEFPrvValidateObjectMode( pxObject, ppxFS, EF_BOOL_FALSE );
+}
+
+ef_return_et eEFPrvValidateObjectShared (
+  ef_object_st   * pxObject,
+  ef_fs_st      ** ppxFS
+)
+{
+  return eEFPrvValidateObjectMode( pxObject, ppxFS, EF_BOOL_TRUE );
+}
+
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
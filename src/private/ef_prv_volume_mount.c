@@ -153,6 +153,21 @@ static  ef_return_et eEFPrvBPBFATAnalyze (
   ef_fs_st  * pxFS
 );
 
+/**
+ *  @brief  Determine logical drive number and lock the volume, exclusive or shared
+ *
+ *  @param  ppxPath Pointer to pointer to the pxPath name (drive number)
+ *  @param  ppxFS   Pointer to pointer to the found filesystem object
+ *  @param  bShared Lock the volume shared
+ *
+ *  @return Operation result, see eEFPrvVolumeMountCheck()
+ */
+static  ef_return_et eEFPrvVolumeMountCheckMode (
+  const TCHAR **  ppxPath,
+  ef_fs_st    **  ppxFS,
+  ef_bool_t       bShared
+);
+
 
 /* Local functions ------------------------------------------------------------------------------------------------- */
 
@@ -723,6 +738,8 @@ ef_return_et eEFPrvVolumeMount (
   {
     /* Volume mount ID */
     pxFS->u16MountId = ++Fsid;
+    /* Free extent index is built on first use */
+    (void) eEFPrvFATIndexReset( pxFS );
     if ( 0 != EF_CONF_VFAT )
     {
 //  #if ( EF_DEF_VFAT_BUFFER_STATIC == EF_CONF_VFAT_BUFFER ) && ( 0 != EF_CONF_VFAT )
@@ -782,9 +799,11 @@ ef_return_et eEFPrvVolumeFSPtrSet (
   return eRetVal;
 }
 
-ef_return_et eEFPrvVolumeMountCheck (
+/* Determine logical drive number and lock the volume, exclusive or shared */
+static  ef_return_et eEFPrvVolumeMountCheckMode (
   const TCHAR **  ppxPath,
-  ef_fs_st    **  ppxFS
+  ef_fs_st    **  ppxFS,
+  ef_bool_t       bShared
 )
 {
   EF_ASSERT_PRIVATE( 0 != ppxPath );
@@ -813,7 +832,12 @@ ef_return_et eEFPrvVolumeMountCheck (
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_NOT_ENABLED );
   }
   /* Else, if we cannot lock the volume */
-  else if ( EF_RET_OK != eEFPrvFSLock( pxFS ) )
+  else if ( ( EF_BOOL_FALSE == bShared ) && ( EF_RET_OK != eEFPrvFSLock( pxFS ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
+  }
+  /* Else, if we cannot lock the volume shared */
+  else if ( ( EF_BOOL_FALSE != bShared ) && ( EF_RET_OK != eEFPrvFSLockShared( pxFS ) ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TIMEOUT );
   }
@@ -848,5 +872,21 @@ ef_return_et eEFPrvVolumeMountCheck (
   return eRetVal;
 }
 
+ef_return_et eEFPrvVolumeMountCheck (
+  const TCHAR **  ppxPath,
+  ef_fs_st    **  ppxFS
+)
+{
+  return eEFPrvVolumeMountCheckMode( ppxPath, ppxFS, EF_BOOL_FALSE );
+}
+
+ef_return_et eEFPrvVolumeMountCheckShared (
+  const TCHAR **  ppxPath,
+  ef_fs_st    **  ppxFS
+)
+{
+  return eEFPrvVolumeMountCheckMode( ppxPath, ppxFS, EF_BOOL_TRUE );
+}
+
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
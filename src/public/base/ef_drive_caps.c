@@ -0,0 +1,59 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_drive_caps.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Get the capabilities of a drive
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include "efat.h"
+#include "ef_prv_def.h"
+#include "ef_prv_drive.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEF_drive_caps_get (
+  ef_u08_t            u8PhyDrvNb,
+  ef_drive_caps_st  * pxCaps
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxCaps );
+
+  ef_return_et eRetVal = eEFPrvDriveCapsGet( u8PhyDrvNb, pxCaps );
+
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
+
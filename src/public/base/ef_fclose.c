@@ -33,6 +33,7 @@
 #include <efat.h>
 #include "ef_prv_lock.h"
 #include "ef_prv_validate.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -50,6 +51,7 @@ ef_return_et eEF_fclose (
   EF_ASSERT_PUBLIC( 0 != pxFile );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FCLOSE, pxFile );
   ef_fs_st    * pxFS;
 
   /* Flush cached data */
@@ -73,12 +75,14 @@ ef_return_et eEF_fclose (
   }
   else
   {
-    EF_CODE_COVERAGE( );
+    /* Invalidate file object */
+    pxFile->xObject.pxFS = 0;
   }
 
   /* Unlock volume */
   (void) eEFPrvFSUnlockForce( pxFS );
 
+  EF_LATENCY_END( EF_LATENCY_FCLOSE, eRetVal );
   return eRetVal;
 }
 
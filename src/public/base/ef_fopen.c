@@ -33,6 +33,7 @@
 #include <efat.h>
 #include <ef_prv_def.h>
 #include <ef_prv_fat.h>
+#include <ef_prv_file.h>
 #include "ef_prv_drive.h"
 #include "ef_prv_directory.h"
 #include "ef_prv_dirfunc.h"
@@ -50,6 +51,7 @@
 #include <ef_prv_volume_mount.h>
 #include <ef_port_load_store.h>
 #include <ef_port_memory.h>
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -104,9 +106,9 @@ ef_return_et eEF_file_truncate (
   EF_ASSERT_PRIVATE( 0 != pxFile );
   EF_ASSERT_PRIVATE( 0 != pxFS );
 
-  ef_return_et  eRetVal = EF_RET_ERROR;
+  ef_return_et  eRetVal = EF_RET_OK;
 
-  ef_u32_t  u32Cluster;
+  ef_u32_t  u32Cluster = 0;
   ef_lba_t  xSector;
 
   /* Set directory entry initial state */
@@ -137,6 +139,10 @@ ef_return_et eEF_file_truncate (
       /* Reuse the cluster hole */
       pxFS->u32ClstLast = u32Cluster - 1;
     }
+    else
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+    }
   }
 
   return eRetVal;
@@ -154,6 +160,7 @@ ef_return_et eEF_fopen (
   EF_ASSERT_PUBLIC( 0 != pxPath );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FOPEN, pxPath );
   ef_fs_st *    pxFS;
   ef_u08_t      u8temp = u8Mode & (   EF_FILE_OPEN_EXISTING
                                     | EF_FILE_OPEN_ANYWAY
@@ -183,10 +190,10 @@ ef_return_et eEF_fopen (
     xDir.xObject.pxFS = pxFS;
 
     /* Link buffers for name to the instance of the FS object */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
       /* LFN Buffer setting error */
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_LFN_BUFFER_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     else
     {
@@ -297,7 +304,6 @@ ef_return_et eEF_fopen (
       }
       else
       {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
         EF_CODE_COVERAGE( );
       }
 
@@ -361,12 +367,29 @@ ef_return_et eEF_fopen (
         pxFile->xSector = 0;
         /* Set file pointer top of the file */
         pxFile->u32FileOffset = 0;
+#if ( 0 != EF_CONF_DELAYED_ALLOC )
+        /* Nothing staged for delayed allocation */
+        pxFile->u32DelayedSize = 0;
+#endif
+        /* Contiguous run of the chain is not known yet */
+        pxFile->u32ClstRunNb = 0;
         /* Clear sector buffer */
         eEFPortMemZero( pxFile->u8Window, sizeof(pxFile->u8Window) );
 
+        /* If measuring the contiguous run of the chain failed */
+        if ( EF_RET_OK != eEFPrvFileRunCheck( pxFile, pxFS ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+
         /* If     EF_FILE_OPEN_APPEND is specified
          *    AND File size is not null */
-        if (    ( 0 != (u8Mode & EF_FILE_OPEN_APPEND) )
+        if (    ( EF_RET_OK == eRetVal )
+             && ( 0 != (u8Mode & EF_FILE_OPEN_APPEND) )
              && ( pxFile->u32Size > 0 ) )
         {
           /* Seek to end of file if EF_FILE_OPEN_APPEND is specified */
@@ -377,6 +400,21 @@ ef_return_et eEF_fopen (
           /* Follow the cluster chain */
           u32Cluster = pxFile->xObject.u32ClstStart;
           ef_u32_t u32Offset = pxFile->u32Size;
+          /* Index of the last cluster of the file */
+          ef_u32_t u32ClusterIndex = ( u32Offset - 1 ) / u32ClusterSize;
+          ef_bool_t bFound = EF_BOOL_FALSE;
+          /* If the last cluster is in the contiguous run */
+          if (    ( EF_RET_OK == eEFPrvFileRunClusterGet( pxFile, u32ClusterIndex, &u32Cluster, &bFound ) )
+               && ( EF_BOOL_FALSE != bFound ) )
+          {
+            /* Jump to it without following the FAT */
+            u32Offset -= u32ClusterIndex * u32ClusterSize;
+          }
+          else
+          {
+            u32Cluster = pxFile->xObject.u32ClstStart;
+            (void) eEFPrvFileRunGrow( pxFile, 0, u32Cluster );
+          }
           while ( u32Offset > u32ClusterSize )
           {
             if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32Cluster ) )
@@ -387,6 +425,8 @@ ef_return_et eEF_fopen (
             else
             {
               u32Offset -= u32ClusterSize;
+              /* Extend the contiguous run if the chain still follows it */
+              (void) eEFPrvFileRunGrow( pxFile, ( pxFile->u32Size - u32Offset ) / u32ClusterSize, u32Cluster );
             }
           }
           pxFile->u32Clst = u32Cluster;
@@ -440,6 +480,7 @@ ef_return_et eEF_fopen (
 
   }
 
+  EF_LATENCY_END( EF_LATENCY_FOPEN, eRetVal );
   return eRetVal;
 }
 
@@ -50,6 +50,7 @@
 #include "ef_prv_volume.h"
 
 #include <stdio.h>
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -83,24 +84,47 @@ ef_return_et eEFPrvFileReadClusterNbUpdate (
 
   ef_return_et  eRetVal = EF_RET_OK;
   ef_u32_t     u32ClusterNb;
+  /* Index of the cluster in the chain */
+  ef_u32_t     u32ClusterIndex = pxFile->u32FileOffset
+                               / ( (ef_u32_t) pxFile->xObject.pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFile->xObject.pxFS ) );
+  /* The cluster is in the contiguous run of the file */
+  ef_bool_t    bFound = EF_BOOL_FALSE;
 
   /* If on the top of the file? */
   if ( 0 == pxFile->u32FileOffset )
   {
     /* Follow cluster chain from the origin */
     pxFile->u32Clst = pxFile->xObject.u32ClstStart;
+    (void) eEFPrvFileRunGrow( pxFile, 0, pxFile->u32Clst );
   }
-  /* Else, if Following cluster chain on the FAT failed (Middle or end of the file) */
-  else if ( EF_RET_OK != eEFPrvFATGet( pxFile->xObject.pxFS, pxFile->u32Clst, &u32ClusterNb ) )
+  /* Else, if the cluster is in the contiguous run, no FAT access is needed */
+  else if (    ( EF_RET_OK == eEFPrvFileRunClusterGet( pxFile, u32ClusterIndex, &u32ClusterNb, &bFound ) )
+            && ( EF_BOOL_FALSE != bFound ) )
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
     /* Update current cluster */
-    pxFile->u32Clst = 0;
+    pxFile->u32Clst = u32ClusterNb;
   }
+  /* Else, the cluster chain is followed on the FAT (Middle or end of the file) */
   else
   {
-    /* Update current cluster */
-    pxFile->u32Clst = u32ClusterNb;
+    /* The window is shared with the other tasks reading the volume */
+    (void) eEFPrvFSWindowLock( pxFile->xObject.pxFS );
+    eRetVal = eEFPrvFATGet( pxFile->xObject.pxFS, pxFile->u32Clst, &u32ClusterNb );
+    (void) eEFPrvFSWindowUnlock( pxFile->xObject.pxFS );
+    /* If following the cluster chain failed */
+    if ( EF_RET_OK != eRetVal )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      /* Update current cluster */
+      pxFile->u32Clst = 0;
+    }
+    else
+    {
+      /* Update current cluster */
+      pxFile->u32Clst = u32ClusterNb;
+      /* Extend the contiguous run if the chain still follows it */
+      (void) eEFPrvFileRunGrow( pxFile, u32ClusterIndex, u32ClusterNb );
+    }
   }
 
   return eRetVal;
@@ -120,16 +144,29 @@ ef_return_et eEF_fread (
   EF_ASSERT_PUBLIC( 0 != pu32BytesRead );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FREAD, pxFile );
   ef_fs_st    * pxFS;
+  /* Reading a file with no delayed data leaves the volume unmodified, the other readers share it */
+#if ( 0 != EF_CONF_DELAYED_ALLOC )
+  ef_bool_t     bShared = ( 0 == pxFile->u32DelayedSize ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+#else
+  ef_bool_t     bShared = EF_BOOL_TRUE;
+#endif
 
   /* Clear read byte counter */
   *pu32BytesRead = 0;
   /* Check validity of the file object */
   /* If File object is not valid */
-  if ( EF_RET_OK != eEFPrvValidateObject( &pxFile->xObject, &pxFS ) )
+  if (    ( ( EF_BOOL_FALSE != bShared ) && ( EF_RET_OK != eEFPrvValidateObjectShared( &pxFile->xObject, &pxFS ) ) )
+       || ( ( EF_BOOL_FALSE == bShared ) && ( EF_RET_OK != eEFPrvValidateObject( &pxFile->xObject, &pxFS ) ) ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_OBJECT );
   }
+  /* Else, if allocating and writing the delayed data failed */
+  else if ( EF_RET_OK != eEFPrvFileDelayedFlush( pxFile, pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
   /* Else, if Nothing to read */
   else if ( 0 == u32BytesToRead )
   {
@@ -236,15 +273,13 @@ ef_return_et eEF_fread (
          *    AND (    Updating the current cluster failed
          *          OR Getting the base sector of the cluster failed )
          */
-        if ( 0 != u32ClusterOffset )
-        {
-          EF_CODE_COVERAGE( );
-        }
-        else if ( EF_RET_OK != eEFPrvFileReadClusterNbUpdate( pxFile ) )
+        if (    ( 0 == u32ClusterOffset )
+             && ( EF_RET_OK != eEFPrvFileReadClusterNbUpdate( pxFile ) ) )
         {
           eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
           break;
         }
+        /* Else, if getting the base sector of the current cluster failed */
         else if ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, pxFile->u32Clst, &xSector ) )
         {
           eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
@@ -252,7 +287,8 @@ ef_return_et eEF_fread (
         }
         else
         {
-          EF_CODE_COVERAGE( );
+          /* Add the offset in the cluster to the Sector number to get the real value */
+          xSector += u32ClusterOffset;
         }
 
         /* Get the number of remaining sectors */
@@ -262,11 +298,24 @@ ef_return_et eEF_fread (
         if ( 0 != u32SectorsNb )
         { /* TRANSFER WHOLE SECTORS ONLY BEGIN */
 
-          /* Add the offset in the cluster to the Sector number to get the real value */
-          xSector += u32ClusterOffset;
+          /* Sectors left in the contiguous run from the file offset */
+          ef_u32_t  u32SectorsRunNb = 0;
 
-          /* If the sectors remaining to read in the cluster is larger than the cluster size */
-          if ( ( u32SectorsNb + u32ClusterOffset ) > pxFS->u8ClstSize )
+          (void) eEFPrvFileRunSectorsGet( pxFile, pxFS, &u32SectorsRunNb );
+          /* If the read stays inside the contiguous run */
+          if ( u32SectorsNb <= u32SectorsRunNb )
+          {
+            /* Read across the cluster boundaries at once */
+            EF_CODE_COVERAGE( );
+          }
+          /* Else, if the contiguous run goes beyond the current cluster */
+          else if ( u32SectorsRunNb > ( pxFS->u8ClstSize - u32ClusterOffset ) )
+          {
+            /* Clip at the end of the contiguous run */
+            u32SectorsNb = u32SectorsRunNb;
+          }
+          /* Else, if the sectors remaining to read in the cluster is larger than the cluster size */
+          else if ( ( u32SectorsNb + u32ClusterOffset ) > pxFS->u8ClstSize )
           {
             /* Clip at cluster boundary, Limit the number of sectors to what remains in the cluster */
             u32SectorsNb = pxFS->u8ClstSize - u32ClusterOffset;
@@ -276,19 +325,46 @@ ef_return_et eEF_fread (
             EF_CODE_COVERAGE( );
           }
 
-          /* Reading whole sectors */
-          /* If reading the maximum contiguous sectors directly failed */
-          if ( EF_RET_OK != eEFPrvDriveRead( pxFS->u8PhysDrv, pu8DataBuffer, xSector, u32SectorsNb ) )
+          /* Reading whole sectors, the volume being released meanwhile so that other tasks can use it */
+          (void) eEFPrvFSUnlockForce( pxFS );
+          ef_return_et  eDriveRetVal = eEFPrvDriveRead( pxFS->u8PhysDrv, pu8DataBuffer, xSector, u32SectorsNb );
+
+          eRetVal = eEFPrvFSRelock( &pxFile->xObject, bShared );
+          /* If getting the volume back failed */
+          if ( EF_RET_OK != eRetVal )
+          {
+            break;
+          }
+          /* Else, if reading the maximum contiguous sectors directly failed */
+          else if ( EF_RET_OK != eDriveRetVal )
           {
             eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
             break;
           }
           else
           {
+            /* If     the window holds unwritten data
+             *    AND its sector was part of the read
+             */
+            if (    ( 0 != ( pxFile->u8StatusFlags & EF_FILE_WIN_DIRTY ) )
+                 && ( pxFile->xSector >= xSector )
+                 && ( pxFile->xSector < ( xSector + u32SectorsNb ) ) )
+            {
+              /* The window is more recent than the disk */
+              (void) eEFPortMemCopy( pxFile->u8Window,
+                                     pu8DataBuffer + ( ( pxFile->xSector - xSector ) * EF_SECTOR_SIZE( pxFS ) ),
+                                     EF_SECTOR_SIZE( pxFS ) );
+            }
+            else
+            {
+              EF_CODE_COVERAGE( );
+            }
             /* Number of bytes transferred */
             u32BytesTransfered = EF_SECTOR_SIZE( pxFS ) * u32SectorsNb;
-            /* Add the sector offset in the cluster to the sector number */
-            xSector += u32ClusterOffset;
+            /* Move to the sector following the read */
+            xSector += u32SectorsNb;
+            /* Move to the last cluster read, clusters of the run are contiguous */
+            pxFile->u32Clst += ( u32ClusterOffset + u32SectorsNb - 1 ) / pxFS->u8ClstSize;
           }
 
         } /* TRANSFER WHOLE SECTORS ONLY END */
@@ -316,17 +392,17 @@ ef_return_et eEF_fread (
       /* Invalidate the window */
       xSector = 0;
     }
+    /* Else, if there are no more bytes to read */
+    else if ( 0 == u32BytesToRead )
+    {
+      /* We are done, the window is left untouched */
+      xSector = pxFile->xSector;
+    }
     /* Else, if Data sector window update failed */
     else if ( EF_RET_OK != eEFPrvFileWindowUpdate ( pxFile, pxFS, xSector ) )
     {
       eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
     }
-    /* Else, if there are no more bytes to read */
-    else if ( 0 == u32BytesToRead )
-    {
-      /* We are done */
-      EF_CODE_COVERAGE( );
-    }
     /* Else, if filling the remaining bytes into the window */
     else if ( EF_RET_OK != eEFPortMemCopy( pxFile->u8Window, pu8DataBuffer, u32BytesToRead ) )
     {
@@ -351,6 +427,7 @@ ef_return_et eEF_fread (
   /* Unlock filesystem if eRetVal allows */
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
 
+  EF_LATENCY_END( EF_LATENCY_FREAD, eRetVal );
   return eRetVal;
 }
 
@@ -48,6 +48,7 @@
 #include "ef_prv_validate.h"
 #include "ef_prv_volume_nb.h"
 #include "ef_prv_volume.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -65,6 +66,7 @@ ef_return_et eEF_fsync (
   EF_ASSERT_PUBLIC( 0 != pxFile );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FSYNC, pxFile );
   ef_fs_st    * pxFS;
   ef_u08_t    * pu8Dir;
 
@@ -78,11 +80,31 @@ ef_return_et eEF_fsync (
   {
     EF_CODE_COVERAGE( );
   }
+  /* Else, if queuing the writes of the data and its clusters chain failed */
+  else if ( EF_RET_OK != eEFPrvDriveElevatorStart( pxFS->u8PhysDrv ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  /* Else, if allocating and writing the delayed data failed */
+  else if ( EF_RET_OK != eEFPrvFileDelayedFlush( pxFile, pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
   /* Else, if Write-back cached data failed */
   else if ( EF_RET_OK != eEFPrvFileWindowDirtyWriteBack( pxFile, pxFS ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
   }
+  /* Else, if the data could not be written before the directory entry pointing to it */
+  else if ( EF_RET_OK != eEFPrvDriveElevatorFlush( pxFS->u8PhysDrv ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  /* Else, if queuing the writes of the metadata failed */
+  else if ( EF_RET_OK != eEFPrvDriveElevatorStart( pxFS->u8PhysDrv ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
   /* Else, if updating the FS window failed */
   else if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, pxFile->xDirSector ) )
   {
@@ -135,7 +157,18 @@ ef_return_et eEF_fsync (
     }
   }
 
+  /* The writes queued before a failure are issued anyway */
+  if ( ( EF_RET_OK != eRetVal ) && ( 0 != pxFS ) )
+  {
+    (void) eEFPrvDriveElevatorFlush( pxFS->u8PhysDrv );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_FSYNC, eRetVal );
   return eRetVal;
 }
 
@@ -51,6 +51,7 @@
 #include <ef_port_memory.h>
 
 #include "stdio.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -85,6 +86,11 @@ ef_return_et eEFPrvFileWriteClusterNbUpdate (
   ef_return_et  eRetVal = EF_RET_OK;
 
   ef_u32_t u32ClusterNb;
+  /* Index of the cluster in the chain */
+  ef_u32_t u32ClusterIndex = pxFile->u32FileOffset
+                           / ( (ef_u32_t) pxFile->xObject.pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFile->xObject.pxFS ) );
+  /* The cluster is in the contiguous run of the file */
+  ef_bool_t bFound = EF_BOOL_FALSE;
   /* On the top of the file? */
   if ( 0 == pxFile->u32FileOffset )
   {
@@ -102,9 +108,16 @@ ef_return_et eEFPrvFileWriteClusterNbUpdate (
     }
     else
     {
-      EF_CODE_COVERAGE( );
+      /* A new chain starts a new run */
+      pxFile->u32ClstRunNb = 0;
     }
   }
+  /* Else, if the cluster is in the contiguous run, no FAT access is needed */
+  else if (    ( EF_RET_OK == eEFPrvFileRunClusterGet( pxFile, u32ClusterIndex, &u32ClusterNb, &bFound ) )
+            && ( EF_BOOL_FALSE != bFound ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
   /* Middle or end of the file */
   /* Follow or stretch cluster chain on the FAT */
   else if ( EF_RET_OK != eEFPrvFATChainStretch( &pxFile->xObject, pxFile->u32Clst, &u32ClusterNb ) )
@@ -129,6 +142,8 @@ ef_return_et eEFPrvFileWriteClusterNbUpdate (
     {
       EF_CODE_COVERAGE( );
     }
+    /* Extend the contiguous run if the chain still follows it */
+    (void) eEFPrvFileRunGrow( pxFile, u32ClusterIndex, u32ClusterNb );
   }
   else
   {
@@ -153,6 +168,7 @@ ef_return_et eEF_fwrite (
   EF_ASSERT_PUBLIC( 0 != pu32BytesWritten );
 
   ef_return_et    eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FWRITE, pxFile );
   ef_fs_st      * pxFS;
 
   /* Clear written bytes counter */
@@ -205,8 +221,36 @@ ef_return_et eEF_fwrite (
       /* Offset in the sector */
       ef_u32_t  u32OffsetInSector = (ef_u32_t)( pxFile->u32FileOffset ) % EF_SECTOR_SIZE( pxFS );
 
-      /* If on the sector boundary */
-      if ( 0 != u32OffsetInSector )
+      /* Data past the end of the cluster chain, allocation is delayed */
+      ef_bool_t bDelayed = EF_BOOL_FALSE;
+
+      /* If checking for delayed allocation failed */
+      if ( EF_RET_OK != eEFPrvFileDelayedCheck( pxFile, pxFS, &bDelayed ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        break;
+      }
+      /* Else, if the data goes to the delayed allocation buffer */
+      else if ( EF_BOOL_FALSE != bDelayed )
+      { /* TRANSFER TO THE DELAYED ALLOCATION BUFFER BEGIN */
+        /* If staging the data failed, a full volume is reported as such */
+        if ( EF_RET_OK != ( eRetVal = eEFPrvFileDelayedWrite( pxFile,
+                                                              pxFS,
+                                                              pu8DataBuffer,
+                                                              u32BytesToWrite,
+                                                              &u32BytesTransfered ) ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+          break;
+        }
+        else
+        {
+          /* A flush may have moved the window */
+          xSector = pxFile->xSector;
+        }
+      } /* TRANSFER TO THE DELAYED ALLOCATION BUFFER END */
+      /* Else, if on the sector boundary */
+      else if ( 0 != u32OffsetInSector )
       { /* TRANSFER NOT ON THE SECTOR BOUNDARY BEGIN */
 
         /* Number of bytes remaining in the sector */
@@ -251,15 +295,13 @@ ef_return_et eEF_fwrite (
          *    AND (    Updating the current cluster failed
          *          OR Getting the base sector of the cluster failed )
          */
-        if ( 0 != u32ClusterOffset )
-        {
-          EF_CODE_COVERAGE( );
-        }
-        else if ( EF_RET_OK != eEFPrvFileWriteClusterNbUpdate( pxFile ) )
+        if (    ( 0 == u32ClusterOffset )
+             && ( EF_RET_OK != eEFPrvFileWriteClusterNbUpdate( pxFile ) ) )
         {
           eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
           break;
         }
+        /* Else, if getting the base sector of the current cluster failed */
         else if ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, pxFile->u32Clst, &xSector ) )
         {
           eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
@@ -267,7 +309,8 @@ ef_return_et eEF_fwrite (
         }
         else
         {
-          EF_CODE_COVERAGE( );
+          /* Add the offset in the cluster to the Sector number to get the real value */
+          xSector += u32ClusterOffset;
         }
 
         /* Get the number of remaining sectors */
@@ -277,8 +320,24 @@ ef_return_et eEF_fwrite (
         if ( 0 != u32SectorsNb )
         { /* TRANSFER WHOLE SECTORS ONLY BEGIN */
 
-          /* If the sectors remaining to write in the cluster is larger than the cluster size */
-          if ( ( u32SectorsNb + u32ClusterOffset ) > pxFS->u8ClstSize )
+          /* Sectors left in the contiguous run from the file offset */
+          ef_u32_t  u32SectorsRunNb = 0;
+
+          (void) eEFPrvFileRunSectorsGet( pxFile, pxFS, &u32SectorsRunNb );
+          /* If the write stays inside the contiguous run */
+          if ( u32SectorsNb <= u32SectorsRunNb )
+          {
+            /* Write across the cluster boundaries at once */
+            EF_CODE_COVERAGE( );
+          }
+          /* Else, if the contiguous run goes beyond the current cluster */
+          else if ( u32SectorsRunNb > ( pxFS->u8ClstSize - u32ClusterOffset ) )
+          {
+            /* Clip at the end of the contiguous run */
+            u32SectorsNb = u32SectorsRunNb;
+          }
+          /* Else, if the sectors remaining to write in the cluster is larger than the cluster size */
+          else if ( ( u32SectorsNb + u32ClusterOffset ) > pxFS->u8ClstSize )
           {
             /* Clip at cluster boundary, Limit the number of sectors to what remains in the cluster */
             u32SectorsNb = pxFS->u8ClstSize - u32ClusterOffset;
@@ -288,19 +347,44 @@ ef_return_et eEF_fwrite (
             EF_CODE_COVERAGE( );
           }
 
-          /* Writing whole sectors */
-          /* If writing the maximum contiguous sectors directly failed */
-          if ( EF_RET_OK != eEFPrvDriveWrite( pxFS->u8PhysDrv, pu8DataBuffer, xSector, u32SectorsNb ) )
+          /* Writing whole sectors, the volume being released meanwhile so that other tasks can use it */
+          (void) eEFPrvFSUnlockForce( pxFS );
+          ef_return_et  eDriveRetVal = eEFPrvDriveWrite( pxFS->u8PhysDrv, pu8DataBuffer, xSector, u32SectorsNb );
+
+          eRetVal = eEFPrvFSRelock( &pxFile->xObject, EF_BOOL_FALSE );
+          /* If getting the volume back failed */
+          if ( EF_RET_OK != eRetVal )
+          {
+            break;
+          }
+          /* Else, if writing the maximum contiguous sectors directly failed */
+          else if ( EF_RET_OK != eDriveRetVal )
           {
             eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR);
             break;
           }
           else
           {
+            /* If the window sector was overwritten */
+            if (    ( pxFile->xSector >= xSector )
+                 && ( pxFile->xSector < ( xSector + u32SectorsNb ) ) )
+            {
+              /* Refresh the window with the data written so it does not write back stale data */
+              (void) eEFPortMemCopy( pu8DataBuffer + ( ( pxFile->xSector - xSector ) * EF_SECTOR_SIZE( pxFS ) ),
+                                     pxFile->u8Window,
+                                     EF_SECTOR_SIZE( pxFS ) );
+              pxFile->u8StatusFlags &= (ef_u08_t) ~EF_FILE_WIN_DIRTY;
+            }
+            else
+            {
+              EF_CODE_COVERAGE( );
+            }
             /* Number of bytes transferred */
             u32BytesTransfered = EF_SECTOR_SIZE( pxFS ) * u32SectorsNb;
             /* Add the sector offset in the cluster to the sector number */
             xSector += u32SectorsNb;
+            /* Move to the last cluster written, clusters of the run are contiguous */
+            pxFile->u32Clst += ( u32ClusterOffset + u32SectorsNb - 1 ) / pxFS->u8ClstSize;
           }
 
         } /* TRANSFER WHOLE SECTORS ONLY END */
@@ -326,17 +410,17 @@ ef_return_et eEF_fwrite (
       /* Invalidate the window */
       xSector = 0;
     }
+    /* Else, if there are no more bytes to write */
+    else if ( 0 == u32BytesToWrite )
+    {
+      /* We are done, the window is left untouched */
+      xSector = pxFile->xSector;
+    }
     /* Else, if Data sector window update failed */
     else if ( EF_RET_OK != eEFPrvFileWindowUpdate ( pxFile, pxFS, xSector ) )
     {
       eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
     }
-    /* Else, if there are no more bytes to write */
-    else if ( 0 == u32BytesToWrite )
-    {
-      /* We are done */
-      EF_CODE_COVERAGE( );
-    }
     /* Else, if filling the remaining bytes into the window */
     else if ( EF_RET_OK != eEFPortMemCopy( pu8DataBuffer, pxFile->u8Window, u32BytesToWrite ) )
     {
@@ -386,6 +470,7 @@ ef_return_et eEF_fwrite (
 //  eRetVal = eEFPrvFSUnlock( pxFS, eRetVal );
 //  printf("ErrocCode %d", u8Code);
 
+  EF_LATENCY_END( EF_LATENCY_FWRITE, eRetVal );
   return eRetVal;
 }
 
@@ -31,6 +31,7 @@
 /* Includes -------------------------------------------------------------------------------------------------------- */
 
 #include <ef_port_load_store.h>
+#include <ef_port_memory.h>
 #include <efat.h>
 #include <ef_prv_def.h>
 #include <ef_prv_fat.h>
@@ -48,6 +49,7 @@
 #include <ef_prv_volume_mount.h>
 #include "ef_prv_volume_nb.h"
 #include "ef_prv_volume.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -89,6 +91,7 @@ ef_return_et eEF_mount (
   EF_ASSERT_PUBLIC( 0 != pxPath );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_MOUNT, pxPath );
   const TCHAR * rp = pxPath;
   int8_t        s8VolumeNb = -1;
   ef_fs_st    * pxFS = 0;
@@ -120,6 +123,12 @@ ef_return_et eEF_mount (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
   }
+  /* Create the window lock of the new volume */
+  else if ( EF_RET_OK != eEFPortLockCreate( &(xeFAT[ s8VolumeNb ].xWindowLock) ) )
+  {
+    (void) eEFPortSyncObjectDelete( xeFAT[ s8VolumeNb ].xSyncObject );
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
   /* Lock the volume */
   else if ( EF_RET_OK != eEFPrvFSLock( &xeFAT[ s8VolumeNb ] ) )
   {
@@ -137,14 +146,19 @@ ef_return_et eEF_mount (
 //    xeFAT[ s8VolumeNb ].pu8Window    = pu8pointer;
 //    pu8pointer    = &xeFATWindows[ s8VolumeNb * EF_CONF_SS_MAX ];
     xeFAT[ s8VolumeNb ].pu8Window    = &xeFATWindows[ s8VolumeNb * EF_CONF_SECTOR_SIZE ];
+    xeFAT[ s8VolumeNb ].u32WinSize   = EF_CONF_SECTOR_SIZE;
+#if ( 0 != EF_CONF_STATS )
+    (void) eEFPortMemZero( &xeFAT[ s8VolumeNb ].xStats, sizeof( ef_stats_st ) );
+#endif
 //    eRetVal = eEFPrvVolumeMount( &pxPath, &pxFS, u8ReadOnly );
 
     /* if mounting the volume failed */
     if ( EF_RET_OK != eEFPrvVolumeMount( &xeFAT[ s8VolumeNb ], u8ReadOnly ) )
     {
       (void) eEFPrvFSUnlockForce( &xeFAT[ s8VolumeNb ] );
-      /* Discard sync object of the current volume */
-      if ( EF_RET_OK != eEFPortSyncObjectDelete( xeFAT[ s8VolumeNb ].xSyncObject ) )
+      /* Discard sync objects of the current volume */
+      if (    ( EF_RET_OK != eEFPortLockDelete( &(xeFAT[ s8VolumeNb ].xWindowLock) ) )
+           || ( EF_RET_OK != eEFPortSyncObjectDelete( xeFAT[ s8VolumeNb ].xSyncObject ) ) )
       {
         eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
       }
@@ -167,6 +181,7 @@ ef_return_et eEF_mount (
     }
   }
 
+  EF_LATENCY_END( EF_LATENCY_MOUNT, eRetVal );
   return eRetVal;
 }
 
@@ -178,6 +193,7 @@ ef_return_et eEF_umount (
   EF_ASSERT_PRIVATE( 0 != pxPath );
 
   ef_return_et    eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_UMOUNT, pxPath );
   const TCHAR   * rp = pxPath;
   int8_t          s8VolumeNb = -1;
   ef_fs_st      * pxFS = 0;
@@ -214,7 +230,11 @@ ef_return_et eEF_umount (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_PARAMETER );
   }
-  /* Discard sync object of the current volume */
+  /* Discard sync objects of the current volume */
+  else if ( EF_RET_OK != eEFPortLockDelete( &pxFS->xWindowLock ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
   else if ( EF_RET_OK != eEFPortSyncObjectDelete( pxFS->xSyncObject ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
@@ -224,6 +244,7 @@ ef_return_et eEF_umount (
     EF_CODE_COVERAGE( );
   }
 
+  EF_LATENCY_END( EF_LATENCY_UMOUNT, eRetVal );
   return eRetVal;
 }
 
@@ -46,6 +46,7 @@
 #include "ef_prv_lfn.h"
 #include "ef_prv_unicode.h"
 #include "ef_prv_path_follow.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -63,6 +64,7 @@ ef_return_et eEF_remove (
   EF_ASSERT_PUBLIC( 0 != pxPath );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_REMOVE, pxPath );
   ef_fs_st    * pxFS;
 
 
@@ -82,9 +84,9 @@ ef_return_et eEF_remove (
     xDir.xObject.pxFS = pxFS;
 
     /* If LFN BUFFER initialisation failed */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     /* Else, if following file path failed */
     else if ( EF_RET_OK != eEFPrvPathFollow( pxPath, &xDir, &bFound ) )
@@ -209,6 +211,7 @@ ef_return_et eEF_remove (
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
 
+  EF_LATENCY_END( EF_LATENCY_REMOVE, eRetVal );
   return eRetVal;
 }
 
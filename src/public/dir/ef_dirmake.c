@@ -47,6 +47,7 @@
 #include "ef_prv_lfn.h"
 #include "ef_prv_unicode.h"
 #include "ef_prv_path_follow.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -64,6 +65,7 @@ ef_return_et eEF_dirmake (
   EF_ASSERT_PUBLIC( 0 != pxPath );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_DIRMAKE, pxPath );
   ef_fs_st    * pxFS;
 
   /* Get logical drive */
@@ -88,9 +90,9 @@ ef_return_et eEF_dirmake (
     xSyncObject.pxFS = pxFS;
 
     /* If LFN BUFFER initialization failed */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     /* Else, if following file path failed */
     else if ( EF_RET_OK != eEFPrvPathFollow( pxPath, &xDir, &bFound ) )
@@ -166,6 +168,7 @@ ef_return_et eEF_dirmake (
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_DIRMAKE, eRetVal );
   return eRetVal;
 }
 
@@ -45,6 +45,7 @@
 #include "ef_prv_lfn.h"
 #include "ef_prv_unicode.h"
 #include "ef_prv_path_follow.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -64,6 +65,7 @@ ef_return_et eEF_diropen (
   EF_ASSERT_PUBLIC( 0 != pxPath );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_DIROPEN, pxDir );
   ef_fs_st    * pxFS;
   EF_LFN_BUFFER_DEFINE
 
@@ -83,9 +85,9 @@ ef_return_et eEF_diropen (
     pxDir->xObject.pxFS = pxFS;
 
     /* If LFN BUFFER initialization failed */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     /* Follow the pxPath to the directory */
     else if ( EF_RET_OK != eEFPrvPathFollow( pxPath, pxDir, &bFound ) )
@@ -134,8 +136,8 @@ ef_return_et eEF_diropen (
         }
         else if ( 0 != pxDir->xObject.u32ClstStart )
         {
-          (void) eEFPrvLockInc( pxDir, 0, &(pxDir->xObject.u32LockId) );  /* Lock the sub directory */
-          if ( 0 == pxDir->xObject.u32LockId )
+          /* Lock the sub directory */
+          if ( EF_RET_OK != eEFPrvLockInc( pxDir, 0, &(pxDir->xObject.u32LockId) ) )
           {
             eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_TOO_MANY_OPEN_FILES );
           }
@@ -162,6 +164,7 @@ ef_return_et eEF_diropen (
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_DIROPEN, eRetVal );
   return eRetVal;
 }
 
@@ -25,6 +25,7 @@
 #include "ef_prv_lock.h"
 #include "ef_prv_validate.h"
 #include "ef_prv_volume_nb.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -44,17 +45,20 @@ ef_return_et eEF_dirread (
   EF_ASSERT_PUBLIC( 0 != pxFileInfo );
 
   ef_return_et    eRetVal = EF_RET_INVALID_OBJECT;
+  EF_LATENCY_START( EF_LATENCY_DIRREAD, pxDir );
   ef_fs_st      * pxFS;
   EF_LFN_BUFFER_DEFINE
 
 
   /* Check validity of the directory object */
-  if ( EF_RET_OK != eEFPrvValidateObject( &pxDir->xObject, &pxFS ) )
+  if ( EF_RET_OK != eEFPrvValidateObjectShared( &pxDir->xObject, &pxFS ) )
   {
     eRetVal = EF_RET_INVALID_OBJECT;
   }
   else
   {
+    /* The directory sectors are read in the window shared with the other readers */
+    (void) eEFPrvFSWindowLock( pxFS );
     if ( 0 == pxFileInfo )
     {
       /* Rewind the directory object */
@@ -63,9 +67,9 @@ ef_return_et eEF_dirread (
     else
     {
       /* If LFN BUFFER initialization failed */
-      if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+      if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
       {
-        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+        eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
       }
       else
       {
@@ -77,7 +81,8 @@ ef_return_et eEF_dirread (
         }
         else if ( EF_BOOL_TRUE == bEmpty )
         {
-          /* Ignore end of directory */
+          /* Ignore end of directory, a null name reports it */
+          pxFileInfo->xName[ 0 ] = 0;
           eRetVal = EF_RET_OK;
         }
         /* A valid entry is found */
@@ -95,18 +100,18 @@ ef_return_et eEF_dirread (
           {
             eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
           }
-          eRetVal = eEFPrvDirectoryIndexNext( pxDir, EF_BOOL_FALSE, &bStretched, &bMoved );
-          if ( EF_RET_NO_FILE == eRetVal )
+          else
           {
-            /* Ignore end of directory now */
             eRetVal = EF_RET_OK;
           }
         }
       }
       EF_LFN_BUFFER_FREE();
     }
+    (void) eEFPrvFSWindowUnlock( pxFS );
   }
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_DIRREAD, eRetVal );
   return eRetVal;
 }
 
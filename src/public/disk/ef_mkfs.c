@@ -31,6 +31,7 @@
 /* Includes -------------------------------------------------------------------------------------------------------- */
 
 #include <ef_port_load_store.h>
+#include <ef_port_memory.h>
 #include <efat.h>
 #include <efat_level3.h>
 #include <ef_prv_def.h>
@@ -45,6 +46,7 @@
 #include "ef_prv_lock.h"
 #include "ef_prv_string.h"
 #include "ef_prv_volume.h"
+#include "ef_prv_volume_mount.h"
 #include "ef_prv_volume_nb.h"
 #include "ef_prv_gpt.h"
 #include "ef_prv_lfn.h"
@@ -58,6 +60,11 @@
 #define EF_CLUTER_NB_MAX_FAT16  ( 0xFFF5 )      /**< Max FAT16 clusters (differs from specs, but right for real DOS/Windows behavior) */
 #define EF_CLUTER_NB_MAX_FAT32  ( 0x0FFFFFF5 )  /**< Max FAT32 clusters (not specified, practical limit) */
 
+/* FAT sub-types handled by the format, independent of the FS types enabled for mounting */
+#define EF_MKFS_FAT12 ( 1 )   /**< Format as FAT12 */
+#define EF_MKFS_FAT16 ( 2 )   /**< Format as FAT16 */
+#define EF_MKFS_FAT32 ( 3 )   /**< Format as FAT32 */
+
 /* Local function macros ------------------------------------------------------------------------------------------- */
 /* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
 /* Local variables ------------------------------------------------------------------------------------------------- */
@@ -66,12 +73,7 @@
 /* Local functions ------------------------------------------------------------------------------------------------- */
 /* Public functions ------------------------------------------------------------------------------------------------ */
 
-/**
- *  This option switches f_mkfs() function. (0:Disable or 1:Enable)
- */
-#define EF_USE_MKFS ( 0 )
-
-#if ( 0 != EF_USE_MKFS )
+#if ( 0 != EF_CONF_MKFS )
 /*-----------------------------------------------------------------------*/
 /* Create an FAT volume                                            */
 /*-----------------------------------------------------------------------*/
@@ -111,20 +113,32 @@ ef_return_et eEF_mkfs (
   ef_lba_t xSector, lba[2];
   ef_u32_t sz_rsv, sz_fat, sz_dir, sz_au;  /* Size of reserved, fat, pu8Dir, data, cluster */
   ef_u32_t u8FatsNb, u32RootDirNb, i;          /* Index, Number of FATs and Number of root pu8Dir entries */
-  int vol;
-  ef_u08_t ds;
+  int8_t vol = -1;
+  ef_fs_st * pxFS = 0;
+  ef_return_et ds;
   ef_return_et fr;
 
 
   /* Check mounted drive and clear work area */
-  vol = eEFPrvVolumeNbPathRemove( &pxPath );          /* Get target logical drive */
-  if (vol < 0)
+  if (    ( EF_RET_OK != eEFPrvVolumeNbGet( &pxPath, &vol ) )  /* Get target logical drive */
+       || ( vol < 0 )
+       || ( EF_RET_OK != eEFPrvVolumeFSPtrGet( vol, &pxFS ) ) )
   {
     return EF_RET_INVALID_DRIVE;
   }
-  if (eFAT[vol]) eFAT[vol]->u8FsType = 0;  /* Clear the fs object if mounted */
-  u8PhyDrvNb = LD2PD(vol);      /* Physical drive */
-  ipart = LD2PT(vol);      /* Partition (0:create as new, 1..:get from partition table) */
+  if ( 0 != pxFS )
+  {
+    /* Format the partition the volume is mounted on, and clear the fs object */
+    u8PhyDrvNb = pxFS->u8PhysDrv;
+    ipart = pxFS->u8Partition;
+    pxFS->u8FsType = 0;
+  }
+  else
+  {
+    /* Not mounted: physical drive of the same number, create as new */
+    u8PhyDrvNb = (ef_u08_t) vol;
+    ipart = 0;
+  }
   if (!pxParameters)
   {
     pxParameters = &xParametersDefault;  /* Use default parameter if it is not given */
@@ -132,13 +146,13 @@ ef_return_et eEF_mkfs (
 
   /* Get physical drive status (sz_drv, sz_blk, ss) */
   ds =  eEFPrvDriveInitialize(u8PhyDrvNb);
-  if ( 0 != ( ds & EF_RET_DISK_NOINIT ) )
+  if ( EF_RET_DISK_PROTECT == ds )
   {
-    return EF_RET_NOT_READY;
+    return EF_RET_WRITE_PROTECTED;
   }
-  if ( 0 != ( ds & EF_RET_DISK_PROTECT ) )
+  if ( EF_RET_OK != ds )
   {
-    return EF_RET_WRITE_PROTECTED;
+    return EF_RET_NOT_READY;
   }
   sz_blk = pxParameters->u32DataAlign;
   if (sz_blk == 0 &&  eEFPrvDriveIOCtrl(u8PhyDrvNb, GET_BLOCK_SIZE, &sz_blk) != EF_RET_OK)
@@ -149,17 +163,17 @@ ef_return_et eEF_mkfs (
   {
     sz_blk = 1;
   }
-#if EF_CONF_SS_MAX != EF_CONF_SS_MIN
+#if ( 0 == EF_CONF_SECTOR_SIZE_FIXED )
   if ( eEFPrvDriveIOCtrl(u8PhyDrvNb, GET_SECTOR_SIZE, &ss) != EF_RET_OK)
   {
     return EF_RET_DISK_ERR;
   }
-  if (ss > EF_CONF_SS_MAX || ss < EF_CONF_SS_MIN || (ss & (ss - 1)))
+  if (ss > EF_CONF_SECTOR_SIZE || ss < 512 || (ss & (ss - 1)))
   {
     return EF_RET_DISK_ERR;
   }
 #else
-  ss = EF_CONF_SS_MAX;
+  ss = EF_CONF_SECTOR_SIZE;
 #endif
   /* Options for FAT sub-type and FAT parameters */
   fsopt       = pxParameters->u8Format & (FM_ANY | FM_SFD);
@@ -222,7 +236,7 @@ ef_return_et eEF_mkfs (
           LEAVE_MKFS(EF_RET_DISK_ERR);  /* Get PT sector */
         }
         /* MS basic data partition? */
-        if (!effMemCompare(buf + ofs + EF_GPT_PTE_OFFSET_TYPE_GUID, u8GUIDBasicDataPartition, 16) && ++i == ipart)
+        if (EF_RET_OK == eEFPortMemCompare(buf + ofs + EF_GPT_PTE_OFFSET_TYPE_GUID, u8GUIDBasicDataPartition, 16) && ++i == ipart)
         {
           b_vol = u64EFPortLoad(buf + ofs + EF_GPT_PTE_OFFSET_LBA_FIRST);
           sz_vol = u64EFPortLoad(buf + ofs + EF_GPT_PTE_OFFSET_LBA_LAST) - b_vol + 1;
@@ -294,19 +308,19 @@ ef_return_et eEF_mkfs (
       /* no-FAT? */
       if ( 0 == ( fsopt & FM_FAT ) )
       {
-        fsty = FS_FAT32; break;
+        fsty = EF_MKFS_FAT32; break;
       }
     }
     if (!(fsopt & FM_FAT))
       LEAVE_MKFS(EF_RET_INVALID_PARAMETER);  /* no-FAT? */
-    fsty = FS_FAT16;
+    fsty = EF_MKFS_FAT16;
   } while (0);
 
   {  /* Create an FAT/FAT32 volume */
     do {
       pau = sz_au;
       /* Pre-determine number of clusters and FAT sub-type */
-      if ( FS_FAT32 == fsty )
+      if ( EF_MKFS_FAT32 == fsty )
       {  /* FAT32 volume */
         if ( 0 == pau )
         {  /* AU auto-selection */
@@ -338,7 +352,7 @@ ef_return_et eEF_mkfs (
         }
         else
         {
-          fsty = FS_FAT12;
+          fsty = EF_MKFS_FAT12;
           n = (n_clst * 3 + 1) / 2 + 3;  /* FAT size [byte] */
         }
         sz_fat = (n + ss - 1) / ss;    /* FAT size [sector] */
@@ -350,7 +364,7 @@ ef_return_et eEF_mkfs (
 
       /* Align data area to erase block boundary (for flash memory media) */
       n = (ef_u32_t)(((b_data + sz_blk - 1) & ~(sz_blk - 1)) - b_data);  /* Sectors to next nearest from current data base */
-      if ( FS_FAT32 == fsty )
+      if ( EF_MKFS_FAT32 == fsty )
       {    /* FAT32: Move FAT */
         sz_rsv += n; b_fat += n;
       }
@@ -372,7 +386,7 @@ ef_return_et eEF_mkfs (
         LEAVE_MKFS(EF_RET_MKFS_ABORTED);  /* Too small volume? */
       }
       n_clst = ((ef_u32_t)sz_vol - sz_rsv - sz_fat * u8FatsNb - sz_dir) / pau;
-      if ( FS_FAT32 == fsty )
+      if ( EF_MKFS_FAT32 == fsty )
       {
         if ( n_clst <= EF_CLUTER_NB_MAX_FAT16 )
         {
@@ -384,7 +398,7 @@ ef_return_et eEF_mkfs (
           LEAVE_MKFS(EF_RET_MKFS_ABORTED);
         }
       }
-      if ( FS_FAT16 == fsty )
+      if ( EF_MKFS_FAT16 == fsty )
       {
         if ( n_clst > EF_CLUTER_NB_MAX_FAT16 )
         {  /* Too many clusters for FAT16 */
@@ -395,7 +409,7 @@ ef_return_et eEF_mkfs (
           }
           if ( 0 != ( fsopt & FM_FAT32 ) )
           {
-            fsty = FS_FAT32;
+            fsty = EF_MKFS_FAT32;
             continue;  /* Switch type to FAT32 and retry */
           }
           if (    ( 0 == sz_au )
@@ -415,7 +429,7 @@ ef_return_et eEF_mkfs (
           LEAVE_MKFS(EF_RET_MKFS_ABORTED);
         }
       }
-      if (    ( FS_FAT12 == fsty )
+      if (    ( EF_MKFS_FAT12 == fsty )
            && ( n_clst > EF_CLUTER_NB_MAX_FAT12 ) )
       {
         LEAVE_MKFS(EF_RET_MKFS_ABORTED);  /* Too many clusters for FAT12 */
@@ -433,13 +447,13 @@ ef_return_et eEF_mkfs (
        eEFPrvDriveIOCtrl( u8PhyDrvNb, CTRL_TRIM, lba );
     }
     /* Create FAT VBR */
-    mem_set( buf, 0, ss );
-    mem_cpy( buf + EF_BS_OFFSET_JMP_INST, "\xEB\xFE\x90" "MSDOS5.0", 11 );/* Boot jump code (x86), OEM name */
+    eEFPortMemZero( buf, ss );
+    eEFPortMemCopy( "\xEB\xFE\x90" "MSDOS5.0", buf + EF_BS_OFFSET_JMP_INST, 11 );/* Boot jump code (x86), OEM name */
     vEFPortStoreu16( buf + EF_BS_BPB_FAT_OFFSET_SECTOR_SIZE, ss );        /* Sector size [byte] */
     buf[EF_BS_BPB_FAT_OFFSET_CLUSTER_SIZE] = (ef_u08_t)pau;        /* Cluster size [sector] */
     vEFPortStoreu16( buf + EF_BS_BPB_FAT_OFFSET_SECTORS_RESERVED_NB, (ef_u16_t)sz_rsv );  /* Size of reserved area */
     buf[EF_BS_BPB_FAT_OFFSET_FATS_NB] = (ef_u08_t)u8FatsNb;          /* Number of FATs */
-    if ( FS_FAT32 == fsty )
+    if ( EF_MKFS_FAT32 == fsty )
     {
       vEFPortStoreu16( buf + EF_BS_BPB_FAT_OFFSET_ROOT_ENTRIES, (ef_u16_t) 0 );  /* Number of root directory entries */
     }
@@ -459,7 +473,7 @@ ef_return_et eEF_mkfs (
     vEFPortStoreu16( buf + EF_BS_BPB_FAT_OFFSET_TRACK_SIZE, 63 );             /* Number of sectors per track (for int13) */
     vEFPortStoreu16( buf + EF_BS_BPB_FAT_OFFSET_HEADS_NB, 255 );             /* Number of heads (for int13) */
     vEFPortStoreu32( buf + EF_BS_BPB_FAT_OFFSET_SECTORS_HIDDEN_NB, (ef_u32_t)b_vol );  /* Volume offset in the physical drive [sector] */
-    if ( FS_FAT32 == fsty )
+    if ( EF_MKFS_FAT32 == fsty )
     {
       vEFPortStoreu32( buf + EF_BS_EBPB_FAT32_OFFSET_VOLUME_ID, EF_FATTIME_GET( ) ); /* VSN */
       vEFPortStoreu32( buf + EF_BS_EBPB_FAT32_OFFSET_FAT_SIZE, sz_fat );       /* FAT size [sector] */
@@ -468,7 +482,7 @@ ef_return_et eEF_mkfs (
       vEFPortStoreu16( buf + EF_BS_EBPB_FAT32_OFFSET_BACKUPBOOT_SECTOR, 6 );        /* Offset of backup VBR (VBR + 6) */
       buf[EF_BS_EBPB_FAT32_OFFSET_DRIVE_NB] = 0x80;                    /* Drive number (for int13) */
       buf[EF_BS_EBPB_FAT32_OFFSET_SIGNATURE] = 0x29;                   /* Extended boot signature */
-      mem_cpy( buf + EF_BS_EBPB_FAT32_OFFSET_VOLUME_LABEL, "NO NAME    " "FAT32   ", 19 );  /* Volume pxLabel, FAT signature */
+      eEFPortMemCopy( "NO NAME    " "FAT32   ", buf + EF_BS_EBPB_FAT32_OFFSET_VOLUME_LABEL, 19 );  /* Volume pxLabel, FAT signature */
     }
     else
     {
@@ -476,7 +490,7 @@ ef_return_et eEF_mkfs (
       vEFPortStoreu16( buf + EF_BS_BPB_FAT_OFFSET_FAT16_SIZE, (ef_u16_t)sz_fat );  /* FAT size [sector] */
       buf[EF_BS_EBPB_FAT16_OFFSET_DRIVE_NB] = 0x80;            /* Drive number (for int13) */
       buf[EF_BS_EBPB_FAT16_OFFSET_SIGNATURE] = 0x29;            /* Extended boot signature */
-      mem_cpy( buf + EF_BS_EBPB_FAT16_OFFSET_VOLUME_LABEL, "NO NAME    " "FAT     ", 19 );  /* Volume pxLabel, FAT signature */
+      eEFPortMemCopy( "NO NAME    " "FAT     ", buf + EF_BS_EBPB_FAT16_OFFSET_VOLUME_LABEL, 19 );  /* Volume pxLabel, FAT signature */
     }
     vEFPortStoreu16( buf + EF_BS_OFFSET_SIGNATURE, 0xAA55 );          /* Signature (offset is fixed here regardless of sector size) */
     if ( EF_RET_OK !=  eEFPrvDriveWrite( u8PhyDrvNb, buf, b_vol, 1 ) )
@@ -485,10 +499,10 @@ ef_return_et eEF_mkfs (
     }
 
     /* Create FSINFO record if needed */
-    if ( FS_FAT32 == fsty )
+    if ( EF_MKFS_FAT32 == fsty )
     {
        eEFPrvDriveWrite( u8PhyDrvNb, buf, b_vol + 6, 1 );    /* Write backup VBR (VBR + 6) */
-      mem_set( buf, 0, ss );
+      eEFPortMemZero( buf, ss );
       vEFPortStoreu32( buf + EF_BS_FAT32_FSI_OFFSET_SIGNATURE_LEAD, 0x41615252 );
       vEFPortStoreu32( buf + EF_BS_FAT32_FSI_OFFSET_SIGNATURE_NEXT, 0x61417272 );
       vEFPortStoreu32( buf + EF_BS_FAT32_FSI_OFFSET_FREE_CLUSTERS, n_clst - 1 );  /* Number of free clusters */
@@ -499,11 +513,11 @@ ef_return_et eEF_mkfs (
     }
 
     /* Initialize FAT area */
-    mem_set( buf, 0, sz_buf * ss );
+    eEFPortMemZero( buf, sz_buf * ss );
     xSector = b_fat;    /* FAT start sector */
     for (i = 0; i < u8FatsNb; i++)      /* Initialize FATs each */
     {
-      if ( FS_FAT32 == fsty )
+      if ( EF_MKFS_FAT32 == fsty )
       {
         vEFPortStoreu32( buf + 0, 0xFFFFFFF8 );  /* FAT[0] */
         vEFPortStoreu32( buf + 4, 0xFFFFFFFF );  /* FAT[1] */
@@ -511,7 +525,7 @@ ef_return_et eEF_mkfs (
       }
       else
       {
-        vEFPortStoreu32( buf + 0, (fsty == FS_FAT12) ? 0xFFFFF8 : 0xFFFFFFF8 );  /* FAT[0] and FAT[1] */
+        vEFPortStoreu32( buf + 0, (fsty == EF_MKFS_FAT12) ? 0xFFFFF8 : 0xFFFFFFF8 );  /* FAT[0] and FAT[1] */
       }
       nsect = sz_fat;    /* Number of FAT sectors */
       do {  /* Fill FAT sectors */
@@ -527,13 +541,13 @@ ef_return_et eEF_mkfs (
         {
           LEAVE_MKFS( EF_RET_DISK_ERR );
         }
-        mem_set( buf, 0, ss );  /* Rest of FAT all are cleared */
+        eEFPortMemZero( buf, ss );  /* Rest of FAT all are cleared */
         xSector += n; nsect -= n;
       } while ( 0 != nsect );
     }
 
     /* Initialize root directory (fill with zero) */
-    if ( FS_FAT32 == fsty )
+    if ( EF_MKFS_FAT32 == fsty )
     {
       nsect = pau;  /* Number of root directory sectors */
     }
@@ -561,7 +575,7 @@ ef_return_et eEF_mkfs (
   /* A FAT volume has been created here */
 
   /* Determine system ID in the MBR partition table */
-  if ( FS_FAT32 == fsty )
+  if ( EF_MKFS_FAT32 == fsty )
   {
     sys = 0x0C;    /* FAT32X */
   }
@@ -573,7 +587,7 @@ ef_return_et eEF_mkfs (
     }
     else
     {
-      if ( FS_FAT16 == fsty )
+      if ( EF_MKFS_FAT16 == fsty )
       {
         sys = 0x04; /* FAT16 */
       }
@@ -625,7 +639,7 @@ ef_return_et eEF_mkfs (
   LEAVE_MKFS( EF_RET_OK );
 }
 
-#endif /* && EF_USE_MKFS */
+#endif /* ( 0 != EF_CONF_MKFS ) */
 
 /* ***************************************************************************************************************** */
 /* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,951 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_check.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Check and repair the consistency of a volume
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include <ef_prv_def.h>
+#include <ef_prv_fat.h>
+#include <ef_prv_volume_mount.h>
+#include "ef_prv_def.h"
+#include "ef_prv_directory.h"
+#include "ef_prv_fs_window.h"
+#include "ef_prv_lock.h"
+#include "ef_prv_latency.h"
+#include <ef_port_load_store.h>
+#include <ef_port_memory.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+
+#define EF_CHECK_BAD_FAT12  ( 0x00000FF7 )  /**< Bad cluster mark on FAT12 */
+#define EF_CHECK_BAD_FAT16  ( 0x0000FFF7 )  /**< Bad cluster mark on FAT16 */
+#define EF_CHECK_BAD_FAT32  ( 0x0FFFFFF7 )  /**< Bad cluster mark on FAT32 */
+#define EF_CHECK_END_OF_CHAIN  ( 0xFFFFFFFF )  /**< End of chain mark, truncated to the FAT entry width */
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+
+/**
+ *  Bit of a cluster in the bitmap of the slice
+ */
+#define EF_CHECK_BIT_MASK( pxCtx, u32Cluster ) \
+  ( (ef_u08_t) ( 1u << ( ( ( u32Cluster ) - ( pxCtx )->u32SliceFirst ) % 8 ) ) )
+
+/**
+ *  Byte of a cluster in the bitmap of the slice
+ */
+#define EF_CHECK_BIT_BYTE( pxCtx, u32Cluster ) \
+  ( ( pxCtx )->pu8Bitmap[ ( ( u32Cluster ) - ( pxCtx )->u32SliceFirst ) / 8 ] )
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+
+/**
+ *  Chain walk outcome
+ */
+typedef enum {
+  EF_CHECK_CHAIN_OK = 0,  /**< Chain ends with an end of chain mark */
+  EF_CHECK_CHAIN_BROKEN,  /**< Chain links to a free, bad or out of range cluster */
+  EF_CHECK_CHAIN_CROSSED  /**< Chain runs into a cluster already owned, or loops */
+} ef_check_chain_et;
+
+/**
+ *  Consistency check context
+ */
+typedef struct ef_check_context_struct {
+  ef_fs_st    * pxFS;           /**< Volume checked */
+  ef_check_st * pxReport;       /**< Report to fill */
+  ef_u08_t    * pu8Bitmap;      /**< One bit per cluster of the slice, set when owned */
+  ef_u32_t      u32SliceFirst;  /**< First cluster of the slice */
+  ef_u32_t      u32SliceNb;     /**< Number of clusters of the slice */
+  ef_u32_t      u32BadMark;     /**< Bad cluster mark of the FAT type */
+  ef_bool_t     bRepair;        /**< Repair what can be repaired */
+  ef_bool_t     bChainRepair;   /**< Repair chains and sizes, only when no chain is shared */
+  ef_bool_t     bFirstSlice;    /**< Object checks are only made on the first slice */
+} ef_check_context_st;
+
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Walk the chain of an object and mark its clusters of the slice as owned
+ *
+ *  @param  pxCtx           Pointer to the check context
+ *  @param  u32Cluster      First cluster of the chain
+ *  @param  pu32ClusterNb   Pointer to the number of valid clusters of the chain to update
+ *  @param  pu32ClusterLast Pointer to the last valid cluster of the chain to update, 0:none
+ *  @param  peChain         Pointer to the chain walk outcome to update
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvCheckChainWalk (
+  ef_check_context_st * pxCtx,
+  ef_u32_t              u32Cluster,
+  ef_u32_t            * pu32ClusterNb,
+  ef_u32_t            * pu32ClusterLast,
+  ef_check_chain_et   * peChain
+);
+
+/**
+ *  @brief  Check the chain and the size of the object of a directory entry
+ *
+ *  @param  pxCtx       Pointer to the check context
+ *  @param  pu8Entry    Pointer to a copy of the directory entry
+ *  @param  xSector     Sector holding the directory entry
+ *  @param  u32Offset   Offset of the directory entry in its sector
+ *  @param  pu32Cluster Pointer to the start cluster of a sub-directory to walk, 0:none
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvCheckObject (
+  ef_check_context_st * pxCtx,
+  const ef_u08_t      * pu8Entry,
+  ef_lba_t              xSector,
+  ef_u32_t              u32Offset,
+  ef_u32_t            * pu32Cluster
+);
+
+/**
+ *  @brief  Walk the directory tree and check every file and directory
+ *
+ *  @param  pxCtx Pointer to the check context
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvCheckTree (
+  ef_check_context_st * pxCtx
+);
+
+/**
+ *  @brief  Classify a FAT entry of the slice and free it if lost
+ *
+ *  @param  pxCtx       Pointer to the check context
+ *  @param  u32Cluster  Cluster number
+ *  @param  u32Value    Value of its FAT entry
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvCheckEntry (
+  ef_check_context_st * pxCtx,
+  ef_u32_t              u32Cluster,
+  ef_u32_t              u32Value
+);
+
+/**
+ *  @brief  Read the FAT entries of the slice, one sector at a time
+ *
+ *  @param  pxCtx Pointer to the check context
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvCheckFATScan (
+  ef_check_context_st * pxCtx
+);
+
+/**
+ *  @brief  Check the whole FAT, slice by slice, the tree being walked once per slice
+ *
+ *  @param  pxCtx           Pointer to the check context
+ *  @param  u32SliceMax     Number of clusters tracked by the bitmap at once
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvCheckVolume (
+  ef_check_context_st * pxCtx,
+  ef_u32_t              u32SliceMax
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFPrvCheckChainWalk (
+  ef_check_context_st * pxCtx,
+  ef_u32_t              u32Cluster,
+  ef_u32_t            * pu32ClusterNb,
+  ef_u32_t            * pu32ClusterLast,
+  ef_check_chain_et   * peChain
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCtx );
+  EF_ASSERT_PRIVATE( 0 != pu32ClusterNb );
+  EF_ASSERT_PRIVATE( 0 != pu32ClusterLast );
+  EF_ASSERT_PRIVATE( 0 != peChain );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_fs_st    * pxFS = pxCtx->pxFS;
+  ef_u32_t      u32ClusterNext;
+  ef_bool_t     bInSlice;
+
+  *pu32ClusterNb = 0;
+  *pu32ClusterLast = 0;
+  *peChain = EF_CHECK_CHAIN_OK;
+
+  /* Follow the chain up to its end */
+  while ( 0 != u32Cluster )
+  {
+    bInSlice = (    ( u32Cluster >= pxCtx->u32SliceFirst )
+                 && ( ( u32Cluster - pxCtx->u32SliceFirst ) < pxCtx->u32SliceNb ) ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+
+    /* If the cluster is free, reserved or out of the volume */
+    if ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
+    {
+      *peChain = EF_CHECK_CHAIN_BROKEN;
+      break;
+    }
+    /* Else, if the chain is longer than the volume, it loops */
+    else if ( *pu32ClusterNb >= ( pxFS->u32FatEntriesNb - 2 ) )
+    {
+      *peChain = EF_CHECK_CHAIN_CROSSED;
+      break;
+    }
+    /* Else, if the cluster is already owned */
+    else if (    ( EF_BOOL_FALSE != bInSlice )
+              && ( 0 != ( EF_CHECK_BIT_BYTE( pxCtx, u32Cluster ) & EF_CHECK_BIT_MASK( pxCtx, u32Cluster ) ) ) )
+    {
+      *peChain = EF_CHECK_CHAIN_CROSSED;
+      break;
+    }
+    /* Else, if getting the next cluster failed */
+    else if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterNext ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      break;
+    }
+    else
+    {
+      /* If the cluster is in the slice */
+      if ( EF_BOOL_FALSE != bInSlice )
+      {
+        /* Own it */
+        EF_CHECK_BIT_BYTE( pxCtx, u32Cluster ) |= EF_CHECK_BIT_MASK( pxCtx, u32Cluster );
+        pxCtx->pxReport->u32ClustersUsedNb++;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      ( *pu32ClusterNb )++;
+      *pu32ClusterLast = u32Cluster;
+
+      /* If the cluster links to a free cluster or is marked bad */
+      if (    ( 0 == u32ClusterNext )
+           || ( pxCtx->u32BadMark == u32ClusterNext ) )
+      {
+        *peChain = EF_CHECK_CHAIN_BROKEN;
+        break;
+      }
+      /* Else, if end of chain */
+      else if ( u32ClusterNext >= pxFS->u32FatEntriesNb )
+      {
+        break;
+      }
+      else
+      {
+        u32Cluster = u32ClusterNext;
+      }
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvCheckObject (
+  ef_check_context_st * pxCtx,
+  const ef_u08_t      * pu8Entry,
+  ef_lba_t              xSector,
+  ef_u32_t              u32Offset,
+  ef_u32_t            * pu32Cluster
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCtx );
+  EF_ASSERT_PRIVATE( 0 != pu8Entry );
+  EF_ASSERT_PRIVATE( 0 != pu32Cluster );
+
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_fs_st          * pxFS = pxCtx->pxFS;
+  ef_check_st       * pxReport = pxCtx->pxReport;
+  ef_u32_t            u32ClusterSize = (ef_u32_t) pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS );
+  ef_u32_t            u32Cluster = 0;
+  ef_u32_t            u32ClusterNb = 0;
+  ef_u32_t            u32ClusterLast = 0;
+  ef_u32_t            u32ClusterNeeded;
+  ef_u32_t            u32Size = u32EFPortLoad( pu8Entry + EF_DIR_FILE_SIZE );
+  ef_u32_t            u32SizeNew;
+  ef_u32_t            u32ClusterStartNew;
+  ef_check_chain_et   eChain = EF_CHECK_CHAIN_OK;
+  ef_bool_t           bDirectory;
+  ef_object_st        xObject;
+
+  xObject.pxFS = pxFS;
+  *pu32Cluster = 0;
+  bDirectory = ( 0 != ( EF_DIR_ATTRIB_BIT_DIRECTORY & pu8Entry[ EF_DIR_ATTRIBUTES ] ) ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+
+  /* If getting the start cluster failed */
+  if ( EF_RET_OK != eEFPrvDirectoryClusterGet( pxFS, pu8Entry, &u32Cluster ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if walking the chain failed */
+  else if ( EF_RET_OK != eEFPrvCheckChainWalk( pxCtx, u32Cluster, &u32ClusterNb, &u32ClusterLast, &eChain ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  else
+  {
+    u32SizeNew = u32Size;
+    u32ClusterStartNew = u32Cluster;
+
+    /* If the chain runs into another one, it is found in the slice holding the junction */
+    if ( EF_CHECK_CHAIN_CROSSED == eChain )
+    {
+      pxReport->u32CrossLinkedNb++;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* If the object itself was already checked on the first slice */
+    if ( EF_BOOL_FALSE == pxCtx->bFirstSlice )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    else
+    {
+      pxReport->u32ObjectsNb++;
+
+      /* If the chain is broken */
+      if ( EF_CHECK_CHAIN_BROKEN == eChain )
+      {
+        pxReport->u32BrokenNb++;
+        /* If a chain repair is allowed */
+        if ( EF_BOOL_FALSE != pxCtx->bChainRepair )
+        {
+          /* If no valid cluster, the object loses its chain */
+          if ( 0 == u32ClusterLast )
+          {
+            u32ClusterStartNew = 0;
+          }
+          /* Else, if terminating the chain at its last valid cluster failed */
+          else if ( EF_RET_OK != eEFPrvFATSet( pxFS, u32ClusterLast, EF_CHECK_END_OF_CHAIN ) )
+          {
+            eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+          pxReport->u32RepairedNb++;
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+
+      u32ClusterNeeded = ( u32Size / u32ClusterSize ) + ( ( 0 != ( u32Size % u32ClusterSize ) ) ? 1 : 0 );
+
+      /* If    something failed
+       *    OR a directory, which has no size
+       *    OR the chain runs into another one, its length is meaningless
+       *    OR the size matches the chain
+       */
+      if (    ( EF_RET_OK != eRetVal )
+           || ( EF_BOOL_FALSE != bDirectory )
+           || ( EF_CHECK_CHAIN_CROSSED == eChain )
+           || ( u32ClusterNeeded == u32ClusterNb ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      else
+      {
+        pxReport->u32SizeMismatchNb++;
+        /* If no chain repair is allowed */
+        if ( EF_BOOL_FALSE == pxCtx->bChainRepair )
+        {
+          EF_CODE_COVERAGE( );
+        }
+        /* Else, if the chain is too short, the size is fitted to it */
+        else if ( u32ClusterNeeded > u32ClusterNb )
+        {
+          u32SizeNew = u32ClusterNb * u32ClusterSize;
+          pxReport->u32RepairedNb++;
+        }
+        /* Else, if the file is empty, the whole chain is freed */
+        else if ( 0 == u32ClusterNeeded )
+        {
+          (void) eEFPrvFATChainRemove( &xObject, u32ClusterStartNew, 0 );
+          u32ClusterStartNew = 0;
+          pxReport->u32RepairedNb++;
+        }
+        /* Else, the chain is too long, the clusters past the size are freed */
+        else
+        {
+          ef_u32_t  u32ClusterCut = u32ClusterStartNew;
+          ef_u32_t  u32ClusterNext = 0;
+
+          for ( ef_u32_t u32Index = 1 ; u32Index < u32ClusterNeeded ; u32Index++ )
+          {
+            (void) eEFPrvFATGet( pxFS, u32ClusterCut, &u32ClusterCut );
+          }
+          /* If getting the first cluster to free failed */
+          if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32ClusterCut, &u32ClusterNext ) )
+          {
+            eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+          }
+          /* Else, if freeing the tail of the chain failed */
+          else if ( EF_RET_OK != eEFPrvFATChainRemove( &xObject, u32ClusterNext, u32ClusterCut ) )
+          {
+            eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+          }
+          else
+          {
+            pxReport->u32RepairedNb++;
+          }
+        }
+      }
+
+      /* If the chain was lost or a file of no cluster has a size */
+      if (    ( 0 == u32ClusterStartNew )
+           && ( EF_BOOL_FALSE == bDirectory ) )
+      {
+        u32SizeNew = 0;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+
+      /* If the directory entry is unchanged */
+      if (    ( EF_RET_OK != eRetVal )
+           || (    ( u32SizeNew == u32Size )
+                && ( u32ClusterStartNew == u32Cluster ) ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if loading the directory entry failed */
+      else if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, xSector ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        (void) eEFPrvDirectoryClusterSet( pxFS, pxFS->pu8Window + u32Offset, u32ClusterStartNew );
+        vEFPortStoreu32( pxFS->pu8Window + u32Offset + EF_DIR_FILE_SIZE, u32SizeNew );
+        pxFS->u8WinFlags = EF_FS_WIN_DIRTY;
+      }
+      u32Cluster = u32ClusterStartNew;
+    }
+
+    /* If a sub-directory with a sound chain, it is to be walked */
+    if (    ( EF_RET_OK == eRetVal )
+         && ( EF_BOOL_FALSE != bDirectory )
+         && ( EF_CHECK_CHAIN_CROSSED != eChain )
+         && ( 0 != u32ClusterNb ) )
+    {
+      *pu32Cluster = u32Cluster;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvCheckTree (
+  ef_check_context_st * pxCtx
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCtx );
+
+  ef_return_et      eRetVal = EF_RET_OK;
+  ef_fs_st        * pxFS = pxCtx->pxFS;
+  ef_directory_st   xDir;
+  ef_u32_t          u32DirClst[ EF_CONF_CHECK_DEPTH ];
+  ef_u32_t          u32DirOffset[ EF_CONF_CHECK_DEPTH ];
+  ef_u08_t          u8Sector[ EF_CONF_SECTOR_SIZE ];
+  ef_lba_t          xSectorCopy = 0;
+  ef_u32_t          u32Depth = 1;
+  ef_u32_t          u32Cluster;
+  ef_u32_t          u32ClusterNb;
+  ef_u32_t          u32ClusterLast;
+  ef_u32_t          u32Offset;
+  ef_check_chain_et eChain;
+  ef_bool_t         bPositioned = EF_BOOL_FALSE;
+  ef_bool_t         bStretched;
+  ef_bool_t         bMoved;
+
+  xDir.xObject.pxFS = pxFS;
+  u32DirClst[ 0 ] = 0;
+  u32DirOffset[ 0 ] = 0;
+
+  /* If the root directory is not a chain */
+  if ( 0 == ( EF_FS_FAT32 & pxFS->u8FsType ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if walking the root directory chain failed */
+  else if ( EF_RET_OK != eEFPrvCheckChainWalk( pxCtx, (ef_u32_t) pxFS->xDirBase, &u32ClusterNb, &u32ClusterLast, &eChain ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  /* Else, if the root directory chain is damaged, it is reported only */
+  else if ( EF_CHECK_CHAIN_CROSSED == eChain )
+  {
+    pxCtx->pxReport->u32CrossLinkedNb++;
+  }
+  else if (    ( EF_CHECK_CHAIN_BROKEN == eChain )
+            && ( EF_BOOL_FALSE != pxCtx->bFirstSlice ) )
+  {
+    pxCtx->pxReport->u32BrokenNb++;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  /* Visit every entry of the tree, depth first */
+  while (    ( EF_RET_OK == eRetVal )
+          && ( 0 != u32Depth ) )
+  {
+    ef_u32_t  u32Level = u32Depth - 1;
+
+    /* If the directory of this level is not positioned yet */
+    if (    ( EF_BOOL_FALSE == bPositioned )
+         && ( EF_RET_OK != ( xDir.xObject.u32ClstStart = u32DirClst[ u32Level ],
+                             eEFPrvDirectoryIndexSet( &xDir, u32DirOffset[ u32Level ] ) ) ) )
+    {
+      /* Its chain ends before the offset, leave it */
+      u32Depth--;
+    }
+    /* Else, if the directory table is over */
+    else if ( 0 == xDir.xSector )
+    {
+      u32Depth--;
+      bPositioned = EF_BOOL_FALSE;
+    }
+    /* Else, if the sector is not copied yet and loading it failed */
+    else if (    ( xSectorCopy != xDir.xSector )
+              && (    ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, xDir.xSector ) )
+                   || ( EF_RET_OK != eEFPortMemCopy( pxFS->pu8Window, u8Sector, EF_SECTOR_SIZE( pxFS ) ) ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    else
+    {
+      const ef_u08_t  * pu8Entry;
+
+      /* The sector copy survives the FAT reads of the chain walks */
+      xSectorCopy = xDir.xSector;
+      u32Offset = xDir.u32Offset % EF_SECTOR_SIZE( pxFS );
+      pu8Entry = u8Sector + u32Offset;
+      bPositioned = EF_BOOL_TRUE;
+
+      /* If end of the directory table */
+      if ( 0 == pu8Entry[ EF_DIR_NAME_START ] )
+      {
+        u32Depth--;
+        bPositioned = EF_BOOL_FALSE;
+      }
+      /* Else, if a deleted entry, a dot entry, an LFN entry or the volume label */
+      else if (    ( EF_DIR_DELETED_MASK == pu8Entry[ EF_DIR_NAME_START ] )
+                || ( '.' == pu8Entry[ EF_DIR_NAME_START ] )
+                || ( EF_DIR_ATTRIB_BITS_LFN == ( EF_DIR_ATTRIB_BITS_DEFINED & pu8Entry[ EF_DIR_ATTRIBUTES ] ) )
+                || ( 0 != ( EF_DIR_ATTRIB_BIT_VOLUME_ID & pu8Entry[ EF_DIR_ATTRIBUTES ] ) ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if checking the object failed */
+      else if ( EF_RET_OK != eEFPrvCheckObject( pxCtx, pu8Entry, xDir.xSector, u32Offset, &u32Cluster ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      /* Else, if not a sub-directory to walk */
+      else if ( 0 == u32Cluster )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if the tree is too deep */
+      else if ( EF_CONF_CHECK_DEPTH <= u32Depth )
+      {
+        /* Its clusters look lost, they must not be freed */
+        pxCtx->pxReport->bIncomplete = EF_BOOL_TRUE;
+      }
+      else
+      {
+        /* Come back to the next entry of this directory after the sub-directory */
+        u32DirOffset[ u32Level ] = xDir.u32Offset + EF_DIR_ENTRY_SIZE;
+        u32DirClst[ u32Depth ] = u32Cluster;
+        u32DirOffset[ u32Depth ] = 0;
+        u32Depth++;
+        bPositioned = EF_BOOL_FALSE;
+      }
+
+      /* If the directory is left or the walk failed */
+      if (    ( EF_RET_OK != eRetVal )
+           || ( EF_BOOL_FALSE == bPositioned ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if moving to the next entry failed */
+      else if ( EF_RET_OK != eEFPrvDirectoryIndexNext( &xDir, EF_BOOL_FALSE, &bStretched, &bMoved ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvCheckEntry (
+  ef_check_context_st * pxCtx,
+  ef_u32_t              u32Cluster,
+  ef_u32_t              u32Value
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCtx );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  /* If the cluster is free */
+  if ( 0 == u32Value )
+  {
+    pxCtx->pxReport->u32ClustersFreeNb++;
+  }
+  /* Else, if    the cluster is marked bad
+   *          OR it is owned by a file or a directory
+   */
+  else if (    ( pxCtx->u32BadMark == u32Value )
+            || ( 0 != ( EF_CHECK_BIT_BYTE( pxCtx, u32Cluster ) & EF_CHECK_BIT_MASK( pxCtx, u32Cluster ) ) ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    pxCtx->pxReport->u32LostNb++;
+    /* If    no repair is requested
+     *    OR part of the tree was not walked
+     */
+    if (    ( EF_BOOL_FALSE == pxCtx->bRepair )
+         || ( EF_BOOL_FALSE != pxCtx->pxReport->bIncomplete ) )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* Else, if freeing the lost cluster failed */
+    else if ( EF_RET_OK != eEFPrvFATSet( pxCtx->pxFS, u32Cluster, 0 ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    else
+    {
+      EF_STATS_ADD( pxCtx->pxFS, u32ClustersFreed, 1 );
+      pxCtx->pxReport->u32ClustersFreeNb++;
+      pxCtx->pxReport->u32RepairedNb++;
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvCheckFATScan (
+  ef_check_context_st * pxCtx
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCtx );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_fs_st    * pxFS = pxCtx->pxFS;
+  ef_u32_t      u32ClusterEnd = pxCtx->u32SliceFirst + pxCtx->u32SliceNb;
+  ef_u32_t      u32Cluster = pxCtx->u32SliceFirst;
+  ef_u32_t      u32Value;
+
+  /* If FAT12, entries straddle sectors: read them one by one */
+  if ( 0 != ( EF_FS_FAT12 & pxFS->u8FsType ) )
+  {
+    for ( ; u32Cluster < u32ClusterEnd ; u32Cluster++ )
+    {
+      /* If reading the entry or checking it failed */
+      if (    ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32Value ) )
+           || ( EF_RET_OK != eEFPrvCheckEntry( pxCtx, u32Cluster, u32Value ) ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+        break;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+  /* Else FAT16/32: decode all the entries of a sector once it is loaded */
+  else
+  {
+    ef_u32_t  u32EntrySize = ( 0 != ( EF_FS_FAT32 & pxFS->u8FsType ) ) ? 4 : 2;
+    ef_u32_t  u32EntriesPerSector = EF_SECTOR_SIZE( pxFS ) / u32EntrySize;
+
+    while (    ( EF_RET_OK == eRetVal )
+            && ( u32Cluster < u32ClusterEnd ) )
+    {
+      /* If loading the FAT sector failed */
+      if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, pxFS->xFatBase + ( u32Cluster / u32EntriesPerSector ) ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        do
+        {
+          ef_u08_t  * pu8Entry = pxFS->pu8Window + ( ( u32Cluster % u32EntriesPerSector ) * u32EntrySize );
+
+          u32Value = ( 4 == u32EntrySize ) ? ( 0x0FFFFFFF & u32EFPortLoad( pu8Entry ) ) : u16EFPortLoad( pu8Entry );
+          /* If checking the entry failed, freeing it stays in the same FAT sector */
+          if ( EF_RET_OK != eEFPrvCheckEntry( pxCtx, u32Cluster, u32Value ) )
+          {
+            eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+            break;
+          }
+          else
+          {
+            u32Cluster++;
+          }
+        } while (    ( u32Cluster < u32ClusterEnd )
+                  && ( 0 != ( u32Cluster % u32EntriesPerSector ) ) );
+      }
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvCheckVolume (
+  ef_check_context_st * pxCtx,
+  ef_u32_t              u32SliceMax
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxCtx );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_fs_st    * pxFS = pxCtx->pxFS;
+
+  for ( pxCtx->u32SliceFirst = 2 ; pxCtx->u32SliceFirst < pxFS->u32FatEntriesNb ; pxCtx->u32SliceFirst += pxCtx->u32SliceNb )
+  {
+    pxCtx->u32SliceNb = pxFS->u32FatEntriesNb - pxCtx->u32SliceFirst;
+    if ( pxCtx->u32SliceNb > u32SliceMax )
+    {
+      pxCtx->u32SliceNb = u32SliceMax;
+    }
+    pxCtx->bFirstSlice = ( 2 == pxCtx->u32SliceFirst ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+    pxCtx->pxReport->u32PassesNb++;
+
+    /* If    clearing the bitmap failed
+     *    OR walking the tree failed
+     *    OR reading the FAT slice failed
+     */
+    if (    ( EF_RET_OK != eEFPortMemZero( pxCtx->pu8Bitmap, ( pxCtx->u32SliceNb + 7 ) / 8 ) )
+         || ( EF_RET_OK != eEFPrvCheckTree( pxCtx ) )
+         || ( EF_RET_OK != eEFPrvCheckFATScan( pxCtx ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      break;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEF_check (
+  const TCHAR * pxPath,
+  ef_u08_t    * pu8Bitmap,
+  ef_u32_t      u32BitmapSize,
+  ef_bool_t     bRepair,
+  ef_check_st * pxReport
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxPath );
+  EF_ASSERT_PUBLIC( 0 != pu8Bitmap );
+  EF_ASSERT_PUBLIC( 0 != pxReport );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_CHECK, pxPath );
+  ef_fs_st    * pxFS;
+
+  (void) eEFPortMemZero( pxReport, sizeof( ef_check_st ) );
+
+  /* Get logical drive */
+  if ( EF_RET_OK != eEFPrvVolumeMountCheck( &pxPath, &pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  /* Else, if the bitmap cannot hold a single cluster */
+  else if ( 0 == u32BitmapSize )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_PARAMETER );
+  }
+  else
+  {
+    ef_check_context_st xCtx;
+    ef_u32_t            u32SliceMax;
+    ef_u32_t            u32PassesNb;
+
+    xCtx.pxFS = pxFS;
+    xCtx.pxReport = pxReport;
+    xCtx.pu8Bitmap = pu8Bitmap;
+    xCtx.bRepair = EF_BOOL_FALSE;
+    xCtx.bChainRepair = EF_BOOL_FALSE;
+    if ( 0 != ( EF_FS_FAT32 & pxFS->u8FsType ) )
+    {
+      xCtx.u32BadMark = EF_CHECK_BAD_FAT32;
+    }
+    else if ( 0 != ( EF_FS_FAT16 & pxFS->u8FsType ) )
+    {
+      xCtx.u32BadMark = EF_CHECK_BAD_FAT16;
+    }
+    else
+    {
+      xCtx.u32BadMark = EF_CHECK_BAD_FAT12;
+    }
+    /* Clusters tracked by the bitmap at once */
+    u32SliceMax = ( u32BitmapSize > ( pxFS->u32FatEntriesNb / 8 ) ) ? pxFS->u32FatEntriesNb : ( u32BitmapSize * 8 );
+
+    /* If checking the whole volume without repairing failed */
+    if ( EF_RET_OK != eEFPrvCheckVolume( &xCtx, u32SliceMax ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    /* Else, if no repair is requested */
+    else if ( EF_BOOL_FALSE == bRepair )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* Else, the repairs are made on a second check, once all the junctions of the volume are known:
+     * cutting or freeing a chain shared with another one would damage the other one as well
+     */
+    else
+    {
+      xCtx.bRepair = EF_BOOL_TRUE;
+      xCtx.bChainRepair = ( 0 == pxReport->u32CrossLinkedNb ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+      u32PassesNb = pxReport->u32PassesNb;
+      (void) eEFPortMemZero( pxReport, sizeof( ef_check_st ) );
+      /* If checking and repairing the volume failed */
+      if ( EF_RET_OK != eEFPrvCheckVolume( &xCtx, u32SliceMax ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      pxReport->u32PassesNb += u32PassesNb;
+    }
+
+    /* If the free cluster count of the volume is known and wrong */
+    if (    ( EF_RET_OK == eRetVal )
+         && ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) )
+         && ( pxFS->u32ClstFreeNb != pxReport->u32ClustersFreeNb ) )
+    {
+      pxReport->bFreeNbMismatch = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* If nothing to repair */
+    if (    ( EF_RET_OK != eRetVal )
+         || ( EF_BOOL_FALSE == bRepair ) )
+    {
+      EF_CODE_COVERAGE( );
+    }
+    else
+    {
+      /* If the free cluster count was wrong */
+      if ( EF_BOOL_FALSE != pxReport->bFreeNbMismatch )
+      {
+        pxReport->u32RepairedNb++;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* The counted value is the reference from now on */
+      pxFS->u32ClstFreeNb = pxReport->u32ClustersFreeNb;
+      pxFS->u8FsInfoFlags |= 1;
+      /* If writing the repairs back failed */
+      if ( EF_RET_OK != eEFPrvFSSync( pxFS ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+
+  (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_CHECK, eRetVal );
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -82,9 +82,9 @@ ef_return_et eEF_chmod (
     xDir.xObject.pxFS = pxFS;
 
     /* If LFN BUFFER initialization failed */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     /* Else, if following file path failed */
     else if ( EF_RET_OK != eEFPrvPathFollow( pxPath, &xDir, &bFound ) )
@@ -0,0 +1,821 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_defrag.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Relocate files and directories into contiguous runs
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include <ef_prv_def.h>
+#include <ef_prv_fat.h>
+#include <ef_prv_volume_mount.h>
+#include "ef_prv_def.h"
+#include "ef_prv_directory.h"
+#include "ef_prv_drive.h"
+#include "ef_prv_fs_window.h"
+#include "ef_prv_lock.h"
+#include "ef_prv_lfn.h"
+#include "ef_prv_path_follow.h"
+#include "ef_prv_latency.h"
+#include <ef_port_load_store.h>
+#include <ef_port_memory.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Count the clusters of a chain and tell if it is contiguous
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32Cluster    First cluster of the chain
+ *  @param  pu32ClusterNb Pointer to the number of clusters to update
+ *  @param  pbContiguous  Pointer to the contiguity flag to update
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_FAT_ERROR  Broken chain
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvDefragChainCount (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t  * pu32ClusterNb,
+  ef_bool_t * pbContiguous
+);
+
+/**
+ *  @brief  Copy the clusters of a chain to a contiguous run
+ *          For a directory, the dot entry of the copy is pointed to the run.
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32Cluster    First cluster of the chain to copy
+ *  @param  u32ClusterNew First cluster of the destination run
+ *  @param  bDirectory    EF_BOOL_TRUE if the chain holds a directory table
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_FAT_ERROR  Broken chain
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvDefragChainCopy (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNew,
+  ef_bool_t   bDirectory
+);
+
+/**
+ *  @brief  Point the dot dot entry of every sub-directory of a relocated directory to its new run
+ *
+ *  @param  pxFS          Pointer to the Filesystem object
+ *  @param  u32ClusterNew First cluster of the relocated directory
+ *  @param  u32ClusterNb  Number of clusters of the relocated directory
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK       Success
+ *  @retval EF_RET_DISK_ERR A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT   Assertion failed
+ */
+static ef_return_et eEFPrvDefragDotDotUpdate (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32ClusterNew,
+  ef_u32_t    u32ClusterNb
+);
+
+/**
+ *  @brief  Relocate the object of a directory entry into one contiguous run
+ *
+ *  @param  pxFS                Pointer to the Filesystem object
+ *  @param  pxDir               Pointer to the directory object pointing the entry
+ *  @param  pu32Cluster         Pointer to the start cluster of the object to update (new one if relocated)
+ *  @param  pu32ClusterMovedNb  Pointer to the number of relocated clusters to update
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success, or nothing to do
+ *  @retval EF_RET_LOCKED     The object is open
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_FAT_ERROR  Broken chain
+ *  @retval EF_RET_INT_ERR    Internal error
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvDefragObject (
+  ef_fs_st        * pxFS,
+  ef_directory_st * pxDir,
+  ef_u32_t        * pu32Cluster,
+  ef_u32_t        * pu32ClusterMovedNb
+);
+
+/**
+ *  @brief  Check that a directory saved in the defragmentation state is still a directory
+ *          Its dot entry must point to its own start cluster.
+ *
+ *  @param  pxFS        Pointer to the Filesystem object
+ *  @param  u32Cluster  Start cluster of the directory, 0:root
+ *
+ *  @return Operation result
+ *  @retval EF_RET_OK         Success
+ *  @retval EF_RET_FAT_ERROR  The cluster does not hold that directory anymore
+ *  @retval EF_RET_DISK_ERR   A hard error occurred in the low level disk I/O layer
+ *  @retval EF_RET_ASSERT     Assertion failed
+ */
+static ef_return_et eEFPrvDefragDirectoryCheck (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFPrvDefragChainCount (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t  * pu32ClusterNb,
+  ef_bool_t * pbContiguous
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pu32ClusterNb );
+  EF_ASSERT_PRIVATE( 0 != pbContiguous );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32ClusterNext;
+
+  *pu32ClusterNb = 0;
+  *pbContiguous = EF_BOOL_TRUE;
+
+  /* Follow the chain up to its end */
+  while ( u32Cluster < pxFS->u32FatEntriesNb )
+  {
+    ( *pu32ClusterNb )++;
+    /* If getting the next cluster failed */
+    if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterNext ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+      break;
+    }
+    /* Else, if the chain is broken or loops */
+    else if (    ( 2 > u32ClusterNext )
+              || ( *pu32ClusterNb >= pxFS->u32FatEntriesNb ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+      break;
+    }
+    /* Else, if the next cluster is not the following one */
+    else if (    ( u32ClusterNext < pxFS->u32FatEntriesNb )
+              && ( ( u32Cluster + 1 ) != u32ClusterNext ) )
+    {
+      *pbContiguous = EF_BOOL_FALSE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    u32Cluster = u32ClusterNext;
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvDefragChainCopy (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster,
+  ef_u32_t    u32ClusterNew,
+  ef_bool_t   bDirectory
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u08_t      u8Buffer[ EF_CONF_SECTOR_SIZE ] __attribute__ ((aligned (32)));
+  ef_lba_t      xSector;
+  ef_lba_t      xSectorNew;
+
+  /* If writing back the FS window failed, the drive must hold what is copied */
+  if ( EF_RET_OK != eEFPrvFSWindowStore( pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  else
+  {
+    /* Copy the chain cluster by cluster */
+    for ( ef_u32_t u32Index = 0 ; u32Cluster < pxFS->u32FatEntriesNb ; u32Index++ )
+    {
+      /* If getting the base sectors of the clusters failed */
+      if (    ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, u32Cluster, &xSector ) )
+           || ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, u32ClusterNew + u32Index, &xSectorNew ) ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+        break;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      for ( ef_u32_t u32Sector = 0 ; u32Sector < pxFS->u8ClstSize ; u32Sector++ )
+      {
+        /* If reading the sector failed */
+        if ( EF_RET_OK != eEFPrvDriveRead( pxFS->u8PhysDrv, u8Buffer, xSector + u32Sector, 1 ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+          break;
+        }
+        /* Else, if the dot entry of a directory copy cannot be pointed to the copy */
+        else if (    ( EF_BOOL_FALSE != bDirectory )
+                  && ( 0 == u32Index )
+                  && ( 0 == u32Sector )
+                  && ( EF_RET_OK != eEFPrvDirectoryClusterSet( pxFS, u8Buffer, u32ClusterNew ) ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+          break;
+        }
+        /* Else, if writing the sector failed */
+        else if ( EF_RET_OK != eEFPrvDriveWrite( pxFS->u8PhysDrv, u8Buffer, xSectorNew + u32Sector, 1 ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+          break;
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+      /* If something failed */
+      if ( EF_RET_OK != eRetVal )
+      {
+        break;
+      }
+      /* Else, if getting the next cluster failed */
+      else if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32Cluster ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+        break;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvDefragDotDotUpdate (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32ClusterNew,
+  ef_u32_t    u32ClusterNb
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_lba_t      xSector;
+  ef_lba_t      xSectorChild;
+  ef_u32_t      u32ClusterChild;
+  ef_bool_t     bEnd = EF_BOOL_FALSE;
+
+  /* The relocated directory is contiguous, its table is walked sector by sector */
+  (void) eEFPrvFATClusterToSector( pxFS, u32ClusterNew, &xSector );
+
+  for ( ef_u32_t u32Sector = 0 ; u32Sector < ( u32ClusterNb * pxFS->u8ClstSize ) ; u32Sector++ )
+  {
+    for ( ef_u32_t u32Offset = 0 ; u32Offset < EF_SECTOR_SIZE( pxFS ) ; u32Offset += EF_DIR_ENTRY_SIZE )
+    {
+      ef_u08_t  * pu8Dir;
+
+      /* If loading the directory sector failed */
+      if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, xSector + u32Sector ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+        break;
+      }
+      else
+      {
+        pu8Dir = pxFS->pu8Window + u32Offset;
+      }
+
+      /* If end of the directory table */
+      if ( 0 == pu8Dir[ EF_DIR_NAME_START ] )
+      {
+        bEnd = EF_BOOL_TRUE;
+        break;
+      }
+      /* Else, if a deleted entry, a dot entry or not a sub-directory */
+      else if (    ( EF_DIR_DELETED_MASK == pu8Dir[ EF_DIR_NAME_START ] )
+                || ( '.' == pu8Dir[ EF_DIR_NAME_START ] )
+                || ( EF_DIR_ATTRIB_BITS_LFN == ( EF_DIR_ATTRIB_BITS_DEFINED & pu8Dir[ EF_DIR_ATTRIBUTES ] ) )
+                || ( 0 == ( EF_DIR_ATTRIB_BIT_DIRECTORY & pu8Dir[ EF_DIR_ATTRIBUTES ] ) ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if getting the sub-directory start cluster failed */
+      else if ( EF_RET_OK != eEFPrvDirectoryClusterGet( pxFS, pu8Dir, &u32ClusterChild ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        break;
+      }
+      /* Else, if the sub-directory has no table */
+      else if ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, u32ClusterChild, &xSectorChild ) )
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* Else, if loading its first sector failed */
+      else if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, xSectorChild ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+        break;
+      }
+      /* Else, if the second entry is its dot dot entry */
+      else if (    ( '.' == pxFS->pu8Window[ EF_DIR_ENTRY_SIZE + 0 ] )
+                && ( '.' == pxFS->pu8Window[ EF_DIR_ENTRY_SIZE + 1 ] ) )
+      {
+        /* Point it to the new run */
+        (void) eEFPrvDirectoryClusterSet( pxFS, pxFS->pu8Window + EF_DIR_ENTRY_SIZE, u32ClusterNew );
+        pxFS->u8WinFlags = EF_FS_WIN_DIRTY;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    /* If something failed or the table is over */
+    if (    ( EF_RET_OK != eRetVal )
+         || ( EF_BOOL_FALSE != bEnd ) )
+    {
+      break;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvDefragObject (
+  ef_fs_st        * pxFS,
+  ef_directory_st * pxDir,
+  ef_u32_t        * pu32Cluster,
+  ef_u32_t        * pu32ClusterMovedNb
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+  EF_ASSERT_PRIVATE( 0 != pxDir );
+  EF_ASSERT_PRIVATE( 0 != pu32Cluster );
+  EF_ASSERT_PRIVATE( 0 != pu32ClusterMovedNb );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32Cluster = 0;
+  ef_u32_t      u32ClusterNew = 0;
+  ef_u32_t      u32ClusterNb = 0;
+  ef_bool_t     bContiguous = EF_BOOL_TRUE;
+  ef_bool_t     bDirectory = EF_BOOL_FALSE;
+
+  *pu32ClusterMovedNb = 0;
+
+  /* If loading the directory entry failed */
+  if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, pxDir->xSector ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  /* Else, if getting the start cluster of the object failed */
+  else if ( EF_RET_OK != eEFPrvDirectoryClusterGet( pxFS, pxDir->pu8Dir, &u32Cluster ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+  }
+  /* Else, if the object has no cluster */
+  else if ( 0 == u32Cluster )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if the object is open */
+  else if ( EF_RET_OK != eEFPrvLockCheck( pxDir, 2 ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_LOCKED );
+  }
+  /* Else, if counting the clusters of the chain failed */
+  else if ( EF_RET_OK != eEFPrvDefragChainCount( pxFS, u32Cluster, &u32ClusterNb, &bContiguous ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+  }
+  /* Else, if the chain is already contiguous */
+  else if ( EF_BOOL_FALSE != bContiguous )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if taking a contiguous free run failed */
+  else if ( EF_RET_OK != ( eRetVal = eEFPrvFATChainRunAppend( &pxDir->xObject,
+                                                              0,
+                                                              u32ClusterNb,
+                                                              EF_BOOL_TRUE,
+                                                              &u32ClusterNew ) ) )
+  {
+    /* If there is no free run large enough */
+    if ( EF_RET_FAT_FULL == eRetVal )
+    {
+      /* Leave the object as it is */
+      eRetVal = EF_RET_OK;
+    }
+    else
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+    }
+  }
+  else
+  {
+    bDirectory = ( 0 != ( EF_DIR_ATTRIB_BIT_DIRECTORY & pxDir->xObject.u8Attrib ) ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+
+    /* STEP 1: THE NEW RUN IS ONLY REFERENCED BY ITSELF, A POWER LOSS LEAVES LOST CLUSTERS */
+    /* If copying the data to the new run failed */
+    if ( EF_RET_OK != eEFPrvDefragChainCopy( pxFS, u32Cluster, u32ClusterNew, bDirectory ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    /* Else, if the sub-directories of a directory cannot follow it */
+    else if (    ( EF_BOOL_FALSE != bDirectory )
+              && ( EF_RET_OK != eEFPrvDefragDotDotUpdate( pxFS, u32ClusterNew, u32ClusterNb ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    /* Else, if flushing the new chain and its data failed */
+    else if ( EF_RET_OK != eEFPrvFSSync( pxFS ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    /* STEP 2: THE DIRECTORY ENTRY SWITCHES TO THE NEW RUN, THE OLD CHAIN BECOMES LOST CLUSTERS */
+    /* Else, if reloading the directory entry failed */
+    else if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, pxDir->xSector ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+    }
+    /* Else, if pointing the entry to the new run failed */
+    else if ( EF_RET_OK != eEFPrvDirectoryClusterSet( pxFS, pxDir->pu8Dir, u32ClusterNew ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+    }
+    else
+    {
+      pxFS->u8WinFlags = EF_FS_WIN_DIRTY;
+      /* If committing the directory entry failed */
+      if ( EF_RET_OK != eEFPrvFSSync( pxFS ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      /* STEP 3: THE OLD CHAIN IS FREED */
+      /* Else, if freeing the old chain failed */
+      else if (    ( EF_RET_OK != eEFPrvFATChainRemove( &pxDir->xObject, u32Cluster, 0 ) )
+                || ( EF_RET_OK != eEFPrvFSSync( pxFS ) ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      /* The object lives in the new run from now on */
+      if (    ( 0 != EF_CONF_RELATIVE_PATH )
+           && ( u32Cluster == pxFS->u32DirClstCurrent ) )
+      {
+        pxFS->u32DirClstCurrent = u32ClusterNew;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      u32Cluster = u32ClusterNew;
+      *pu32ClusterMovedNb = u32ClusterNb;
+      u32ClusterNew = 0;
+    }
+
+    /* If the new run was not committed */
+    if ( 0 != u32ClusterNew )
+    {
+      /* Give it back */
+      (void) eEFPrvFATChainRemove( &pxDir->xObject, u32ClusterNew, 0 );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  *pu32Cluster = u32Cluster;
+
+  return eRetVal;
+}
+
+static ef_return_et eEFPrvDefragDirectoryCheck (
+  ef_fs_st  * pxFS,
+  ef_u32_t    u32Cluster
+)
+{
+  EF_ASSERT_PRIVATE( 0 != pxFS );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_lba_t      xSector;
+  ef_u32_t      u32ClusterDot;
+
+  /* If the root directory */
+  if ( 0 == u32Cluster )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if the cluster is out of the volume */
+  else if ( EF_RET_OK != eEFPrvFATClusterToSector( pxFS, u32Cluster, &xSector ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+  }
+  /* Else, if loading its first sector failed */
+  else if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, xSector ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  /* Else, if the first entry is not a dot entry pointing to the directory */
+  else if (    ( '.' != pxFS->pu8Window[ EF_DIR_NAME_START ] )
+            || ( ' ' != pxFS->pu8Window[ EF_DIR_NAME_START + 1 ] )
+            || ( EF_RET_OK != eEFPrvDirectoryClusterGet( pxFS, pxFS->pu8Window, &u32ClusterDot ) )
+            || ( u32ClusterDot != u32Cluster ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_FAT_ERROR );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEF_defrag_file (
+  const TCHAR * pxPath
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxPath );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_DEFRAG_FILE, pxPath );
+  ef_fs_st    * pxFS;
+
+  /* Get logical drive */
+  if ( EF_RET_OK != eEFPrvVolumeMountCheck( &pxPath, &pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  else
+  {
+    ef_directory_st xDir;
+    ef_bool_t       bFound = EF_BOOL_FALSE;
+    ef_u32_t        u32Cluster;
+    ef_u32_t        u32ClusterMovedNb;
+
+    EF_LFN_BUFFER_DEFINE
+
+    xDir.xObject.pxFS = pxFS;
+
+    /* If LFN BUFFER initialisation failed */
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+    }
+    /* Else, if following file path failed */
+    else if ( EF_RET_OK != eEFPrvPathFollow( pxPath, &xDir, &bFound ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_NAME );
+    }
+    /* Else, if the object was not found */
+    else if ( EF_BOOL_TRUE != bFound )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_NO_FILE );
+    }
+    /* Else, if it is a dot entry or the origin directory */
+    else if ( 0 != ( (EF_NS_DOT | EF_NS_NONAME) & xDir.u8Name[ EF_NSFLAG ] ) )
+    {
+      /* The root directory cannot be relocated */
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_NAME );
+    }
+    /* Else, if relocating the object failed */
+    else if ( EF_RET_OK != ( eRetVal = eEFPrvDefragObject( pxFS, &xDir, &u32Cluster, &u32ClusterMovedNb ) ) )
+    {
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    EF_LFN_BUFFER_FREE( );
+  }
+
+  (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_DEFRAG_FILE, eRetVal );
+  return eRetVal;
+}
+
+ef_return_et eEF_defrag_volume (
+  const TCHAR   * pxPath,
+  ef_defrag_st  * pxState,
+  ef_u32_t        u32StepBudget,
+  ef_bool_t     * pbDone
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxPath );
+  EF_ASSERT_PUBLIC( 0 != pxState );
+  EF_ASSERT_PUBLIC( 0 != pbDone );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_DEFRAG_VOL, pxPath );
+  ef_fs_st    * pxFS;
+
+  *pbDone = EF_BOOL_FALSE;
+
+  /* Get logical drive */
+  if ( EF_RET_OK != eEFPrvVolumeMountCheck( &pxPath, &pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
+  else
+  {
+    ef_directory_st xDir;
+    ef_bool_t       bPositioned = EF_BOOL_FALSE;
+    ef_bool_t       bStretched;
+    ef_bool_t       bMoved;
+    ef_u32_t        u32Cluster;
+    ef_u32_t        u32ClusterMovedNb;
+    ef_u08_t        u8Attrib;
+
+    /* If a new pass starts or the volume was mounted again meanwhile */
+    if (    ( 0 == pxState->u8Depth )
+         || ( pxState->u16MountId != pxFS->u16MountId ) )
+    {
+      /* Start from the root directory */
+      (void) eEFPortMemZero( pxState, sizeof( ef_defrag_st ) );
+      pxState->u16MountId = pxFS->u16MountId;
+      pxState->u8Depth = 1;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    xDir.xObject.pxFS = pxFS;
+
+    /* Visit entries until the budget is spent or the tree is over */
+    while (    ( 0 != u32StepBudget )
+            && ( 0 != pxState->u8Depth ) )
+    {
+      ef_u08_t  u8Level = pxState->u8Depth - 1;
+
+      u32StepBudget--;
+
+      /* If     The directory of this level is not positioned yet
+       *    AND (    It is not the directory it was when saved
+       *          OR It shrank below the saved offset )
+       */
+      if (    ( EF_BOOL_FALSE == bPositioned )
+           && (    ( EF_RET_OK != eEFPrvDefragDirectoryCheck( pxFS, pxState->u32DirClst[ u8Level ] ) )
+                || ( EF_RET_OK != ( xDir.xObject.u32ClstStart = pxState->u32DirClst[ u8Level ],
+                                    eEFPrvDirectoryIndexSet( &xDir, pxState->u32DirOffset[ u8Level ] ) ) ) ) )
+      {
+        /* Leave this directory */
+        pxState->u8Depth--;
+      }
+      /* Else, if the directory table is over */
+      else if ( 0 == xDir.xSector )
+      {
+        pxState->u8Depth--;
+        bPositioned = EF_BOOL_FALSE;
+      }
+      /* Else, if loading the entry failed */
+      else if ( EF_RET_OK != eEFPrvFSWindowLoad( pxFS, xDir.xSector ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+        break;
+      }
+      /* Else, if end of the directory table */
+      else if ( 0 == xDir.pu8Dir[ EF_DIR_NAME_START ] )
+      {
+        pxState->u8Depth--;
+        bPositioned = EF_BOOL_FALSE;
+      }
+      else
+      {
+        bPositioned = EF_BOOL_TRUE;
+        u8Attrib = xDir.pu8Dir[ EF_DIR_ATTRIBUTES ] & EF_DIR_ATTRIB_BITS_DEFINED;
+        xDir.xObject.u8Attrib = u8Attrib;
+
+        /* If a deleted entry, a dot entry, an LFN entry or the volume label */
+        if (    ( EF_DIR_DELETED_MASK == xDir.pu8Dir[ EF_DIR_NAME_START ] )
+             || ( '.' == xDir.pu8Dir[ EF_DIR_NAME_START ] )
+             || ( EF_DIR_ATTRIB_BITS_LFN == u8Attrib )
+             || ( 0 != ( EF_DIR_ATTRIB_BIT_VOLUME_ID & u8Attrib ) ) )
+        {
+          EF_CODE_COVERAGE( );
+        }
+        /* Else, if relocating the object failed, open objects are skipped */
+        else if (    ( EF_RET_OK != ( eRetVal = eEFPrvDefragObject( pxFS, &xDir, &u32Cluster, &u32ClusterMovedNb ) ) )
+                  && ( EF_RET_LOCKED != eRetVal ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+          break;
+        }
+        else
+        {
+          eRetVal = EF_RET_OK;
+          /* If the object was relocated */
+          if ( 0 != u32ClusterMovedNb )
+          {
+            pxState->u32ObjectsMoved++;
+            pxState->u32ClustersMoved += u32ClusterMovedNb;
+            /* Each relocated cluster is a step */
+            u32StepBudget -= ( u32ClusterMovedNb < u32StepBudget ) ? u32ClusterMovedNb : u32StepBudget;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+          /* If a sub-directory to walk */
+          if (    ( 0 != ( EF_DIR_ATTRIB_BIT_DIRECTORY & u8Attrib ) )
+               && ( 0 != u32Cluster )
+               && ( EF_CONF_DEFRAG_DEPTH > pxState->u8Depth ) )
+          {
+            /* Come back to the next entry of this directory after it */
+            pxState->u32DirOffset[ u8Level ] = xDir.u32Offset + EF_DIR_ENTRY_SIZE;
+            pxState->u32DirClst[ pxState->u8Depth ] = u32Cluster;
+            pxState->u32DirOffset[ pxState->u8Depth ] = 0;
+            pxState->u8Depth++;
+            bPositioned = EF_BOOL_FALSE;
+          }
+          else
+          {
+            EF_CODE_COVERAGE( );
+          }
+        }
+
+        /* If still in this directory */
+        if ( EF_BOOL_FALSE == bPositioned )
+        {
+          EF_CODE_COVERAGE( );
+        }
+        /* Else, if moving to the next entry failed */
+        else if ( EF_RET_OK != eEFPrvDirectoryIndexNext( &xDir, EF_BOOL_FALSE, &bStretched, &bMoved ) )
+        {
+          eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+          break;
+        }
+        else
+        {
+          pxState->u32DirOffset[ u8Level ] = xDir.u32Offset;
+        }
+      }
+    }
+
+    /* If the pass is complete */
+    if (    ( EF_RET_OK == eRetVal )
+         && ( 0 == pxState->u8Depth ) )
+    {
+      *pbDone = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_DEFRAG_VOL, eRetVal );
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
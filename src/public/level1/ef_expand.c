@@ -46,6 +46,7 @@
 #include "ef_prv_unicode.h"
 #include "ef_prv_validate.h"
 #include "ef_port_diskio.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -65,118 +66,135 @@ ef_return_et eEF_expand (
   EF_ASSERT_PUBLIC( 0 != pxFile );
 
   ef_return_et  eRetVal;
+  EF_LATENCY_START( EF_LATENCY_EXPAND, pxFile );
   ef_fs_st    * pxFS;
   ef_u32_t      n;
   ef_u32_t      clst;
   ef_u32_t      stcl;
   ef_u32_t      scl;
+#if ( 0 == EF_CONF_FREE_INDEX )
   ef_u32_t      ncl;
+#endif
   ef_u32_t      tcl;
   ef_u32_t      lclst;
 
-
-  eRetVal = eEFPrvValidateObject( &pxFile->xObject, &pxFS );    /* Check validity of the file object */
-  if (( EF_RET_OK != eRetVal ) || (eRetVal = (ef_return_et)pxFile->u8ErrorCode) != EF_RET_OK)
+  /* If    the file object is invalid
+   *    OR the file is aborted
+   */
+  if (    ( EF_RET_OK != ( eRetVal = eEFPrvValidateObject( &pxFile->xObject, &pxFS ) ) )
+       || ( EF_RET_OK != ( eRetVal = (ef_return_et) pxFile->u8ErrorCode ) ) )
   {
-    (void) eEFPrvFSUnlock( pxFS, eRetVal );
-    return eRetVal;
+    EF_CODE_COVERAGE( );
   }
-  if (    ( 0 == fsz )
-       || ( 0 != pxFile->u32Size )
-       || ( 0 == ( pxFile->u8StatusFlags & EF_FILE_OPEN_WRITE ) ) )
+  /* Else, if    no size
+   *          OR the file is not empty
+   *          OR the file is not opened for writing
+   *          OR the size is over the file size limit
+   */
+  else if (    ( 0 == fsz )
+            || ( 0 != pxFile->u32Size )
+            || ( 0 == ( pxFile->u8StatusFlags & EF_FILE_OPEN_WRITE ) )
+            || ( EF_FILE_SIZE_MAX < fsz ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );
-    (void) eEFPrvFSUnlock( pxFS, eRetVal );
-    return eRetVal;
   }
-  if ( EF_FILE_SIZE_MAX < fsz )
-  {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );  /* Check if in size limit */
-    (void) eEFPrvFSUnlock( pxFS, eRetVal );
-    return eRetVal;
-   }
-  n = (ef_u32_t)pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS );  /* Cluster size */
-  tcl = (ef_u32_t)(fsz / n) + ((fsz & (n - 1)) ? 1 : 0);  /* Number of clusters needed */
-  stcl = pxFS->u32ClstLast; lclst = 0;
-  if ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, stcl ) )
+  else
   {
-    stcl = 2;
-  }
-
-  scl   = stcl;
-  clst  = stcl;
-  ncl = 0;
-  for ( ; ; )
-  {  /* Find a contiguous cluster block */
-    eRetVal = eEFPrvFATGet( pxFS, clst, &n );
-    if ( ++clst >= pxFS->u32FatEntriesNb )
+    n = (ef_u32_t)pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS );  /* Cluster size */
+    tcl = (ef_u32_t)(fsz / n) + ((fsz & (n - 1)) ? 1 : 0);  /* Number of clusters needed */
+    stcl = pxFS->u32ClstLast; lclst = 0;
+    if ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, stcl ) )
     {
-      clst = 2;
+      stcl = 2;
     }
-    if ( EF_RET_OK != eRetVal )
+
+#if ( 0 != EF_CONF_FREE_INDEX )
+    /* Best fit from the free extent index */
+    eRetVal = eEFPrvFATIndexFind( pxFS, tcl, &scl );
+    if ( EF_RET_DENIED == eRetVal )
     {
-      break;
+      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );
     }
-    /* If it is a free cluster? */
-    if ( 0 == n )
-    {
-      /* If a contiguous cluster block is found */
-      if ( ++ncl == tcl )
+#else
+    scl   = stcl;
+    clst  = stcl;
+    ncl = 0;
+    for ( ; ; )
+    {  /* Find a contiguous cluster block */
+      eRetVal = eEFPrvFATGet( pxFS, clst, &n );
+      if ( ++clst >= pxFS->u32FatEntriesNb )
+      {
+        clst = 2;
+      }
+      if ( EF_RET_OK != eRetVal )
       {
         break;
       }
-    }
-    else
-    {
-      /* Not a free cluster */
-      scl = clst;
-      ncl = 0;
-    }
-    if ( clst == stcl )
-    {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );
-      break;
-    }  /* No contiguous cluster? */
-  }
-  if ( EF_RET_OK == eRetVal )  /* A contiguous free area is found */
-  {
-    if ( 0 != opt )    /* Allocate it now */
-    {
-      for ( clst = scl, n = tcl; n; clst++, n-- )  /* Create a cluster chain on the FAT */
+      /* If it is a free cluster? */
+      if ( 0 == n )
       {
-        eRetVal = eEFPrvFATSet( pxFS, clst, (n == 1) ? 0xFFFFFFFF : clst + 1);
-        if ( EF_RET_OK != eRetVal )
+        /* If a contiguous cluster block is found */
+        if ( ++ncl == tcl )
         {
           break;
         }
-        lclst = clst;
       }
+      else
+      {
+        /* Not a free cluster */
+        scl = clst;
+        ncl = 0;
+      }
+      if ( clst == stcl )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );
+        break;
+      }  /* No contiguous cluster? */
     }
-    else
+#endif
+    if ( EF_RET_OK == eRetVal )  /* A contiguous free area is found */
     {
-      /* Set it as suggested point for next allocation */
-      lclst = scl - 1;
+      if ( 0 != opt )    /* Allocate it now */
+      {
+        for ( clst = scl, n = tcl; n; clst++, n-- )  /* Create a cluster chain on the FAT */
+        {
+          eRetVal = eEFPrvFATSet( pxFS, clst, (n == 1) ? 0xFFFFFFFF : clst + 1);
+          if ( EF_RET_OK != eRetVal )
+          {
+            break;
+          }
+          lclst = clst;
+        }
+      }
+      else
+      {
+        /* Set it as suggested point for next allocation */
+        lclst = scl - 1;
+      }
     }
-  }
 
-  if ( EF_RET_OK == eRetVal )
-  {
-    pxFS->u32ClstLast = lclst;    /* Set suggested start cluster to start next */
-    /* Is it allocated now? */
-    if ( 0 != opt )
+    if ( EF_RET_OK == eRetVal )
     {
-      pxFile->xObject.u32ClstStart = scl;    /* Update object allocation information */
-      pxFile->u32Size = fsz;
-      pxFile->u8StatusFlags |= EF_FILE_MODIFIED;
-      if ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) ) /* Update FSINFO */
+      pxFS->u32ClstLast = lclst;    /* Set suggested start cluster to start next */
+      /* Is it allocated now? */
+      if ( 0 != opt )
       {
-        pxFS->u32ClstFreeNb -= tcl;
-        pxFS->u8FsInfoFlags |= 1;
+        pxFile->xObject.u32ClstStart = scl;    /* Update object allocation information */
+        pxFile->u32ClstRunNb = tcl;            /* The whole chain is contiguous */
+        pxFile->u32Size = fsz;
+        pxFile->u8StatusFlags |= EF_FILE_MODIFIED;
+        EF_STATS_ADD( pxFS, u32ClustersAllocated, tcl );
+        if ( pxFS->u32ClstFreeNb <= ( pxFS->u32FatEntriesNb - 2 ) ) /* Update FSINFO */
+        {
+          pxFS->u32ClstFreeNb -= tcl;
+          pxFS->u8FsInfoFlags |= 1;
+        }
       }
     }
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_EXPAND, eRetVal );
   return eRetVal;
 }
 
@@ -0,0 +1,175 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_fextents.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Get the physical layout of a file
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include <ef_prv_def.h>
+#include <ef_prv_fat.h>
+#include "ef_prv_def.h"
+#include "ef_prv_file.h"
+#include "ef_prv_lock.h"
+#include "ef_prv_validate.h"
+#include "ef_prv_latency.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEF_fextents (
+  EF_FILE       * pxFile,
+  ef_extent_st  * pxExtents,
+  ef_u32_t        u32ExtentsMax,
+  ef_u32_t      * pu32ExtentsNb
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxFile );
+  EF_ASSERT_PUBLIC( ( 0 != pxExtents ) || ( 0 == u32ExtentsMax ) );
+  EF_ASSERT_PUBLIC( 0 != pu32ExtentsNb );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FEXTENTS, pxFile );
+  ef_fs_st    * pxFS;
+
+  *pu32ExtentsNb = 0;
+
+  /* If File object is not valid */
+  if ( EF_RET_OK != eEFPrvValidateObject( &pxFile->xObject, &pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_OBJECT );
+  }
+  /* Else, if the file is aborted */
+  else if ( EF_RET_OK != (ef_return_et) pxFile->u8ErrorCode )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( (ef_return_et) pxFile->u8ErrorCode );
+  }
+  /* Else, if allocating the delayed data failed */
+  else if ( EF_RET_OK != eEFPrvFileDelayedFlush( pxFile, pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+  }
+  else
+  {
+    ef_u32_t  u32Cluster = pxFile->xObject.u32ClstStart;
+    ef_u32_t  u32ClusterRun = pxFile->xObject.u32ClstStart;
+    ef_u32_t  u32ClusterRunNb = 0;
+    ef_u32_t  u32ClusterNext;
+    ef_u32_t  u32ClusterNb = 0;
+
+    /* If the file starts with a known run (eEF_expand(), contiguous check on opening, previous walk) */
+    if (    ( 0 != u32Cluster )
+         && ( 1 < pxFile->u32ClstRunNb ) )
+    {
+      /* Its clusters are not looked up in the FAT, the walk resumes from the last one */
+      u32ClusterRunNb = pxFile->u32ClstRunNb - 1;
+      u32ClusterNb = u32ClusterRunNb;
+      u32Cluster += u32ClusterRunNb;
+      *pu32ExtentsNb = 1;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* Follow the chain, consecutive entries sharing the FAT sector already loaded */
+    while ( 0 != u32Cluster )
+    {
+      /* If the chain is broken or loops */
+      if (    ( EF_RET_OK != eEFPrvFATClusterNbCheck( pxFS->u32FatEntriesNb, u32Cluster ) )
+           || ( u32ClusterNb++ >= ( pxFS->u32FatEntriesNb - 2 ) ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        break;
+      }
+      /* Else, if getting the next cluster failed */
+      else if ( EF_RET_OK != eEFPrvFATGet( pxFS, u32Cluster, &u32ClusterNext ) )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DISK_ERR );
+        break;
+      }
+      /* Else, if the cluster extends the current run */
+      else if (    ( 0 != u32ClusterRunNb )
+                && ( ( u32ClusterRun + u32ClusterRunNb ) == u32Cluster ) )
+      {
+        u32ClusterRunNb++;
+      }
+      else
+      {
+        /* Start a new run */
+        u32ClusterRun = u32Cluster;
+        u32ClusterRunNb = 1;
+        ( *pu32ExtentsNb )++;
+      }
+      /* Remember the first run so offsets inside it are mapped without the FAT */
+      (void) eEFPrvFileRunGrow( pxFile, u32ClusterNb - 1, u32Cluster );
+
+      /* If the run is to be returned */
+      if ( *pu32ExtentsNb <= u32ExtentsMax )
+      {
+        ef_extent_st  * pxExtent = &pxExtents[ *pu32ExtentsNb - 1 ];
+
+        (void) eEFPrvFATClusterToSector( pxFS, u32ClusterRun, &pxExtent->xSector );
+        pxExtent->u32SectorNb = u32ClusterRunNb * pxFS->u8ClstSize;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+
+      /* If end of chain */
+      if ( u32ClusterNext >= pxFS->u32FatEntriesNb )
+      {
+        break;
+      }
+      /* Else, if the chain links to a free cluster */
+      else if ( 2 > u32ClusterNext )
+      {
+        eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INT_ERR );
+        break;
+      }
+      else
+      {
+        u32Cluster = u32ClusterNext;
+      }
+    }
+  }
+
+  (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_FEXTENTS, eRetVal );
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
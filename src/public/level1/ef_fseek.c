@@ -48,6 +48,7 @@
 #include "ef_prv_validate.h"
 #include "ef_prv_volume_nb.h"
 #include "ef_prv_volume.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -66,6 +67,7 @@ ef_return_et eEF_fseek (
   EF_ASSERT_PUBLIC( 0 != pxFile );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_FSEEK, pxFile );
   ef_fs_st    * pxFS;
 
   /* If File object is not valid */
@@ -73,6 +75,11 @@ ef_return_et eEF_fseek (
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
   }
+  /* Else, if allocating and writing the delayed data failed */
+  else if ( EF_RET_OK != eEFPrvFileDelayedFlush( pxFile, pxFS ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+  }
   /* Else, if file offset is  0 */
   else
   {
@@ -108,10 +115,24 @@ ef_return_et eEF_fseek (
       /* Cluster size in bytes */
       ef_u32_t u32ClusterByteSize = (ef_u32_t) pxFS->u8ClstSize * EF_SECTOR_SIZE(pxFS);
 
-      /* If     Files offset is not null
-       *    AND Seeked offset stays in the same cluster as we are
+      /* Cluster of the chain where the seeked offset is */
+      ef_u32_t  u32ClusterIndex = ( u32Offset - 1 ) / u32ClusterByteSize;
+      /* The cluster is in the contiguous run of the file */
+      ef_bool_t bFound = EF_BOOL_FALSE;
+
+      /* If the seeked cluster is in the contiguous run */
+      if (    ( EF_RET_OK == eEFPrvFileRunClusterGet( pxFile, u32ClusterIndex, &u32ClusterNb, &bFound ) )
+           && ( EF_BOOL_FALSE != bFound ) )
+      { /* SEEKING INSIDE THE CONTIGUOUS RUN BEGIN */
+        /* Jump to the cluster without following the FAT */
+        pxFile->u32FileOffset = u32ClusterIndex * u32ClusterByteSize;
+        u32Offset -= pxFile->u32FileOffset;
+        pxFile->u32Clst = u32ClusterNb;
+      } /* SEEKING INSIDE THE CONTIGUOUS RUN END */
+      /* Else, if     Files offset is not null
+       *          AND Seeked offset stays in the same cluster as we are
        */
-      if (    ( 0 != u32FileOffset )
+      else if (    ( 0 != u32FileOffset )
            && ( ( ( u32Offset - 1 ) / u32ClusterByteSize ) >= ( ( u32FileOffset - 1 ) / u32ClusterByteSize) ) )
       { /* SEEKING TO SAME OR NEXT CLUSTER BEGIN */
         /* start from the current cluster */
@@ -132,13 +153,14 @@ ef_return_et eEF_fseek (
         else if ( EF_RET_OK != eEFPrvFATChainCreate(&pxFile->xObject, &u32ClusterNb) )
         {
           eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
-          (void) eEFPrvFSUnlock(pxFS, eRetVal);
-          return eRetVal;
         }
         else
         {
           pxFile->xObject.u32ClstStart = u32ClusterNb;
           pxFile->u32Clst = u32ClusterNb;
+          /* A new chain starts a new run */
+          pxFile->u32ClstRunNb = 0;
+          (void) eEFPrvFileRunGrow( pxFile, 0, u32ClusterNb );
         }
       } /* SEEKING TO PREVIOUS CLUSTER END */
 
@@ -187,6 +209,8 @@ ef_return_et eEF_fseek (
             EF_CODE_COVERAGE( );
           }
           pxFile->u32Clst = u32ClusterNb;
+          /* Extend the contiguous run if the chain still follows it */
+          (void) eEFPrvFileRunGrow( pxFile, pxFile->u32FileOffset / u32ClusterByteSize, u32ClusterNb );
         } /* Cluster following loop End */
 
         if ( EF_RET_OK == eRetVal )
@@ -257,6 +281,7 @@ ef_return_et eEF_fseek (
   }
 
   eRetVal = eEFPrvFSUnlock(pxFS, eRetVal);
+  EF_LATENCY_END( EF_LATENCY_FSEEK, eRetVal );
   return eRetVal;
 }
 /* ***************************************************************************************************************** */
@@ -49,6 +49,7 @@
 #include "ef_prv_validate.h"
 #include "ef_prv_volume_nb.h"
 #include "ef_prv_volume.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -68,6 +69,7 @@ ef_return_et eEF_getfree (
   EF_ASSERT_PUBLIC( 0 != pu32ClusterNb );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_GETFREE, pxPath );
   ef_fs_st    * pxFS;
 
   /* Get logical drive, Return ptr to the pxFS object */
@@ -154,6 +156,7 @@ ef_return_et eEF_getfree (
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_GETFREE, eRetVal );
   return eRetVal;
 }
 
@@ -52,6 +52,7 @@
 #include "ef_prv_validate.h"
 #include "ef_prv_volume_nb.h"
 #include "ef_prv_volume.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -71,6 +72,7 @@ ef_return_et eEF_rename (
   EF_ASSERT_PUBLIC( 0 != pxPath_new );
 
   ef_return_et      eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_RENAME, pxPath_old );
   ef_directory_st   xDirOld;
   ef_directory_st   xDirNew;
   ef_fs_st        * pxFS;
@@ -97,9 +99,9 @@ ef_return_et eEF_rename (
     xDirOld.xObject.pxFS = pxFS;
 
     /* If LFN BUFFER initialization failed */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     /* Else, if following file path failed */
     else if ( EF_RET_OK != eEFPrvPathFollow( pxPath_old, &xDirOld, &bFound ) )
@@ -157,7 +159,9 @@ ef_return_et eEF_rename (
         }
       }
       /* It is a valid pxPath and no name collision */
-      if ( EF_RET_NO_FILE == eRetVal )
+      if (    ( EF_RET_NO_FILE == eRetVal )
+           || (    ( EF_RET_OK == eRetVal )
+                && ( EF_BOOL_FALSE == bFound ) ) )
       {
         /* Register the new entry */
         eRetVal = eEFPrvDirRegister( &xDirNew );
@@ -230,6 +234,7 @@ ef_return_et eEF_rename (
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_RENAME, eRetVal );
   return eRetVal;
 }
 
@@ -41,6 +41,7 @@
 #include "ef_prv_lock.h"
 #include "ef_prv_validate.h"
 #include "ef_prv_path_follow.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -60,10 +61,11 @@ ef_return_et eEF_stat (
   EF_ASSERT_PUBLIC( 0 != pxFileInfo );
 
   ef_return_et  eRetVal = EF_RET_OK;
+  EF_LATENCY_START( EF_LATENCY_STAT, pxPath );
   ef_fs_st    * pxFS;
 
 
-  if ( EF_RET_OK != eEFPrvVolumeMountCheck( &pxPath, &pxFS ) )
+  if ( EF_RET_OK != eEFPrvVolumeMountCheckShared( &pxPath, &pxFS ) )
   {
     eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
   }
@@ -76,10 +78,12 @@ ef_return_et eEF_stat (
 
     xDir.xObject.pxFS = pxFS;
 
+    /* The directory sectors are looked up in the window shared with the other readers */
+    (void) eEFPrvFSWindowLock( pxFS );
     /* If LFN BUFFER initialization failed */
-    if ( EF_RET_OK != EF_LFN_BUFFER_SET( pxFS ) )
+    if ( EF_RET_OK != ( eRetVal = EF_LFN_BUFFER_SET( pxFS ) ) )
     {
-      eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_ERROR );
+      eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
     }
     /* Else, if following file path failed */
     else if ( EF_RET_OK != eEFPrvPathFollow( pxPath, &xDir, &bFound ) )
@@ -106,9 +110,11 @@ ef_return_et eEF_stat (
       EF_CODE_COVERAGE( );
     }
     EF_LFN_BUFFER_FREE();
+    (void) eEFPrvFSWindowUnlock( pxFS );
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_STAT, eRetVal );
   return eRetVal;
 }
 
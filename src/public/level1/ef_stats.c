@@ -0,0 +1,109 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_stats.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Volume I/O and Cache Statistics
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include <ef_port_memory.h>
+#include "ef_prv_def.h"
+#include "ef_prv_drive.h"
+#include "ef_prv_lock.h"
+#include "ef_prv_volume_mount.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+/* Get the I/O and Cache Statistics of a Volume */
+ef_return_et eEF_stats_get (
+  const TCHAR * pxPath,
+  ef_stats_st * pxStats
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxPath );
+  EF_ASSERT_PUBLIC( 0 != pxStats );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_fs_st    * pxFS;
+
+  /* Get logical drive, Return ptr to the pxFS object */
+  if ( EF_RET_OK != ( eRetVal = eEFPrvVolumeMountCheck( &pxPath, &pxFS ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+  }
+  else
+  {
+#if ( 0 != EF_CONF_STATS )
+    *pxStats = pxFS->xStats;
+#else
+    (void) eEFPortMemZero( pxStats, sizeof( ef_stats_st ) );
+#endif
+    /* The drive counters are held by the drive layer */
+    eRetVal = eEFPrvDriveStatsGet( pxFS->u8PhysDrv, pxStats );
+    (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  }
+
+  return eRetVal;
+}
+
+/* Reset the I/O and Cache Statistics of a Volume */
+ef_return_et eEF_stats_reset (
+  const TCHAR * pxPath
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxPath );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_fs_st    * pxFS;
+
+  /* Get logical drive, Return ptr to the pxFS object */
+  if ( EF_RET_OK != ( eRetVal = eEFPrvVolumeMountCheck( &pxPath, &pxFS ) ) )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( eRetVal );
+  }
+  else
+  {
+#if ( 0 != EF_CONF_STATS )
+    (void) eEFPortMemZero( &pxFS->xStats, sizeof( ef_stats_st ) );
+#endif
+    eRetVal = eEFPrvDriveStatsReset( pxFS->u8PhysDrv );
+    (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  }
+
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -33,8 +33,10 @@
 #include <efat.h>
 #include <ef_prv_fat.h>
 #include "ef_prv_def.h"
+#include "ef_prv_file.h"
 #include "ef_prv_lock.h"
 #include "ef_prv_validate.h"
+#include "ef_prv_latency.h"
 
 /* Local constant macros ------------------------------------------------------------------------------------------- */
 /* Local function macros ------------------------------------------------------------------------------------------- */
@@ -52,40 +54,57 @@ ef_return_et eEF_truncate (
   EF_ASSERT_PUBLIC( 0 != pxFile );
 
   ef_return_et  eRetVal;
+  EF_LATENCY_START( EF_LATENCY_TRUNCATE, pxFile );
   ef_fs_st    * pxFS;
   ef_u32_t     ncl;
 
-
-  /* Check validity of the file object */
-  eRetVal = eEFPrvValidateObject( &pxFile->xObject, &pxFS );
-  if ( EF_RET_OK != eRetVal )
+  /* If the file object is invalid */
+  if ( EF_RET_OK != ( eRetVal = eEFPrvValidateObject( &pxFile->xObject, &pxFS ) ) )
   {
-    (void) eEFPrvFSUnlock( pxFS, eRetVal );
-    return eRetVal;
+    EF_CODE_COVERAGE( );
   }
-  eRetVal = (ef_return_et) pxFile->u8ErrorCode;
-  if ( EF_RET_OK != eRetVal )
+  /* Else, if the file is aborted */
+  else if ( EF_RET_OK != ( eRetVal = (ef_return_et) pxFile->u8ErrorCode ) )
   {
-    (void) eEFPrvFSUnlock( pxFS, eRetVal );
-    return eRetVal;
+    EF_CODE_COVERAGE( );
   }
-  if ( 0 == ( pxFile->u8StatusFlags & EF_FILE_OPEN_WRITE ) )
+  /* Else, if the file is not opened for writing */
+  else if ( 0 == ( pxFile->u8StatusFlags & EF_FILE_OPEN_WRITE ) )
   {
-    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );  /* Check access u8Mode */
-    (void) eEFPrvFSUnlock( pxFS, eRetVal );
-    return eRetVal;
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_DENIED );
   }
-
-  if ( pxFile->u32FileOffset < pxFile->u32Size )
-  {  /* Process when u32FileOffset is not on the eof */
+  /* Else, if allocating and writing the delayed data before cutting the chain failed */
+  else if ( EF_RET_OK != ( eRetVal = eEFPrvFileDelayedFlush( pxFile, pxFS ) ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  /* Else, if the read/write pointer is at the end of the file, nothing to cut */
+  else if ( pxFile->u32FileOffset >= pxFile->u32Size )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
     if ( 0 == pxFile->u32FileOffset )
     {  /* When set file size to zero, remove entire cluster chain */
       eRetVal = eEFPrvFATChainRemove( &pxFile->xObject, pxFile->xObject.u32ClstStart, 0 );
       pxFile->xObject.u32ClstStart = 0;
+      pxFile->u32ClstRunNb = 0;
     }
     else
     {
-      eRetVal = EF_RET_OK;
+      ef_u32_t  u32ClusterByteSize = (ef_u32_t) pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS );
+      /* Clusters kept in the chain */
+      ef_u32_t  u32ClusterKeptNb = ( ( pxFile->u32FileOffset - 1 ) / u32ClusterByteSize ) + 1;
+      /* If the contiguous run goes beyond the new end of the chain */
+      if ( pxFile->u32ClstRunNb > u32ClusterKeptNb )
+      {
+        pxFile->u32ClstRunNb = u32ClusterKeptNb;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
       /* When truncate a part of the file, remove remaining clusters */
       eRetVal = eEFPrvFATGet( pxFS, pxFile->u32Clst, &ncl );
       if (    ( EF_RET_OK == eRetVal )
@@ -100,12 +119,11 @@ ef_return_et eEF_truncate (
     if ( EF_RET_OK != eRetVal )
     {
       pxFile->u8ErrorCode = (ef_u08_t)(eRetVal);
-      (void) eEFPrvFSUnlock( pxFS, eRetVal );
-      return eRetVal;
     }
   }
 
   (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  EF_LATENCY_END( EF_LATENCY_TRUNCATE, eRetVal );
   return eRetVal;
 }
 
@@ -0,0 +1,97 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_latency.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Latency Histograms of the Public Functions
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include "ef_prv_def.h"
+#include "ef_prv_latency.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+/* Get the Latency Histogram of a Public Function */
+ef_return_et eEF_latency_get (
+  ef_latency_op_et  eOperation,
+  ef_latency_st   * pxLatency
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxLatency );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( EF_LATENCY_OP_NB <= eOperation )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_INVALID_PARAMETER );
+  }
+  else
+  {
+    eRetVal = eEFPrvLatencyGet( eOperation, pxLatency );
+  }
+
+  return eRetVal;
+}
+
+/* Reset the Latency Histograms of all the Public Functions */
+ef_return_et eEF_latency_reset (
+  void
+)
+{
+  return eEFPrvLatencyReset( );
+}
+
+/* Set the Slow Operation Callback */
+ef_return_et eEF_latency_callback_set (
+  xLatencyCallback  * pxCallback,
+  ef_u32_t            u32ThresholdTicks
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( 0 == EF_CONF_LATENCY )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_NOT_ENABLED );
+  }
+  else
+  {
+    eRetVal = eEFPrvLatencyCallbackSet( pxCallback, u32ThresholdTicks );
+  }
+
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
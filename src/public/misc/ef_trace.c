@@ -0,0 +1,94 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_trace.c
+ *  @ingroup  group_eFAT_Public
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Drive Command Trace
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+
+#include <efat.h>
+#include "ef_prv_def.h"
+#include "ef_prv_drive.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+/* Start or Stop the Drive Command Trace */
+ef_return_et eEF_trace_enable (
+  ef_bool_t bEnable
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( 0 == EF_CONF_TRACE )
+  {
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_NOT_ENABLED );
+  }
+  else
+  {
+    eRetVal = eEFPrvDriveTraceEnable( bEnable );
+  }
+
+  return eRetVal;
+}
+
+/* Read the Oldest Records of the Drive Command Trace */
+ef_return_et eEF_trace_read (
+  ef_trace_record_st  * pxRecords,
+  ef_u32_t              u32RecordsMax,
+  ef_u32_t            * pu32RecordsNb,
+  ef_u32_t            * pu32LostNb
+)
+{
+  EF_ASSERT_PUBLIC( 0 != pxRecords );
+  EF_ASSERT_PUBLIC( 0 != pu32RecordsNb );
+  EF_ASSERT_PUBLIC( 0 != pu32LostNb );
+
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( 0 == EF_CONF_TRACE )
+  {
+    *pu32RecordsNb  = 0;
+    *pu32LostNb     = 0;
+    eRetVal = EF_RETURN_CODE_HANDLER( EF_RET_NOT_ENABLED );
+  }
+  else
+  {
+    eRetVal = eEFPrvDriveTraceRead( pxRecords, u32RecordsMax, pu32RecordsNb, pu32LostNb );
+  }
+
+  return eRetVal;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,860 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_bench.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host benchmarks common helpers: backends, drive command counters, timer and PRNG
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <efat.h>
+#include <efat_level3.h>
+#include <ef_port_diskio.h>
+#include <ef_prv_def.h>
+#include <ef_prv_fat.h>
+#include <ef_prv_lock.h>
+#include <ef_prv_volume_mount.h>
+
+#include "ef_bench.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Minimum number of clusters of a FAT32 volume, with margin for the FAT and the partition
+ */
+#define EF_BENCH_FAT32_CLUSTERS_MIN   ( 68000UL )
+
+/**
+ *  Default path of the disk image file
+ */
+#define EF_BENCH_IMAGE_PATH           "efat_bench.img"
+
+/**
+ *  Stripe of the striped backend: 64 KiB
+ */
+#define EF_BENCH_STRIPE_SIZE          ( 65536 / EF_CONF_SECTOR_SIZE )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/**
+ *  Backend the counting drive forwards to
+ */
+static ef_drive_functions_st  * pxBenchBackend = 0;
+
+/**
+ *  Commands received by the counting drive
+ */
+static ef_bench_counters_st     xBenchCounters;
+
+/**
+ *  The counting drive is registered as physical drive 0
+ */
+static ef_bool_t                bBenchRegistered = EF_BOOL_FALSE;
+
+/**
+ *  State of the pseudo random generator
+ */
+static ef_u32_t                 u32BenchRandomState = EF_BENCH_SEED_DEFAULT;
+
+/**
+ *  eEF_mkfs working buffer
+ */
+static ef_u08_t                 u8BenchWork[ 8 * EF_CONF_SECTOR_SIZE ];
+
+/**
+ *  Names of the timed public functions, in ef_latency_op_et order
+ */
+static const char             * pcBenchLatencyNames[ EF_LATENCY_OP_NB + 1 ] = {
+  "mount", "umount", "fopen", "fclose", "fread", "fwrite", "fsync", "fseek", "truncate",
+  "expand", "stat", "remove", "rename", "dirmake", "diropen", "dirread", "getfree", "fextents",
+  "defrag_file", "defrag_volume", "check", "none"
+};
+
+/**
+ *  Drive command trace file, 0:not tracing
+ */
+static FILE                   * pxBenchTraceFile = 0;
+
+/**
+ *  Records written to the trace file and records lost
+ */
+static ef_bench_trace_header_st xBenchTraceHeader;
+static ef_u32_t                 u32BenchTraceRecordsNb = 0;
+
+/**
+ *  Drive commands since the trace ring was last emptied
+ */
+static ef_u32_t                 u32BenchTracePending = 0;
+
+/**
+ *  Latency added to every read command [us], the device access time of the memory backends being zero
+ */
+static ef_u32_t                 u32BenchReadUs = 0;
+
+/**
+ *  Model of the flash backend
+ */
+static ef_port_flash_config_st  xBenchFlashModel;
+
+/**
+ *  Members of the striped backend, registered after the counting drive
+ */
+static const ef_port_stripe_config_st xBenchStripe = { EF_BENCH_STRIPE_SIZE, 2, { 1, 2 } };
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFBenchDriveInitialize (
+  void
+);
+
+static ef_return_et eEFBenchDriveStatus (
+  void
+);
+
+static ef_return_et eEFBenchDriveRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+);
+
+static ef_return_et eEFBenchDriveWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+);
+
+static ef_return_et eEFBenchDriveCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+);
+
+static void vEFBenchLatencySlow (
+  const ef_latency_event_st * pxEvent
+);
+
+static ef_return_et eEFBenchTraceFlush (
+  ef_bool_t bForce
+);
+
+static double dEFBenchTicksToMs (
+  ef_u64_t  u64Ticks
+);
+
+/**
+ *  Counting drive, forwards every call to the selected backend
+ */
+static ef_drive_functions_st xBenchDrive = {
+  .pxInitialize  = eEFBenchDriveInitialize,
+  .pxStatus      = eEFBenchDriveStatus,
+  .pxRead        = eEFBenchDriveRead,
+  .pxWrite       = eEFBenchDriveWrite,
+  .pxCtrl        = eEFBenchDriveCtrl,
+};
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eEFBenchDriveInitialize (
+  void
+)
+{
+  return pxBenchBackend->pxInitialize( );
+}
+
+static ef_return_et eEFBenchDriveStatus (
+  void
+)
+{
+  return pxBenchBackend->pxStatus( );
+}
+
+static ef_return_et eEFBenchDriveRead (
+  ef_u08_t  * pu8Buffer,
+  ef_lba_t    xSector,
+  ef_u32_t    u32Count
+)
+{
+  (void) eEFBenchTraceFlush( EF_BOOL_FALSE );
+  /* The reads of a concurrent backend are sent by several tasks at once */
+  (void) eEFPortCriticalEnter( );
+  xBenchCounters.u32ReadCmds++;
+  xBenchCounters.u64SectorsRead += u32Count;
+  (void) eEFPortCriticalExit( );
+  if ( 0 != u32BenchReadUs )
+  {
+    struct timespec xDelay = { u32BenchReadUs / 1000000UL, (long) ( u32BenchReadUs % 1000000UL ) * 1000L };
+
+    (void) nanosleep( &xDelay, 0 );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return pxBenchBackend->pxRead( pu8Buffer, xSector, u32Count );
+}
+
+static ef_return_et eEFBenchDriveWrite (
+  const ef_u08_t  * pu8Buffer,
+  ef_lba_t          xSector,
+  ef_u32_t          u32Count
+)
+{
+  (void) eEFBenchTraceFlush( EF_BOOL_FALSE );
+  (void) eEFPortCriticalEnter( );
+  xBenchCounters.u32WriteCmds++;
+  xBenchCounters.u64SectorsWritten += u32Count;
+  (void) eEFPortCriticalExit( );
+
+  return pxBenchBackend->pxWrite( pu8Buffer, xSector, u32Count );
+}
+
+static ef_return_et eEFBenchDriveCtrl (
+  ef_u08_t    u8Cmd,
+  void      * pvBuffer
+)
+{
+  (void) eEFBenchTraceFlush( EF_BOOL_FALSE );
+  /* Geometry queries are not commands sent to the device */
+  if (    ( CTRL_SYNC == u8Cmd )
+       || ( CTRL_TRIM == u8Cmd ) )
+  {
+    (void) eEFPortCriticalEnter( );
+    xBenchCounters.u32CtrlCmds++;
+    (void) eEFPortCriticalExit( );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return pxBenchBackend->pxCtrl( u8Cmd, pvBuffer );
+}
+
+static void vEFBenchLatencySlow (
+  const ef_latency_event_st * pxEvent
+)
+{
+  printf( "slow %s: %.3f ms, returned %d\n",
+          pcEFBenchLatencyName( pxEvent->eOperation ),
+          dEFBenchTicksToMs( pxEvent->u32Ticks ),
+          (int) pxEvent->eResult );
+}
+
+static double dEFBenchTicksToMs (
+  ef_u64_t  u64Ticks
+)
+{
+  return (double) u64Ticks * 1000.0 / (double) EF_CONF_LATENCY_TICK_HZ;
+}
+
+/* Empty the trace ring in the file before it can overflow, every record is written when forced */
+static ef_return_et eEFBenchTraceFlush (
+  ef_bool_t bForce
+)
+{
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_trace_record_st  xRecords[ 256 ];
+  ef_u32_t            u32RecordsNb;
+  ef_u32_t            u32LostNb;
+
+  if ( 0 == pxBenchTraceFile )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if (    ( EF_BOOL_FALSE == bForce )
+            && ( ++u32BenchTracePending < ( EF_CONF_TRACE_DEPTH / 2 ) ) )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    u32BenchTracePending = 0;
+    do
+    {
+      eRetVal = eEF_trace_read( xRecords, sizeof(xRecords) / sizeof(xRecords[ 0 ]), &u32RecordsNb, &u32LostNb );
+      xBenchTraceHeader.u32LostNb += u32LostNb;
+      u32BenchTraceRecordsNb += u32RecordsNb;
+      if (    ( EF_RET_OK == eRetVal )
+           && ( u32RecordsNb != fwrite( xRecords, sizeof(ef_trace_record_st), u32RecordsNb, pxBenchTraceFile ) ) )
+      {
+        eRetVal = EF_RET_DISK_ERR;
+      }
+    } while ( ( EF_RET_OK == eRetVal ) && ( 0 != u32RecordsNb ) );
+  }
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+ef_return_et eEFBenchArgsParse (
+  int                   iArgc,
+  char               ** ppcArgv,
+  ef_bench_config_st  * pxConfig
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( 0 == pxConfig->pcImagePath )
+  {
+    pxConfig->pcImagePath = EF_BENCH_IMAGE_PATH;
+  }
+  for ( int iArg = 1 ; ( iArg < iArgc ) && ( EF_RET_OK == eRetVal ) ; iArg++ )
+  {
+    const char  * pcOption = ppcArgv[ iArg ];
+    const char  * pcValue = ( ( iArg + 1 ) < iArgc ) ? ppcArgv[ iArg + 1 ] : 0;
+
+    if ( 0 == strcmp( pcOption, "-m" ) )
+    {
+      pxConfig->bImageMap = EF_BOOL_TRUE;
+    }
+    /* Else, every other option takes a value */
+    else if ( 0 == pcValue )
+    {
+      eRetVal = EF_RET_INVALID_PARAMETER;
+    }
+    else if ( 0 == strcmp( pcOption, "-b" ) )
+    {
+      if ( 0 == strcmp( pcValue, "ram" ) )
+      {
+        pxConfig->eBackend = EF_BENCH_BACKEND_RAM;
+      }
+      else if ( 0 == strcmp( pcValue, "image" ) )
+      {
+        pxConfig->eBackend = EF_BENCH_BACKEND_IMAGE;
+      }
+      else if ( 0 == strcmp( pcValue, "flash" ) )
+      {
+        pxConfig->eBackend = EF_BENCH_BACKEND_FLASH;
+      }
+      else if ( 0 == strcmp( pcValue, "stripe" ) )
+      {
+        pxConfig->eBackend = EF_BENCH_BACKEND_STRIPE;
+      }
+      else
+      {
+        eRetVal = EF_RET_INVALID_PARAMETER;
+      }
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-f" ) )
+    {
+      pxConfig->pcImagePath = pcValue;
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-s" ) )
+    {
+      pxConfig->u32Seed = (ef_u32_t) strtoul( pcValue, 0, 0 );
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-d" ) )
+    {
+      pxConfig->u32DiskMaxMB = (ef_u32_t) strtoul( pcValue, 0, 0 );
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-z" ) )
+    {
+      pxConfig->u32SizeMB = (ef_u32_t) strtoul( pcValue, 0, 0 );
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-n" ) )
+    {
+      pxConfig->u32Ops = (ef_u32_t) strtoul( pcValue, 0, 0 );
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-l" ) )
+    {
+      pxConfig->u32SlowMs = (ef_u32_t) strtoul( pcValue, 0, 0 );
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-r" ) )
+    {
+      pxConfig->u32ReadUs = (ef_u32_t) strtoul( pcValue, 0, 0 );
+      iArg++;
+    }
+    else if ( 0 == strcmp( pcOption, "-t" ) )
+    {
+      pxConfig->pcTracePath = pcValue;
+      iArg++;
+    }
+    else
+    {
+      eRetVal = EF_RET_INVALID_PARAMETER;
+    }
+  }
+  if ( EF_RET_OK != eRetVal )
+  {
+    printf( "usage: %s [-b ram|image|flash|stripe] [-f image] [-m] [-s seed] [-d disk max MB] [-z size MB] [-n ops] [-l slow ms] [-r read us] [-t trace]\n",
+            ppcArgv[ 0 ] );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+void vEFBenchConfigPrint (
+  const char                * pcName,
+  const ef_bench_config_st  * pxConfig
+)
+{
+  printf( "%s: FAT12 %d FAT16 %d FAT32 %d, VFAT %d, sector %d, lock %d, backend %s%s, seed 0x%08lX, size %lu MB, ops %lu\n",
+          pcName,
+          EF_CONF_FS_FAT12,
+          EF_CONF_FS_FAT16,
+          EF_CONF_FS_FAT32,
+          EF_CONF_VFAT,
+          EF_CONF_SECTOR_SIZE,
+          EF_CONF_FS_LOCK,
+          ( EF_BENCH_BACKEND_RAM == pxConfig->eBackend ) ? "ram"
+          : ( EF_BENCH_BACKEND_FLASH == pxConfig->eBackend ) ? "flash"
+          : ( EF_BENCH_BACKEND_STRIPE == pxConfig->eBackend ) ? "stripe ram+flash" : pxConfig->pcImagePath,
+          ( EF_BOOL_FALSE != pxConfig->bImageMap ) ? " (mapped)" : "",
+          (unsigned long) pxConfig->u32Seed,
+          (unsigned long) pxConfig->u32SizeMB,
+          (unsigned long) pxConfig->u32Ops );
+}
+
+ef_return_et eEFBenchVolumeCreate (
+  const ef_bench_config_st  * pxConfig,
+  ef_u32_t                    u32ClusterSize,
+  ef_u32_t                    u32DataMB
+)
+{
+  ef_return_et      eRetVal = EF_RET_OK;
+  ef_mkfs_param_st  xParam = { 0, 1, 0, 0, u32ClusterSize };
+  ef_u64_t          u64DiskSize;
+
+  /* Room for the data, the metadata and the growth of the files */
+  u64DiskSize = ( (ef_u64_t) u32DataMB * 1024UL * 1024UL * 5UL ) / 4UL + ( 16UL * 1024UL * 1024UL );
+  if ( ( 0 != EF_CONF_FS_FAT32 ) && ( 0 == EF_CONF_FS_FAT16 ) )
+  {
+    ef_u64_t  u64Fat32Min = (ef_u64_t) EF_BENCH_FAT32_CLUSTERS_MIN
+                          * ( ( 0 != u32ClusterSize ) ? u32ClusterSize : EF_CONF_SECTOR_SIZE );
+
+    xParam.u8Format = FM_FAT32;
+    if ( u64DiskSize < u64Fat32Min )
+    {
+      u64DiskSize = u64Fat32Min;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  else if ( 0 != EF_CONF_FS_FAT32 )
+  {
+    xParam.u8Format = FM_ANY;
+  }
+  else
+  {
+    xParam.u8Format = FM_FAT;
+  }
+
+  /* If the disk is too large for this run */
+  if ( u64DiskSize > ( (ef_u64_t) pxConfig->u32DiskMaxMB * 1024UL * 1024UL ) )
+  {
+    eRetVal = EF_RET_NOT_ENOUGH_CORE;
+  }
+  else
+  {
+    ef_u32_t  u32SectorNb = (ef_u32_t) ( u64DiskSize / EF_CONF_SECTOR_SIZE );
+
+    u32BenchReadUs = pxConfig->u32ReadUs;
+    if ( EF_BENCH_BACKEND_RAM == pxConfig->eBackend )
+    {
+      pxBenchBackend = &xffDriveFunctionsRAM;
+      EF_BENCH_CHECK( eEFPortDriveRAMConfigure( 0, u32SectorNb, EF_CONF_SECTOR_SIZE, EF_BENCH_BLOCK_SIZE ) );
+    }
+    else if ( EF_BENCH_BACKEND_FLASH == pxConfig->eBackend )
+    {
+      (void) eEFPortDriveFlashDefaultGet( &xBenchFlashModel );
+      xBenchFlashModel.u32SectorNb = u32SectorNb;
+      pxBenchBackend = &xffDriveFunctionsFlash;
+      EF_BENCH_CHECK( eEFPortDriveFlashConfigure( &xBenchFlashModel ) );
+    }
+    else if ( EF_BENCH_BACKEND_STRIPE == pxConfig->eBackend )
+    {
+      /* Each member holds half of the disk, in whole stripes */
+      ef_u32_t  u32MemberNb = ( ( ( u32SectorNb / 2 ) + EF_BENCH_STRIPE_SIZE - 1 ) / EF_BENCH_STRIPE_SIZE )
+                              * EF_BENCH_STRIPE_SIZE;
+
+      (void) eEFPortDriveFlashDefaultGet( &xBenchFlashModel );
+      xBenchFlashModel.u32SectorNb = u32MemberNb;
+      pxBenchBackend = &xffDriveFunctionsStripe;
+      EF_BENCH_CHECK( eEFPortDriveRAMConfigure( 0, u32MemberNb, EF_CONF_SECTOR_SIZE, EF_BENCH_BLOCK_SIZE ) );
+      EF_BENCH_CHECK( eEFPortDriveFlashConfigure( &xBenchFlashModel ) );
+      EF_BENCH_CHECK( eEFPortDriveStripeConfigure( &xBenchStripe ) );
+    }
+    else
+    {
+      /* Start from an empty image of the right size */
+      (void) remove( pxConfig->pcImagePath );
+      pxBenchBackend = &xffDriveFunctionsImage;
+      EF_BENCH_CHECK( eEFPortDriveImageConfigure( pxConfig->pcImagePath,
+                                                  u32SectorNb,
+                                                  EF_CONF_SECTOR_SIZE,
+                                                  EF_BENCH_BLOCK_SIZE,
+                                                  pxConfig->bImageMap ) );
+    }
+    if ( EF_BOOL_FALSE == bBenchRegistered )
+    {
+      EF_BENCH_CHECK( eEF_drive_register( &xBenchDrive ) );
+      if ( EF_BENCH_BACKEND_STRIPE == pxConfig->eBackend )
+      {
+        EF_BENCH_CHECK( eEF_drive_register( &xffDriveFunctionsRAM ) );
+        EF_BENCH_CHECK( eEF_drive_register( &xffDriveFunctionsFlash ) );
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      bBenchRegistered = EF_BOOL_TRUE;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    EF_BENCH_CHECK( eEF_mkfs( EF_BENCH_VOLUME, &xParam, u8BenchWork, sizeof(u8BenchWork) ) );
+    EF_BENCH_CHECK( eEF_mount( EF_BENCH_VOLUME, 0, 1, 0 ) );
+  }
+
+  return eRetVal;
+}
+
+ef_return_et eEFBenchVolumeRelease (
+  const ef_bench_config_st  * pxConfig
+)
+{
+  ef_return_et  eRetVal = eEF_umount( EF_BENCH_VOLUME );
+
+  if ( EF_BENCH_BACKEND_IMAGE == pxConfig->eBackend )
+  {
+    (void) eEFPortDriveImageClose( );
+    (void) remove( pxConfig->pcImagePath );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+ef_return_et eEFBenchFreeScan (
+  ef_bench_free_st  * pxFree
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  const TCHAR * pxPath = EF_BENCH_VOLUME;
+  ef_fs_st    * pxFS;
+
+  (void) memset( pxFree, 0, sizeof(ef_bench_free_st) );
+  if ( EF_RET_OK != eEFPrvVolumeMountCheck( &pxPath, &pxFS ) )
+  {
+    eRetVal = EF_RET_NOT_READY;
+  }
+  else
+  {
+    ef_u32_t  u32Run = 0;
+
+    pxFree->u32ClusterSize = (ef_u32_t) pxFS->u8ClstSize * EF_SECTOR_SIZE( pxFS );
+    pxFree->u32ClustersNb = pxFS->u32FatEntriesNb - 2;
+    /* One more turn with a used entry closes the last run */
+    for ( ef_u32_t u32Cluster = 2 ; u32Cluster <= pxFS->u32FatEntriesNb ; u32Cluster++ )
+    {
+      ef_u32_t  u32Value = 1;
+
+      if (    ( u32Cluster < pxFS->u32FatEntriesNb )
+           && ( EF_RET_OK != ( eRetVal = eEFPrvFATGet( pxFS, u32Cluster, &u32Value ) ) ) )
+      {
+        break;
+      }
+      else if ( 0 == u32Value )
+      {
+        pxFree->u32FreeNb++;
+        u32Run++;
+      }
+      else if ( 0 != u32Run )
+      {
+        ef_u32_t  u32Bucket = 0;
+
+        while ( ( ( u32Run >> ( u32Bucket + 1 ) ) != 0 ) && ( u32Bucket < ( EF_BENCH_HISTOGRAM_NB - 1 ) ) )
+        {
+          u32Bucket++;
+        }
+        pxFree->u32Histogram[ u32Bucket ]++;
+        pxFree->u32RunsNb++;
+        if ( u32Run > pxFree->u32RunMax )
+        {
+          pxFree->u32RunMax = u32Run;
+        }
+        u32Run = 0;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    (void) eEFPrvFSUnlock( pxFS, eRetVal );
+  }
+
+  return eRetVal;
+}
+
+void vEFBenchCountersReset (
+  void
+)
+{
+  (void) eEFPortCriticalEnter( );
+  (void) memset( &xBenchCounters, 0, sizeof(xBenchCounters) );
+  (void) eEFPortCriticalExit( );
+  if ( &xffDriveFunctionsFlash == pxBenchBackend )
+  {
+    (void) eEFPortDriveFlashStatsReset( );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+}
+
+void vEFBenchCountersGet (
+  ef_bench_counters_st  * pxCounters
+)
+{
+  (void) eEFPortCriticalEnter( );
+  *pxCounters = xBenchCounters;
+  (void) eEFPortCriticalExit( );
+  if ( &xffDriveFunctionsFlash == pxBenchBackend )
+  {
+    ef_port_flash_stats_st  xFlash;
+
+    (void) eEFPortDriveFlashStatsGet( &xFlash );
+    pxCounters->u64DeviceUs = xFlash.u64ElapsedUs;
+    pxCounters->u64SectorsProgrammed = xFlash.u64PagesProgrammed * xBenchFlashModel.u32PageSize;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+}
+
+ef_return_et eEFBenchLatencyWatch (
+  ef_u32_t  u32ThresholdMs
+)
+{
+  ef_return_et  eRetVal = eEF_latency_reset( );
+
+  /* A zero threshold removes the callback */
+  if ( EF_RET_OK != eRetVal )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if ( 0 == EF_CONF_LATENCY )
+  {
+    printf( "latency histograms disabled (EF_CONF_LATENCY)\n" );
+  }
+  else if ( 0 == u32ThresholdMs )
+  {
+    eRetVal = eEF_latency_callback_set( 0, 0 );
+  }
+  else
+  {
+    eRetVal = eEF_latency_callback_set( vEFBenchLatencySlow,
+                                        (ef_u32_t) ( (ef_u64_t) u32ThresholdMs * EF_CONF_LATENCY_TICK_HZ / 1000 ) );
+  }
+
+  return eRetVal;
+}
+
+void vEFBenchLatencyPrint (
+  void
+)
+{
+  ef_latency_st xLatency;
+
+  if ( 0 == EF_CONF_LATENCY )
+  {
+    return;
+  }
+  printf( "%-9s %9s %10s %10s %10s %10s\n", "function", "calls", "mean-ms", "p50-ms<", "p99-ms<", "max-ms" );
+  for ( ef_latency_op_et eOp = EF_LATENCY_MOUNT ; eOp < EF_LATENCY_OP_NB ; eOp++ )
+  {
+    ef_u32_t  u32Count = 0;
+    ef_u32_t  u32P50 = 0;
+    ef_u32_t  u32P99 = 0;
+
+    if (    ( EF_RET_OK != eEF_latency_get( eOp, &xLatency ) )
+         || ( 0 == xLatency.u32CallsNb ) )
+    {
+      continue;
+    }
+    /* Percentiles are given as the upper bound of their bucket */
+    for ( ef_u32_t u32Bucket = 0 ; u32Bucket < EF_LATENCY_BUCKETS_NB ; u32Bucket++ )
+    {
+      u32Count += xLatency.u32Buckets[ u32Bucket ];
+      if ( ( 0 == u32P50 ) && ( ( (ef_u64_t) u32Count * 2 ) >= xLatency.u32CallsNb ) )
+      {
+        u32P50 = u32Bucket + 1;
+      }
+      if ( ( 0 == u32P99 ) && ( ( (ef_u64_t) u32Count * 100 ) >= ( (ef_u64_t) xLatency.u32CallsNb * 99 ) ) )
+      {
+        u32P99 = u32Bucket + 1;
+      }
+    }
+    printf( "%-9s %9lu %10.4f %10.4f %10.4f %10.4f\n",
+            pcEFBenchLatencyName( eOp ),
+            (unsigned long) xLatency.u32CallsNb,
+            dEFBenchTicksToMs( xLatency.u64TicksTotal ) / xLatency.u32CallsNb,
+            dEFBenchTicksToMs( (ef_u64_t) 1 << ( u32P50 - 1 ) ),
+            dEFBenchTicksToMs( (ef_u64_t) 1 << ( u32P99 - 1 ) ),
+            dEFBenchTicksToMs( xLatency.u32TicksMax ) );
+  }
+}
+
+const char * pcEFBenchLatencyName (
+  ef_latency_op_et  eOperation
+)
+{
+  return pcBenchLatencyNames[ ( eOperation < EF_LATENCY_OP_NB ) ? eOperation : EF_LATENCY_OP_NB ];
+}
+
+ef_return_et eEFBenchTraceStart (
+  const ef_bench_config_st  * pxConfig
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( 0 == pxConfig->pcTracePath )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else if ( 0 == EF_CONF_TRACE )
+  {
+    printf( "drive command trace disabled (EF_CONF_TRACE)\n" );
+    eRetVal = EF_RET_NOT_ENABLED;
+  }
+  else if ( 0 == ( pxBenchTraceFile = fopen( pxConfig->pcTracePath, "wb" ) ) )
+  {
+    printf( "cannot create the trace file %s\n", pxConfig->pcTracePath );
+    eRetVal = EF_RET_DENIED;
+  }
+  else
+  {
+    (void) memset( &xBenchTraceHeader, 0, sizeof(xBenchTraceHeader) );
+    xBenchTraceHeader.u32Magic      = EF_BENCH_TRACE_MAGIC;
+    xBenchTraceHeader.u32Version    = EF_BENCH_TRACE_VERSION;
+    xBenchTraceHeader.u32RecordSize = sizeof(ef_trace_record_st);
+    xBenchTraceHeader.u32SectorSize = EF_CONF_SECTOR_SIZE;
+    xBenchTraceHeader.u32TickHz     = EF_CONF_LATENCY_TICK_HZ;
+    u32BenchTraceRecordsNb = 0;
+    u32BenchTracePending = 0;
+    if ( 1 != fwrite( &xBenchTraceHeader, sizeof(xBenchTraceHeader), 1, pxBenchTraceFile ) )
+    {
+      eRetVal = EF_RET_DISK_ERR;
+    }
+    else
+    {
+      eRetVal = eEF_trace_enable( EF_BOOL_TRUE );
+    }
+  }
+
+  return eRetVal;
+}
+
+ef_return_et eEFBenchTraceStop (
+  void
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+
+  if ( 0 == pxBenchTraceFile )
+  {
+    EF_CODE_COVERAGE( );
+  }
+  else
+  {
+    (void) eEF_trace_enable( EF_BOOL_FALSE );
+    eRetVal = eEFBenchTraceFlush( EF_BOOL_TRUE );
+    /* Rewrite the header with the lost count */
+    if (    ( EF_RET_OK == eRetVal )
+         && (    ( 0 != fseek( pxBenchTraceFile, 0, SEEK_SET ) )
+              || ( 1 != fwrite( &xBenchTraceHeader, sizeof(xBenchTraceHeader), 1, pxBenchTraceFile ) ) ) )
+    {
+      eRetVal = EF_RET_DISK_ERR;
+    }
+    if ( ( 0 != fclose( pxBenchTraceFile ) ) && ( EF_RET_OK == eRetVal ) )
+    {
+      eRetVal = EF_RET_DISK_ERR;
+    }
+    pxBenchTraceFile = 0;
+    printf( "trace: %lu drive commands recorded, %lu lost\n",
+            (unsigned long) u32BenchTraceRecordsNb,
+            (unsigned long) xBenchTraceHeader.u32LostNb );
+  }
+
+  return eRetVal;
+}
+
+double dEFBenchTimeGet (
+  void
+)
+{
+  struct timespec xTime;
+
+  (void) clock_gettime( CLOCK_MONOTONIC, &xTime );
+
+  return (double) xTime.tv_sec + ( (double) xTime.tv_nsec * 1e-9 );
+}
+
+void vEFBenchRandomSeed (
+  ef_u32_t  u32Seed
+)
+{
+  u32BenchRandomState = ( 0 != u32Seed ) ? u32Seed : EF_BENCH_SEED_DEFAULT;
+}
+
+ef_u32_t u32EFBenchRandom (
+  void
+)
+{
+  u32BenchRandomState ^= u32BenchRandomState << 13;
+  u32BenchRandomState ^= u32BenchRandomState >> 17;
+  u32BenchRandomState ^= u32BenchRandomState << 5;
+
+  return u32BenchRandomState;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
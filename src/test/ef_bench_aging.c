@@ -0,0 +1,564 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_bench_aging.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host benchmark: age a volume with a synthetic lifecycle and measure fragmentation and speed
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <efat.h>
+#include <ef_prv_def.h>
+
+#include "ef_bench.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Number of directories the aged files are spread over
+ */
+#define EF_BENCH_AGING_DIRS_NB    ( 8UL )
+
+/**
+ *  Most files alive at once
+ */
+#define EF_BENCH_AGING_FILES_MAX  ( 4096UL )
+
+/**
+ *  The lifecycle keeps the volume filled between these bounds [%]
+ */
+#define EF_BENCH_AGING_FILL_LOW   ( 50UL )
+#define EF_BENCH_AGING_FILL_HIGH  ( 85UL )
+
+/**
+ *  Size of the file of the throughput measure [bytes]
+ */
+#define EF_BENCH_SPEED_FILE_SIZE  ( 16UL * 1024UL * 1024UL )
+
+/**
+ *  Transfer size of the sequential throughput measure [bytes]
+ */
+#define EF_BENCH_SPEED_TRANSFER   ( 64UL * 1024UL )
+
+/**
+ *  Number of random 4K reads and of files of the metadata measure
+ */
+#define EF_BENCH_SPEED_OPS_NB     ( 1000UL )
+
+/**
+ *  Number of files preallocated with eEF_expand() and largest size of them [bytes]
+ */
+#define EF_BENCH_EXPAND_NB        ( 200UL )
+#define EF_BENCH_EXPAND_SIZE_MAX  ( 256UL * 1024UL )
+
+/**
+ *  Largest number of extents read per file
+ */
+#define EF_BENCH_EXTENTS_MAX      ( 64UL )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+static ef_u08_t     u8Buffer[ EF_BENCH_SPEED_TRANSFER ];
+
+/**
+ *  Size of the aged files, 0:not alive
+ */
+static ef_u32_t     u32FileSizes[ EF_BENCH_AGING_FILES_MAX ];
+
+/**
+ *  Runs of the file being measured
+ */
+static ef_extent_st xExtents[ EF_BENCH_EXTENTS_MAX ];
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Build the path of an aged file
+ *
+ *  @param  pcPath    Path buffer, 32 bytes
+ *  @param  u32Index  Index of the file
+ */
+static void vBenchPathGet (
+  char      * pcPath,
+  ef_u32_t    u32Index
+);
+
+/**
+ *  @brief  Draw a file size: mostly small files, some medium, a few large ones
+ *
+ *  @return Size [bytes]
+ */
+static ef_u32_t u32BenchFileSizeDraw (
+  void
+);
+
+/**
+ *  @brief  Write bytes at the current offset of a file
+ *
+ *  @param  pxFile    File
+ *  @param  u32Size   Number of bytes
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchFileFill (
+  EF_FILE   * pxFile,
+  ef_u32_t    u32Size
+);
+
+/**
+ *  @brief  Replay the synthetic lifecycle of creates, appends, truncates and deletes
+ *          The files are spread over the directories D0 to D7, created beforehand.
+ *
+ *  @param  u32Steps  Number of operations
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchAge (
+  ef_u32_t  u32Steps
+);
+
+/**
+ *  @brief  Print the average run length of the files and the free extent histogram
+ *
+ *  @param  pcLabel   Name of the volume state
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchFragmentationPrint (
+  const char  * pcLabel
+);
+
+/**
+ *  @brief  Measure sequential and random throughput, metadata operations and contiguous preallocation
+ *
+ *  @param  pcLabel   Name of the volume state
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchSpeedPrint (
+  const char  * pcLabel
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static void vBenchPathGet (
+  char      * pcPath,
+  ef_u32_t    u32Index
+)
+{
+  (void) snprintf( pcPath,
+                   32,
+                   "%s/D%lu/A%05lu.DAT",
+                   EF_BENCH_VOLUME,
+                   (unsigned long) ( u32Index % EF_BENCH_AGING_DIRS_NB ),
+                   (unsigned long) u32Index );
+}
+
+static ef_u32_t u32BenchFileSizeDraw (
+  void
+)
+{
+  ef_u32_t  u32Class = u32EFBenchRandom( ) % 100UL;
+  ef_u32_t  u32Size;
+
+  /* Log-uniform size inside each class, like logs, configs, records and recordings */
+  if ( u32Class < 50UL )
+  {
+    u32Size = 512UL << ( u32EFBenchRandom( ) % 5UL );     /* 512 B .. 8 KB */
+  }
+  else if ( u32Class < 85UL )
+  {
+    u32Size = 16384UL << ( u32EFBenchRandom( ) % 4UL );   /* 16 KB .. 128 KB */
+  }
+  else if ( u32Class < 98UL )
+  {
+    u32Size = 262144UL << ( u32EFBenchRandom( ) % 4UL );  /* 256 KB .. 2 MB */
+  }
+  else
+  {
+    u32Size = 4194304UL << ( u32EFBenchRandom( ) % 2UL ); /* 4 MB .. 8 MB */
+  }
+
+  return u32Size + ( u32EFBenchRandom( ) % u32Size );
+}
+
+static ef_return_et eBenchFileFill (
+  EF_FILE   * pxFile,
+  ef_u32_t    u32Size
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u32_t      u32Written;
+
+  while ( ( 0 != u32Size ) && ( EF_RET_OK == eRetVal ) )
+  {
+    ef_u32_t  u32Chunk = ( u32Size < EF_BENCH_SPEED_TRANSFER ) ? u32Size : EF_BENCH_SPEED_TRANSFER;
+
+    eRetVal = eEF_fwrite( pxFile, u8Buffer, u32Chunk, &u32Written );
+    if ( ( EF_RET_OK == eRetVal ) && ( u32Written != u32Chunk ) )
+    {
+      /* Volume full */
+      eRetVal = EF_RET_DENIED;
+    }
+    u32Size -= u32Chunk;
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eBenchAge (
+  ef_u32_t  u32Steps
+)
+{
+  ef_return_et      eRetVal = EF_RET_OK;
+  ef_bench_free_st  xFree;
+  EF_FILE           xFile;
+  char              cPath[ 32 ];
+  ef_u32_t          u32Fill = 0;
+  ef_u32_t          u32Counts[ 4 ] = { 0, 0, 0, 0 };
+
+  for ( ef_u32_t u32Step = 0 ; u32Step < u32Steps ; u32Step++ )
+  {
+    ef_u32_t  u32Index = u32EFBenchRandom( ) % EF_BENCH_AGING_FILES_MAX;
+    ef_u32_t  u32Op = u32EFBenchRandom( ) % 100UL;
+
+    /* Refresh the fill level from time to time */
+    if ( 0 == ( u32Step % 64UL ) )
+    {
+      EF_BENCH_CHECK( eEFBenchFreeScan( &xFree ) );
+      u32Fill = (ef_u32_t) ( ( (ef_u64_t) ( xFree.u32ClustersNb - xFree.u32FreeNb ) * 100UL ) / xFree.u32ClustersNb );
+    }
+    vBenchPathGet( cPath, u32Index );
+    /* Dead slot: create, unless the volume is too full */
+    if ( 0 == u32FileSizes[ u32Index ] )
+    {
+      if ( u32Fill < EF_BENCH_AGING_FILL_HIGH )
+      {
+        ef_u32_t  u32Size = u32BenchFileSizeDraw( );
+
+        EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+        eRetVal = eBenchFileFill( &xFile, u32Size );
+        EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+        if ( EF_RET_DENIED == eRetVal )
+        {
+          /* Keep what was written, the next scan will start deleting */
+          u32Fill = 100UL;
+          eRetVal = EF_RET_OK;
+        }
+        EF_BENCH_CHECK( eRetVal );
+        u32FileSizes[ u32Index ] = u32Size;
+        u32Counts[ 0 ]++;
+      }
+    }
+    /* Delete, always when the volume is too full */
+    else if ( ( u32Op < 30UL ) || ( u32Fill >= EF_BENCH_AGING_FILL_HIGH ) )
+    {
+      EF_BENCH_CHECK( eEF_remove( cPath ) );
+      u32FileSizes[ u32Index ] = 0;
+      u32Counts[ 3 ]++;
+    }
+    /* Append, like a log or a recording being extended */
+    else if ( ( u32Op < 85UL ) || ( u32Fill < EF_BENCH_AGING_FILL_LOW ) )
+    {
+      ef_u32_t  u32Size = 512UL + ( u32EFBenchRandom( ) % 65536UL );
+
+      EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_EXISTING | EF_FILE_OPEN_APPEND ) );
+      eRetVal = eBenchFileFill( &xFile, u32Size );
+      EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+      if ( EF_RET_DENIED == eRetVal )
+      {
+        u32Fill = 100UL;
+        eRetVal = EF_RET_OK;
+      }
+      EF_BENCH_CHECK( eRetVal );
+      u32FileSizes[ u32Index ] += u32Size;
+      u32Counts[ 1 ]++;
+    }
+    /* Truncate to a random point */
+    else
+    {
+      ef_u32_t  u32Size = u32EFBenchRandom( ) % u32FileSizes[ u32Index ];
+
+      EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_EXISTING ) );
+      EF_BENCH_CHECK( eEF_fseek( &xFile, u32Size ) );
+      EF_BENCH_CHECK( eEF_truncate( &xFile ) );
+      EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+      /* An emptied file stays alive */
+      u32FileSizes[ u32Index ] = ( 0 != u32Size ) ? u32Size : 1UL;
+      u32Counts[ 2 ]++;
+    }
+  }
+  printf( "aging: %lu steps, %lu creates, %lu appends, %lu truncates, %lu deletes\n",
+          (unsigned long) u32Steps,
+          (unsigned long) u32Counts[ 0 ],
+          (unsigned long) u32Counts[ 1 ],
+          (unsigned long) u32Counts[ 2 ],
+          (unsigned long) u32Counts[ 3 ] );
+
+  return eRetVal;
+}
+
+static ef_return_et eBenchFragmentationPrint (
+  const char  * pcLabel
+)
+{
+  ef_return_et      eRetVal = EF_RET_OK;
+  ef_bench_free_st  xFree;
+  EF_FILE           xFile;
+  char              cPath[ 32 ];
+  ef_u32_t          u32FilesNb = 0;
+  ef_u32_t          u32Fragmented = 0;
+  ef_u64_t          u64Runs = 0;
+  ef_u64_t          u64Clusters = 0;
+
+  EF_BENCH_CHECK( eEFBenchFreeScan( &xFree ) );
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_BENCH_AGING_FILES_MAX ; u32Index++ )
+  {
+    ef_u32_t  u32RunsNb;
+
+    if ( 1UL < u32FileSizes[ u32Index ] )
+    {
+      vBenchPathGet( cPath, u32Index );
+      EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_EXISTING ) );
+      EF_BENCH_CHECK( eEF_fextents( &xFile, xExtents, EF_BENCH_EXTENTS_MAX, &u32RunsNb ) );
+      EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+      u32FilesNb++;
+      u64Runs += u32RunsNb;
+      u64Clusters += ( u32FileSizes[ u32Index ] + xFree.u32ClusterSize - 1 ) / xFree.u32ClusterSize;
+      if ( 1UL < u32RunsNb )
+      {
+        u32Fragmented++;
+      }
+    }
+  }
+  printf( "%s: %lu files, %.2f runs per file, %.1f clusters per run, %.1f%% fragmented\n",
+          pcLabel,
+          (unsigned long) u32FilesNb,
+          ( 0 != u32FilesNb ) ? (double) u64Runs / u32FilesNb : 0.0,
+          ( 0 != u64Runs ) ? (double) u64Clusters / (double) u64Runs : 0.0,
+          ( 0 != u32FilesNb ) ? ( 100.0 * u32Fragmented ) / u32FilesNb : 0.0 );
+  printf( "%s: cluster %lu B, %lu of %lu clusters free in %lu runs, longest %lu\n",
+          pcLabel,
+          (unsigned long) xFree.u32ClusterSize,
+          (unsigned long) xFree.u32FreeNb,
+          (unsigned long) xFree.u32ClustersNb,
+          (unsigned long) xFree.u32RunsNb,
+          (unsigned long) xFree.u32RunMax );
+  printf( "%s: free runs  ", pcLabel );
+  for ( ef_u32_t u32Bucket = 0 ; u32Bucket < EF_BENCH_HISTOGRAM_NB ; u32Bucket++ )
+  {
+    if ( 0 != xFree.u32Histogram[ u32Bucket ] )
+    {
+      printf( " %lu+:%lu", 1UL << u32Bucket, (unsigned long) xFree.u32Histogram[ u32Bucket ] );
+    }
+  }
+  printf( "\n" );
+
+  return eRetVal;
+}
+
+static ef_return_et eBenchSpeedPrint (
+  const char  * pcLabel
+)
+{
+  ef_return_et          eRetVal = EF_RET_OK;
+  ef_bench_counters_st  xCounters;
+  EF_FILE               xFile;
+  ef_file_info_st       xInfo;
+  char                  cPath[ 32 ];
+  ef_u32_t              u32Size;
+  ef_u32_t              u32RunsNb;
+  ef_u32_t              u32DeniedNb = 0;
+  double                dTimes[ 6 ];
+  ef_u32_t              u32Cmds[ 6 ];
+  double                dStart;
+
+  /* Sequential write and read of a new file */
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  EF_BENCH_CHECK( eEF_fopen( &xFile, EF_BENCH_VOLUME "/SPEED.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_BENCH_CHECK( eBenchFileFill( &xFile, EF_BENCH_SPEED_FILE_SIZE ) );
+  EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+  dTimes[ 0 ] = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  u32Cmds[ 0 ] = xCounters.u32ReadCmds + xCounters.u32WriteCmds;
+
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  EF_BENCH_CHECK( eEF_fopen( &xFile, EF_BENCH_VOLUME "/SPEED.BIN", EF_FILE_OPEN_EXISTING ) );
+  for ( ef_u32_t u32Offset = 0 ; u32Offset < EF_BENCH_SPEED_FILE_SIZE ; u32Offset += EF_BENCH_SPEED_TRANSFER )
+  {
+    EF_BENCH_CHECK( eEF_fread( &xFile, u8Buffer, EF_BENCH_SPEED_TRANSFER, &u32Size ) );
+  }
+  dTimes[ 1 ] = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  u32Cmds[ 1 ] = xCounters.u32ReadCmds + xCounters.u32WriteCmds;
+
+  /* Random 4K reads */
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  for ( ef_u32_t u32Op = 0 ; u32Op < EF_BENCH_SPEED_OPS_NB ; u32Op++ )
+  {
+    EF_BENCH_CHECK( eEF_fseek( &xFile, ( u32EFBenchRandom( ) % ( EF_BENCH_SPEED_FILE_SIZE / 4096UL ) ) * 4096UL ) );
+    EF_BENCH_CHECK( eEF_fread( &xFile, u8Buffer, 4096UL, &u32Size ) );
+  }
+  dTimes[ 2 ] = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  u32Cmds[ 2 ] = xCounters.u32ReadCmds + xCounters.u32WriteCmds;
+  EF_BENCH_CHECK( eEF_fextents( &xFile, xExtents, EF_BENCH_EXTENTS_MAX, &u32RunsNb ) );
+  EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+  EF_BENCH_CHECK( eEF_remove( EF_BENCH_VOLUME "/SPEED.BIN" ) );
+
+  /* Create and stat in an aged directory, then clean up */
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  for ( ef_u32_t u32Op = 0 ; u32Op < EF_BENCH_SPEED_OPS_NB ; u32Op++ )
+  {
+    (void) snprintf( cPath, sizeof(cPath), "%s/D0/S%05lu.DAT", EF_BENCH_VOLUME, (unsigned long) u32Op );
+    EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+    EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+  }
+  dTimes[ 3 ] = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  u32Cmds[ 3 ] = xCounters.u32ReadCmds + xCounters.u32WriteCmds;
+
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  for ( ef_u32_t u32Op = 0 ; u32Op < EF_BENCH_SPEED_OPS_NB ; u32Op++ )
+  {
+    (void) snprintf( cPath,
+                     sizeof(cPath),
+                     "%s/D0/S%05lu.DAT",
+                     EF_BENCH_VOLUME,
+                     (unsigned long) ( u32EFBenchRandom( ) % EF_BENCH_SPEED_OPS_NB ) );
+    EF_BENCH_CHECK( eEF_stat( cPath, &xInfo ) );
+  }
+  dTimes[ 4 ] = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  u32Cmds[ 4 ] = xCounters.u32ReadCmds + xCounters.u32WriteCmds;
+  for ( ef_u32_t u32Op = 0 ; u32Op < EF_BENCH_SPEED_OPS_NB ; u32Op++ )
+  {
+    (void) snprintf( cPath, sizeof(cPath), "%s/D0/S%05lu.DAT", EF_BENCH_VOLUME, (unsigned long) u32Op );
+    EF_BENCH_CHECK( eEF_remove( cPath ) );
+  }
+
+  /* Contiguous preallocation, a volume without a run large enough is not an error */
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  for ( ef_u32_t u32Op = 0 ; u32Op < EF_BENCH_EXPAND_NB ; u32Op++ )
+  {
+    (void) snprintf( cPath, sizeof(cPath), "%s/D0/E%05lu.DAT", EF_BENCH_VOLUME, (unsigned long) u32Op );
+    EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+    eRetVal = eEF_expand( &xFile, 4096UL + ( u32EFBenchRandom( ) % EF_BENCH_EXPAND_SIZE_MAX ), 1 );
+    if ( EF_RET_DENIED == eRetVal )
+    {
+      u32DeniedNb++;
+    }
+    else
+    {
+      EF_BENCH_CHECK( eRetVal );
+    }
+    EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+  }
+  dTimes[ 5 ] = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  u32Cmds[ 5 ] = xCounters.u32ReadCmds + xCounters.u32WriteCmds;
+  for ( ef_u32_t u32Op = 0 ; u32Op < EF_BENCH_EXPAND_NB ; u32Op++ )
+  {
+    (void) snprintf( cPath, sizeof(cPath), "%s/D0/E%05lu.DAT", EF_BENCH_VOLUME, (unsigned long) u32Op );
+    EF_BENCH_CHECK( eEF_remove( cPath ) );
+  }
+
+  printf( "%s: seq-write %.1f MB/s (%lu cmds, %lu runs), seq-read %.1f MB/s (%lu cmds), rand-read %.0f ops/s (%lu cmds)\n",
+          pcLabel,
+          ( (double) EF_BENCH_SPEED_FILE_SIZE / ( 1024.0 * 1024.0 ) ) / dTimes[ 0 ],
+          (unsigned long) u32Cmds[ 0 ],
+          (unsigned long) u32RunsNb,
+          ( (double) EF_BENCH_SPEED_FILE_SIZE / ( 1024.0 * 1024.0 ) ) / dTimes[ 1 ],
+          (unsigned long) u32Cmds[ 1 ],
+          (double) EF_BENCH_SPEED_OPS_NB / dTimes[ 2 ],
+          (unsigned long) u32Cmds[ 2 ] );
+  printf( "%s: create %.0f ops/s (%lu cmds), stat %.0f ops/s (%lu cmds), expand %.0f ops/s (%lu cmds, %lu denied)\n",
+          pcLabel,
+          (double) EF_BENCH_SPEED_OPS_NB / dTimes[ 3 ],
+          (unsigned long) u32Cmds[ 3 ],
+          (double) EF_BENCH_SPEED_OPS_NB / dTimes[ 4 ],
+          (unsigned long) u32Cmds[ 4 ],
+          (double) EF_BENCH_EXPAND_NB / dTimes[ 5 ],
+          (unsigned long) u32Cmds[ 5 ],
+          (unsigned long) u32DeniedNb );
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  int     iArgc,
+  char ** ppcArgv
+)
+{
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_bench_config_st  xConfig = { EF_BENCH_BACKEND_IMAGE, 0, EF_BOOL_FALSE, EF_BENCH_SEED_DEFAULT, 1024UL, 256UL, 20000UL, 0UL, 0, 0UL };
+
+  if ( EF_RET_OK != eEFBenchArgsParse( iArgc, ppcArgv, &xConfig ) )
+  {
+    return 2;
+  }
+  vEFBenchConfigPrint( "ef_bench_aging", &xConfig );
+  EF_BENCH_CHECK( eEFBenchTraceStart( &xConfig ) );
+  vEFBenchRandomSeed( xConfig.u32Seed );
+
+  eRetVal = eEFBenchVolumeCreate( &xConfig, 0, xConfig.u32SizeMB );
+  if ( EF_RET_NOT_ENOUGH_CORE == eRetVal )
+  {
+    printf( "FAILED: the volume would exceed %lu MB (-d)\n", (unsigned long) xConfig.u32DiskMaxMB );
+    return 1;
+  }
+  EF_BENCH_CHECK( eRetVal );
+  for ( ef_u32_t u32Dir = 0 ; u32Dir < EF_BENCH_AGING_DIRS_NB ; u32Dir++ )
+  {
+    char  cPath[ 32 ];
+
+    (void) snprintf( cPath, sizeof(cPath), "%s/D%lu", EF_BENCH_VOLUME, (unsigned long) u32Dir );
+    EF_BENCH_CHECK( eEF_dirmake( cPath ) );
+  }
+  EF_BENCH_CHECK( eBenchSpeedPrint( "fresh" ) );
+  EF_BENCH_CHECK( eBenchAge( xConfig.u32Ops ) );
+  EF_BENCH_CHECK( eBenchFragmentationPrint( "aged" ) );
+  EF_BENCH_CHECK( eBenchSpeedPrint( "aged" ) );
+  EF_BENCH_CHECK( eEFBenchVolumeRelease( &xConfig ) );
+  EF_BENCH_CHECK( eEFBenchTraceStop( ) );
+
+  return 0;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,313 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_bench_metadata.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host benchmark: create, stat, list, rename and delete at scale
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <efat.h>
+#include <ef_prv_def.h>
+
+#include "ef_bench.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Directory holding the benchmark files
+ */
+#define EF_BENCH_DIR              EF_BENCH_VOLUME "/D"
+
+/**
+ *  Size of the volume data area needed by the benchmark [MB]
+ */
+#define EF_BENCH_META_DATA_MB     ( 16UL )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/**
+ *  @brief  Operations measured
+ */
+typedef enum {
+  EF_BENCH_CREATE = 0,  /**< Create an empty file */
+  EF_BENCH_STAT,        /**< Look a file up */
+  EF_BENCH_LIST,        /**< Read one directory entry */
+  EF_BENCH_RENAME,      /**< Rename a file in the same directory */
+  EF_BENCH_DELETE,      /**< Delete a file */
+  EF_BENCH_OPS_NB,      /**< Number of operations */
+} ef_bench_op_et;
+
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/**
+ *  Names of the operations
+ */
+static const char * pcOpNames[ EF_BENCH_OPS_NB ] = { "create", "stat", "list", "rename", "delete" };
+
+/**
+ *  Directory sizes measured, up to -n
+ */
+static const ef_u32_t u32EntriesNb[ ] = { 100UL, 500UL, 1000UL, 2000UL, 5000UL, 10000UL, 20000UL };
+
+/**
+ *  Latency of every operation of a phase [s]
+ */
+static double * pdLatencies = 0;
+
+/**
+ *  Order the files are accessed in
+ */
+static ef_u32_t * pu32Order = 0;
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Build the path of a benchmark file
+ *
+ *  @param  pcPath    Path buffer, 32 bytes
+ *  @param  cPrefix   First letter of the name
+ *  @param  u32Index  Index of the file
+ */
+static void vBenchPathGet (
+  char      * pcPath,
+  char        cPrefix,
+  ef_u32_t    u32Index
+);
+
+/**
+ *  @brief  Shuffle the access order with the benchmark pseudo random generator
+ *
+ *  @param  u32Nb   Number of files
+ */
+static void vBenchOrderShuffle (
+  ef_u32_t  u32Nb
+);
+
+/**
+ *  @brief  Comparison of two latencies for qsort()
+ */
+static int iBenchLatencyCompare (
+  const void  * pvA,
+  const void  * pvB
+);
+
+/**
+ *  @brief  Run one operation on every file and print latency percentiles and drive commands per operation
+ *
+ *  @param  eOp     Operation
+ *  @param  u32Nb   Number of files
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchPhaseRun (
+  ef_bench_op_et  eOp,
+  ef_u32_t        u32Nb
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static void vBenchPathGet (
+  char      * pcPath,
+  char        cPrefix,
+  ef_u32_t    u32Index
+)
+{
+  (void) snprintf( pcPath, 32, "%s/%c%07lu.DAT", EF_BENCH_DIR, cPrefix, (unsigned long) u32Index );
+}
+
+static void vBenchOrderShuffle (
+  ef_u32_t  u32Nb
+)
+{
+  for ( ef_u32_t u32Index = 0 ; u32Index < u32Nb ; u32Index++ )
+  {
+    pu32Order[ u32Index ] = u32Index;
+  }
+  for ( ef_u32_t u32Index = u32Nb - 1 ; u32Index > 0 ; u32Index-- )
+  {
+    ef_u32_t  u32Swap = u32EFBenchRandom( ) % ( u32Index + 1 );
+    ef_u32_t  u32Tmp = pu32Order[ u32Index ];
+
+    pu32Order[ u32Index ] = pu32Order[ u32Swap ];
+    pu32Order[ u32Swap ] = u32Tmp;
+  }
+}
+
+static int iBenchLatencyCompare (
+  const void  * pvA,
+  const void  * pvB
+)
+{
+  double  dA = *(const double *) pvA;
+  double  dB = *(const double *) pvB;
+
+  return ( dA > dB ) - ( dA < dB );
+}
+
+static ef_return_et eBenchPhaseRun (
+  ef_bench_op_et  eOp,
+  ef_u32_t        u32Nb
+)
+{
+  ef_return_et          eRetVal = EF_RET_OK;
+  ef_bench_counters_st  xCounters;
+  EF_FILE               xFile;
+  EF_DIR                xDir;
+  ef_file_info_st       xInfo;
+  char                  cPath[ 32 ];
+  char                  cNewPath[ 32 ];
+  double                dTotal = 0;
+
+  vBenchOrderShuffle( u32Nb );
+  if ( EF_BENCH_LIST == eOp )
+  {
+    EF_BENCH_CHECK( eEF_diropen( &xDir, EF_BENCH_DIR ) );
+  }
+  vEFBenchCountersReset( );
+  for ( ef_u32_t u32Op = 0 ; u32Op < u32Nb ; u32Op++ )
+  {
+    /* Creation is in index order, the other operations in random order */
+    ef_u32_t  u32Index = ( EF_BENCH_CREATE == eOp ) ? u32Op : pu32Order[ u32Op ];
+    double    dStart;
+
+    vBenchPathGet( cPath, ( ( EF_BENCH_DELETE == eOp ) ? 'R' : 'F' ), u32Index );
+    vBenchPathGet( cNewPath, 'R', u32Index );
+    dStart = dEFBenchTimeGet( );
+    if ( EF_BENCH_CREATE == eOp )
+    {
+      EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+      EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+    }
+    else if ( EF_BENCH_STAT == eOp )
+    {
+      EF_BENCH_CHECK( eEF_stat( cPath, &xInfo ) );
+    }
+    else if ( EF_BENCH_LIST == eOp )
+    {
+      EF_BENCH_CHECK( eEF_dirread( &xDir, &xInfo ) );
+      if ( 0 == xInfo.xName[ 0 ] )
+      {
+        printf( "FAILED: %lu entries listed instead of %lu\n", (unsigned long) u32Op, (unsigned long) u32Nb );
+        return EF_RET_INT_ERR;
+      }
+    }
+    else if ( EF_BENCH_RENAME == eOp )
+    {
+      EF_BENCH_CHECK( eEF_rename( cPath, cNewPath ) );
+    }
+    else
+    {
+      EF_BENCH_CHECK( eEF_remove( cPath ) );
+    }
+    pdLatencies[ u32Op ] = dEFBenchTimeGet( ) - dStart;
+    dTotal += pdLatencies[ u32Op ];
+  }
+  vEFBenchCountersGet( &xCounters );
+  if ( EF_BENCH_LIST == eOp )
+  {
+    EF_BENCH_CHECK( eEF_dirclose( &xDir ) );
+  }
+
+  qsort( pdLatencies, u32Nb, sizeof(double), iBenchLatencyCompare );
+  printf( "%-7lu %-8s %10.0f %9.1f %9.1f %9.1f %9.1f %8.2f %8.2f\n",
+          (unsigned long) u32Nb,
+          pcOpNames[ eOp ],
+          (double) u32Nb / dTotal,
+          pdLatencies[ ( u32Nb * 50UL ) / 100UL ] * 1e6,
+          pdLatencies[ ( u32Nb * 90UL ) / 100UL ] * 1e6,
+          pdLatencies[ ( u32Nb * 99UL ) / 100UL ] * 1e6,
+          pdLatencies[ u32Nb - 1 ] * 1e6,
+          (double) xCounters.u32ReadCmds / u32Nb,
+          (double) xCounters.u32WriteCmds / u32Nb );
+
+  return eRetVal;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  int     iArgc,
+  char ** ppcArgv
+)
+{
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_bench_config_st  xConfig = { EF_BENCH_BACKEND_RAM, 0, EF_BOOL_FALSE, EF_BENCH_SEED_DEFAULT, 1024UL, 0UL, 5000UL, 0UL, 0, 0UL };
+
+  if ( EF_RET_OK != eEFBenchArgsParse( iArgc, ppcArgv, &xConfig ) )
+  {
+    return 2;
+  }
+  vEFBenchConfigPrint( "ef_bench_metadata", &xConfig );
+  EF_BENCH_CHECK( eEFBenchTraceStart( &xConfig ) );
+  pdLatencies = (double *) malloc( xConfig.u32Ops * sizeof(double) );
+  pu32Order = (ef_u32_t *) malloc( xConfig.u32Ops * sizeof(ef_u32_t) );
+  if ( ( 0 == pdLatencies ) || ( 0 == pu32Order ) )
+  {
+    printf( "FAILED: no memory for %lu files\n", (unsigned long) xConfig.u32Ops );
+    return 1;
+  }
+
+  printf( "%-7s %-8s %10s %9s %9s %9s %9s %8s %8s\n",
+          "files", "op", "ops/s", "p50 us", "p90 us", "p99 us", "max us", "rd/op", "wr/op" );
+  for ( ef_u32_t u32Test = 0 ; u32Test < ( sizeof(u32EntriesNb) / sizeof(u32EntriesNb[ 0 ]) ) ; u32Test++ )
+  {
+    ef_u32_t  u32Nb = u32EntriesNb[ u32Test ];
+
+    if ( u32Nb > xConfig.u32Ops )
+    {
+      break;
+    }
+    vEFBenchRandomSeed( xConfig.u32Seed );
+    eRetVal = eEFBenchVolumeCreate( &xConfig, 0, EF_BENCH_META_DATA_MB );
+    if ( EF_RET_OK == eRetVal )
+    {
+      eRetVal = eEF_dirmake( EF_BENCH_DIR );
+    }
+    for ( ef_bench_op_et eOp = EF_BENCH_CREATE ; ( EF_RET_OK == eRetVal ) && ( eOp < EF_BENCH_OPS_NB ) ; eOp++ )
+    {
+      eRetVal = eBenchPhaseRun( eOp, u32Nb );
+    }
+    if ( EF_RET_OK != eRetVal )
+    {
+      break;
+    }
+    EF_BENCH_CHECK( eEFBenchVolumeRelease( &xConfig ) );
+  }
+  free( pdLatencies );
+  free( pu32Order );
+  if ( EF_RET_OK == eRetVal )
+  {
+    eRetVal = eEFBenchTraceStop( );
+  }
+
+  return ( EF_RET_OK == eRetVal ) ? 0 : 1;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
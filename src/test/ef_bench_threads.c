@@ -0,0 +1,559 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_bench_threads.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host benchmark: tasks reading their own file concurrently on one volume
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <efat.h>
+#include <ef_prv_def.h>
+#include <ef_prv_lfn.h>
+
+#include "ef_bench.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Most tasks run together
+ */
+#define EF_BENCH_THREADS_MAX      ( 8UL )
+
+/**
+ *  Size of the random transfers [bytes]
+ */
+#define EF_BENCH_THREADS_IO       ( 4096UL )
+
+/**
+ *  One operation in this many is a file lookup instead of a read
+ */
+#define EF_BENCH_THREADS_STAT     ( 8UL )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/**
+ *  @brief  Work and result of one task
+ */
+typedef struct {
+  pthread_t     xThread;      /**< Thread running the task */
+  ef_u32_t      u32Index;     /**< Task number, selects the file and the data pattern */
+  ef_u32_t      u32Seed;      /**< State of the pseudo random generator of the task */
+  ef_u32_t      u32FileSize;  /**< Size of the file of the task [bytes] */
+  ef_u32_t      u32Ops;       /**< Number of operations */
+  ef_u32_t      u32Mismatch;  /**< Words read back with a wrong value */
+  ef_u32_t      u32Empty;     /**< LFN buffer pool found empty */
+  ef_return_et  eResult;      /**< First error of the task */
+} ef_bench_task_st;
+
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/**
+ *  Number of tasks measured, up to EF_BENCH_THREADS_MAX
+ */
+static const ef_u32_t u32TasksNb[ ] = { 1UL, 2UL, 4UL, 8UL };
+
+/**
+ *  Tasks of a run
+ */
+static ef_bench_task_st xTasks[ EF_BENCH_THREADS_MAX ];
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Build the path of the file of a task
+ *
+ *  @param  pcPath    Path buffer, 32 bytes
+ *  @param  u32Index  Task number
+ */
+static void vBenchPathGet (
+  char      * pcPath,
+  ef_u32_t    u32Index
+);
+
+/**
+ *  @brief  Pseudo random generator of a task (xorshift32)
+ *
+ *  @param  pu32State  State of the generator, not 0
+ *
+ *  @return Next pseudo random value
+ */
+static ef_u32_t u32BenchRandom (
+  ef_u32_t  * pu32State
+);
+
+/**
+ *  @brief  Fill a buffer with the data of a task file at an offset
+ *
+ *  @param  pu32Buffer  Buffer to fill, EF_BENCH_THREADS_IO bytes
+ *  @param  u32Index    Task number
+ *  @param  u32Offset   Offset of the buffer in the file [bytes]
+ */
+static void vBenchPatternFill (
+  ef_u32_t  * pu32Buffer,
+  ef_u32_t    u32Index,
+  ef_u32_t    u32Offset
+);
+
+/**
+ *  @brief  Write the file of a task
+ *
+ *  @param  pxTask  Task
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchFileWrite (
+  ef_bench_task_st  * pxTask
+);
+
+/**
+ *  @brief  Random reads and lookups of the file of a task, the data read is checked
+ *
+ *  @param  pxTask  Task
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchTaskRun (
+  ef_bench_task_st  * pxTask
+);
+
+/**
+ *  @brief  Thread entry of a task
+ *
+ *  @param  pvTask  Task
+ *
+ *  @return Always 0
+ */
+static void * pvBenchThread (
+  void  * pvTask
+);
+
+/**
+ *  @brief  Run the tasks together and print the operations per second and the volume lock contention
+ *
+ *  @param  pxConfig  Configuration
+ *  @param  u32Nb     Number of tasks
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchRun (
+  const ef_bench_config_st  * pxConfig,
+  ef_u32_t                    u32Nb
+);
+
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
+/**
+ *  @brief  Thread entry of a task taking and giving back LFN working buffers, each buffer taken is filled with the
+ *          task number and checked before it is given back
+ *
+ *  @param  pvTask  Task
+ *
+ *  @return Always 0
+ */
+static void * pvBenchPoolThread (
+  void  * pvTask
+);
+
+/**
+ *  @brief  Run EF_BENCH_THREADS_MAX tasks on the LFN buffer pool together, then check that every buffer is back
+ *
+ *  @param  pxConfig  Configuration
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchPoolRun (
+  const ef_bench_config_st  * pxConfig
+);
+#endif
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static void vBenchPathGet (
+  char      * pcPath,
+  ef_u32_t    u32Index
+)
+{
+  (void) snprintf( pcPath, 32, "%s/T%07lu.DAT", EF_BENCH_VOLUME, (unsigned long) u32Index );
+}
+
+static ef_u32_t u32BenchRandom (
+  ef_u32_t  * pu32State
+)
+{
+  ef_u32_t  u32Value = *pu32State;
+
+  u32Value ^= u32Value << 13;
+  u32Value ^= u32Value >> 17;
+  u32Value ^= u32Value << 5;
+  *pu32State = u32Value;
+
+  return u32Value;
+}
+
+static void vBenchPatternFill (
+  ef_u32_t  * pu32Buffer,
+  ef_u32_t    u32Index,
+  ef_u32_t    u32Offset
+)
+{
+  for ( ef_u32_t u32Word = 0 ; u32Word < ( EF_BENCH_THREADS_IO / 4 ) ; u32Word++ )
+  {
+    pu32Buffer[ u32Word ] = ( u32Index << 28 ) ^ ( ( u32Offset / 4 ) + u32Word );
+  }
+}
+
+static ef_return_et eBenchFileWrite (
+  ef_bench_task_st  * pxTask
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  EF_FILE       xFile;
+  ef_u32_t      u32Buffer[ EF_BENCH_THREADS_IO / 4 ];
+  ef_u32_t      u32Done;
+  char          cPath[ 32 ];
+
+  vBenchPathGet( cPath, pxTask->u32Index );
+  EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_ANYWAY | EF_FILE_OPEN_TRUNCATE ) );
+  for ( ef_u32_t u32Offset = 0 ; u32Offset < pxTask->u32FileSize ; u32Offset += EF_BENCH_THREADS_IO )
+  {
+    vBenchPatternFill( u32Buffer, pxTask->u32Index, u32Offset );
+    EF_BENCH_CHECK( eEF_fwrite( &xFile, u32Buffer, EF_BENCH_THREADS_IO, &u32Done ) );
+  }
+  EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+
+  return eRetVal;
+}
+
+static ef_return_et eBenchTaskRun (
+  ef_bench_task_st  * pxTask
+)
+{
+  ef_return_et      eRetVal = EF_RET_OK;
+  EF_FILE           xFile;
+  ef_file_info_st   xInfo;
+  ef_u32_t          u32Buffer[ EF_BENCH_THREADS_IO / 4 ];
+  ef_u32_t          u32Expected[ EF_BENCH_THREADS_IO / 4 ];
+  ef_u32_t          u32Slots = pxTask->u32FileSize / EF_BENCH_THREADS_IO;
+  ef_u32_t          u32Done;
+  char              cPath[ 32 ];
+
+  vBenchPathGet( cPath, pxTask->u32Index );
+  EF_BENCH_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_EXISTING ) );
+  for ( ef_u32_t u32Op = 0 ; u32Op < pxTask->u32Ops ; u32Op++ )
+  {
+    ef_u32_t  u32Random = u32BenchRandom( &pxTask->u32Seed );
+
+    if ( 0 == ( u32Random % EF_BENCH_THREADS_STAT ) )
+    {
+      EF_BENCH_CHECK( eEF_stat( cPath, &xInfo ) );
+      if ( pxTask->u32FileSize != xInfo.u32FileSize )
+      {
+        pxTask->u32Mismatch++;
+      }
+    }
+    else
+    {
+      ef_u32_t  u32Offset = ( ( u32Random / EF_BENCH_THREADS_STAT ) % u32Slots ) * EF_BENCH_THREADS_IO;
+
+      EF_BENCH_CHECK( eEF_fseek( &xFile, u32Offset ) );
+      EF_BENCH_CHECK( eEF_fread( &xFile, u32Buffer, EF_BENCH_THREADS_IO, &u32Done ) );
+      vBenchPatternFill( u32Expected, pxTask->u32Index, u32Offset );
+      if (    ( EF_BENCH_THREADS_IO != u32Done )
+           || ( 0 != memcmp( u32Buffer, u32Expected, EF_BENCH_THREADS_IO ) ) )
+      {
+        pxTask->u32Mismatch++;
+      }
+    }
+  }
+  EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+
+  return eRetVal;
+}
+
+static void * pvBenchThread (
+  void  * pvTask
+)
+{
+  ef_bench_task_st  * pxTask = (ef_bench_task_st *) pvTask;
+
+  pxTask->eResult = eBenchTaskRun( pxTask );
+
+  return 0;
+}
+
+static ef_return_et eBenchRun (
+  const ef_bench_config_st  * pxConfig,
+  ef_u32_t                    u32Nb
+)
+{
+  ef_return_et          eRetVal = EF_RET_OK;
+  ef_bench_counters_st  xCounters;
+  ef_stats_st           xStatsStart;
+  ef_stats_st           xStatsEnd;
+  ef_return_et          eTasksResult = EF_RET_OK;
+  ef_u32_t              u32Mismatch = 0;
+  double                dStart;
+  double                dSeconds;
+
+  EF_BENCH_CHECK( eEFBenchVolumeCreate( pxConfig, 0, u32Nb * pxConfig->u32SizeMB + 1 ) );
+  for ( ef_u32_t u32Index = 0 ; u32Index < u32Nb ; u32Index++ )
+  {
+    xTasks[ u32Index ].u32Index     = u32Index;
+    xTasks[ u32Index ].u32Seed      = ( pxConfig->u32Seed ^ ( u32Index * 0x9E3779B9UL ) ) | 1;
+    xTasks[ u32Index ].u32FileSize  = pxConfig->u32SizeMB * 1024UL * 1024UL;
+    xTasks[ u32Index ].u32Ops       = pxConfig->u32Ops;
+    xTasks[ u32Index ].u32Mismatch  = 0;
+    xTasks[ u32Index ].eResult      = EF_RET_OK;
+    EF_BENCH_CHECK( eBenchFileWrite( &xTasks[ u32Index ] ) );
+  }
+
+  EF_BENCH_CHECK( eEF_stats_get( EF_BENCH_VOLUME, &xStatsStart ) );
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  for ( ef_u32_t u32Index = 0 ; u32Index < u32Nb ; u32Index++ )
+  {
+    if ( 0 != pthread_create( &xTasks[ u32Index ].xThread, 0, pvBenchThread, &xTasks[ u32Index ] ) )
+    {
+      printf( "FAILED: cannot start task %lu\n", (unsigned long) u32Index );
+      exit( 1 );
+    }
+  }
+  for ( ef_u32_t u32Index = 0 ; u32Index < u32Nb ; u32Index++ )
+  {
+    (void) pthread_join( xTasks[ u32Index ].xThread, 0 );
+    if ( EF_RET_OK == eTasksResult )
+    {
+      eTasksResult = xTasks[ u32Index ].eResult;
+    }
+    u32Mismatch += xTasks[ u32Index ].u32Mismatch;
+  }
+  dSeconds = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+  EF_BENCH_CHECK( eEF_stats_get( EF_BENCH_VOLUME, &xStatsEnd ) );
+
+  printf( "%-7lu %12.0f %10.1f %10.2f %10lu %10lu\n",
+          (unsigned long) u32Nb,
+          (double) ( u32Nb * pxConfig->u32Ops ) / dSeconds,
+          (double) ( u32Nb * pxConfig->u32Ops ) * EF_BENCH_THREADS_IO / ( dSeconds * 1024.0 * 1024.0 ),
+          (double) ( xStatsEnd.u32LockWaits - xStatsStart.u32LockWaits ) / ( u32Nb * pxConfig->u32Ops ),
+          (unsigned long) xCounters.u32ReadCmds,
+          (unsigned long) u32Mismatch );
+  if ( EF_RET_OK != eTasksResult )
+  {
+    printf( "FAILED: a task returned %d\n", (int) eTasksResult );
+    eRetVal = eTasksResult;
+  }
+  else if ( 0 != u32Mismatch )
+  {
+    printf( "FAILED: %lu reads returned wrong data\n", (unsigned long) u32Mismatch );
+    eRetVal = EF_RET_INT_ERR;
+  }
+  else
+  {
+    eRetVal = eEFBenchVolumeRelease( pxConfig );
+  }
+
+  return eRetVal;
+}
+
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
+static void * pvBenchPoolThread (
+  void  * pvTask
+)
+{
+  ef_bench_task_st  * pxTask = (ef_bench_task_st *) pvTask;
+  ucs2_t            * pxBuffer;
+  ef_return_et        eResult;
+
+  for ( ef_u32_t u32Op = 0 ; ( EF_RET_OK == pxTask->eResult ) && ( u32Op < pxTask->u32Ops ) ; u32Op++ )
+  {
+    eResult = eEFPrvLFNBufferTake( &pxBuffer );
+    if ( EF_RET_NOT_ENOUGH_CORE == eResult )
+    {
+      pxTask->u32Empty++;
+    }
+    else if ( EF_RET_OK != eResult )
+    {
+      pxTask->eResult = eResult;
+    }
+    else
+    {
+      /* Another task holding the same buffer overwrites the pattern */
+      for ( ef_u32_t u32Unit = 0 ; u32Unit <= EF_LFN_UNITS_MAX ; u32Unit++ )
+      {
+        pxBuffer[ u32Unit ] = (ucs2_t) ( pxTask->u32Index + 1 );
+      }
+      (void) sched_yield( );
+      for ( ef_u32_t u32Unit = 0 ; u32Unit <= EF_LFN_UNITS_MAX ; u32Unit++ )
+      {
+        if ( (ucs2_t) ( pxTask->u32Index + 1 ) != pxBuffer[ u32Unit ] )
+        {
+          pxTask->u32Mismatch++;
+        }
+      }
+      pxTask->eResult = eEFPrvLFNBufferRelease( pxBuffer );
+    }
+  }
+
+  return 0;
+}
+
+static ef_return_et eBenchPoolRun (
+  const ef_bench_config_st  * pxConfig
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_return_et  eTasksResult = EF_RET_OK;
+  ef_u32_t      u32Mismatch = 0;
+  ef_u32_t      u32Empty = 0;
+  ef_u32_t      u32Drained = 0;
+  ucs2_t      * pxBuffers[ EF_CONF_VFAT_BUFFER_POOL_NB ];
+
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_BENCH_THREADS_MAX ; u32Index++ )
+  {
+    xTasks[ u32Index ].u32Index     = u32Index;
+    xTasks[ u32Index ].u32Ops       = pxConfig->u32Ops;
+    xTasks[ u32Index ].u32Mismatch  = 0;
+    xTasks[ u32Index ].u32Empty     = 0;
+    xTasks[ u32Index ].eResult      = EF_RET_OK;
+    if ( 0 != pthread_create( &xTasks[ u32Index ].xThread, 0, pvBenchPoolThread, &xTasks[ u32Index ] ) )
+    {
+      printf( "FAILED: cannot start task %lu\n", (unsigned long) u32Index );
+      exit( 1 );
+    }
+  }
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_BENCH_THREADS_MAX ; u32Index++ )
+  {
+    (void) pthread_join( xTasks[ u32Index ].xThread, 0 );
+    if ( EF_RET_OK == eTasksResult )
+    {
+      eTasksResult = xTasks[ u32Index ].eResult;
+    }
+    u32Mismatch += xTasks[ u32Index ].u32Mismatch;
+    u32Empty += xTasks[ u32Index ].u32Empty;
+  }
+
+  /* Every buffer is given back: the pool gives all of them, then no more */
+  while (    ( EF_CONF_VFAT_BUFFER_POOL_NB > u32Drained )
+          && ( EF_RET_OK == eEFPrvLFNBufferTake( &pxBuffers[ u32Drained ] ) ) )
+  {
+    u32Drained++;
+  }
+  if (    ( EF_CONF_VFAT_BUFFER_POOL_NB == u32Drained )
+       && ( EF_RET_NOT_ENOUGH_CORE != eEFPrvLFNBufferTake( &pxBuffers[ 0 ] ) ) )
+  {
+    u32Drained++;
+  }
+  for ( ef_u32_t u32Index = 0 ; ( u32Index < u32Drained ) && ( u32Index < EF_CONF_VFAT_BUFFER_POOL_NB ) ; u32Index++ )
+  {
+    (void) eEFPrvLFNBufferRelease( pxBuffers[ u32Index ] );
+  }
+
+  printf( "LFN pool: %lu buffers, %lu tasks, %lu takes, %lu found empty, %lu mismatch\n",
+          (unsigned long) EF_CONF_VFAT_BUFFER_POOL_NB,
+          (unsigned long) EF_BENCH_THREADS_MAX,
+          (unsigned long) ( EF_BENCH_THREADS_MAX * pxConfig->u32Ops - u32Empty ),
+          (unsigned long) u32Empty,
+          (unsigned long) u32Mismatch );
+  if ( EF_RET_OK != eTasksResult )
+  {
+    printf( "FAILED: a task returned %d\n", (int) eTasksResult );
+    eRetVal = eTasksResult;
+  }
+  else if ( 0 != u32Mismatch )
+  {
+    printf( "FAILED: %lu buffer units overwritten by another task\n", (unsigned long) u32Mismatch );
+    eRetVal = EF_RET_INT_ERR;
+  }
+  else if ( EF_CONF_VFAT_BUFFER_POOL_NB != u32Drained )
+  {
+    printf( "FAILED: %lu buffers in the pool at the end\n", (unsigned long) u32Drained );
+    eRetVal = EF_RET_INT_ERR;
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+#endif
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  int     iArgc,
+  char ** ppcArgv
+)
+{
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_bench_config_st  xConfig = { EF_BENCH_BACKEND_RAM, 0, EF_BOOL_FALSE, EF_BENCH_SEED_DEFAULT, 1024UL, 1UL, 20000UL, 0UL, 0, 0UL };
+
+  if ( EF_RET_OK != eEFBenchArgsParse( iArgc, ppcArgv, &xConfig ) )
+  {
+    return 2;
+  }
+  vEFBenchConfigPrint( "ef_bench_threads", &xConfig );
+#if ( EF_DEF_VFAT_BUFFER_POOL == EF_CONF_VFAT_BUFFER )
+  /* The LFN buffer pool is taken without the volume lock */
+  if ( EF_RET_OK != eBenchPoolRun( &xConfig ) )
+  {
+    return 1;
+  }
+#endif
+  /* The tasks share the volume, they need its lock to wait for each other */
+  if ( ( 0 == EF_CONF_FS_LOCK ) || ( 0 == EF_CONF_PORT_PTHREAD ) )
+  {
+    printf( "skipped, the volume lock is disabled (EFAT_FS_LOCK=1 or 2 and EFAT_PTHREAD=ON are needed)\n" );
+    return 0;
+  }
+  if ( 0 == xConfig.u32SizeMB )
+  {
+    xConfig.u32SizeMB = 1UL;
+  }
+  EF_BENCH_CHECK( eEFBenchTraceStart( &xConfig ) );
+  EF_BENCH_CHECK( eEFBenchLatencyWatch( xConfig.u32SlowMs ) );
+
+  printf( "%-7s %12s %10s %10s %10s %10s\n", "tasks", "ops/s", "MB/s", "waits/op", "rd cmds", "mismatch" );
+  for ( ef_u32_t u32Test = 0 ; ( EF_RET_OK == eRetVal ) && ( u32Test < ( sizeof(u32TasksNb) / sizeof(u32TasksNb[ 0 ]) ) ) ; u32Test++ )
+  {
+    eRetVal = eBenchRun( &xConfig, u32TasksNb[ u32Test ] );
+  }
+  vEFBenchLatencyPrint( );
+  if ( EF_RET_OK == eRetVal )
+  {
+    eRetVal = eEFBenchTraceStop( );
+  }
+
+  return ( EF_RET_OK == eRetVal ) ? 0 : 1;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,283 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_bench_throughput.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host benchmark: sequential, random and mixed file throughput
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+
+#include <efat.h>
+#include <ef_prv_def.h>
+
+#include "ef_bench.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Largest transfer size
+ */
+#define EF_BENCH_TRANSFER_MAX     ( 1024UL * 1024UL )
+
+/**
+ *  Transfer size of the random workloads
+ */
+#define EF_BENCH_TRANSFER_RANDOM  ( 4096UL )
+
+/**
+ *  Share of reads in the mixed workload [%]
+ */
+#define EF_BENCH_MIXED_READS      ( 70UL )
+
+/**
+ *  Path of the benchmark file
+ */
+#define EF_BENCH_FILE             EF_BENCH_VOLUME "/BENCH.BIN"
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/**
+ *  @brief  Workloads measured
+ */
+typedef enum {
+  EF_BENCH_SEQ_WRITE = 0,   /**< Sequential write of a new file */
+  EF_BENCH_SEQ_READ,        /**< Sequential read of the file */
+  EF_BENCH_RAND_READ,       /**< Random aligned reads */
+  EF_BENCH_RAND_WRITE,      /**< Random aligned overwrites */
+  EF_BENCH_MIXED,           /**< Random aligned reads and overwrites */
+} ef_bench_workload_et;
+
+/* Local variables ------------------------------------------------------------------------------------------------- */
+static ef_u08_t   u8Buffer[ EF_BENCH_TRANSFER_MAX ];
+
+/**
+ *  Names of the workloads
+ */
+static const char * pcWorkloadNames[ ] = { "seq-write", "seq-read", "rand-read", "rand-write", "mixed-70/30" };
+
+/**
+ *  Transfer sizes of the sequential workloads
+ */
+static const ef_u32_t u32TransferSizes[ ] = { 512UL, 4096UL, 65536UL, EF_BENCH_TRANSFER_MAX };
+
+/**
+ *  Cluster sizes measured, 0:eEF_mkfs default (reported as 0)
+ */
+static const ef_u32_t u32ClusterSizes[ ] = { 0UL, 4096UL, 32768UL };
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Run a workload on the benchmark file and print its results
+ *
+ *  @param  pxConfig      Configuration
+ *  @param  u32Cluster    Cluster size of the volume [bytes]
+ *  @param  eWorkload     Workload
+ *  @param  u32Transfer   Transfer size [bytes]
+ *
+ *  @return Function completion
+ */
+static ef_return_et eBenchWorkloadRun (
+  const ef_bench_config_st  * pxConfig,
+  ef_u32_t                    u32Cluster,
+  ef_bench_workload_et        eWorkload,
+  ef_u32_t                    u32Transfer
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eBenchWorkloadRun (
+  const ef_bench_config_st  * pxConfig,
+  ef_u32_t                    u32Cluster,
+  ef_bench_workload_et        eWorkload,
+  ef_u32_t                    u32Transfer
+)
+{
+  ef_return_et          eRetVal;
+  ef_bench_counters_st  xCounters;
+  EF_FILE               xFile;
+  ef_u32_t              u32FileSize = pxConfig->u32SizeMB * 1024UL * 1024UL;
+  ef_u32_t              u32Ops;
+  ef_u32_t              u32Size;
+  ef_u64_t              u64Bytes = 0;
+  double                dStart;
+  double                dTime;
+
+  vEFBenchRandomSeed( pxConfig->u32Seed );
+  vEFBenchCountersReset( );
+  dStart = dEFBenchTimeGet( );
+  if ( EF_BENCH_SEQ_WRITE == eWorkload )
+  {
+    u32Ops = u32FileSize / u32Transfer;
+    EF_BENCH_CHECK( eEF_fopen( &xFile, EF_BENCH_FILE, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_ANYWAY | EF_FILE_OPEN_TRUNCATE ) );
+    for ( ef_u32_t u32Op = 0 ; u32Op < u32Ops ; u32Op++ )
+    {
+      EF_BENCH_CHECK( eEF_fwrite( &xFile, u8Buffer, u32Transfer, &u32Size ) );
+      u64Bytes += u32Size;
+    }
+  }
+  else if ( EF_BENCH_SEQ_READ == eWorkload )
+  {
+    u32Ops = u32FileSize / u32Transfer;
+    EF_BENCH_CHECK( eEF_fopen( &xFile, EF_BENCH_FILE, EF_FILE_OPEN_EXISTING ) );
+    for ( ef_u32_t u32Op = 0 ; u32Op < u32Ops ; u32Op++ )
+    {
+      EF_BENCH_CHECK( eEF_fread( &xFile, u8Buffer, u32Transfer, &u32Size ) );
+      u64Bytes += u32Size;
+    }
+  }
+  else
+  {
+    ef_u32_t  u32Slots = u32FileSize / u32Transfer;
+
+    u32Ops = pxConfig->u32Ops;
+    EF_BENCH_CHECK( eEF_fopen( &xFile, EF_BENCH_FILE, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_EXISTING ) );
+    for ( ef_u32_t u32Op = 0 ; u32Op < u32Ops ; u32Op++ )
+    {
+      ef_u32_t  u32Offset = ( u32EFBenchRandom( ) % u32Slots ) * u32Transfer;
+      ef_bool_t bRead = ( EF_BENCH_RAND_READ == eWorkload ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+
+      if ( EF_BENCH_MIXED == eWorkload )
+      {
+        bRead = ( ( u32EFBenchRandom( ) % 100UL ) < EF_BENCH_MIXED_READS ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+      }
+      EF_BENCH_CHECK( eEF_fseek( &xFile, u32Offset ) );
+      if ( EF_BOOL_FALSE != bRead )
+      {
+        EF_BENCH_CHECK( eEF_fread( &xFile, u8Buffer, u32Transfer, &u32Size ) );
+      }
+      else
+      {
+        EF_BENCH_CHECK( eEF_fwrite( &xFile, u8Buffer, u32Transfer, &u32Size ) );
+      }
+      u64Bytes += u32Size;
+    }
+  }
+  EF_BENCH_CHECK( eEF_fclose( &xFile ) );
+  dTime = dEFBenchTimeGet( ) - dStart;
+  vEFBenchCountersGet( &xCounters );
+
+  printf( "%-8lu %-12s %8lu %10.1f %12.0f %9lu %9lu %6lu %10.0f",
+          (unsigned long) u32Cluster,
+          pcWorkloadNames[ eWorkload ],
+          (unsigned long) u32Transfer,
+          ( (double) u64Bytes / ( 1024.0 * 1024.0 ) ) / dTime,
+          (double) u32Ops / dTime,
+          (unsigned long) xCounters.u32ReadCmds,
+          (unsigned long) xCounters.u32WriteCmds,
+          (unsigned long) xCounters.u32CtrlCmds,
+          (double) ( ( xCounters.u64SectorsRead + xCounters.u64SectorsWritten ) * EF_CONF_SECTOR_SIZE ) / u32Ops );
+  /* The flash backend also gives the speed of the simulated device and its write amplification */
+  if ( EF_BENCH_BACKEND_FLASH == pxConfig->eBackend )
+  {
+    printf( " %10.2f %6.2f",
+            ( 0 != xCounters.u64DeviceUs )
+            ? ( (double) u64Bytes / ( 1024.0 * 1024.0 ) ) / ( (double) xCounters.u64DeviceUs / 1e6 ) : 0.0,
+            ( 0 != xCounters.u64SectorsWritten )
+            ? (double) xCounters.u64SectorsProgrammed / (double) xCounters.u64SectorsWritten : 0.0 );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+  printf( "\n" );
+
+  return EF_RET_OK;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  int     iArgc,
+  char ** ppcArgv
+)
+{
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_bench_config_st  xConfig = { EF_BENCH_BACKEND_RAM, 0, EF_BOOL_FALSE, EF_BENCH_SEED_DEFAULT, 1024UL, 32UL, 20000UL, 0UL, 0, 0UL };
+
+  if ( EF_RET_OK != eEFBenchArgsParse( iArgc, ppcArgv, &xConfig ) )
+  {
+    return 2;
+  }
+  vEFBenchConfigPrint( "ef_bench_throughput", &xConfig );
+  EF_BENCH_CHECK( eEFBenchTraceStart( &xConfig ) );
+  EF_BENCH_CHECK( eEFBenchLatencyWatch( xConfig.u32SlowMs ) );
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_BENCH_TRANSFER_MAX ; u32Index++ )
+  {
+    u8Buffer[ u32Index ] = (ef_u08_t) u32Index;
+  }
+
+  printf( "%-8s %-12s %8s %10s %12s %9s %9s %6s %10s%s\n",
+          "cluster", "workload", "xfer", "MB/s", "ops/s", "rd-cmds", "wr-cmds", "ctl", "dev-B/op",
+          ( EF_BENCH_BACKEND_FLASH == xConfig.eBackend ) ? "   sim-MB/s     WA" : "" );
+  for ( ef_u32_t u32Test = 0 ; u32Test < ( sizeof(u32ClusterSizes) / sizeof(u32ClusterSizes[ 0 ]) ) ; u32Test++ )
+  {
+    ef_u32_t  u32Cluster = u32ClusterSizes[ u32Test ];
+
+    eRetVal = eEFBenchVolumeCreate( &xConfig, u32Cluster, xConfig.u32SizeMB );
+    if ( EF_RET_NOT_ENOUGH_CORE == eRetVal )
+    {
+      printf( "%-8lu skipped, the volume would exceed %lu MB (-d)\n",
+              (unsigned long) u32Cluster,
+              (unsigned long) xConfig.u32DiskMaxMB );
+      eRetVal = EF_RET_OK;
+      continue;
+    }
+    else if ( EF_RET_OK != eRetVal )
+    {
+      break;
+    }
+    for ( ef_u32_t u32Size = 0 ; u32Size < ( sizeof(u32TransferSizes) / sizeof(u32TransferSizes[ 0 ]) ) ; u32Size++ )
+    {
+      if (    ( EF_RET_OK != ( eRetVal = eBenchWorkloadRun( &xConfig, u32Cluster, EF_BENCH_SEQ_WRITE, u32TransferSizes[ u32Size ] ) ) )
+           || ( EF_RET_OK != ( eRetVal = eBenchWorkloadRun( &xConfig, u32Cluster, EF_BENCH_SEQ_READ, u32TransferSizes[ u32Size ] ) ) ) )
+      {
+        break;
+      }
+    }
+    for ( ef_bench_workload_et eWorkload = EF_BENCH_RAND_READ ; ( EF_RET_OK == eRetVal ) && ( eWorkload <= EF_BENCH_MIXED ) ; eWorkload++ )
+    {
+      eRetVal = eBenchWorkloadRun( &xConfig, u32Cluster, eWorkload, EF_BENCH_TRANSFER_RANDOM );
+    }
+    if ( EF_RET_OK != eRetVal )
+    {
+      break;
+    }
+    EF_BENCH_CHECK( eEFBenchVolumeRelease( &xConfig ) );
+  }
+  if ( EF_RET_OK == eRetVal )
+  {
+    vEFBenchLatencyPrint( );
+    eRetVal = eEFBenchTraceStop( );
+  }
+
+  return ( EF_RET_OK == eRetVal ) ? 0 : 1;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,433 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_example_check.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host example: damage the FAT of a RAM disk behind the volume, then check and repair it
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+
+#include <efat.h>
+#include <efat_level3.h>
+#include <ef_port_diskio.h>
+#include <ef_port_load_store.h>
+#include <ef_prv_def.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Number of sectors and format of the RAM disk, FAT32 needs at least 65526 clusters
+ */
+#if ( 0 != EF_CONF_FS_FAT16 )
+  #define EF_EXAMPLE_SECTORS_NB   ( ( 16UL * 1024UL * 1024UL ) / EF_CONF_SECTOR_SIZE )
+  #define EF_EXAMPLE_FORMAT       ( FM_FAT )
+#else
+  #define EF_EXAMPLE_SECTORS_NB   ( 70000UL )
+  #define EF_EXAMPLE_FORMAT       ( FM_FAT32 )
+#endif
+
+/**
+ *  Largest cluster size handled [bytes]
+ */
+#define EF_EXAMPLE_CLUSTER_MAX    ( 32768UL )
+
+/**
+ *  Size of the bitmap forcing a sliced check [bytes]
+ */
+#define EF_EXAMPLE_SLICE_SIZE     ( 64UL )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Stop the example on the first failed call
+ */
+#define EF_EXAMPLE_CHECK( call )                                                    \
+  if ( EF_RET_OK != ( eRetVal = ( call ) ) )                                        \
+  {                                                                                 \
+    printf( "FAILED: %s returned %d (line %d)\n", #call, (int) eRetVal, __LINE__ ); \
+    return 1;                                                                       \
+  }
+
+/**
+ *  Stop the example when a check report differs from the one expected
+ */
+#define EF_EXAMPLE_REPORT( pxCheck, u32Lost, u32Crossed, u32Broken, u32Sizes )      \
+  if ( 0 != iExampleReportCompare( ( pxCheck ), ( u32Lost ), ( u32Crossed ),        \
+                                   ( u32Broken ), ( u32Sizes ), __LINE__ ) )        \
+  {                                                                                 \
+    return 1;                                                                       \
+  }
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+
+/**
+ *  Layout of the volume read from its boot sector
+ */
+typedef struct ef_example_layout_struct {
+  ef_u08_t  * pu8Volume;      /**< First sector of the volume in the RAM disk */
+  ef_u32_t    u32VolumeBase;  /**< First sector of the volume on the drive */
+  ef_u32_t    u32SectorSize;  /**< Sector size [bytes] */
+  ef_u32_t    u32ClusterSize; /**< Cluster size [bytes] */
+  ef_u32_t    u32FatBase;     /**< First sector of the first FAT */
+  ef_u32_t    u32FatSize;     /**< Sectors of a FAT */
+  ef_u32_t    u32FatsNb;      /**< Number of FATs */
+  ef_u32_t    u32DataBase;    /**< First sector of the cluster 2 */
+  ef_u32_t    u32ClustersNb;  /**< Number of clusters */
+  ef_bool_t   bFat32;         /**< 32-bit FAT entries */
+} ef_example_layout_st;
+
+/* Local variables ------------------------------------------------------------------------------------------------- */
+static ef_u08_t               u8WorkBuffer[ 4 * EF_CONF_SECTOR_SIZE ];
+static ef_u08_t               u8WriteBuffer[ 3 * EF_EXAMPLE_CLUSTER_MAX ];
+static ef_u08_t               u8ReadBuffer[ 3 * EF_EXAMPLE_CLUSTER_MAX ];
+static ef_u08_t               u8Bitmap[ ( EF_EXAMPLE_SECTORS_NB + 7 ) / 8 ];
+static ef_example_layout_st   xLayout;
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Read the layout of the volume from the RAM disk
+ *
+ *  @return 0:Success, 1:the RAM disk holds no FAT volume
+ */
+static int iExampleLayoutRead (
+  void
+);
+
+/**
+ *  @brief  Write a FAT entry straight in the RAM disk, in every FAT
+ *
+ *  @param  u32Cluster  Cluster number
+ *  @param  u32Value    Value of the entry, 0xFFFFFFFF for an end of chain
+ */
+static void vExampleFATSet (
+  ef_u32_t  u32Cluster,
+  ef_u32_t  u32Value
+);
+
+/**
+ *  @brief  Get the first cluster of a file, its data being in a single run
+ *
+ *  @param  pcPath        Path of the file
+ *  @param  pu32Cluster   Pointer to the first cluster to update
+ *
+ *  @return Function completion
+ */
+static ef_return_et eExampleClusterGet (
+  const char  * pcPath,
+  ef_u32_t    * pu32Cluster
+);
+
+/**
+ *  @brief  Read a whole file and compare it with the start of the written data
+ *
+ *  @param  pcPath    Path of the file
+ *  @param  u32Size   Size the file is expected to have
+ *
+ *  @return 0:Success, 1:the file size or data differ
+ */
+static int iExampleFileCompare (
+  const char  * pcPath,
+  ef_u32_t      u32Size
+);
+
+/**
+ *  @brief  Compare a check report with the inconsistencies expected
+ *
+ *  @return 0:Success, 1:the report differs
+ */
+static int iExampleReportCompare (
+  const ef_check_st * pxCheck,
+  ef_u32_t            u32Lost,
+  ef_u32_t            u32Crossed,
+  ef_u32_t            u32Broken,
+  ef_u32_t            u32Sizes,
+  int                 iLine
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static int iExampleLayoutRead (
+  void
+)
+{
+  ef_u08_t  * pu8Disk = pu8EFPortDriveRAMMemoryGet( );
+  ef_u08_t  * pu8Boot;
+  ef_u32_t    u32SectorsNb;
+  ef_u32_t    u32RootSectors;
+
+  /* The volume is the first partition of the disk */
+  xLayout.u32VolumeBase = u32EFPortLoad( pu8Disk + 0x1C6 );
+  pu8Boot = pu8Disk + ( xLayout.u32VolumeBase * EF_CONF_SECTOR_SIZE );
+  xLayout.pu8Volume = pu8Boot;
+  xLayout.u32SectorSize = u16EFPortLoad( pu8Boot + 0x0B );
+  xLayout.u32ClusterSize = xLayout.u32SectorSize * pu8Boot[ 0x0D ];
+  xLayout.u32FatBase = u16EFPortLoad( pu8Boot + 0x0E );
+  xLayout.u32FatsNb = pu8Boot[ 0x10 ];
+  xLayout.u32FatSize = u16EFPortLoad( pu8Boot + 0x16 );
+  xLayout.bFat32 = ( 0 == xLayout.u32FatSize ) ? EF_BOOL_TRUE : EF_BOOL_FALSE;
+  if ( EF_BOOL_FALSE != xLayout.bFat32 )
+  {
+    xLayout.u32FatSize = u32EFPortLoad( pu8Boot + 0x24 );
+  }
+  u32SectorsNb = u16EFPortLoad( pu8Boot + 0x13 );
+  if ( 0 == u32SectorsNb )
+  {
+    u32SectorsNb = u32EFPortLoad( pu8Boot + 0x20 );
+  }
+  u32RootSectors = ( ( u16EFPortLoad( pu8Boot + 0x11 ) * 32 ) + xLayout.u32SectorSize - 1 ) / xLayout.u32SectorSize;
+  xLayout.u32DataBase = xLayout.u32FatBase + ( xLayout.u32FatsNb * xLayout.u32FatSize ) + u32RootSectors;
+  xLayout.u32ClustersNb = ( u32SectorsNb - xLayout.u32DataBase ) / pu8Boot[ 0x0D ];
+
+  return (    ( EF_CONF_SECTOR_SIZE != xLayout.u32SectorSize )
+           || ( 0 == xLayout.u32ClusterSize )
+           || ( EF_EXAMPLE_CLUSTER_MAX < xLayout.u32ClusterSize ) ) ? 1 : 0;
+}
+
+static void vExampleFATSet (
+  ef_u32_t  u32Cluster,
+  ef_u32_t  u32Value
+)
+{
+  for ( ef_u32_t u32Fat = 0 ; u32Fat < xLayout.u32FatsNb ; u32Fat++ )
+  {
+    ef_u08_t  * pu8Fat = xLayout.pu8Volume
+                       + ( ( xLayout.u32FatBase + ( u32Fat * xLayout.u32FatSize ) ) * xLayout.u32SectorSize );
+
+    if ( EF_BOOL_FALSE != xLayout.bFat32 )
+    {
+      vEFPortStoreu32( pu8Fat + ( u32Cluster * 4 ),
+                       ( 0xF0000000 & u32EFPortLoad( pu8Fat + ( u32Cluster * 4 ) ) ) | ( 0x0FFFFFFF & u32Value ) );
+    }
+    else
+    {
+      vEFPortStoreu16( pu8Fat + ( u32Cluster * 2 ), (ef_u16_t) u32Value );
+    }
+  }
+}
+
+static ef_return_et eExampleClusterGet (
+  const char  * pcPath,
+  ef_u32_t    * pu32Cluster
+)
+{
+  ef_return_et  eRetVal;
+  EF_FILE       xFile;
+  ef_extent_st  xExtent;
+  ef_u32_t      u32ExtentsNb;
+
+  if ( EF_RET_OK == ( eRetVal = eEF_fopen( &xFile, pcPath, EF_FILE_OPEN_EXISTING ) ) )
+  {
+    eRetVal = eEF_fextents( &xFile, &xExtent, 1, &u32ExtentsNb );
+    (void) eEF_fclose( &xFile );
+    /* The extents are counted from the start of the drive */
+    *pu32Cluster = 2 + ( ( (ef_u32_t) xExtent.xSector - xLayout.u32VolumeBase - xLayout.u32DataBase )
+                         / ( xLayout.u32ClusterSize / xLayout.u32SectorSize ) );
+  }
+
+  return eRetVal;
+}
+
+static int iExampleFileCompare (
+  const char  * pcPath,
+  ef_u32_t      u32Size
+)
+{
+  EF_FILE   xFile;
+  ef_u32_t  u32Read = 0;
+  int       iResult = 1;
+
+  if ( EF_RET_OK == eEF_fopen( &xFile, pcPath, EF_FILE_OPEN_EXISTING ) )
+  {
+    (void) memset( u8ReadBuffer, 0, sizeof(u8ReadBuffer) );
+    if (    ( EF_RET_OK == eEF_fread( &xFile, u8ReadBuffer, sizeof(u8ReadBuffer), &u32Read ) )
+         && ( u32Size == u32Read )
+         && ( 0 == memcmp( u8WriteBuffer, u8ReadBuffer, u32Size ) ) )
+    {
+      iResult = 0;
+    }
+    (void) eEF_fclose( &xFile );
+  }
+  if ( 0 != iResult )
+  {
+    printf( "FAILED: %s holds %lu bytes, %lu expected, or its data differs\n",
+            pcPath, (unsigned long) u32Read, (unsigned long) u32Size );
+  }
+
+  return iResult;
+}
+
+static int iExampleReportCompare (
+  const ef_check_st * pxCheck,
+  ef_u32_t            u32Lost,
+  ef_u32_t            u32Crossed,
+  ef_u32_t            u32Broken,
+  ef_u32_t            u32Sizes,
+  int                 iLine
+)
+{
+  int iResult = 0;
+
+  if (    ( u32Lost != pxCheck->u32LostNb )
+       || ( u32Crossed != pxCheck->u32CrossLinkedNb )
+       || ( u32Broken != pxCheck->u32BrokenNb )
+       || ( u32Sizes != pxCheck->u32SizeMismatchNb ) )
+  {
+    printf( "FAILED: check found %lu lost, %lu cross-linked, %lu broken, %lu size mismatches (line %d)\n",
+            (unsigned long) pxCheck->u32LostNb, (unsigned long) pxCheck->u32CrossLinkedNb,
+            (unsigned long) pxCheck->u32BrokenNb, (unsigned long) pxCheck->u32SizeMismatchNb, iLine );
+    iResult = 1;
+  }
+
+  return iResult;
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  void
+)
+{
+  ef_return_et      eRetVal;
+  ef_mkfs_param_st  xMkfsParam = { EF_EXAMPLE_FORMAT, 1, 0, 0, 0 };
+  EF_FILE           xFile;
+  ef_check_st       xCheck;
+  ef_u32_t          u32Size;
+  ef_u32_t          u32ClusterSize;
+  ef_u32_t          u32SizeFirst;
+  ef_u32_t          u32BrokenFirst;
+  ef_u32_t          u32CrossFirst;
+  ef_u32_t          u32OtherFirst;
+  ef_u32_t          u32ClusterFree;
+
+  for ( ef_u32_t u32Index = 0 ; u32Index < sizeof(u8WriteBuffer) ; u32Index++ )
+  {
+    u8WriteBuffer[ u32Index ] = (ef_u08_t) ( ( u32Index * 13 ) ^ ( u32Index >> 9 ) );
+  }
+
+  /* Format a RAM disk and read its layout */
+  EF_EXAMPLE_CHECK( eEFPortDriveRAMConfigure( 0, EF_EXAMPLE_SECTORS_NB, EF_CONF_SECTOR_SIZE, 8 ) );
+  EF_EXAMPLE_CHECK( eEF_drive_register( &xffDriveFunctionsRAM ) );
+  EF_EXAMPLE_CHECK( eEF_mkfs( "A:", &xMkfsParam, u8WorkBuffer, sizeof(u8WorkBuffer) ) );
+  if ( 0 != iExampleLayoutRead( ) )
+  {
+    printf( "FAILED: volume layout not read\n" );
+    return 1;
+  }
+  u32ClusterSize = xLayout.u32ClusterSize;
+
+  /* Create files of three and two clusters, each one in a single run */
+  EF_EXAMPLE_CHECK( eEF_mount( "A:", 0, 1, 0 ) );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/SIZE.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, 3 * u32ClusterSize, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/BROKEN.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, 3 * u32ClusterSize, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/CROSS.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, 2 * u32ClusterSize, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/OTHER.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, 2 * u32ClusterSize, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  EF_EXAMPLE_CHECK( eExampleClusterGet( "A:/SIZE.BIN", &u32SizeFirst ) );
+  EF_EXAMPLE_CHECK( eExampleClusterGet( "A:/BROKEN.BIN", &u32BrokenFirst ) );
+  EF_EXAMPLE_CHECK( eExampleClusterGet( "A:/CROSS.BIN", &u32CrossFirst ) );
+  EF_EXAMPLE_CHECK( eExampleClusterGet( "A:/OTHER.BIN", &u32OtherFirst ) );
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, sizeof(u8Bitmap), EF_BOOL_FALSE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 0, 0, 0, 0 );
+  EF_EXAMPLE_CHECK( eEF_umount( "A:" ) );
+
+  /* Behind the volume: SIZE.BIN gets a fourth cluster, BROKEN.BIN links to a free cluster after its first one,
+   * and the last cluster of the volume is allocated to nothing. Its third cluster is lost as well.
+   */
+  u32ClusterFree = xLayout.u32ClustersNb;
+  vExampleFATSet( u32SizeFirst + 2, u32ClusterFree );
+  vExampleFATSet( u32ClusterFree, 0xFFFFFFFF );
+  vExampleFATSet( u32BrokenFirst + 1, 0 );
+  vExampleFATSet( u32ClusterFree + 1, 0xFFFFFFFF );
+  EF_EXAMPLE_CHECK( eEF_mount( "A:", 0, 1, 0 ) );
+
+  /* The damages are reported the same way whatever the bitmap size */
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, sizeof(u8Bitmap), EF_BOOL_FALSE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 2, 0, 1, 2 );
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, EF_EXAMPLE_SLICE_SIZE, EF_BOOL_FALSE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 2, 0, 1, 2 );
+  if ( 1 >= xCheck.u32PassesNb )
+  {
+    printf( "FAILED: sliced check made in %lu passes\n", (unsigned long) xCheck.u32PassesNb );
+    return 1;
+  }
+
+  /* With no cross-link, everything is repaired: SIZE.BIN loses its extra cluster, BROKEN.BIN keeps two */
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, sizeof(u8Bitmap), EF_BOOL_TRUE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 2, 0, 1, 2 );
+  if ( 0 == xCheck.u32RepairedNb )
+  {
+    printf( "FAILED: nothing repaired\n" );
+    return 1;
+  }
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, sizeof(u8Bitmap), EF_BOOL_FALSE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 0, 0, 0, 0 );
+  if ( EF_BOOL_FALSE != xCheck.bFreeNbMismatch )
+  {
+    printf( "FAILED: free cluster count not repaired\n" );
+    return 1;
+  }
+  if (    ( 0 != iExampleFileCompare( "A:/SIZE.BIN", 3 * u32ClusterSize ) )
+       || ( 0 != iExampleFileCompare( "A:/BROKEN.BIN", 2 * u32ClusterSize ) ) )
+  {
+    return 1;
+  }
+  EF_EXAMPLE_CHECK( eEF_umount( "A:" ) );
+
+  /* Behind the volume: CROSS.BIN runs into OTHER.BIN, which is walked after it */
+  vExampleFATSet( u32CrossFirst + 1, u32OtherFirst );
+  vExampleFATSet( u32ClusterFree + 1, 0xFFFFFFFF );
+  EF_EXAMPLE_CHECK( eEF_mount( "A:", 0, 1, 0 ) );
+
+  /* On a sliced check too, the cross-linked chain is only reported: fitting CROSS.BIN to its size would free
+   * OTHER.BIN. The lost cluster is still freed.
+   */
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, EF_EXAMPLE_SLICE_SIZE, EF_BOOL_TRUE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 1, 1, 0, 1 );
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, sizeof(u8Bitmap), EF_BOOL_FALSE, &xCheck ) );
+  EF_EXAMPLE_REPORT( &xCheck, 0, 1, 0, 1 );
+  if (    ( 0 != iExampleFileCompare( "A:/CROSS.BIN", 2 * u32ClusterSize ) )
+       || ( 0 != iExampleFileCompare( "A:/OTHER.BIN", 2 * u32ClusterSize ) ) )
+  {
+    return 1;
+  }
+  EF_EXAMPLE_CHECK( eEF_umount( "A:" ) );
+
+  printf( "eFAT check example passed, %lu clusters of %lu bytes\n",
+          (unsigned long) xLayout.u32ClustersNb, (unsigned long) u32ClusterSize );
+  return 0;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
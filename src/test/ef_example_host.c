@@ -0,0 +1,281 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_example_host.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host example: format, mount and exercise a RAM disk through the public API
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+
+#include <efat.h>
+#include <efat_level3.h>
+#include <ef_port_diskio.h>
+#include <ef_prv_def.h>
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Number of sectors and format of the RAM disk, FAT32 needs at least 65526 clusters
+ */
+#if ( 0 != EF_CONF_FS_FAT16 )
+  #define EF_EXAMPLE_SECTORS_NB   ( ( 16UL * 1024UL * 1024UL ) / EF_CONF_SECTOR_SIZE )
+  #define EF_EXAMPLE_FORMAT       ( FM_FAT )
+#else
+  #define EF_EXAMPLE_SECTORS_NB   ( 70000UL )
+  #define EF_EXAMPLE_FORMAT       ( FM_FAT32 )
+#endif
+
+/**
+ *  Size of the test file
+ */
+#define EF_EXAMPLE_FILE_SIZE      ( 100000UL )
+
+/**
+ *  Number of files created in the sub-directory
+ */
+#define EF_EXAMPLE_FILES_NB       ( 64UL )
+
+/**
+ *  Size of the chunks the fragmented files are written with [bytes]
+ */
+#define EF_EXAMPLE_CHUNK_SIZE     ( EF_CONF_SECTOR_SIZE )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Stop the example on the first failed call
+ */
+#define EF_EXAMPLE_CHECK( call )                                                    \
+  if ( EF_RET_OK != ( eRetVal = ( call ) ) )                                        \
+  {                                                                                 \
+    printf( "FAILED: %s returned %d (line %d)\n", #call, (int) eRetVal, __LINE__ ); \
+    return 1;                                                                       \
+  }
+
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+static ef_u08_t   u8WorkBuffer[ 4 * EF_CONF_SECTOR_SIZE ];
+static ef_u08_t   u8WriteBuffer[ EF_EXAMPLE_FILE_SIZE ];
+static ef_u08_t   u8ReadBuffer[ EF_EXAMPLE_FILE_SIZE ];
+static ef_u08_t   u8Bitmap[ ( EF_EXAMPLE_SECTORS_NB + 7 ) / 8 ];
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+/* Local functions ------------------------------------------------------------------------------------------------- */
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  void
+)
+{
+  ef_return_et      eRetVal;
+  ef_mkfs_param_st  xMkfsParam = { EF_EXAMPLE_FORMAT, 1, 0, 0, 0 };
+  EF_FILE           xFile;
+  EF_DIR            xDir;
+  ef_file_info_st   xFileInfo;
+  ef_stats_st       xStats;
+  ef_u32_t          u32Size;
+  ef_u32_t          u32FilesNb;
+  char              cPath[ 32 ];
+  ef_drive_caps_st  xCaps;
+  ef_extent_st      xExtents[ 4 ];
+  EF_FILE           xOther;
+  ef_defrag_st      xDefrag;
+  ef_bool_t         bDone;
+  ef_check_st       xCheck;
+
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_EXAMPLE_FILE_SIZE ; u32Index++ )
+  {
+    u8WriteBuffer[ u32Index ] = (ef_u08_t) ( ( u32Index * 31 ) ^ ( u32Index >> 8 ) );
+  }
+
+  /* Format a RAM disk and mount its first partition */
+  EF_EXAMPLE_CHECK( eEFPortDriveRAMConfigure( 0, EF_EXAMPLE_SECTORS_NB, EF_CONF_SECTOR_SIZE, 8 ) );
+  EF_EXAMPLE_CHECK( eEF_drive_register( &xffDriveFunctionsRAM ) );
+  EF_EXAMPLE_CHECK( eEF_mkfs( "A:", &xMkfsParam, u8WorkBuffer, sizeof(u8WorkBuffer) ) );
+  EF_EXAMPLE_CHECK( eEF_mount( "A:", 0, 1, 0 ) );
+
+  /* The RAM disk reports its capabilities on initialization */
+  EF_EXAMPLE_CHECK( eEF_drive_caps_get( 0, &xCaps ) );
+  if ( 0 == ( EF_DRIVE_CAP_WRITE_ZEROES & xCaps.u32Features ) )
+  {
+    printf( "FAILED: RAM disk capabilities not read\n" );
+    return 1;
+  }
+
+  /* Write a file and read it back */
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/DATA.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_ANYWAY ) );
+  EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, EF_EXAMPLE_FILE_SIZE, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/DATA.BIN", EF_FILE_OPEN_EXISTING ) );
+  EF_EXAMPLE_CHECK( eEF_fread( &xFile, u8ReadBuffer, EF_EXAMPLE_FILE_SIZE, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  if (    ( EF_EXAMPLE_FILE_SIZE != u32Size )
+       || ( 0 != memcmp( u8WriteBuffer, u8ReadBuffer, EF_EXAMPLE_FILE_SIZE ) ) )
+  {
+    printf( "FAILED: read back data differs\n" );
+    return 1;
+  }
+
+  /* Fill a sub-directory over several clusters and list it */
+  EF_EXAMPLE_CHECK( eEF_dirmake( "A:/SUB" ) );
+  for ( ef_u32_t u32Index = 0 ; u32Index < EF_EXAMPLE_FILES_NB ; u32Index++ )
+  {
+    (void) snprintf( cPath, sizeof(cPath), "A:/SUB/F%lu.DAT", (unsigned long) u32Index );
+    EF_EXAMPLE_CHECK( eEF_fopen( &xFile, cPath, EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+    EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, 100 + u32Index, &u32Size ) );
+    EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  }
+  u32FilesNb = 0;
+  EF_EXAMPLE_CHECK( eEF_diropen( &xDir, "A:/SUB" ) );
+  for ( ;; )
+  {
+    EF_EXAMPLE_CHECK( eEF_dirread( &xDir, &xFileInfo ) );
+    if ( 0 == xFileInfo.xName[ 0 ] )
+    {
+      break;
+    }
+    u32FilesNb++;
+  }
+  EF_EXAMPLE_CHECK( eEF_dirclose( &xDir ) );
+  if ( EF_EXAMPLE_FILES_NB != u32FilesNb )
+  {
+    printf( "FAILED: %lu entries listed\n", (unsigned long) u32FilesNb );
+    return 1;
+  }
+
+  /* Preallocate a contiguous file among the holes left by removed files, then fill it */
+  for ( ef_u32_t u32Index = 2 ; u32Index < EF_EXAMPLE_FILES_NB ; u32Index += 4 )
+  {
+    (void) snprintf( cPath, sizeof(cPath), "A:/SUB/F%lu.DAT", (unsigned long) u32Index );
+    EF_EXAMPLE_CHECK( eEF_remove( cPath ) );
+  }
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/CONTIG.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_EXAMPLE_CHECK( eEF_expand( &xFile, EF_EXAMPLE_FILE_SIZE, 1 ) );
+  EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer, EF_EXAMPLE_FILE_SIZE, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fextents( &xFile, xExtents, 4, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  if ( 1 != u32Size )
+  {
+    printf( "FAILED: preallocated file in %lu runs\n", (unsigned long) u32Size );
+    return 1;
+  }
+
+  /* Append two files in turn by small chunks: their clusters interleave, in runs of a staging buffer at least
+   * with the delayed allocation */
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/FRAG1.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xOther, "A:/FRAG2.BIN", EF_FILE_OPEN_WRITE | EF_FILE_OPEN_NEW ) );
+  for ( ef_u32_t u32Offset = 0 ; u32Offset < EF_EXAMPLE_FILE_SIZE ; u32Offset += EF_EXAMPLE_CHUNK_SIZE )
+  {
+    ef_u32_t  u32Chunk = ( EF_EXAMPLE_CHUNK_SIZE < ( EF_EXAMPLE_FILE_SIZE - u32Offset ) )
+                       ? EF_EXAMPLE_CHUNK_SIZE : ( EF_EXAMPLE_FILE_SIZE - u32Offset );
+
+    EF_EXAMPLE_CHECK( eEF_fwrite( &xFile, u8WriteBuffer + u32Offset, u32Chunk, &u32Size ) );
+    EF_EXAMPLE_CHECK( eEF_fwrite( &xOther, u8WriteBuffer + u32Offset, u32Chunk, &u32Size ) );
+  }
+  EF_EXAMPLE_CHECK( eEF_fextents( &xFile, xExtents, 4, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xOther ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  if (    ( 1 == u32Size )
+       || (    ( 0 != EF_CONF_DELAYED_ALLOC )
+            && ( ( ( EF_EXAMPLE_FILE_SIZE / ( EF_CONF_DELAYED_ALLOC * EF_CONF_SECTOR_SIZE ) ) + 1 ) < u32Size ) ) )
+  {
+    printf( "FAILED: interleaved file in %lu runs\n", (unsigned long) u32Size );
+    return 1;
+  }
+
+  /* Relocate the fragmented files, one explicitly and the others by an incremental pass, then read one back */
+  EF_EXAMPLE_CHECK( eEF_defrag_file( "A:/FRAG1.BIN" ) );
+  (void) memset( &xDefrag, 0, sizeof(xDefrag) );
+  do
+  {
+    EF_EXAMPLE_CHECK( eEF_defrag_volume( "A:", &xDefrag, 64, &bDone ) );
+  } while ( EF_BOOL_FALSE == bDone );
+  EF_EXAMPLE_CHECK( eEF_fopen( &xFile, "A:/FRAG2.BIN", EF_FILE_OPEN_EXISTING ) );
+  EF_EXAMPLE_CHECK( eEF_fextents( &xFile, xExtents, 4, &u32FilesNb ) );
+  EF_EXAMPLE_CHECK( eEF_fread( &xFile, u8ReadBuffer, EF_EXAMPLE_FILE_SIZE, &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_fclose( &xFile ) );
+  if (    ( 1 != u32FilesNb )
+       || ( EF_EXAMPLE_FILE_SIZE != u32Size )
+       || ( 0 != memcmp( u8WriteBuffer, u8ReadBuffer, EF_EXAMPLE_FILE_SIZE ) ) )
+  {
+    printf( "FAILED: defragmented file in %lu runs or data differs\n", (unsigned long) u32FilesNb );
+    return 1;
+  }
+
+  /* The volume counters follow the work done */
+  EF_EXAMPLE_CHECK( eEF_stats_get( "A:", &xStats ) );
+  if (    ( 0 != EF_CONF_STATS )
+       && (    ( 0 == xStats.u32WindowHits )
+            || ( ( EF_EXAMPLE_FILES_NB + 2 ) > xStats.u32ClustersAllocated ) ) )
+  {
+    printf( "FAILED: statistics not counted\n" );
+    return 1;
+  }
+
+  /* Rename, remove, and check everything survives a remount */
+  EF_EXAMPLE_CHECK( eEF_rename( "A:/SUB/F7.DAT", "A:/MOVED.DAT" ) );
+  EF_EXAMPLE_CHECK( eEF_remove( "A:/SUB/F8.DAT" ) );
+  EF_EXAMPLE_CHECK( eEF_umount( "A:" ) );
+  EF_EXAMPLE_CHECK( eEF_mount( "A:", 0, 1, 0 ) );
+  EF_EXAMPLE_CHECK( eEF_stat( "A:/MOVED.DAT", &xFileInfo ) );
+  if ( 107 != xFileInfo.u32FileSize )
+  {
+    printf( "FAILED: renamed file size %lu\n", (unsigned long) xFileInfo.u32FileSize );
+    return 1;
+  }
+  if ( EF_RET_OK == eEF_stat( "A:/SUB/F8.DAT", &xFileInfo ) )
+  {
+    printf( "FAILED: removed file still exists\n" );
+    return 1;
+  }
+
+  /* The FAT matches the chains of the files and directories */
+  EF_EXAMPLE_CHECK( eEF_check( "A:", u8Bitmap, sizeof(u8Bitmap), EF_BOOL_FALSE, &xCheck ) );
+  if (    ( 0 != xCheck.u32LostNb )
+       || ( 0 != xCheck.u32CrossLinkedNb )
+       || ( 0 != xCheck.u32BrokenNb )
+       || ( 0 != xCheck.u32SizeMismatchNb )
+       || ( EF_BOOL_FALSE != xCheck.bFreeNbMismatch ) )
+  {
+    printf( "FAILED: check found %lu lost, %lu cross-linked, %lu broken, %lu size mismatches\n",
+            (unsigned long) xCheck.u32LostNb, (unsigned long) xCheck.u32CrossLinkedNb,
+            (unsigned long) xCheck.u32BrokenNb, (unsigned long) xCheck.u32SizeMismatchNb );
+    return 1;
+  }
+  EF_EXAMPLE_CHECK( eEF_getfree( "A:", &u32Size ) );
+  EF_EXAMPLE_CHECK( eEF_stats_get( "A:", &xStats ) );
+  EF_EXAMPLE_CHECK( eEF_umount( "A:" ) );
+
+  printf( "eFAT host example passed, %lu free clusters\n", (unsigned long) u32Size );
+  printf( "  drive: %lu reads, %lu writes, window: %lu hits, %lu misses\n",
+          (unsigned long) xStats.u32ReadCmds, (unsigned long) xStats.u32WriteCmds,
+          (unsigned long) xStats.u32WindowHits, (unsigned long) xStats.u32WindowMisses );
+  return 0;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */
@@ -0,0 +1,609 @@
+/**
+ * ********************************************************************************************************************
+ *  @file     ef_trace_replay.c
+ *  @ingroup  group_eFAT_Test
+ *  @author   ChaN
+ *  @author   Emmanuel AMADIO
+ *  @version  V0.1
+ *  @brief    Host tool: analyse a drive command trace and replay it against a backend
+ *
+ * ********************************************************************************************************************
+ *  eFAT - embedded FAT Filesystem module
+ * ********************************************************************************************************************
+ *
+ *  Copyright (C) 2021, Amadio Emmanuel, all right reserved.
+ *  Copyright (C) 2019, ChaN, all right reserved.
+ *
+ *  eFAT module is an open source software. Redistribution and use of eFAT in source and binary forms, with or without
+ *  modification, are permitted provided that the following condition is met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this condition and the following disclaimer.
+ *
+ *  This software is provided by the copyright holders and contributors "AS IS" and any warranties related to this
+ *  software are DISCLAIMED.
+ *  The copyright owners or contributors be NOT LIABLE for any damages caused by use of this software.
+ * ********************************************************************************************************************
+ */
+
+/* START OF FILE *************************************************************************************************** */
+/* ***************************************************************************************************************** */
+
+/* Includes -------------------------------------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <efat.h>
+#include <ef_port_diskio.h>
+#include <ef_prv_def.h>
+
+#include "ef_bench.h"
+
+/* Local constant macros ------------------------------------------------------------------------------------------- */
+/**
+ *  Buckets of the request size histogram, bucket N counts the requests of 2^(N-1) to 2^N - 1 sectors
+ */
+#define EF_REPLAY_SIZES_NB        ( 16UL )
+
+/**
+ *  Number of hot sectors printed
+ */
+#define EF_REPLAY_HOT_NB          ( 10UL )
+
+/**
+ *  Number of physical drives told apart by the sequential detection
+ */
+#define EF_REPLAY_DRIVES_NB       ( 256UL )
+
+/* Local function macros ------------------------------------------------------------------------------------------- */
+/* Local typedefs, structures, unions and enums -------------------------------------------------------------------- */
+/* Local variables ------------------------------------------------------------------------------------------------- */
+/**
+ *  Names of the drive commands, indexed by ef_trace_op_et
+ */
+static const char           * pcReplayOpNames[ ] = { "read", "write", "trim", "sync" };
+
+/**
+ *  Header and records of the trace
+ */
+static ef_bench_trace_header_st xReplayHeader;
+static ef_trace_record_st     * pxReplayRecords = 0;
+static ef_u32_t                 u32ReplayRecordsNb = 0;
+
+/* Public variables ------------------------------------------------------------------------------------------------ */
+/* Local function prototypes---------------------------------------------------------------------------------------- */
+
+/**
+ *  @brief  Load the trace file
+ *
+ *  @param  pcPath  Path of the trace file
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK             Succeeded
+ *  @retval EF_RET_NO_FILE        The file could not be opened
+ *  @retval EF_RET_INVALID_OBJECT The file is not a trace of this build
+ *  @retval EF_RET_NOT_ENOUGH_CORE No memory for the records
+ */
+static ef_return_et eReplayLoad (
+  const char  * pcPath
+);
+
+/**
+ *  @brief  Print the command mix, request sizes, sequentiality and origins of the trace
+ */
+static void vReplayAnalyse (
+  void
+);
+
+/**
+ *  @brief  Print the most accessed first sectors of the read and write commands
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK               Succeeded
+ *  @retval EF_RET_NOT_ENOUGH_CORE  No memory to sort the sectors
+ */
+static ef_return_et eReplayHotPrint (
+  void
+);
+
+/**
+ *  @brief  Send the commands of the trace to the backend of the configuration, as fast as possible
+ *
+ *  @param  pxConfig  Configuration, backend and disk size limit
+ *
+ *  @return Function completion
+ *  @retval EF_RET_OK               Succeeded
+ *  @retval EF_RET_NOT_ENOUGH_CORE  The disk would be larger than u32DiskMaxMB
+ */
+static ef_return_et eReplayRun (
+  const ef_bench_config_st  * pxConfig
+);
+
+/**
+ *  @brief  Print the simulated time and the flash operations of the replay on the flash backend
+ *
+ *  @param  pxModel   Model of the simulated device
+ */
+static void vReplayFlashPrint (
+  const ef_port_flash_config_st * pxModel
+);
+
+/**
+ *  @brief  Compare two sectors for qsort()
+ */
+static int iReplaySectorCompare (
+  const void  * pvA,
+  const void  * pvB
+);
+
+/* Local functions ------------------------------------------------------------------------------------------------- */
+
+static ef_return_et eReplayLoad (
+  const char  * pcPath
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  FILE        * pxFile = fopen( pcPath, "rb" );
+  long          lSize;
+
+  if ( 0 == pxFile )
+  {
+    printf( "cannot open the trace file %s\n", pcPath );
+    eRetVal = EF_RET_NO_FILE;
+  }
+  else if (    ( 1 != fread( &xReplayHeader, sizeof(xReplayHeader), 1, pxFile ) )
+            || ( EF_BENCH_TRACE_MAGIC != xReplayHeader.u32Magic )
+            || ( EF_BENCH_TRACE_VERSION != xReplayHeader.u32Version )
+            || ( sizeof(ef_trace_record_st) != xReplayHeader.u32RecordSize )
+            || ( 0 == xReplayHeader.u32TickHz ) )
+  {
+    printf( "%s is not a drive command trace of this build\n", pcPath );
+    eRetVal = EF_RET_INVALID_OBJECT;
+  }
+  else if (    ( 0 != fseek( pxFile, 0, SEEK_END ) )
+            || ( 0 > ( lSize = ftell( pxFile ) ) )
+            || ( 0 != fseek( pxFile, (long) sizeof(xReplayHeader), SEEK_SET ) ) )
+  {
+    eRetVal = EF_RET_DISK_ERR;
+  }
+  else
+  {
+    u32ReplayRecordsNb = (ef_u32_t) ( ( (unsigned long) lSize - sizeof(xReplayHeader) ) / sizeof(ef_trace_record_st) );
+    pxReplayRecords = (ef_trace_record_st *) malloc( ( (size_t) u32ReplayRecordsNb + 1 ) * sizeof(ef_trace_record_st) );
+    if ( 0 == pxReplayRecords )
+    {
+      eRetVal = EF_RET_NOT_ENOUGH_CORE;
+    }
+    else if ( u32ReplayRecordsNb != fread( pxReplayRecords, sizeof(ef_trace_record_st), u32ReplayRecordsNb, pxFile ) )
+    {
+      eRetVal = EF_RET_DISK_ERR;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+  if ( 0 != pxFile )
+  {
+    (void) fclose( pxFile );
+  }
+  else
+  {
+    EF_CODE_COVERAGE( );
+  }
+
+  return eRetVal;
+}
+
+static void vReplayAnalyse (
+  void
+)
+{
+  ef_u32_t  u32OpCmds[ EF_TRACE_SYNC + 1 ] = { 0 };
+  ef_u64_t  u64OpSectors[ EF_TRACE_SYNC + 1 ] = { 0 };
+  ef_u32_t  u32Sizes[ EF_TRACE_WRITE + 1 ][ EF_REPLAY_SIZES_NB ];
+  ef_u32_t  u32OriginCmds[ EF_LATENCY_OP_NB + 1 ] = { 0 };
+  ef_u64_t  u64OriginSectors[ EF_LATENCY_OP_NB + 1 ] = { 0 };
+  ef_u64_t  u64LastEnd[ EF_REPLAY_DRIVES_NB ];
+  ef_u32_t  u32Sequential = 0;
+  ef_u32_t  u32ErrorsNb = 0;
+  ef_u64_t  u64Ticks = 0;
+
+  (void) memset( u32Sizes, 0, sizeof(u32Sizes) );
+  (void) memset( u64LastEnd, 0xFF, sizeof(u64LastEnd) );
+  for ( ef_u32_t u32Index = 0 ; u32Index < u32ReplayRecordsNb ; u32Index++ )
+  {
+    const ef_trace_record_st  * pxRecord = &pxReplayRecords[ u32Index ];
+    ef_u32_t                    u32Op = ( pxRecord->u8Operation <= EF_TRACE_SYNC ) ? pxRecord->u8Operation : EF_TRACE_SYNC;
+    ef_u32_t                    u32Origin = ( pxRecord->u8Origin < EF_LATENCY_OP_NB ) ? pxRecord->u8Origin : EF_LATENCY_OP_NB;
+
+    u32OpCmds[ u32Op ]++;
+    u64OpSectors[ u32Op ] += pxRecord->u32Count;
+    u32OriginCmds[ u32Origin ]++;
+    u64OriginSectors[ u32Origin ] += pxRecord->u32Count;
+    if ( EF_RET_OK != pxRecord->u8Result )
+    {
+      u32ErrorsNb++;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    /* The timestamps wrap, the deltas do not */
+    if ( 0 != u32Index )
+    {
+      u64Ticks += (ef_u32_t) ( pxRecord->u32Timestamp - pxReplayRecords[ u32Index - 1 ].u32Timestamp );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    if ( u32Op <= EF_TRACE_WRITE )
+    {
+      ef_u32_t  u32Bucket = 0;
+
+      for ( ef_u32_t u32Count = pxRecord->u32Count ; 0 != u32Count ; u32Count >>= 1 )
+      {
+        u32Bucket++;
+      }
+      if ( u32Bucket >= EF_REPLAY_SIZES_NB )
+      {
+        u32Bucket = EF_REPLAY_SIZES_NB - 1;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      u32Sizes[ u32Op ][ u32Bucket ]++;
+      if ( pxRecord->u64Sector == u64LastEnd[ pxRecord->u8Drive ] )
+      {
+        u32Sequential++;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+      u64LastEnd[ pxRecord->u8Drive ] = pxRecord->u64Sector + pxRecord->u32Count;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  printf( "%lu commands over %.3f s, %lu failed, %lu lost while tracing, %lu bytes per sector\n",
+          (unsigned long) u32ReplayRecordsNb,
+          (double) u64Ticks / (double) xReplayHeader.u32TickHz,
+          (unsigned long) u32ErrorsNb,
+          (unsigned long) xReplayHeader.u32LostNb,
+          (unsigned long) xReplayHeader.u32SectorSize );
+
+  printf( "\n%-8s %10s %14s %12s\n", "command", "cmds", "sectors", "sectors/cmd" );
+  for ( ef_u32_t u32Op = EF_TRACE_READ ; u32Op <= EF_TRACE_SYNC ; u32Op++ )
+  {
+    printf( "%-8s %10lu %14llu %12.1f\n",
+            pcReplayOpNames[ u32Op ],
+            (unsigned long) u32OpCmds[ u32Op ],
+            (unsigned long long) u64OpSectors[ u32Op ],
+            ( 0 != u32OpCmds[ u32Op ] ) ? (double) u64OpSectors[ u32Op ] / (double) u32OpCmds[ u32Op ] : 0.0 );
+  }
+  printf( "sequential: %.1f %% of the read and write commands start where the previous one ended\n",
+          ( 0 != ( u32OpCmds[ EF_TRACE_READ ] + u32OpCmds[ EF_TRACE_WRITE ] ) )
+          ? ( 100.0 * u32Sequential ) / (double) ( u32OpCmds[ EF_TRACE_READ ] + u32OpCmds[ EF_TRACE_WRITE ] )
+          : 0.0 );
+
+  printf( "\n%-12s %10s %10s\n", "sectors", "reads", "writes" );
+  for ( ef_u32_t u32Bucket = 1 ; u32Bucket < EF_REPLAY_SIZES_NB ; u32Bucket++ )
+  {
+    if ( 0 != ( u32Sizes[ EF_TRACE_READ ][ u32Bucket ] + u32Sizes[ EF_TRACE_WRITE ][ u32Bucket ] ) )
+    {
+      printf( "%5lu-%-6lu %10lu %10lu\n",
+              1UL << ( u32Bucket - 1 ),
+              ( 1UL << u32Bucket ) - 1,
+              (unsigned long) u32Sizes[ EF_TRACE_READ ][ u32Bucket ],
+              (unsigned long) u32Sizes[ EF_TRACE_WRITE ][ u32Bucket ] );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  printf( "\n%-10s %10s %14s\n", "origin", "cmds", "sectors" );
+  for ( ef_u32_t u32Origin = 0 ; u32Origin <= EF_LATENCY_OP_NB ; u32Origin++ )
+  {
+    if ( 0 != u32OriginCmds[ u32Origin ] )
+    {
+      printf( "%-10s %10lu %14llu\n",
+              pcEFBenchLatencyName( (ef_latency_op_et) u32Origin ),
+              (unsigned long) u32OriginCmds[ u32Origin ],
+              (unsigned long long) u64OriginSectors[ u32Origin ] );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+}
+
+static ef_return_et eReplayHotPrint (
+  void
+)
+{
+  ef_return_et  eRetVal = EF_RET_OK;
+  ef_u64_t    * pu64Sectors = (ef_u64_t *) malloc( ( (size_t) u32ReplayRecordsNb + 1 ) * sizeof(ef_u64_t) );
+  ef_u64_t      u64HotSectors[ EF_REPLAY_HOT_NB ] = { 0 };
+  ef_u32_t      u32HotCounts[ EF_REPLAY_HOT_NB ] = { 0 };
+  ef_u32_t      u32SectorsNb = 0;
+
+  if ( 0 == pu64Sectors )
+  {
+    eRetVal = EF_RET_NOT_ENOUGH_CORE;
+  }
+  else
+  {
+    for ( ef_u32_t u32Index = 0 ; u32Index < u32ReplayRecordsNb ; u32Index++ )
+    {
+      if ( pxReplayRecords[ u32Index ].u8Operation <= EF_TRACE_WRITE )
+      {
+        pu64Sectors[ u32SectorsNb++ ] = pxReplayRecords[ u32Index ].u64Sector;
+      }
+      else
+      {
+        EF_CODE_COVERAGE( );
+      }
+    }
+    qsort( pu64Sectors, u32SectorsNb, sizeof(ef_u64_t), iReplaySectorCompare );
+    /* Count the runs of equal sectors, keep the longest ones sorted by count */
+    for ( ef_u32_t u32Index = 0 ; u32Index < u32SectorsNb ; )
+    {
+      ef_u32_t  u32Run = 1;
+
+      while (    ( ( u32Index + u32Run ) < u32SectorsNb )
+              && ( pu64Sectors[ u32Index + u32Run ] == pu64Sectors[ u32Index ] ) )
+      {
+        u32Run++;
+      }
+      for ( ef_u32_t u32Hot = 0 ; u32Hot < EF_REPLAY_HOT_NB ; u32Hot++ )
+      {
+        if ( u32Run > u32HotCounts[ u32Hot ] )
+        {
+          (void) memmove( &u32HotCounts[ u32Hot + 1 ], &u32HotCounts[ u32Hot ],
+                          ( EF_REPLAY_HOT_NB - 1 - u32Hot ) * sizeof(ef_u32_t) );
+          (void) memmove( &u64HotSectors[ u32Hot + 1 ], &u64HotSectors[ u32Hot ],
+                          ( EF_REPLAY_HOT_NB - 1 - u32Hot ) * sizeof(ef_u64_t) );
+          u32HotCounts[ u32Hot ] = u32Run;
+          u64HotSectors[ u32Hot ] = pu64Sectors[ u32Index ];
+          break;
+        }
+        else
+        {
+          EF_CODE_COVERAGE( );
+        }
+      }
+      u32Index += u32Run;
+    }
+    free( pu64Sectors );
+
+    printf( "\n%-14s %10s\n", "hot sector", "cmds" );
+    for ( ef_u32_t u32Hot = 0 ; ( u32Hot < EF_REPLAY_HOT_NB ) && ( 0 != u32HotCounts[ u32Hot ] ) ; u32Hot++ )
+    {
+      printf( "%-14llu %10lu\n", (unsigned long long) u64HotSectors[ u32Hot ], (unsigned long) u32HotCounts[ u32Hot ] );
+    }
+  }
+
+  return eRetVal;
+}
+
+static ef_return_et eReplayRun (
+  const ef_bench_config_st  * pxConfig
+)
+{
+  ef_return_et            eRetVal = EF_RET_OK;
+  ef_drive_functions_st * pxBackend;
+  ef_port_flash_config_st xModel;
+  ef_u64_t                u64SectorNb = 0;
+  ef_u32_t                u32CountMax = 1;
+  ef_u64_t                u64Bytes = 0;
+  ef_u08_t              * pu8Buffer;
+  double                  dStart;
+  double                  dSeconds;
+
+  for ( ef_u32_t u32Index = 0 ; u32Index < u32ReplayRecordsNb ; u32Index++ )
+  {
+    const ef_trace_record_st  * pxRecord = &pxReplayRecords[ u32Index ];
+
+    if ( ( pxRecord->u64Sector + pxRecord->u32Count ) > u64SectorNb )
+    {
+      u64SectorNb = pxRecord->u64Sector + pxRecord->u32Count;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    if ( ( pxRecord->u8Operation <= EF_TRACE_WRITE ) && ( pxRecord->u32Count > u32CountMax ) )
+    {
+      u32CountMax = pxRecord->u32Count;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  /* If the disk is too large for this run */
+  if (    ( EF_CONF_SECTOR_SIZE != xReplayHeader.u32SectorSize )
+       || ( ( u64SectorNb * EF_CONF_SECTOR_SIZE ) > ( (ef_u64_t) pxConfig->u32DiskMaxMB * 1024UL * 1024UL ) ) )
+  {
+    printf( "replay skipped, the disk would exceed %lu MB (-d) or the sector size differs\n",
+            (unsigned long) pxConfig->u32DiskMaxMB );
+    eRetVal = EF_RET_NOT_ENOUGH_CORE;
+  }
+  else if ( 0 == ( pu8Buffer = (ef_u08_t *) malloc( (size_t) u32CountMax * EF_CONF_SECTOR_SIZE ) ) )
+  {
+    eRetVal = EF_RET_NOT_ENOUGH_CORE;
+  }
+  else
+  {
+    (void) memset( pu8Buffer, 0xA5, (size_t) u32CountMax * EF_CONF_SECTOR_SIZE );
+    if ( EF_BENCH_BACKEND_RAM == pxConfig->eBackend )
+    {
+      pxBackend = &xffDriveFunctionsRAM;
+      eRetVal = eEFPortDriveRAMConfigure( 0, (ef_u32_t) u64SectorNb, EF_CONF_SECTOR_SIZE, EF_BENCH_BLOCK_SIZE );
+    }
+    else if ( EF_BENCH_BACKEND_FLASH == pxConfig->eBackend )
+    {
+      (void) eEFPortDriveFlashDefaultGet( &xModel );
+      xModel.u32SectorNb = (ef_u32_t) u64SectorNb;
+      pxBackend = &xffDriveFunctionsFlash;
+      eRetVal = eEFPortDriveFlashConfigure( &xModel );
+    }
+    else
+    {
+      (void) remove( pxConfig->pcImagePath );
+      pxBackend = &xffDriveFunctionsImage;
+      eRetVal = eEFPortDriveImageConfigure( pxConfig->pcImagePath,
+                                            (ef_u32_t) u64SectorNb,
+                                            EF_CONF_SECTOR_SIZE,
+                                            EF_BENCH_BLOCK_SIZE,
+                                            pxConfig->bImageMap );
+    }
+    if ( EF_RET_OK == eRetVal )
+    {
+      eRetVal = pxBackend->pxInitialize( );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+
+    /* All the drives of the trace are sent to the single backend */
+    dStart = dEFBenchTimeGet( );
+    for ( ef_u32_t u32Index = 0 ; ( EF_RET_OK == eRetVal ) && ( u32Index < u32ReplayRecordsNb ) ; u32Index++ )
+    {
+      const ef_trace_record_st  * pxRecord = &pxReplayRecords[ u32Index ];
+      ef_lba_t                    xRange[ 2 ];
+
+      if ( EF_TRACE_READ == pxRecord->u8Operation )
+      {
+        eRetVal = pxBackend->pxRead( pu8Buffer, (ef_lba_t) pxRecord->u64Sector, pxRecord->u32Count );
+        u64Bytes += (ef_u64_t) pxRecord->u32Count * EF_CONF_SECTOR_SIZE;
+      }
+      else if ( EF_TRACE_WRITE == pxRecord->u8Operation )
+      {
+        eRetVal = pxBackend->pxWrite( pu8Buffer, (ef_lba_t) pxRecord->u64Sector, pxRecord->u32Count );
+        u64Bytes += (ef_u64_t) pxRecord->u32Count * EF_CONF_SECTOR_SIZE;
+      }
+      else if ( EF_TRACE_TRIM == pxRecord->u8Operation )
+      {
+        xRange[ 0 ] = (ef_lba_t) pxRecord->u64Sector;
+        xRange[ 1 ] = (ef_lba_t) ( pxRecord->u64Sector + pxRecord->u32Count - 1 );
+        eRetVal = pxBackend->pxCtrl( CTRL_TRIM, xRange );
+      }
+      else
+      {
+        eRetVal = pxBackend->pxCtrl( CTRL_SYNC, 0 );
+      }
+    }
+    if ( EF_RET_OK == eRetVal )
+    {
+      eRetVal = pxBackend->pxCtrl( CTRL_SYNC, 0 );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    dSeconds = dEFBenchTimeGet( ) - dStart;
+    if ( dSeconds <= 0.0 )
+    {
+      dSeconds = 1e-9;
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+    free( pu8Buffer );
+
+    printf( "\nreplay on the %s backend, %llu sectors: %.3f s, %.0f cmds/s, %.2f MB/s, returned %d\n",
+            ( EF_BENCH_BACKEND_RAM == pxConfig->eBackend ) ? "ram"
+            : ( EF_BENCH_BACKEND_FLASH == pxConfig->eBackend ) ? "flash" : "image",
+            (unsigned long long) u64SectorNb,
+            dSeconds,
+            (double) u32ReplayRecordsNb / dSeconds,
+            (double) u64Bytes / ( dSeconds * 1024.0 * 1024.0 ),
+            (int) eRetVal );
+    if ( EF_BENCH_BACKEND_IMAGE == pxConfig->eBackend )
+    {
+      (void) eEFPortDriveImageClose( );
+    }
+    else if ( EF_BENCH_BACKEND_FLASH == pxConfig->eBackend )
+    {
+      vReplayFlashPrint( &xModel );
+    }
+    else
+    {
+      EF_CODE_COVERAGE( );
+    }
+  }
+
+  return eRetVal;
+}
+
+static void vReplayFlashPrint (
+  const ef_port_flash_config_st * pxModel
+)
+{
+  ef_port_flash_stats_st  xStats;
+
+  (void) eEFPortDriveFlashStatsGet( &xStats );
+  printf( "simulated device: %.3f s, %llu pages read, %llu programmed, %llu blocks erased, %llu sectors copied, "
+          "%lu merges, write amplification %.2f\n",
+          (double) xStats.u64ElapsedUs / 1e6,
+          (unsigned long long) xStats.u64PagesRead,
+          (unsigned long long) xStats.u64PagesProgrammed,
+          (unsigned long long) xStats.u64BlocksErased,
+          (unsigned long long) xStats.u64SectorsCopied,
+          (unsigned long) xStats.u32Merges,
+          ( 0 != xStats.u64SectorsWritten )
+          ? (double) ( xStats.u64PagesProgrammed * pxModel->u32PageSize ) / (double) xStats.u64SectorsWritten : 0.0 );
+}
+
+static int iReplaySectorCompare (
+  const void  * pvA,
+  const void  * pvB
+)
+{
+  ef_u64_t  u64A = *(const ef_u64_t *) pvA;
+  ef_u64_t  u64B = *(const ef_u64_t *) pvB;
+
+  return ( u64A > u64B ) - ( u64A < u64B );
+}
+
+/* Public functions ------------------------------------------------------------------------------------------------ */
+
+int main (
+  int     iArgc,
+  char ** ppcArgv
+)
+{
+  ef_return_et        eRetVal = EF_RET_OK;
+  ef_bench_config_st  xConfig = { EF_BENCH_BACKEND_RAM, 0, EF_BOOL_FALSE, EF_BENCH_SEED_DEFAULT, 1024UL, 0UL, 0UL, 0UL, 0, 0UL };
+
+  if (    ( EF_RET_OK != eEFBenchArgsParse( iArgc, ppcArgv, &xConfig ) )
+       || ( 0 == xConfig.pcTracePath )
+       || ( EF_BENCH_BACKEND_STRIPE == xConfig.eBackend ) )
+  {
+    printf( "usage: %s -t trace [-b ram|image|flash] [-f image] [-m] [-d disk max MB]\n", ppcArgv[ 0 ] );
+    return 2;
+  }
+  EF_BENCH_CHECK( eReplayLoad( xConfig.pcTracePath ) );
+  vReplayAnalyse( );
+  EF_BENCH_CHECK( eReplayHotPrint( ) );
+  eRetVal = eReplayRun( &xConfig );
+  free( pxReplayRecords );
+
+  return ( EF_RET_OK == eRetVal ) ? 0 : 1;
+}
+
+/* ***************************************************************************************************************** */
+/* END OF FILE ***************************************************************************************************** */